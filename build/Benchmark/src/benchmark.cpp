@@ -0,0 +1,1896 @@
+// benchmark.cpp
+// Microbenchmarks of the pipeline kernels.
+//
+// Each kernel runs over several input sizes, and the time per operation,
+// the throughput (items per second), and the number of heap allocations
+// per operation are reported. Inputs are synthetic and generated with fixed seeds,
+// and thus the results of different builds can be compared with '--benchmark_output'.
+//
+// With '--throughput', the whole pipeline runs over synthetic inputs with increasing
+// numbers of worker processes, and the throughput (meshes per hour), latency percentiles,
+// per-stage times, peak memory and scaling efficiency are reported ('--throughput_output').
+//
+// With '--geometry_precision', the float and double geometry kernels (see 'GeometryReal.h')
+// run over the same synthetic inputs, and the differences of the evaluation metrics are reported.
+//
+// With '--check_kernels', the analytic and batched kernels are checked against
+// brute-force references on random inputs.
+
+//-----------------------------------------------------------------------------
+// Includes
+#include <cassert>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <gflags/gflags.h>
+#include <ANN/ANN.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "BinaryIO.h"
+#include "CuboidDistanceKernel.h"
+#include "ICP.h"
+#include "LabelConfidenceTable.h"
+#include "MeshCuboid.h"
+#include "MeshCuboidFusion.h"
+#include "MeshCuboidParameters.h"
+#include "MeshCuboidRelation.h"
+#include "MeshCuboidSolver.h"
+#include "MeshCuboidStructure.h"
+#include "MyMesh.h"
+#include "NLPFormulation.h"
+#include "StructureCompletion.h"
+#include "SymmetryDetection.h"
+#include "SyntheticDataset.h"
+#include "TraceRecorder.h"
+#include "simplerandom.h"
+
+
+//-----------------------------------------------------------------------------
+// Flags
+DEFINE_string(benchmark_filter, "", "Run only benchmarks whose names contain this string.");
+DEFINE_double(benchmark_min_time, 0.5, "Minimum measuring time of each case (in seconds).");
+DEFINE_double(benchmark_size_scale, 1.0, "Scale of the input sizes of all benchmarks.");
+DEFINE_string(benchmark_output, "", "CSV file where the results are written.");
+
+DEFINE_bool(throughput, false, "Run the whole pipeline over synthetic inputs instead of the kernels.");
+DEFINE_int32(throughput_num_inputs, 16, "Number of inputs (meshes) in each run.");
+DEFINE_int32(throughput_max_processes, 0, "Maximum number of worker processes (0: number of cores).");
+DEFINE_string(throughput_category, "chair", "Synthetic object category.");
+DEFINE_int32(throughput_num_training_objects, 20, "Number of synthetic training objects.");
+DEFINE_int32(throughput_num_sample_points, 1000, "Number of sample points of each object.");
+DEFINE_double(throughput_label_noise, 0.1, "Probability of a wrong label prediction of a sample point.");
+DEFINE_bool(throughput_fixed_inputs, true, "Use the fixed seed and the fixed pose for all inputs.");
+DEFINE_string(throughput_data_path, "benchmark_data", "Directory where the training data are generated.");
+DEFINE_string(throughput_output, "", "JSON file where the throughput results are written.");
+
+DEFINE_bool(geometry_precision, false, "Compare the float and double geometry kernels instead of timing the kernels.");
+DEFINE_bool(check_kernels, false, "Check the kernels against brute-force references instead of timing the kernels.");
+DEFINE_int32(check_kernels_num_cases, 200, "Number of random cases of each kernel check.");
+
+DEFINE_double(geometry_precision_tolerance, 1.0E-3, "Maximum difference of the evaluation metrics between the float and double kernels.");
+
+#define BENCHMARK_RANDOM_SEED	20160101
+
+
+//-----------------------------------------------------------------------------
+// Allocation counter
+static std::atomic<unsigned long long> g_NumAllocations(0);
+
+#if defined(__GLIBC__)
+// NOTE:
+// Wrap the glibc allocator so that all heap allocations are counted,
+// including Eigen matrices and ANN arrays which do not use 'operator new'.
+extern "C" {
+void *__libc_malloc(size_t _size);
+void *__libc_calloc(size_t _num, size_t _size);
+void *__libc_realloc(void *_ptr, size_t _size);
+void __libc_free(void *_ptr);
+
+void *malloc(size_t _size)
+{
+	g_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(_size);
+}
+
+void *calloc(size_t _num, size_t _size)
+{
+	g_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(_num, _size);
+}
+
+void *realloc(void *_ptr, size_t _size)
+{
+	g_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(_ptr, _size);
+}
+
+void free(void *_ptr)
+{
+	__libc_free(_ptr);
+}
+}
+#else
+// NOTE:
+// Only allocations through 'operator new' are counted.
+void *operator new(size_t _size)
+{
+	g_NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	void *ptr = std::malloc(_size > 0 ? _size : 1);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void *operator new[](size_t _size)
+{
+	return operator new(_size);
+}
+
+void operator delete(void *_ptr) noexcept
+{
+	std::free(_ptr);
+}
+
+void operator delete[](void *_ptr) noexcept
+{
+	std::free(_ptr);
+}
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Benchmark runner
+struct BenchmarkResult
+{
+	std::string name_;
+	unsigned int size_;
+	unsigned long long num_iterations_;
+	double ns_per_op_;
+	double items_per_second_;
+	double allocs_per_op_;
+};
+
+std::vector<BenchmarkResult> g_Results;
+
+// Suppress 'std::cout' messages of the kernels while measuring.
+class QuietOutput
+{
+public:
+	QuietOutput() : buffer_(std::cout.rdbuf(NULL)) {}
+	~QuietOutput() { std::cout.rdbuf(buffer_); }
+
+private:
+	std::streambuf *buffer_;
+};
+
+bool is_benchmark_enabled(const std::string &_name)
+{
+	return (FLAGS_benchmark_filter.empty()
+		|| _name.find(FLAGS_benchmark_filter) != std::string::npos);
+}
+
+std::vector<unsigned int> scaled_sizes(const std::vector<unsigned int> &_sizes)
+{
+	std::vector<unsigned int> sizes;
+	for (std::vector<unsigned int>::const_iterator it = _sizes.begin(); it != _sizes.end(); ++it)
+	{
+		unsigned int size = static_cast<unsigned int>(std::round((*it) * FLAGS_benchmark_size_scale));
+		sizes.push_back(std::max(size, 1u));
+	}
+	return sizes;
+}
+
+// '_num_items': Number of items processed in a single call of '_function'.
+// NOTE:
+// '_function' is called once before measuring so that lazy initializations
+// are not measured. The number of calls is doubled until the total time exceeds
+// the minimum time.
+void run_benchmark(const std::string &_name, const unsigned int _size,
+	const double _num_items, const std::function<void()> &_function)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	unsigned long long num_iterations = 0;
+	unsigned long long num_allocations = 0;
+	double elapsed_seconds = 0;
+
+	{
+		QuietOutput quiet;
+		_function();
+
+		for (unsigned long long batch_size = 1; elapsed_seconds < FLAGS_benchmark_min_time;
+			batch_size *= 2)
+		{
+			const unsigned long long start_num_allocations = g_NumAllocations.load();
+			const Clock::time_point start_time = Clock::now();
+
+			for (unsigned long long i = 0; i < batch_size; ++i)
+				_function();
+
+			const Clock::time_point end_time = Clock::now();
+			num_allocations += (g_NumAllocations.load() - start_num_allocations);
+			elapsed_seconds += std::chrono::duration<double>(end_time - start_time).count();
+			num_iterations += batch_size;
+		}
+	}
+
+	BenchmarkResult result;
+	result.name_ = _name;
+	result.size_ = _size;
+	result.num_iterations_ = num_iterations;
+	result.ns_per_op_ = 1.0E9 * elapsed_seconds / num_iterations;
+	result.items_per_second_ = _num_items * num_iterations / elapsed_seconds;
+	result.allocs_per_op_ = static_cast<double>(num_allocations) / num_iterations;
+	g_Results.push_back(result);
+
+	std::stringstream name_sstr;
+	name_sstr << _name << "/" << _size;
+
+	std::cout << std::left << std::setw(44) << name_sstr.str() << std::right
+		<< std::setw(10) << result.num_iterations_
+		<< std::setw(16) << std::fixed << std::setprecision(0) << result.ns_per_op_
+		<< std::setw(16) << std::scientific << std::setprecision(3) << result.items_per_second_
+		<< std::setw(14) << std::fixed << std::setprecision(1) << result.allocs_per_op_
+		<< std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+}
+
+bool write_results(const std::string &_filename)
+{
+	std::ofstream file(_filename.c_str());
+	if (!file.is_open())
+	{
+		std::cerr << "Error: Cannot save the benchmark results (" << _filename << ")." << std::endl;
+		return false;
+	}
+
+	file << "name,size,iterations,ns_per_op,items_per_second,allocs_per_op" << std::endl;
+	file << std::setprecision(12);
+	for (std::vector<BenchmarkResult>::const_iterator it = g_Results.begin(); it != g_Results.end(); ++it)
+	{
+		file << it->name_ << "," << it->size_ << "," << it->num_iterations_ << ","
+			<< it->ns_per_op_ << "," << it->items_per_second_ << "," << it->allocs_per_op_ << std::endl;
+	}
+
+	file.close();
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Input generation
+Real random_real(SimpleRandomCong_t &_rng, const Real _min = 0.0, const Real _max = 1.0)
+{
+	Real value = static_cast<Real>(simplerandom_cong_next(&_rng))
+		/ std::numeric_limits<uint32_t>::max();
+	return _min + (_max - _min) * value;
+}
+
+// Uniformly distributed points in [-0.5, 0.5]^3.
+Eigen::MatrixXd random_points(const unsigned int _num_points, const uint32_t _seed)
+{
+	SimpleRandomCong_t rng;
+	simplerandom_cong_seed(&rng, _seed);
+
+	Eigen::MatrixXd points(3, _num_points);
+	for (unsigned int point_index = 0; point_index < _num_points; ++point_index)
+		for (unsigned int i = 0; i < 3; ++i)
+			points.col(point_index)(i) = random_real(rng, -0.5, 0.5);
+	return points;
+}
+
+MeshCuboid *create_cuboid(const LabelIndex _label_index,
+	const MyMesh::Point &_center, const MyMesh::Normal &_size, const Real _angle)
+{
+	std::array<MyMesh::Normal, 3> axes;
+	axes[0] = MyMesh::Normal(std::cos(_angle), std::sin(_angle), 0.0);
+	axes[1] = MyMesh::Normal(-std::sin(_angle), std::cos(_angle), 0.0);
+	axes[2] = MyMesh::Normal(0.0, 0.0, 1.0);
+
+	MeshCuboid *cuboid = new MeshCuboid(_label_index);
+	cuboid->set_bbox_center(_center);
+	cuboid->set_bbox_axes(axes, false);
+	cuboid->set_bbox_size(_size);
+	return cuboid;
+}
+
+// Modelview matrix (column-major) of a camera at (0, 0, 3) looking at the origin.
+void get_modelview_matrix(Real _modelview_matrix[16])
+{
+	for (unsigned int i = 0; i < 16; ++i)
+		_modelview_matrix[i] = (i % 5 == 0) ? 1.0 : 0.0;
+	_modelview_matrix[14] = -3.0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Benchmarks
+void benchmark_cuboid_surface_point_visibility()
+{
+	const std::string name = "cuboid_surface_point_visibility";
+	if (!is_benchmark_enabled(name)) return;
+
+	MeshCuboidParameters params;
+	params.use_view_plane_mask_ = false;
+
+	Real modelview_matrix[16];
+	get_modelview_matrix(modelview_matrix);
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 256, 1024, 4096 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = (*it);
+
+		// Observed points and points on a cuboid behind them.
+		Eigen::MatrixXd points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+		std::vector<MeshSamplePoint *> sample_points;
+		for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+		{
+			MyMesh::Point point(points(0, point_index), points(1, point_index), 0.5);
+			sample_points.push_back(new MeshSamplePoint(point_index, 0, MyMesh::Point(0.0),
+				point, MyMesh::Normal(0.0, 0.0, 1.0)));
+		}
+
+		MeshCuboid *cuboid = create_cuboid(0, MyMesh::Point(0.0), MyMesh::Normal(1.0), 0.3);
+		cuboid->create_grid_points_on_cuboid_surface(num_points);
+
+		std::vector<MyMesh::Point> test_points;
+		std::vector<MyMesh::Normal> test_normals;
+		for (unsigned int point_index = 0; point_index < cuboid->num_cuboid_surface_points(); ++point_index)
+		{
+			test_points.push_back(cuboid->get_cuboid_surface_point(point_index)->point_);
+			test_normals.push_back(cuboid->get_cuboid_surface_point(point_index)->normal_);
+		}
+
+		std::vector<Real> visibility_values;
+		run_benchmark(name, num_points,
+			static_cast<double>(sample_points.size()) * test_points.size(), [&]()
+		{
+			MeshCuboid::compute_cuboid_surface_point_visibility(modelview_matrix,
+				params.occlusion_test_neighbor_distance_, sample_points, test_points, &test_normals,
+				params, visibility_values);
+		});
+
+		delete cuboid;
+		for (std::vector<MeshSamplePoint *>::iterator jt = sample_points.begin();
+			jt != sample_points.end(); ++jt)
+			delete (*jt);
+	}
+}
+
+void benchmark_points_to_cuboid_distances()
+{
+	// NOTE: The name has the instruction set of the kernel (e.g. 'points_to_cuboid_distances_avx2').
+	const std::string name = std::string("points_to_cuboid_distances_") +
+		CuboidDistanceKernel::get_instruction_set();
+	if (!is_benchmark_enabled(name)) return;
+
+	const unsigned int num_cuboids = 16;
+	std::vector<MeshCuboid *> cuboids;
+	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+	{
+		const Real angle = 2 * M_PI * cuboid_index / num_cuboids;
+		cuboids.push_back(create_cuboid(cuboid_index,
+			MyMesh::Point(0.3 * std::cos(angle), 0.3 * std::sin(angle), 0.0),
+			MyMesh::Normal(0.2, 0.1, 0.3), angle));
+	}
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 1024, 16384, 131072 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = (*it);
+		Eigen::MatrixXd points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+
+		Eigen::VectorXd distances;
+		run_benchmark(name, num_points, static_cast<double>(num_points) * num_cuboids, [&]()
+		{
+			for (std::vector<MeshCuboid *>::iterator jt = cuboids.begin(); jt != cuboids.end(); ++jt)
+				(*jt)->points_to_cuboid_distances(points, distances);
+		});
+	}
+
+	for (std::vector<MeshCuboid *>::iterator it = cuboids.begin(); it != cuboids.end(); ++it)
+		delete (*it);
+}
+
+void benchmark_points_to_nearest_cuboids()
+{
+	// NOTE: The name has the instruction set of the kernel (e.g. 'points_to_nearest_cuboids_avx2').
+	const std::string name = std::string("points_to_nearest_cuboids_") +
+		CuboidDistanceKernel::get_instruction_set();
+	if (!is_benchmark_enabled(name)) return;
+
+	const unsigned int num_cuboids = 16;
+	std::vector<MeshCuboid *> cuboids;
+	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+	{
+		const Real angle = 2 * M_PI * cuboid_index / num_cuboids;
+		cuboids.push_back(create_cuboid(cuboid_index,
+			MyMesh::Point(0.3 * std::cos(angle), 0.3 * std::sin(angle), 0.0),
+			MyMesh::Normal(0.2, 0.1, 0.3), angle));
+	}
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 1024, 16384, 131072 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = (*it);
+		Eigen::MatrixXd points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+
+		std::vector<int> cuboid_indices;
+		Eigen::VectorXd distances;
+		run_benchmark(name, num_points, static_cast<double>(num_points) * num_cuboids, [&]()
+		{
+			MeshCuboid::points_to_nearest_cuboids(points, cuboids, cuboid_indices, distances);
+		});
+	}
+
+	for (std::vector<MeshCuboid *>::iterator it = cuboids.begin(); it != cuboids.end(); ++it)
+		delete (*it);
+}
+
+void benchmark_label_confidence_table()
+{
+	// NOTE: The names have the encoding (e.g. 'label_confidence_argmax_half').
+	const unsigned int num_labels = 20;
+	const char *encoding_names[] = { "float", "half", "byte" };
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 16384, 131072, 1048576 });
+	for (unsigned int encoding = LabelConfidenceTable::FloatEncoding;
+		encoding <= LabelConfidenceTable::ByteEncoding; ++encoding)
+	{
+		const std::string argmax_name = std::string("label_confidence_argmax_") + encoding_names[encoding];
+		const std::string normalize_name = std::string("label_confidence_normalize_") + encoding_names[encoding];
+		if (!is_benchmark_enabled(argmax_name) && !is_benchmark_enabled(normalize_name)) continue;
+
+		for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+		{
+			const unsigned int num_points = (*it);
+
+			SimpleRandomCong_t rng;
+			simplerandom_cong_seed(&rng, BENCHMARK_RANDOM_SEED);
+			Eigen::MatrixXd values(num_points, num_labels);
+			for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+				for (unsigned int label_index = 0; label_index < num_labels; ++label_index)
+					values(point_index, label_index) = random_real(rng, 0.0, 1.0);
+
+			LabelConfidenceTable table(static_cast<LabelConfidenceTable::Encoding>(encoding));
+			table.set_matrix(values);
+
+			std::vector<LabelIndex> label_indices;
+			if (is_benchmark_enabled(argmax_name))
+			{
+				run_benchmark(argmax_name, num_points, static_cast<double>(num_points) * num_labels, [&]()
+				{
+					table.get_argmax_labels(label_indices);
+				});
+			}
+
+			if (is_benchmark_enabled(normalize_name))
+			{
+				run_benchmark(normalize_name, num_points, static_cast<double>(num_points) * num_labels, [&]()
+				{
+					table.normalize();
+				});
+			}
+		}
+	}
+}
+
+void benchmark_icp_get_closest_points()
+{
+	const std::string name = "icp_get_closest_points";
+	if (!is_benchmark_enabled(name)) return;
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 1024, 8192, 65536 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = (*it);
+		Eigen::MatrixXd data_points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+		Eigen::MatrixXd query_points = random_points(num_points, BENCHMARK_RANDOM_SEED + 1);
+
+		ANNpointArray data_ann_points;
+		ANNkd_tree *data_ann_kd_tree = ICP::create_kd_tree(data_points, data_ann_points);
+
+		Eigen::VectorXd distances;
+		run_benchmark(name, num_points, num_points, [&]()
+		{
+			ICP::get_closest_points(data_ann_kd_tree, query_points, distances);
+		});
+
+		annDeallocPts(data_ann_points);
+		delete data_ann_kd_tree;
+	}
+}
+
+void benchmark_icp_run_iterative_closest_points()
+{
+	const std::string name = "icp_run_iterative_closest_points";
+	if (!is_benchmark_enabled(name)) return;
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 256, 1024, 4096 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = (*it);
+		Eigen::MatrixXd target_points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+
+		// Slightly rotated and translated copy of the target points.
+		Eigen::Matrix3d rotation = Eigen::AngleAxisd(0.05, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+		Eigen::Vector3d translation(0.01, -0.01, 0.02);
+		Eigen::MatrixXd source_points = (rotation * target_points).colwise() + translation;
+
+		Eigen::Matrix3d output_rotation;
+		Eigen::Vector3d output_translation;
+
+		// NOTE:
+		// The source points are modified in ICP, and the copy is included in the measurement.
+		run_benchmark(name, num_points, num_points, [&]()
+		{
+			Eigen::MatrixXd points = source_points;
+			ICP::run_iterative_closest_points(points, target_points,
+				output_rotation, output_translation);
+		});
+	}
+}
+
+void benchmark_joint_normal_relations_compute_error()
+{
+	const std::string name = "joint_normal_relations_compute_error";
+	if (!is_benchmark_enabled(name)) return;
+
+	MeshCuboidJointNormalRelations relations;
+	const int mat_size = MeshCuboidJointNormalRelations::k_mat_size;
+	relations.set_mean(Eigen::VectorXd::Zero(mat_size));
+	relations.set_inv_cov(Eigen::MatrixXd::Identity(mat_size, mat_size));
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 4, 8, 16 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_cuboids = std::max((*it), 2u);
+
+		SimpleRandomCong_t rng;
+		simplerandom_cong_seed(&rng, BENCHMARK_RANDOM_SEED);
+
+		std::vector<MeshCuboid *> cuboids;
+		std::vector<MeshCuboidTransformation *> transformations;
+		for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+		{
+			MyMesh::Point center(random_real(rng, -0.5, 0.5),
+				random_real(rng, -0.5, 0.5), random_real(rng, -0.5, 0.5));
+			MyMesh::Normal size(random_real(rng, 0.05, 0.5),
+				random_real(rng, 0.05, 0.5), random_real(rng, 0.05, 0.5));
+			cuboids.push_back(create_cuboid(cuboid_index, center, size, random_real(rng, 0, M_PI)));
+
+			MeshCuboidTransformation *transformation = new MeshCuboidTransformation("");
+			transformation->compute_transformation(cuboids.back());
+			transformations.push_back(transformation);
+		}
+
+		double sum_error = 0;
+		run_benchmark(name, num_cuboids, num_cuboids * (num_cuboids - 1), [&]()
+		{
+			for (unsigned int cuboid_index_1 = 0; cuboid_index_1 < num_cuboids; ++cuboid_index_1)
+				for (unsigned int cuboid_index_2 = 0; cuboid_index_2 < num_cuboids; ++cuboid_index_2)
+					if (cuboid_index_1 != cuboid_index_2)
+						sum_error += relations.compute_error(
+						cuboids[cuboid_index_1], cuboids[cuboid_index_2],
+						transformations[cuboid_index_1], transformations[cuboid_index_2]);
+		});
+
+		for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+		{
+			delete cuboids[cuboid_index];
+			delete transformations[cuboid_index];
+		}
+	}
+}
+
+void benchmark_solve_markov_random_field()
+{
+	const std::string name = "solve_markov_random_field";
+	if (!is_benchmark_enabled(name)) return;
+
+	// NOTE:
+	// The number of labels is similar to (number of labels) x (number of axis configurations)
+	// in the cuboid recognition.
+	const unsigned int num_labels = 32;
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 4, 8, 16 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_nodes = std::max((*it), 2u);
+		const unsigned int mat_size = num_nodes * num_labels;
+
+		SimpleRandomCong_t rng;
+		simplerandom_cong_seed(&rng, BENCHMARK_RANDOM_SEED);
+
+		Eigen::MatrixXd energy_mat = Eigen::MatrixXd::Zero(mat_size, mat_size);
+		for (unsigned int row = 0; row < mat_size; ++row)
+		{
+			energy_mat(row, row) = random_real(rng);
+			for (unsigned int col = row + 1; col < mat_size; ++col)
+			{
+				if (row / num_labels == col / num_labels) continue;
+				energy_mat(row, col) = energy_mat(col, row) = random_real(rng);
+			}
+		}
+
+		run_benchmark(name, num_nodes, num_nodes, [&]()
+		{
+			solve_markov_random_field(num_nodes, num_labels, energy_mat);
+		});
+	}
+}
+
+void benchmark_segment_sample_points()
+{
+	const std::string name = "segment_sample_points";
+	if (!is_benchmark_enabled(name)) return;
+
+	// NOTE:
+	// Eight cuboids in the octants of a cube whose diameter is 1.
+	const Real half_size = 0.5 / std::sqrt(3.0);
+	const unsigned int num_cuboids = 8;
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 1000, 4000, 16000 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = (*it);
+
+		// NOTE:
+		// Only the object diameter of the mesh is used.
+		MyMesh mesh;
+		mesh.add_vertex(MyMesh::Point(-half_size));
+		mesh.add_vertex(MyMesh::Point(half_size));
+		mesh.initialize(false);
+
+		MeshCuboidStructure cuboid_structure(&mesh);
+
+		for (LabelIndex label_index = 0; label_index < num_cuboids; ++label_index)
+		{
+			MyMesh::Point center;
+			for (unsigned int i = 0; i < 3; ++i)
+				center[i] = ((label_index >> i) & 1) ? 0.5 * half_size : -0.5 * half_size;
+
+			MeshCuboid *cuboid = create_cuboid(label_index, center, MyMesh::Normal(half_size), 0.0);
+			cuboid->create_grid_points_on_cuboid_surface(
+				cuboid_structure.get_parameters().num_cuboid_surface_points_);
+
+			cuboid_structure.labels_.push_back(label_index);
+			cuboid_structure.label_names_.push_back(std::to_string(label_index));
+			cuboid_structure.label_cuboids_.push_back(std::vector<MeshCuboid *>(1, cuboid));
+		}
+		cuboid_structure.sample_label_confidences_.resize(0, num_cuboids);
+
+		Eigen::MatrixXd points = random_points(num_points, BENCHMARK_RANDOM_SEED) * (2 * half_size);
+		for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+		{
+			MyMesh::Point point(points(0, point_index), points(1, point_index), points(2, point_index));
+			MeshSamplePoint *sample_point = cuboid_structure.add_sample_point(point, MyMesh::Normal(0.0));
+
+			LabelIndex label_index = 0;
+			for (unsigned int i = 0; i < 3; ++i)
+				if (point[i] > 0) label_index |= (1 << i);
+
+			std::vector<Real> label_confidences(num_cuboids, 0.2 / (num_cuboids - 1));
+			label_confidences[label_index] = 0.8;
+			cuboid_structure.sample_label_confidences_.set_row(
+				sample_point->sample_point_index_, label_confidences);
+			cuboid_structure.label_cuboids_[label_index].front()->add_sample_point(sample_point);
+		}
+
+		run_benchmark(name, num_points, num_points, [&]()
+		{
+			segment_sample_points(cuboid_structure);
+		});
+	}
+}
+
+void benchmark_nlp_expression()
+{
+	const std::string eval_name = "nlp_expression_eval";
+	const std::string gradient_name = "nlp_expression_gradient";
+	const std::string hessian_name = "nlp_expression_hessian";
+	if (!is_benchmark_enabled(eval_name) && !is_benchmark_enabled(gradient_name)
+		&& !is_benchmark_enabled(hessian_name)) return;
+
+	// NOTE:
+	// The Hessian is dense (lower triangular), and thus the sizes are limited.
+	const std::vector<unsigned int> sizes = scaled_sizes({ 64, 256, 1024 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const Index num_vars = std::max((*it), 2u);
+
+		SimpleRandomCong_t rng;
+		simplerandom_cong_seed(&rng, BENCHMARK_RANDOM_SEED);
+
+		// sum_i { a_i * (x_i - x_{i+1})^2 + b_i * x_i^2 + c_i * x_i }.
+		NLPExpression expression;
+		unsigned int num_terms = 0;
+		for (Index var_index = 0; var_index < num_vars; ++var_index)
+		{
+			const Number a = random_real(rng), b = random_real(rng), c = random_real(rng);
+			std::vector<Index> square_indices(2, var_index);
+
+			if (var_index + 1 < num_vars)
+			{
+				std::vector<Index> next_square_indices(2, var_index + 1);
+				std::vector<Index> pair_indices;
+				pair_indices.push_back(var_index);
+				pair_indices.push_back(var_index + 1);
+
+				expression.add_term(NLPTerm(a, square_indices));
+				expression.add_term(NLPTerm(-2 * a, pair_indices));
+				expression.add_term(NLPTerm(a, next_square_indices));
+				num_terms += 3;
+			}
+
+			expression.add_term(NLPTerm(b, square_indices));
+			expression.add_term(NLPTerm(c, var_index));
+			num_terms += 2;
+		}
+
+		NLPSparseFunction function(num_vars, expression);
+
+		std::vector<Number> values(num_vars);
+		for (Index var_index = 0; var_index < num_vars; ++var_index)
+			values[var_index] = random_real(rng, -1.0, 1.0);
+
+		if (is_benchmark_enabled(eval_name))
+		{
+			Number sum_values = 0;
+			run_benchmark(eval_name, num_vars, num_terms, [&]()
+			{
+				sum_values += function.eval(&values[0]);
+			});
+		}
+
+		if (is_benchmark_enabled(gradient_name))
+		{
+			std::vector<Number> gradient(num_vars);
+			run_benchmark(gradient_name, num_vars, num_vars, [&]()
+			{
+				function.eval_gradient(&values[0], &gradient[0]);
+			});
+		}
+
+		if (is_benchmark_enabled(hessian_name))
+		{
+			std::vector<Number> hessian(num_vars * (num_vars + 1) / 2, 0.0);
+			run_benchmark(hessian_name, num_vars, num_vars, [&]()
+			{
+				function.eval_hessian(&values[0], 1.0, &hessian[0]);
+			});
+		}
+	}
+}
+
+void benchmark_voxel_grid_get_distance_map()
+{
+	const std::string name = "voxel_grid_get_distance_map";
+	if (!is_benchmark_enabled(name)) return;
+
+	const unsigned int num_points = 4096;
+	Eigen::MatrixXd points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+
+	ANNpointArray ann_points;
+	ANNkd_tree *ann_kd_tree = ICP::create_kd_tree(points, ann_points);
+
+	// Number of voxels in each axis.
+	const std::vector<unsigned int> sizes = scaled_sizes({ 16, 32, 64 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_axis_voxels = std::max((*it), 2u);
+		MeshCuboidVoxelGrid voxels(MyMesh::Point(-0.5), MyMesh::Point(0.5), 1.0 / num_axis_voxels);
+
+		Eigen::VectorXd voxel_to_point_distances;
+		run_benchmark(name, num_axis_voxels, voxels.n_voxels(), [&]()
+		{
+			voxels.get_distance_map(ann_points, ann_kd_tree, voxel_to_point_distances);
+		});
+	}
+
+	annDeallocPts(ann_points);
+	delete ann_kd_tree;
+}
+
+void benchmark_detect_reflectional_symmetry()
+{
+	const std::string name = "detect_reflectional_symmetry";
+	if (!is_benchmark_enabled(name)) return;
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 500, 1000, 2000 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = std::max((*it) / 2, 1u) * 2;
+
+		// Points symmetric with respect to the x = 0 plane.
+		Eigen::MatrixXd points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+		for (unsigned int point_index = 0; point_index < num_points / 2; ++point_index)
+		{
+			points(0, point_index) = std::abs(points(0, point_index));
+			points.col(num_points / 2 + point_index) = points.col(point_index);
+			points(0, num_points / 2 + point_index) = -points(0, point_index);
+		}
+
+		const double inlier_dist = 0.02;
+		const double inlier_ratio = 0.7;
+		run_benchmark(name, num_points, num_points, [&]()
+		{
+			std::list<SymmetryDetection::ReflectionPlane> reflection_planes;
+			SymmetryDetection::detect_reflectional_symmetry(points,
+				inlier_dist, inlier_ratio, reflection_planes);
+		});
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Geometry precision comparison
+// NOTE:
+// Nothing is timed. The float and double kernels run on the same inputs, and
+// the closest point distances are summarized by the accuracy and completeness curves
+// of 'MeshCuboidEvaluator::evaluate_point_to_point_distances()'.
+// The comparison fails if any metric differs more than '--geometry_precision_tolerance'.
+template <typename Scalar>
+void compute_closest_point_distances(const Eigen::MatrixXd &_points,
+	const Eigen::MatrixXd &_query_points, const double _max_distance,
+	std::vector<int> &_closest_point_indices, Eigen::VectorXd &_distances)
+{
+	PointHashGridT<Scalar> point_grid(_points, _max_distance);
+
+	const unsigned int num_query_points = _query_points.cols();
+	_closest_point_indices.resize(num_query_points);
+	_distances.setConstant(num_query_points, std::numeric_limits<double>::max());
+
+	for (unsigned int point_index = 0; point_index < num_query_points; ++point_index)
+	{
+		Eigen::Vector3d query_point = _query_points.col(point_index);
+		_closest_point_indices[point_index] = point_grid.find_closest_point(
+			query_point, _max_distance, &_distances[point_index]);
+	}
+}
+
+// Ratios of the distances within each neighbor range ('accuracy' or 'completeness').
+Eigen::VectorXd compute_neighbor_range_ratios(const Eigen::VectorXd &_distances,
+	const Eigen::VectorXd &_neighbor_ranges)
+{
+	Eigen::VectorXd ratios(_neighbor_ranges.size());
+	for (unsigned int i = 0; i < _neighbor_ranges.size(); ++i)
+		ratios[i] = static_cast<double>((_distances.array() <= _neighbor_ranges[i]).count())
+		/ _distances.size();
+	return ratios;
+}
+
+// '_num_mismatches': Number of items whose float and double results are different.
+bool report_precision_difference(const std::string &_name, const unsigned int _size,
+	const unsigned int _num_mismatches, const unsigned int _num_items, const double _max_difference)
+{
+	std::stringstream name_sstr;
+	name_sstr << _name << "/" << _size;
+
+	const bool is_passed = (_max_difference <= FLAGS_geometry_precision_tolerance);
+	std::cout << std::left << std::setw(44) << name_sstr.str() << std::right
+		<< std::setw(10) << _num_mismatches
+		<< std::setw(10) << _num_items
+		<< std::setw(16) << std::scientific << std::setprecision(3) << _max_difference
+		<< std::setw(8) << (is_passed ? "OK" : "FAIL")
+		<< std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+	return is_passed;
+}
+
+bool compare_closest_point_precision(const MeshCuboidParameters &_params)
+{
+	const double max_distance = _params.eval_max_neighbor_distance_;
+	Eigen::VectorXd neighbor_ranges;
+	neighbor_ranges.setLinSpaced(_params.eval_num_neighbor_range_samples_, 0.0, max_distance);
+
+	bool is_passed = true;
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 1000, 10000, 100000 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = (*it);
+
+		// Ground truth points, and test points perturbed up to the maximum neighbor distance.
+		Eigen::MatrixXd ground_truth_points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+		Eigen::MatrixXd test_points = ground_truth_points;
+
+		SimpleRandomCong_t rng;
+		simplerandom_cong_seed(&rng, BENCHMARK_RANDOM_SEED + 1);
+		for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+			for (unsigned int i = 0; i < 3; ++i)
+				test_points.col(point_index)(i) += random_real(rng, -max_distance, max_distance);
+
+		std::vector<int> float_indices, double_indices;
+		Eigen::VectorXd float_distances, double_distances;
+		unsigned int num_mismatches;
+		double max_difference;
+
+		for (unsigned int direction = 0; direction < 2; ++direction)
+		{
+			// 0: test to ground truth (accuracy), 1: ground truth to test (completeness).
+			const Eigen::MatrixXd &points = (direction == 0) ? ground_truth_points : test_points;
+			const Eigen::MatrixXd &query_points = (direction == 0) ? test_points : ground_truth_points;
+			const std::string metric_name = (direction == 0) ? "accuracy" : "completeness";
+
+			compute_closest_point_distances<float>(points, query_points, max_distance,
+				float_indices, float_distances);
+			compute_closest_point_distances<double>(points, query_points, max_distance,
+				double_indices, double_distances);
+
+			num_mismatches = 0;
+			max_difference = 0.0;
+			for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+			{
+				if (float_indices[point_index] != double_indices[point_index])
+					++num_mismatches;
+				if (float_indices[point_index] >= 0 && double_indices[point_index] >= 0)
+					max_difference = std::max(max_difference,
+					std::abs(float_distances[point_index] - double_distances[point_index]));
+			}
+			is_passed &= report_precision_difference("closest_point_distance/" + metric_name,
+				num_points, num_mismatches, num_points, max_difference);
+
+			Eigen::VectorXd float_ratios = compute_neighbor_range_ratios(float_distances, neighbor_ranges);
+			Eigen::VectorXd double_ratios = compute_neighbor_range_ratios(double_distances, neighbor_ranges);
+			num_mismatches = (float_ratios.array() != double_ratios.array()).count();
+			max_difference = (float_ratios - double_ratios).cwiseAbs().maxCoeff();
+			is_passed &= report_precision_difference(metric_name,
+				num_points, num_mismatches, neighbor_ranges.size(), max_difference);
+		}
+	}
+
+	return is_passed;
+}
+
+bool compare_visibility_precision(const MeshCuboidParameters &_params)
+{
+	Real modelview_matrix[16];
+	get_modelview_matrix(modelview_matrix);
+
+	bool is_passed = true;
+
+	const std::vector<unsigned int> sizes = scaled_sizes({ 256, 1024, 4096 });
+	for (std::vector<unsigned int>::const_iterator it = sizes.begin(); it != sizes.end(); ++it)
+	{
+		const unsigned int num_points = (*it);
+
+		// Observed points and points on a cuboid behind (and in front of) them.
+		Eigen::MatrixXd points = random_points(num_points, BENCHMARK_RANDOM_SEED);
+		std::vector<MeshSamplePoint *> sample_points;
+		for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+		{
+			MyMesh::Point point(points(0, point_index), points(1, point_index), points(2, point_index));
+			sample_points.push_back(new MeshSamplePoint(point_index, 0, MyMesh::Point(0.0),
+				point, MyMesh::Normal(0.0, 0.0, 1.0)));
+		}
+
+		MeshCuboid *cuboid = create_cuboid(0, MyMesh::Point(0.0), MyMesh::Normal(0.6), 0.3);
+		cuboid->create_grid_points_on_cuboid_surface(num_points);
+
+		std::vector<MyMesh::Point> test_points;
+		for (unsigned int point_index = 0; point_index < cuboid->num_cuboid_surface_points(); ++point_index)
+			test_points.push_back(cuboid->get_cuboid_surface_point(point_index)->point_);
+
+		std::vector<Real> float_visibility_values, double_visibility_values;
+		MeshCuboid::compute_occlusion_visibility<float>(modelview_matrix,
+			_params.occlusion_test_neighbor_distance_, sample_points, test_points, NULL,
+			float_visibility_values);
+		MeshCuboid::compute_occlusion_visibility<double>(modelview_matrix,
+			_params.occlusion_test_neighbor_distance_, sample_points, test_points, NULL,
+			double_visibility_values);
+
+		// The difference of the visible point ratios.
+		const unsigned int num_test_points = test_points.size();
+		unsigned int num_mismatches = 0;
+		double sum_difference = 0.0;
+		for (unsigned int point_index = 0; point_index < num_test_points; ++point_index)
+		{
+			if (float_visibility_values[point_index] != double_visibility_values[point_index])
+				++num_mismatches;
+			sum_difference += (float_visibility_values[point_index] - double_visibility_values[point_index]);
+		}
+		const double max_difference = (num_test_points > 0) ?
+			std::abs(sum_difference) / num_test_points : 0.0;
+		is_passed &= report_precision_difference("visibility",
+			num_points, num_mismatches, num_test_points, max_difference);
+
+		delete cuboid;
+		for (std::vector<MeshSamplePoint *>::iterator jt = sample_points.begin();
+			jt != sample_points.end(); ++jt)
+			delete (*jt);
+	}
+
+	return is_passed;
+}
+
+bool benchmark_geometry_precision()
+{
+	std::cout << "Pipeline geometry precision: "
+		<< (sizeof(GeometryReal) == sizeof(float) ? "float" : "double") << std::endl;
+	std::cout << std::left << std::setw(44) << "Metric" << std::right
+		<< std::setw(10) << "Mism."
+		<< std::setw(10) << "Items"
+		<< std::setw(16) << "Max. diff."
+		<< std::setw(8) << "" << std::endl;
+	std::cout << std::string(88, '-') << std::endl;
+
+	MeshCuboidParameters params;
+
+	bool is_passed = true;
+	is_passed &= compare_closest_point_precision(params);
+	is_passed &= compare_visibility_precision(params);
+
+	if (!is_passed)
+	{
+		std::cerr << "Error: The float and double geometry kernels differ more than "
+			<< FLAGS_geometry_precision_tolerance << "." << std::endl;
+	}
+
+	return is_passed;
+}
+
+
+//-----------------------------------------------------------------------------
+// Kernel checks
+// NOTE:
+// Each check runs over '--check_kernels_num_cases' random cases, and the number of
+// failed cases is reported. Cuboid surfaces are sampled with
+// 'MeshCuboid::create_grid_points_on_cuboid_surface()', and the references are
+// computed from the signed point-to-cuboid distances of the samples.
+#define CHECK_KERNELS_NUM_CUBOID_SURFACE_POINTS	20000
+
+// Randomly rotated cuboid in [-0.5, 0.5]^3.
+MeshCuboid *random_rotated_cuboid(SimpleRandomCong_t &_rng, const LabelIndex _label_index)
+{
+	Eigen::Quaterniond rotation(random_real(_rng, -1.0, 1.0), random_real(_rng, -1.0, 1.0),
+		random_real(_rng, -1.0, 1.0), random_real(_rng, -1.0, 1.0));
+	rotation.normalize();
+	const Eigen::Matrix3d rotation_mat = rotation.toRotationMatrix();
+
+	std::array<MyMesh::Normal, 3> axes;
+	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+		for (unsigned int i = 0; i < 3; ++i)
+			axes[axis_index][i] = rotation_mat(i, axis_index);
+
+	MyMesh::Point center;
+	MyMesh::Normal size;
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		center[i] = random_real(_rng, -0.2, 0.2);
+		size[i] = random_real(_rng, 0.05, 0.5);
+	}
+
+	MeshCuboid *cuboid = new MeshCuboid(_label_index);
+	cuboid->set_bbox_center(center);
+	cuboid->set_bbox_axes(axes, false);
+	cuboid->set_bbox_size(size);
+	cuboid->create_grid_points_on_cuboid_surface(CHECK_KERNELS_NUM_CUBOID_SURFACE_POINTS);
+	return cuboid;
+}
+
+Eigen::MatrixXd get_cuboid_surface_point_matrix(const MeshCuboid *_cuboid)
+{
+	Eigen::MatrixXd points(3, _cuboid->num_cuboid_surface_points());
+	for (unsigned int point_index = 0; point_index < _cuboid->num_cuboid_surface_points(); ++point_index)
+		for (unsigned int i = 0; i < 3; ++i)
+			points(i, point_index) = _cuboid->get_cuboid_surface_point(point_index)->point_[i];
+	return points;
+}
+
+// Maximum distance between neighboring surface samples.
+Real get_cuboid_surface_sample_spacing(const MeshCuboid *_cuboid)
+{
+	Real area = 0;
+	for (unsigned int face_index = 0; face_index < MeshCuboid::k_num_faces; ++face_index)
+		area += _cuboid->get_bbox_face_area(face_index);
+	return 2.0 * std::sqrt(area / _cuboid->num_cuboid_surface_points());
+}
+
+bool report_check(const std::string &_name, const unsigned int _num_failures, const unsigned int _num_cases)
+{
+	const bool is_passed = (_num_failures == 0);
+	std::cout << std::left << std::setw(44) << _name << std::right
+		<< std::setw(10) << _num_failures
+		<< std::setw(10) << _num_cases
+		<< std::setw(8) << (is_passed ? "OK" : "FAIL")
+		<< std::endl;
+	return is_passed;
+}
+
+bool check_cuboid_distances()
+{
+	SimpleRandomCong_t rng;
+	simplerandom_cong_seed(&rng, BENCHMARK_RANDOM_SEED);
+
+	const unsigned int num_cases = FLAGS_check_kernels_num_cases;
+	unsigned int num_directed_failures = 0, num_symmetric_failures = 0;
+	unsigned int num_overlap_failures = 0, num_batch_failures = 0;
+
+	for (unsigned int case_index = 0; case_index < num_cases; ++case_index)
+	{
+		std::vector<MeshCuboid *> cuboids;
+		cuboids.push_back(random_rotated_cuboid(rng, 0));
+		cuboids.push_back(random_rotated_cuboid(rng, 1));
+		cuboids.push_back(random_rotated_cuboid(rng, 2));
+
+		// Reference: |signed distance| of each surface sample of 'j' to cuboid 'i'.
+		Eigen::MatrixXd sampled_distances = Eigen::MatrixXd::Zero(3, 3);
+		Eigen::MatrixXd min_signed_distances = Eigen::MatrixXd::Zero(3, 3);
+		for (unsigned int i = 0; i < 3; ++i)
+		{
+			for (unsigned int j = 0; j < 3; ++j)
+			{
+				if (i == j) continue;
+				Eigen::VectorXd signed_distances;
+				cuboids[i]->points_to_cuboid_distances(
+					get_cuboid_surface_point_matrix(cuboids[j]), signed_distances);
+				sampled_distances(i, j) = signed_distances.cwiseAbs().maxCoeff();
+				min_signed_distances(i, j) = signed_distances.minCoeff();
+			}
+		}
+
+		// The analytic distance is not less than the sampled one, and greater at most by the spacing.
+		const Real spacing = std::max(get_cuboid_surface_sample_spacing(cuboids[0]),
+			get_cuboid_surface_sample_spacing(cuboids[1]));
+		const Real directed_distance = MeshCuboid::distance_between_cuboids(cuboids[0], cuboids[1]);
+		if (directed_distance < sampled_distances(0, 1) - 1.0E-9
+			|| directed_distance > sampled_distances(0, 1) + spacing)
+			++num_directed_failures;
+
+		const Real symmetric_distance = MeshCuboid::distance_between_cuboids(cuboids[0], cuboids[1], true);
+		const Real sampled_symmetric_distance = std::max(sampled_distances(0, 1), sampled_distances(1, 0));
+		if (symmetric_distance < sampled_symmetric_distance - 1.0E-9
+			|| symmetric_distance > sampled_symmetric_distance + spacing)
+			++num_symmetric_failures;
+
+		// Solid cuboids intersect if and only if a surface sample of one is inside the other
+		// (up to the spacing when they are close).
+		const bool is_overlapping = MeshCuboid::are_cuboids_overlapping(cuboids[0], cuboids[1]);
+		const bool is_sample_inside = (min_signed_distances(0, 1) <= 0 || min_signed_distances(1, 0) <= 0);
+		const bool is_close = (std::min(min_signed_distances(0, 1), min_signed_distances(1, 0)) <= spacing);
+		if ((is_sample_inside && !is_overlapping) || (is_overlapping && !is_close))
+			++num_overlap_failures;
+
+		// The batched distances are the same with the pairwise ones.
+		for (int is_symmetric = 0; is_symmetric <= 1; ++is_symmetric)
+		{
+			Eigen::MatrixXd batch_distances;
+			MeshCuboid::distances_between_cuboids(cuboids, batch_distances, is_symmetric != 0);
+
+			bool is_same = (batch_distances.rows() == 3 && batch_distances.cols() == 3);
+			for (unsigned int i = 0; is_same && i < 3; ++i)
+			{
+				for (unsigned int j = 0; j < 3; ++j)
+				{
+					const Real distance = (i == j) ? 0.0 :
+						MeshCuboid::distance_between_cuboids(cuboids[i], cuboids[j], is_symmetric != 0);
+					if (std::abs(batch_distances(i, j) - distance) > 1.0E-12)
+						is_same = false;
+				}
+			}
+			if (!is_same) ++num_batch_failures;
+		}
+
+		for (std::vector<MeshCuboid *>::iterator it = cuboids.begin(); it != cuboids.end(); ++it)
+			delete (*it);
+	}
+
+	bool is_passed = true;
+	is_passed &= report_check("distance_between_cuboids", num_directed_failures, num_cases);
+	is_passed &= report_check("distance_between_cuboids/symmetric", num_symmetric_failures, num_cases);
+	is_passed &= report_check("are_cuboids_overlapping", num_overlap_failures, num_cases);
+	is_passed &= report_check("distances_between_cuboids", num_batch_failures, 2 * num_cases);
+	return is_passed;
+}
+
+// Signed distance from a point to a cuboid, computed directly from the cuboid parameters.
+Real reference_point_to_cuboid_distance(const Eigen::Vector3d &_point, const MeshCuboid *_cuboid)
+{
+	const MyMesh::Point center = _cuboid->get_bbox_center();
+	const std::array<MyMesh::Normal, 3> axes = _cuboid->get_bbox_axes();
+	const MyMesh::Normal size = _cuboid->get_bbox_size();
+
+	Real outside_distance = 0, max_axis_distance = -std::numeric_limits<Real>::max();
+	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+	{
+		const MyMesh::Normal axis = axes[axis_index].normalized();
+		Real local_coord = 0;
+		for (unsigned int i = 0; i < 3; ++i)
+			local_coord += axis[i] * (_point[i] - center[i]);
+
+		const Real axis_distance = std::abs(local_coord) - 0.5 * std::abs(size[axis_index]);
+		outside_distance += std::pow(std::max(axis_distance, 0.0), 2);
+		max_axis_distance = std::max(max_axis_distance, axis_distance);
+	}
+
+	return (max_axis_distance > 0) ? std::sqrt(outside_distance) : max_axis_distance;
+}
+
+bool check_point_cuboid_distances()
+{
+	SimpleRandomCong_t rng;
+	simplerandom_cong_seed(&rng, BENCHMARK_RANDOM_SEED);
+
+	const unsigned int num_cases = FLAGS_check_kernels_num_cases;
+	unsigned int num_single_failures = 0, num_batch_failures = 0, num_nearest_failures = 0;
+
+	for (unsigned int case_index = 0; case_index < num_cases; ++case_index)
+	{
+		// NOTE:
+		// The numbers of points are not multiples of the kernel block size in general,
+		// and some cases have no cuboid.
+		const unsigned int num_cuboids = case_index % 5;
+		const unsigned int num_points = 1 + static_cast<unsigned int>(random_real(rng, 0.0, 300.0));
+
+		std::vector<MeshCuboid *> cuboids;
+		for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+			cuboids.push_back(random_rotated_cuboid(rng, cuboid_index));
+
+		Eigen::MatrixXd points(3, num_points);
+		for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+			for (unsigned int i = 0; i < 3; ++i)
+				points(i, point_index) = random_real(rng, -0.5, 0.5);
+
+		// The single cuboid distances are the same with the reference.
+		Eigen::MatrixXd single_distances(num_points, num_cuboids);
+		bool is_single_same = true;
+		for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+		{
+			Eigen::VectorXd distances;
+			cuboids[cuboid_index]->points_to_cuboid_distances(points, distances);
+			if (distances.size() != num_points)
+			{
+				is_single_same = false;
+				break;
+			}
+			single_distances.col(cuboid_index) = distances;
+
+			for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+			{
+				const Real distance = reference_point_to_cuboid_distance(
+					points.col(point_index), cuboids[cuboid_index]);
+				if (std::abs(distances[point_index] - distance) > 1.0E-9)
+					is_single_same = false;
+			}
+		}
+		if (!is_single_same)
+		{
+			++num_single_failures;
+			for (std::vector<MeshCuboid *>::iterator it = cuboids.begin(); it != cuboids.end(); ++it)
+				delete (*it);
+			continue;
+		}
+
+		// The batched distances are the same with the single cuboid ones.
+		Eigen::MatrixXd batch_distances;
+		MeshCuboid::points_to_cuboids_distances(points, cuboids, batch_distances);
+		if (batch_distances.rows() != num_points || batch_distances.cols() != num_cuboids
+			|| batch_distances != single_distances)
+			++num_batch_failures;
+
+		// The nearest cuboid is the first one of the minimum distance.
+		std::vector<int> nearest_cuboid_indices;
+		Eigen::VectorXd nearest_distances;
+		MeshCuboid::points_to_nearest_cuboids(points, cuboids, nearest_cuboid_indices, nearest_distances);
+		bool is_nearest_same = (nearest_cuboid_indices.size() == num_points
+			&& nearest_distances.size() == num_points);
+		for (unsigned int point_index = 0; is_nearest_same && point_index < num_points; ++point_index)
+		{
+			int nearest_cuboid_index = -1;
+			Real nearest_distance = std::numeric_limits<Real>::max();
+			for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+			{
+				if (single_distances(point_index, cuboid_index) < nearest_distance)
+				{
+					nearest_cuboid_index = cuboid_index;
+					nearest_distance = single_distances(point_index, cuboid_index);
+				}
+			}
+
+			if (nearest_cuboid_indices[point_index] != nearest_cuboid_index
+				|| nearest_distances[point_index] != nearest_distance)
+				is_nearest_same = false;
+		}
+		if (!is_nearest_same) ++num_nearest_failures;
+
+		for (std::vector<MeshCuboid *>::iterator it = cuboids.begin(); it != cuboids.end(); ++it)
+			delete (*it);
+	}
+
+	bool is_passed = true;
+	is_passed &= report_check("points_to_cuboid_distances", num_single_failures, num_cases);
+	is_passed &= report_check("points_to_cuboids_distances", num_batch_failures, num_cases);
+	is_passed &= report_check("points_to_nearest_cuboids", num_nearest_failures, num_cases);
+	return is_passed;
+}
+
+bool check_kernels()
+{
+	std::cout << std::left << std::setw(44) << "Check" << std::right
+		<< std::setw(10) << "Failures"
+		<< std::setw(10) << "Cases"
+		<< std::setw(8) << "" << std::endl;
+	std::cout << std::string(72, '-') << std::endl;
+
+	bool is_passed = true;
+	is_passed &= check_cuboid_distances();
+	is_passed &= check_point_cuboid_distances();
+	return is_passed;
+}
+
+
+//-----------------------------------------------------------------------------
+// Throughput benchmark
+// NOTE:
+// The whole structure completion ('StructureCompletion::complete()') runs for
+// synthetic inputs with 1, 2, 4, ... worker processes, where each process completes
+// one input at a time. Workers are processes rather than threads since the pipeline
+// uses ANN kd-tree searches, which are not reentrant.
+// The model is trained with synthetic objects written in '--throughput_data_path'.
+struct ThroughputInput
+{
+	std::string name_;
+	Eigen::MatrixXd points_;
+	Eigen::MatrixXd normals_;
+	Eigen::MatrixXd point_label_confidences_;
+	Real modelview_matrix_[16];
+};
+
+struct ThroughputResult
+{
+	unsigned int num_processes_;
+	unsigned int num_completed_inputs_;
+	double elapsed_seconds_;
+	double inputs_per_hour_;
+	double scaling_efficiency_;
+	double latency_p50_;
+	double latency_p95_;
+	double latency_p99_;
+	// Largest peak resident set size among the worker processes of the run.
+	double peak_rss_mb_;
+	std::map<std::string, TraceRecorder::StageSummary> stage_summaries_;
+};
+
+#ifndef _WIN32
+// 'ru_maxrss' of 'struct rusage' in MB.
+// NOTE:
+// The peak of a worker process includes the pages shared with this process after 'fork()'.
+double get_rss_mb(const long _max_rss)
+{
+#if defined(__APPLE__)
+	// Bytes on macOS.
+	return _max_rss / (1024.0 * 1024.0);
+#else
+	// Kilobytes on Linux.
+	return _max_rss / 1024.0;
+#endif
+}
+#endif
+
+// Nearest-rank percentile of sorted values.
+double get_percentile(const std::vector<double> &_sorted_values, const double _percent)
+{
+	if (_sorted_values.empty()) return 0.0;
+	const size_t rank = static_cast<size_t>(std::ceil(_percent / 100.0 * _sorted_values.size()));
+	return _sorted_values[std::min(std::max(rank, static_cast<size_t>(1)), _sorted_values.size()) - 1];
+}
+
+bool create_throughput_inputs(const SyntheticDataset::Category &_category,
+	const uint32_t _seed, std::vector<ThroughputInput> &_inputs)
+{
+	SimpleRandomCong_t rng;
+	simplerandom_cong_seed(&rng, _seed);
+
+	_inputs.clear();
+	_inputs.resize(FLAGS_throughput_num_inputs);
+
+	for (unsigned int input_index = 0; input_index < _inputs.size(); ++input_index)
+	{
+		ThroughputInput &input = _inputs[input_index];
+
+		std::stringstream name_sstr;
+		name_sstr << _category.name_ << "_test_" << input_index;
+		input.name_ = name_sstr.str();
+
+		// NOTE:
+		// Test objects are different from the training objects.
+		const unsigned int object_seed = simplerandom_cong_next(&rng);
+		SyntheticDataset::Object object;
+		SyntheticDataset::generate_object(_category, input.name_, object_seed, object);
+
+		std::vector<MyMesh::Point> vertices;
+		std::vector< std::array<VertexIndex, 3> > faces;
+		std::vector<Label> face_labels;
+		SyntheticDataset::get_mesh(object, vertices, faces, face_labels);
+
+		std::vector<SyntheticDataset::SamplePoint> sample_points, visible_sample_points;
+		SyntheticDataset::sample_points(vertices, faces, FLAGS_throughput_num_sample_points,
+			object_seed + 1, sample_points);
+
+		const Real azimuth = FLAGS_throughput_fixed_inputs ?
+			SYNTHETIC_DATASET_AZIMUTH_DEGREES : random_real(rng, -180.0, 180.0);
+		SyntheticDataset::get_modelview_matrix(azimuth, SYNTHETIC_DATASET_ELEVATION_DEGREES,
+			input.modelview_matrix_);
+		SyntheticDataset::get_visible_sample_points(sample_points, input.modelview_matrix_,
+			visible_sample_points);
+
+		const unsigned int num_points = visible_sample_points.size();
+		if (num_points == 0)
+		{
+			std::cerr << "Error: No visible point (" << input.name_ << ")." << std::endl;
+			return false;
+		}
+
+		input.points_.resize(3, num_points);
+		input.normals_.resize(3, num_points);
+		for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+		{
+			for (unsigned int i = 0; i < 3; ++i)
+			{
+				input.points_(i, point_index) = visible_sample_points[point_index].point_[i];
+				input.normals_(i, point_index) = visible_sample_points[point_index].normal_[i];
+			}
+		}
+
+		SyntheticDataset::get_label_confidences(visible_sample_points, face_labels,
+			_category.label_names_.size(), FLAGS_throughput_label_noise, object_seed + 3,
+			input.point_label_confidences_);
+	}
+
+	return true;
+}
+
+// Complete the inputs of '_input_indices', and write the completed inputs, their latencies
+// and the stage summaries to '_stream'.
+void run_throughput_worker(const StructureCompletion &_structure_completion,
+	const std::vector<ThroughputInput> &_inputs, const std::vector<unsigned int> &_input_indices,
+	std::ostream &_stream)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const MeshCuboidParameters params;
+	std::vector< std::pair<unsigned int, double> > latencies;
+	std::vector<unsigned int> completed_input_indices;
+
+	TraceRecorder::start();
+	{
+		QuietOutput quiet;
+
+		for (std::vector<unsigned int>::const_iterator it = _input_indices.begin();
+			it != _input_indices.end(); ++it)
+		{
+			const ThroughputInput &input = _inputs[*it];
+			std::vector<StructureCompletion::Result> results;
+
+			const Clock::time_point input_start_time = Clock::now();
+			if (_structure_completion.complete(input.points_, input.normals_,
+				input.point_label_confidences_, input.modelview_matrix_, params, results))
+				completed_input_indices.push_back(*it);
+			latencies.push_back(std::make_pair(*it, std::chrono::duration<double>(
+				Clock::now() - input_start_time).count()));
+		}
+	}
+
+	std::map<std::string, TraceRecorder::StageSummary> stage_summaries;
+	TraceRecorder::get_stage_summaries(stage_summaries);
+	TraceRecorder::stop();
+
+	BinaryIO::write(_stream, completed_input_indices);
+	BinaryIO::write(_stream, latencies);
+	BinaryIO::write(_stream, static_cast<uint64_t>(stage_summaries.size()));
+	for (std::map<std::string, TraceRecorder::StageSummary>::const_iterator it = stage_summaries.begin();
+		it != stage_summaries.end(); ++it)
+	{
+		BinaryIO::write(_stream, it->first);
+		BinaryIO::write(_stream, it->second.count_);
+		BinaryIO::write(_stream, it->second.total_duration_);
+	}
+}
+
+// Read the output of 'run_throughput_worker()', and add it to '_result'.
+bool read_throughput_worker_result(std::istream &_stream,
+	std::vector<double> &_latencies, ThroughputResult &_result)
+{
+	std::vector<unsigned int> completed_input_indices;
+	std::vector< std::pair<unsigned int, double> > latencies;
+	uint64_t num_stages = 0;
+
+	bool ret = BinaryIO::read(_stream, completed_input_indices);
+	ret = ret && BinaryIO::read(_stream, latencies);
+	ret = ret && BinaryIO::read(_stream, num_stages);
+
+	for (uint64_t i = 0; ret && i < num_stages; ++i)
+	{
+		std::string name;
+		TraceRecorder::StageSummary summary;
+		ret = ret && BinaryIO::read(_stream, name);
+		ret = ret && BinaryIO::read(_stream, summary.count_);
+		ret = ret && BinaryIO::read(_stream, summary.total_duration_);
+		if (!ret) break;
+
+		std::map<std::string, TraceRecorder::StageSummary>::iterator it = _result.stage_summaries_.find(name);
+		if (it == _result.stage_summaries_.end())
+		{
+			_result.stage_summaries_[name] = summary;
+		}
+		else
+		{
+			it->second.count_ += summary.count_;
+			it->second.total_duration_ += summary.total_duration_;
+		}
+	}
+
+	if (!ret) return false;
+
+	_result.num_completed_inputs_ += completed_input_indices.size();
+	for (std::vector< std::pair<unsigned int, double> >::const_iterator it = latencies.begin();
+		it != latencies.end(); ++it)
+		_latencies.push_back(it->second);
+	return true;
+}
+
+void run_throughput(const StructureCompletion &_structure_completion,
+	const std::vector<ThroughputInput> &_inputs, const unsigned int _num_processes,
+	ThroughputResult &_result)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// NOTE:
+	// Inputs are distributed to the worker processes in a round-robin manner.
+	std::vector< std::vector<unsigned int> > process_input_indices(_num_processes);
+	for (unsigned int input_index = 0; input_index < _inputs.size(); ++input_index)
+		process_input_indices[input_index % _num_processes].push_back(input_index);
+
+	std::vector<double> latencies;
+	_result.num_processes_ = _num_processes;
+	_result.num_completed_inputs_ = 0;
+	_result.peak_rss_mb_ = 0.0;
+	_result.stage_summaries_.clear();
+
+	const Clock::time_point start_time = Clock::now();
+#ifdef _WIN32
+	// NOTE:
+	// Worker processes are not supported on Windows, and the inputs are completed in this process.
+	// The peak memory is not measured.
+	assert(_num_processes == 1);
+	std::stringstream stream;
+	run_throughput_worker(_structure_completion, _inputs, process_input_indices[0], stream);
+	if (!read_throughput_worker_result(stream, latencies, _result))
+		std::cerr << "Error: Invalid output of the worker." << std::endl;
+#else
+	std::vector<pid_t> process_ids(_num_processes, -1);
+	std::vector<int> process_fds(_num_processes, -1);
+
+	for (unsigned int process_index = 0; process_index < _num_processes; ++process_index)
+	{
+		int fds[2];
+		if (pipe(fds) != 0)
+		{
+			std::cerr << "Error: Cannot create a pipe." << std::endl;
+			break;
+		}
+
+		// NOTE:
+		// The output streams are flushed so that buffered text is not written twice.
+		std::cout.flush();
+		std::cerr.flush();
+
+		const pid_t process_id = fork();
+		if (process_id == 0)
+		{
+			close(fds[0]);
+			std::ostringstream stream;
+			run_throughput_worker(_structure_completion, _inputs, process_input_indices[process_index], stream);
+
+			const std::string buffer = stream.str();
+			for (size_t offset = 0; offset < buffer.size();)
+			{
+				const ssize_t size = write(fds[1], buffer.data() + offset, buffer.size() - offset);
+				if (size <= 0) _exit(EXIT_FAILURE);
+				offset += size;
+			}
+			close(fds[1]);
+			_exit(EXIT_SUCCESS);
+		}
+
+		close(fds[1]);
+		if (process_id < 0)
+		{
+			std::cerr << "Error: Cannot create a worker process." << std::endl;
+			close(fds[0]);
+			break;
+		}
+
+		process_ids[process_index] = process_id;
+		process_fds[process_index] = fds[0];
+	}
+
+	for (unsigned int process_index = 0; process_index < _num_processes; ++process_index)
+	{
+		if (process_ids[process_index] < 0) continue;
+
+		std::string buffer;
+		char chunk[4096];
+		for (ssize_t size; (size = read(process_fds[process_index], chunk, sizeof(chunk))) > 0;)
+			buffer.append(chunk, size);
+		close(process_fds[process_index]);
+
+		// NOTE:
+		// 'wait4()' returns the resource usage of the worker process only,
+		// and thus the peak memory is measured for each run.
+		int status = 0;
+		struct rusage usage;
+		if (wait4(process_ids[process_index], &status, 0, &usage) < 0
+			|| !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+		{
+			std::cerr << "Error: A worker process failed." << std::endl;
+			continue;
+		}
+		_result.peak_rss_mb_ = std::max(_result.peak_rss_mb_, get_rss_mb(usage.ru_maxrss));
+
+		std::istringstream stream(buffer);
+		if (!read_throughput_worker_result(stream, latencies, _result))
+			std::cerr << "Error: Invalid output of a worker process." << std::endl;
+	}
+#endif
+	const Clock::time_point end_time = Clock::now();
+
+	std::sort(latencies.begin(), latencies.end());
+
+	_result.elapsed_seconds_ = std::chrono::duration<double>(end_time - start_time).count();
+	_result.inputs_per_hour_ = 3600.0 * _inputs.size() / _result.elapsed_seconds_;
+	_result.scaling_efficiency_ = 1.0;
+	_result.latency_p50_ = get_percentile(latencies, 50);
+	_result.latency_p95_ = get_percentile(latencies, 95);
+	_result.latency_p99_ = get_percentile(latencies, 99);
+}
+
+bool write_throughput_results(const std::string &_filename, const unsigned int _num_inputs,
+	const uint32_t _seed, const std::vector<ThroughputResult> &_results)
+{
+	std::ofstream file(_filename.c_str());
+	if (!file.is_open())
+	{
+		std::cerr << "Error: Cannot save the benchmark results (" << _filename << ")." << std::endl;
+		return false;
+	}
+
+	file << std::setprecision(12);
+	file << "{\n\"category\":\"" << FLAGS_throughput_category << "\""
+		<< ",\n\"num_inputs\":" << _num_inputs
+		<< ",\n\"num_sample_points\":" << FLAGS_throughput_num_sample_points
+		<< ",\n\"fixed_inputs\":" << (FLAGS_throughput_fixed_inputs ? "true" : "false")
+		<< ",\n\"seed\":" << _seed
+		<< ",\n\"runs\":[";
+
+	for (std::vector<ThroughputResult>::const_iterator it = _results.begin(); it != _results.end(); ++it)
+	{
+		if (it != _results.begin()) file << ",";
+		file << "\n{\"processes\":" << it->num_processes_
+			<< ",\"completed_inputs\":" << it->num_completed_inputs_
+			<< ",\"elapsed_seconds\":" << it->elapsed_seconds_
+			<< ",\"meshes_per_hour\":" << it->inputs_per_hour_
+			<< ",\"scaling_efficiency\":" << it->scaling_efficiency_
+			<< ",\"latency_seconds\":{\"p50\":" << it->latency_p50_
+			<< ",\"p95\":" << it->latency_p95_
+			<< ",\"p99\":" << it->latency_p99_ << "}"
+			<< ",\"peak_rss_mb\":" << it->peak_rss_mb_
+			<< ",\"stages\":{";
+
+		for (std::map<std::string, TraceRecorder::StageSummary>::const_iterator jt = it->stage_summaries_.begin();
+			jt != it->stage_summaries_.end(); ++jt)
+		{
+			if (jt != it->stage_summaries_.begin()) file << ",";
+			file << "\"" << jt->first << "\":{\"count\":" << jt->second.count_
+				<< ",\"seconds\":" << 1.0E-6 * jt->second.total_duration_ << "}";
+		}
+		file << "}}";
+	}
+
+	file << "\n]\n}\n";
+	file.close();
+	return true;
+}
+
+bool benchmark_throughput()
+{
+	SyntheticDataset::Category category;
+	if (!SyntheticDataset::get_category(FLAGS_throughput_category, category))
+	{
+		std::cerr << "Error: Unknown category (" << FLAGS_throughput_category << ")." << std::endl;
+		return false;
+	}
+
+	if (FLAGS_throughput_num_inputs <= 0 || FLAGS_throughput_num_sample_points <= 0)
+	{
+		std::cerr << "Error: The number of inputs and sample points must be positive." << std::endl;
+		return false;
+	}
+
+	// NOTE:
+	// With '--throughput_fixed_inputs', all inputs are generated with the fixed seed
+	// and seen from the fixed pose so that results of different commits are comparable.
+	const uint32_t seed = FLAGS_throughput_fixed_inputs ? BENCHMARK_RANDOM_SEED :
+		static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count());
+
+	SyntheticDataset::Options options;
+	options.output_path_ = FLAGS_throughput_data_path;
+	options.category_names_ = std::vector<std::string>(1, category.name_);
+	options.num_objects_ = FLAGS_throughput_num_training_objects;
+	options.num_sample_points_ = FLAGS_throughput_num_sample_points;
+	options.num_dense_sample_points_ = FLAGS_throughput_num_sample_points;
+	options.label_noise_ = FLAGS_throughput_label_noise;
+	options.seed_ = BENCHMARK_RANDOM_SEED;
+	options.training_dir_ = FLAGS_training_dir;
+	options.label_info_filename_ = FLAGS_label_info_filename;
+	options.label_symmetry_info_filename_ = FLAGS_label_symmetry_info_filename;
+	options.symmetry_group_info_filename_ = FLAGS_symmetry_group_info_filename;
+	options.pose_filename_ = FLAGS_pose_filename;
+	options.object_list_filename_ = FLAGS_object_list_filename;
+	options.feature_filename_prefix_ = FLAGS_feature_filename_prefix;
+	options.transformation_filename_prefix_ = FLAGS_transformation_filename_prefix;
+	options.joint_normal_relation_filename_prefix_ = FLAGS_joint_normal_relation_filename_prefix;
+	options.batch_job_manifest_filename_ = FLAGS_batch_job_manifest_filename;
+
+	StructureCompletion structure_completion;
+	{
+		QuietOutput quiet;
+		if (!SyntheticDataset::generate_dataset(options, false))
+			return false;
+
+		const std::string experiment_path = FLAGS_throughput_data_path + "/experiments/" + category.name_ + "/";
+		if (!structure_completion.load_model(FLAGS_throughput_data_path + "/data/0_body/" + category.name_ + "/",
+			experiment_path + FLAGS_training_dir, false))
+			return false;
+	}
+
+	std::vector<ThroughputInput> inputs;
+	if (!create_throughput_inputs(category, seed, inputs))
+		return false;
+
+	unsigned int max_num_processes = FLAGS_throughput_max_processes;
+	if (max_num_processes == 0)
+		max_num_processes = std::max(std::thread::hardware_concurrency(), 1u);
+#ifdef _WIN32
+	if (max_num_processes > 1)
+	{
+		std::cerr << "Warning: Worker processes are not supported on Windows. Use a single process." << std::endl;
+		max_num_processes = 1;
+	}
+#endif
+
+	std::vector<unsigned int> process_counts;
+	for (unsigned int num_processes = 1; num_processes < max_num_processes; num_processes *= 2)
+		process_counts.push_back(num_processes);
+	process_counts.push_back(max_num_processes);
+
+	std::cout << "Throughput: " << inputs.size() << " " << category.name_ << " inputs, seed = " << seed
+		<< (FLAGS_throughput_fixed_inputs ? " (fixed inputs)" : "") << std::endl;
+	std::cout << std::right
+		<< std::setw(10) << "Processes"
+		<< std::setw(14) << "meshes/h"
+		<< std::setw(12) << "p50 (s)"
+		<< std::setw(12) << "p95 (s)"
+		<< std::setw(12) << "p99 (s)"
+		<< std::setw(12) << "RSS (MB)"
+		<< std::setw(12) << "Efficiency" << std::endl;
+	std::cout << std::string(84, '-') << std::endl;
+
+	std::vector<ThroughputResult> results;
+	for (std::vector<unsigned int>::const_iterator it = process_counts.begin(); it != process_counts.end(); ++it)
+	{
+		results.push_back(ThroughputResult());
+		ThroughputResult &result = results.back();
+		run_throughput(structure_completion, inputs, (*it), result);
+		result.scaling_efficiency_ = result.inputs_per_hour_ /
+			(result.num_processes_ * results.front().inputs_per_hour_);
+
+		std::cout << std::setw(10) << result.num_processes_
+			<< std::fixed << std::setprecision(1)
+			<< std::setw(14) << result.inputs_per_hour_
+			<< std::setprecision(3)
+			<< std::setw(12) << result.latency_p50_
+			<< std::setw(12) << result.latency_p95_
+			<< std::setw(12) << result.latency_p99_
+			<< std::setprecision(1)
+			<< std::setw(12) << result.peak_rss_mb_
+			<< std::setprecision(2)
+			<< std::setw(12) << result.scaling_efficiency_ << std::endl;
+		std::cout.unsetf(std::ios::floatfield);
+	}
+
+	// Per-stage breakdown of the last run (seconds per input).
+	const ThroughputResult &last_result = results.back();
+	std::cout << std::endl << "Stages (" << last_result.num_processes_ << " processes):" << std::endl;
+	for (std::map<std::string, TraceRecorder::StageSummary>::const_iterator it = last_result.stage_summaries_.begin();
+		it != last_result.stage_summaries_.end(); ++it)
+	{
+		std::cout << std::left << std::setw(44) << it->first << std::right
+			<< std::setw(10) << it->second.count_
+			<< std::setw(14) << std::fixed << std::setprecision(4)
+			<< 1.0E-6 * it->second.total_duration_ / inputs.size() << " s/mesh" << std::endl;
+		std::cout.unsetf(std::ios::floatfield);
+	}
+
+	if (!FLAGS_throughput_output.empty())
+	{
+		if (!write_throughput_results(FLAGS_throughput_output, inputs.size(), seed, results))
+			return false;
+		std::cout << "Saved '" << FLAGS_throughput_output << "'." << std::endl;
+	}
+
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Main function
+int main(int argc, char** argv)
+{
+	gflags::SetUsageMessage("Microbenchmarks of the pipeline kernels.");
+	gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+	if (FLAGS_throughput)
+		return benchmark_throughput() ? 0 : -1;
+
+	if (FLAGS_geometry_precision)
+		return benchmark_geometry_precision() ? 0 : -1;
+
+	if (FLAGS_check_kernels)
+		return check_kernels() ? 0 : -1;
+
+	std::cout << std::left << std::setw(44) << "Benchmark" << std::right
+		<< std::setw(10) << "Iter."
+		<< std::setw(16) << "ns/op"
+		<< std::setw(16) << "items/s"
+		<< std::setw(14) << "allocs/op" << std::endl;
+	std::cout << std::string(100, '-') << std::endl;
+
+	benchmark_cuboid_surface_point_visibility();
+	benchmark_points_to_cuboid_distances();
+	benchmark_points_to_nearest_cuboids();
+	benchmark_label_confidence_table();
+	benchmark_icp_get_closest_points();
+	benchmark_icp_run_iterative_closest_points();
+	benchmark_joint_normal_relations_compute_error();
+	benchmark_solve_markov_random_field();
+	benchmark_segment_sample_points();
+	benchmark_nlp_expression();
+	benchmark_voxel_grid_get_distance_map();
+	benchmark_detect_reflectional_symmetry();
+
+	if (!FLAGS_benchmark_output.empty())
+	{
+		if (!write_results(FLAGS_benchmark_output))
+			return -1;
+		std::cout << "Saved '" << FLAGS_benchmark_output << "'." << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,80 @@
+// dataset_generator.cpp
+// Procedural synthetic dataset generator.
+//
+// Writes cuboid-assembly objects (meshes, face labels, sample points and simulated
+// sample point labels), label and symmetry information files, and training files of each category
+// in the same layout with the shape2pose data. The pipeline runs in 'experiments/<category>/'
+// with '--flagfile=arguments.txt', which contains the data path flags.
+
+//-----------------------------------------------------------------------------
+// Includes
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "MeshCuboidParameters.h"
+#include "SyntheticDataset.h"
+
+
+//-----------------------------------------------------------------------------
+// Flags
+DEFINE_string(synthetic_output_path, "synthetic", "Output directory of the generated dataset.");
+DEFINE_string(synthetic_categories, "chair,table,swivel_chair", "Comma-separated category names.");
+DEFINE_int32(synthetic_num_objects, 20, "Number of objects of each category.");
+DEFINE_int32(synthetic_num_sample_points, 1000, "Number of sample points of each object.");
+DEFINE_int32(synthetic_num_dense_sample_points, 10000, "Number of dense sample points of each object.");
+DEFINE_double(synthetic_label_noise, 0.1, "Probability of a wrong label prediction of a sample point.");
+DEFINE_int32(synthetic_seed, SYNTHETIC_DATASET_RANDOM_SEED, "Random seed.");
+
+
+//-----------------------------------------------------------------------------
+// Main
+int main(int argc, char** argv)
+{
+	gflags::SetUsageMessage("Procedural synthetic dataset generator.");
+	gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+	if (FLAGS_synthetic_num_objects <= 0 || FLAGS_synthetic_num_sample_points <= 0
+		|| FLAGS_synthetic_num_dense_sample_points <= 0)
+	{
+		std::cerr << "Error: The number of objects and sample points must be positive." << std::endl;
+		return -1;
+	}
+
+	SyntheticDataset::Options options;
+	options.output_path_ = FLAGS_synthetic_output_path;
+	options.num_objects_ = FLAGS_synthetic_num_objects;
+	options.num_sample_points_ = FLAGS_synthetic_num_sample_points;
+	options.num_dense_sample_points_ = FLAGS_synthetic_num_dense_sample_points;
+	options.label_noise_ = FLAGS_synthetic_label_noise;
+	options.seed_ = static_cast<unsigned int>(FLAGS_synthetic_seed);
+
+	// The pipeline reads the files with these names.
+	options.training_dir_ = FLAGS_training_dir;
+	options.label_info_filename_ = FLAGS_label_info_filename;
+	options.label_symmetry_info_filename_ = FLAGS_label_symmetry_info_filename;
+	options.symmetry_group_info_filename_ = FLAGS_symmetry_group_info_filename;
+	options.pose_filename_ = FLAGS_pose_filename;
+	options.object_list_filename_ = FLAGS_object_list_filename;
+	options.feature_filename_prefix_ = FLAGS_feature_filename_prefix;
+	options.transformation_filename_prefix_ = FLAGS_transformation_filename_prefix;
+	options.joint_normal_relation_filename_prefix_ = FLAGS_joint_normal_relation_filename_prefix;
+	options.batch_job_manifest_filename_ = FLAGS_batch_job_manifest_filename;
+
+	options.category_names_.clear();
+	std::stringstream category_names_sstr(FLAGS_synthetic_categories);
+	std::string category_name;
+	while (std::getline(category_names_sstr, category_name, ','))
+	{
+		if (!category_name.empty())
+			options.category_names_.push_back(category_name);
+	}
+
+	if (!SyntheticDataset::generate_dataset(options))
+		return -1;
+
+	return 0;
+}
@@ -6,6 +6,7 @@
 #include "GL/glu.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <cassert>
 #include <vector>
 #include <string>
 
@@ -13,6 +14,7 @@
 #include <QImage>
 
 #include "MeshViewerCore.h"
+#include "SnapshotWriter.h"
 
 
 //-----------------------------------------------------------------------------
@@ -23,11 +25,16 @@ static int g_Width = 640;
 static int g_Height = 480;
 std::string g_DrawMode = "Solid Smooth";
 
+SnapshotWriter *g_SnapshotWriter = NULL;
+SnapshotWriter::Encoder g_SnapshotEncoder = NULL;
+std::string g_SnapshotExtension;
+
 
 //-----------------------------------------------------------------------------
 // Function definitions
 void display(void);
 void snapshot(const std::string filename);
+void close_snapshot_writer();
 
 
 //-----------------------------------------------------------------------------
@@ -227,83 +234,76 @@ void display(void)
 	glFinish();
 }
 
-void snapshot(const std::string filename)
+bool write_png(const std::string &filename, const SnapshotImage &image)
 {
-	//// Save binary image
-	//const int binary = 1;
-
-	//FILE *f = fopen((filename + std::string(".ppm")).c_str(), "w");
-	//if (f) {
-	//	int i, x, y;
-	//	const GLubyte *ptr = static_cast<GLubyte *>(g_Buffer);
-	//	if (binary) {
-	//		fprintf(f, "P6\n");
-	//		fprintf(f, "# ppm-file created by osdemo.c\n");
-	//		fprintf(f, "%i %i\n", g_Width, g_Height);
-	//		fprintf(f, "255\n");
-	//		fclose(f);
-	//		f = fopen((filename + std::string(".ppm")).c_str(), "ab");  /* reopen in binary append mode */
-	//		for (y = g_Height - 1; y >= 0; y--) {
-	//			for (x = 0; x < g_Width; x++) {
-	//				i = (y*g_Width + x) * 4;
-	//				fputc(ptr[i], f);   /* write red */
-	//				fputc(ptr[i + 1], f); /* write green */
-	//				fputc(ptr[i + 2], f); /* write blue */
-	//			}
-	//		}
-	//	}
-	//	else {
-	//		/*ASCII*/
-	//		int counter = 0;
-	//		fprintf(f, "P3\n");
-	//		fprintf(f, "# ascii ppm file created by osdemo.c\n");
-	//		fprintf(f, "%i %i\n", g_Width, g_Height);
-	//		fprintf(f, "255\n");
-	//		for (y = g_Height - 1; y >= 0; y--) {
-	//			for (x = 0; x < g_Width; x++) {
-	//				i = (y*g_Width + x) * 4;
-	//				fprintf(f, " %3d %3d %3d", ptr[i], ptr[i + 1], ptr[i + 2]);
-	//				counter++;
-	//				if (counter % 5 == 0)
-	//					fprintf(f, "\n");
-	//			}
-	//		}
-	//	}
-	//	fclose(f);
-	//}
-
 	// Save PNG images using Qt library
 	try
 	{
-		QImage image;
-		size_t w(g_Width), h(g_Height);
-		image = QImage(w, h, QImage::Format_RGB32);
-
-                std::vector<GLubyte> fbuffer(4 * w*h);
-                memcpy(&fbuffer[0], g_Buffer, 4 * w*h * sizeof(GLubyte));
-
-		unsigned int x, y, offset;
-		for (y = 0; y < h; ++y) {
-			for (x = 0; x < w; ++x) {
-				offset = 4 * (y*w + x);
-				image.setPixel(x, h - y - 1, qRgb(fbuffer[offset],
-					fbuffer[offset + 1],
-					fbuffer[offset + 2]));
+		QImage qimage(image.width_, image.height_, QImage::Format_RGB32);
+
+		unsigned int x, y;
+		for (y = 0; y < image.height_; ++y) {
+			const unsigned char *row = image.row(y);
+			for (x = 0; x < image.width_; ++x) {
+				const unsigned char *pixel = &row[image.num_channels_ * x];
+				qimage.setPixel(x, y, qRgb(pixel[0], pixel[1], pixel[2]));
 			}
 		}
 
-		image.save((filename + std::string(".png")).c_str(), "PNG");
+		return qimage.save(filename.c_str(), "PNG");
 	}
 	catch (std::bad_alloc&)
 	{
 		qWarning("Mem Alloc Error");
+		return false;
 	}
 }
 
+void snapshot(const std::string filename)
+{
+	assert(g_SnapshotWriter);
+
+	// NOTE:
+	// Only the frame buffer is copied here.
+	// The image is flipped, encoded, and written in the snapshot writer thread.
+	SnapshotImage image;
+	image.width_ = g_Width;
+	image.height_ = g_Height;
+	image.num_channels_ = 4;
+	image.is_bottom_up_ = true;
+	image.data_.resize(4 * g_Width * g_Height);
+	memcpy(&image.data_[0], g_Buffer, image.data_.size() * sizeof(GLubyte));
+
+	g_SnapshotWriter->push(filename + g_SnapshotExtension, image, g_SnapshotEncoder);
+}
+
+// Write all remaining snapshots, and stop the writer thread.
+// NOTE:
+// This is also called at exit since the experiment modes in 'parse_arguments()' end with 'exit()'.
+void close_snapshot_writer()
+{
+	delete g_SnapshotWriter;
+	g_SnapshotWriter = NULL;
+}
+
 int main(int argc, char** argv)
 {
 	gflags::ParseCommandLineFlags(&argc, &argv, true);
 
+	if (FLAGS_snapshot_format == "png")
+	{
+		g_SnapshotEncoder = &write_png;
+		g_SnapshotExtension = ".png";
+	}
+	else if (!SnapshotWriter::get_encoder(FLAGS_snapshot_format, g_SnapshotEncoder, g_SnapshotExtension))
+	{
+		printf("Unknown snapshot format: %s\n", FLAGS_snapshot_format.c_str());
+		return -1;
+	}
+
+	g_SnapshotWriter = new SnapshotWriter(FLAGS_snapshot_queue_size);
+	atexit(close_snapshot_writer);
+
 	// GLUT Window Initialization:
 	osmesaInitWindowSize(640, 480);
 
@@ -319,6 +319,8 @@ int main(int argc, char** argv)
 
 	g_MeshViewer.parse_arguments();
 
+	close_snapshot_writer();
+
 	osmesaFreeContext();
 
 	return 0;
@@ -154,12 +154,19 @@ if (OPENMP_FOUND)
   set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS}")
 endif()
 
+# std::thread (snapshot writer, trace recorder)
+find_package(Threads REQUIRED)
+
 
 # ========================================================================
 # Link source files and libraries
 # ========================================================================
 include (LinkLibraries)
 
+# NOTE: The GL-free part is built as the structure completion library ('build/StructureCompletion').
+add_subdirectory (${CMAKE_CURRENT_LIST_DIR}/../build/StructureCompletion
+  ${CMAKE_BINARY_DIR}/structure_completion)
+
 include_directories (
   ${CMAKE_SOURCE_DIR}/src/
   ${CMAKE_CURRENT_LIST_DIR}/../include/
@@ -172,8 +179,8 @@ include_directories (
 link_directories ( ${OPENMESH_DIR}/build/Build/lib/ )
 
 # source code directories
+# NOTE: The interface directories are built in the structure completion library.
 set (directories
-  ${directories}
   ${CMAKE_SOURCE_DIR}/src
   ${CMAKE_CURRENT_LIST_DIR}/../include
   ${CMAKE_CURRENT_LIST_DIR}/../src
@@ -188,6 +195,23 @@ acg_append_files (sources "*.cpp" ${directories})
 acg_append_files (sources "*.cxx" ${directories})
 acg_append_files (ui "*.ui" ${directories})
 
+# NOTE: Source files of the structure completion library are not compiled again.
+# Files are matched by name since the paths are not normalized.
+get_target_property (library_sources structure_completion SOURCES)
+set (library_source_names)
+foreach (library_source ${library_sources})
+  get_filename_component (library_source_name ${library_source} NAME)
+  list (APPEND library_source_names ${library_source_name})
+endforeach ()
+
+foreach (source ${sources})
+  get_filename_component (source_name ${source} NAME)
+  list (FIND library_source_names ${source_name} library_source_index)
+  if (NOT library_source_index EQUAL -1)
+    list (REMOVE_ITEM sources ${source})
+  endif ()
+endforeach ()
+
 # remove template cc files from source file list
 acg_drop_templates (sources)
 
@@ -209,9 +233,12 @@ target_link_libraries (${target_name}
   ${QT_LIBRARIES}
 )
 
+target_link_libraries (${target_name} structure_completion)
+
 target_link_libraries (${target_name}
   debug OpenMeshCore${CMAKE_DEBUG_POSTFIX} optimized OpenMeshCore
   debug OpenMeshTools${CMAKE_DEBUG_POSTFIX} optimized OpenMeshTools
 )
 
 target_link_libraries (${target_name} ${libraries})
+target_link_libraries (${target_name} ${CMAKE_THREAD_LIBS_INIT})
@@ -4,6 +4,32 @@
 # Last Modified: Dec. 2015
 ##################################
 
+# Single precision in the geometry kernels (see 'GeometryReal.h').
+option (USE_FLOAT_GEOMETRY "Use single precision in the geometry kernels." OFF)
+if (USE_FLOAT_GEOMETRY)
+  add_definitions (-DUSE_FLOAT_GEOMETRY)
+endif ()
+
+# IPOPT solver backend. Without it, only the augmented Lagrangian solver is built.
+option (USE_IPOPT "Build the IPOPT solver backend and link IPOPT." ON)
+if (USE_IPOPT)
+  add_definitions (-DUSE_IPOPT)
+endif ()
+
+# Remove the IPOPT interface ('interface/ipopt/IPOPTSolver.*') from the file list
+# '_files' without 'USE_IPOPT'.
+# NOTE: Files are matched by name since the globbed paths are not normalized.
+macro (remove_ipopt_files _files)
+  if (NOT USE_IPOPT)
+    foreach (file ${${_files}})
+      get_filename_component (file_name ${file} NAME)
+      if (file_name MATCHES "^IPOPTSolver\\.")
+        list (REMOVE_ITEM ${_files} ${file})
+      endif ()
+    endforeach ()
+  endif ()
+endmacro ()
+
 include_directories (
   ${CMAKE_CURRENT_LIST_DIR}/../src
   ${CMAKE_CURRENT_LIST_DIR}/../interface/ipopt
@@ -30,7 +56,6 @@ set (directories
 if (UNIX)
 
 include_directories (
-  ${LIBRARY_ROOT_PATH}/Ipopt-3.12.1/build/include/coin
   ${LIBRARY_ROOT_PATH}/glew-1.12.0/include
   #${LIBRARY_ROOT_PATH}/glog/build/include
 )
@@ -39,7 +64,6 @@ link_directories (
   ${LIBRARY_ROOT_PATH}/ann-1.1.2/lib/
   ${LIBRARY_ROOT_PATH}/gflags/build/lib/
   ${LIBRARY_ROOT_PATH}/glew-1.12.0/build/lib/
-  ${LIBRARY_ROOT_PATH}/Ipopt-3.12.1/build/lib/
   #${LIBRARY_ROOT_PATH}/ceres-solver-1.10.0/build/lib/
   #${LIBRARY_ROOT_PATH}/glog/build/lib/
 )
@@ -48,18 +72,20 @@ set (libraries
   ANN
   gflags
   GLEW
-  ipopt
-  coinmetis
-  coinmumps
   #ceres
   #glog
 )
 
+if (USE_IPOPT)
+  include_directories (${LIBRARY_ROOT_PATH}/Ipopt-3.12.1/build/include/coin)
+  link_directories (${LIBRARY_ROOT_PATH}/Ipopt-3.12.1/build/lib/)
+  list (APPEND libraries ipopt coinmetis coinmumps)
+endif ()
+
 
 elseif (WIN32)
 
 include_directories (
-  ${LIBRARY_ROOT_PATH}/Ipopt-3.11.0/include/coin
   ${LIBRARY_ROOT_PATH}/glew-1.11.0/include
   #${LIBRARY_ROOT_PATH}/glog/src/windows
 )
@@ -68,7 +94,6 @@ link_directories (
   ${LIBRARY_ROOT_PATH}/ann-1.1.2/build/bin/
   ${LIBRARY_ROOT_PATH}/gflags/build/lib/
   ${LIBRARY_ROOT_PATH}/glew-1.11.0/lib/Release/x64/
-  ${LIBRARY_ROOT_PATH}/Ipopt-3.11.0/lib/x64/ReleaseMKL/
   #${LIBRARY_ROOT_PATH}/ceres-solver-1.10.0/build/lib/
   #${LIBRARY_ROOT_PATH}/glog/x64/
 )
@@ -77,12 +102,16 @@ set (libraries
   ANN
   gflags
   glew32
-  IpOptFSS
-  IpOpt-vc10
   #debug ceres-debug optimized ceres
   #libglog
 )
 
+if (USE_IPOPT)
+  include_directories (${LIBRARY_ROOT_PATH}/Ipopt-3.11.0/include/coin)
+  link_directories (${LIBRARY_ROOT_PATH}/Ipopt-3.11.0/lib/x64/ReleaseMKL/)
+  list (APPEND libraries IpOptFSS IpOpt-vc10)
+endif ()
+
 endif()
 
 
@@ -96,6 +125,7 @@ if (MSVC)
   file (GLOB IPOPT_SOURCES
     "${CMAKE_CURRENT_LIST_DIR}/../interface/ipopt/*.h"
     "${CMAKE_CURRENT_LIST_DIR}/../interface/ipopt/*.cpp")
+  remove_ipopt_files (IPOPT_SOURCES)
   source_group("IPOPT" FILES ${IPOPT_SOURCES})
 
   file (GLOB SIMPLERANDOM_SOURCE
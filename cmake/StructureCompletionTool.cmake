@@ -0,0 +1,51 @@
+###################################
+# File: StructureCompletionTool.cmake
+# Command-line tools linked with the GL-free structure completion library
+# ('build/StructureCompletion').
+##################################
+
+# 'target_name' and 'target_sources' must be given
+if (NOT DEFINED target_name OR NOT DEFINED target_sources)
+  message (FATAL_ERROR "Error: Build one of the subdirectories of 'build' directory")
+endif()
+
+if (NOT CMAKE_BUILD_TYPE)
+  set (CMAKE_BUILD_TYPE Release CACHE STRING
+    "Choose the type of build, options are: None Debug Release RelWithDebInfo MinSizeRel." FORCE)
+endif (NOT CMAKE_BUILD_TYPE)
+
+# NOTE: The library sets the compiler flags (C++11, OpenMP) and the library paths.
+add_subdirectory (${CMAKE_CURRENT_LIST_DIR}/../build/StructureCompletion
+  ${CMAKE_CURRENT_BINARY_DIR}/structure_completion)
+
+set (LIBRARY_ROOT_PATH ${CMAKE_CURRENT_LIST_DIR}/../../lib CACHE PATH "The directory where the all library files can be found.")
+set (OPENMESH_DIR ${LIBRARY_ROOT_PATH}/OpenMesh CACHE PATH "The directory where the OpenMesh files can be found.")
+
+include(CheckCXXCompilerFlag)
+CHECK_CXX_COMPILER_FLAG("-std=c++11" COMPILER_SUPPORTS_CXX11)
+CHECK_CXX_COMPILER_FLAG("-std=c++0x" COMPILER_SUPPORTS_CXX0X)
+if(COMPILER_SUPPORTS_CXX11)
+  set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -std=c++11")
+elseif(COMPILER_SUPPORTS_CXX0X)
+  set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -std=c++0x")
+endif()
+
+find_package(OpenMP)
+if (OPENMP_FOUND)
+  set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS}")
+endif()
+
+find_package(Threads REQUIRED)
+
+include (${CMAKE_CURRENT_LIST_DIR}/LinkLibraries.cmake)
+
+include_directories (
+  ${CMAKE_CURRENT_LIST_DIR}/../include/
+  ${CMAKE_CURRENT_LIST_DIR}/../src/
+  ${OPENMESH_DIR}/src/
+)
+
+add_executable (${target_name} ${target_sources})
+
+target_link_libraries (${target_name} structure_completion)
+target_link_libraries (${target_name} ${CMAKE_THREAD_LIBS_INIT})
@@ -0,0 +1,177 @@
+#ifndef _BINARY_IO_H_
+#define _BINARY_IO_H_
+
+#include "MyMesh.h"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+// NOTE:
+// Values are written in the native byte order. Files should begin with a magic number
+// so that files written on a machine with a different byte order are rejected.
+namespace BinaryIO {
+	// NOTE:
+	// Container overloads are declared first so that nested containers
+	// (e.g. a vector of lists) find each other.
+	template <typename Scalar, int N> void write(std::ostream &_stream, const OpenMesh::VectorT<Scalar, N> &_value);
+	template <typename Scalar, int N> bool read(std::istream &_stream, OpenMesh::VectorT<Scalar, N> &_value);
+	template <typename T, size_t N> void write(std::ostream &_stream, const std::array<T, N> &_value);
+	template <typename T, size_t N> bool read(std::istream &_stream, std::array<T, N> &_value);
+	template <typename T1, typename T2> void write(std::ostream &_stream, const std::pair<T1, T2> &_value);
+	template <typename T1, typename T2> bool read(std::istream &_stream, std::pair<T1, T2> &_value);
+	template <typename T> void write(std::ostream &_stream, const std::vector<T> &_value);
+	template <typename T> bool read(std::istream &_stream, std::vector<T> &_value);
+	template <typename T> void write(std::ostream &_stream, const std::list<T> &_value);
+	template <typename T> bool read(std::istream &_stream, std::list<T> &_value);
+
+	template <typename T>
+	inline void write(std::ostream &_stream, const T &_value)
+	{
+		static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be written.");
+		_stream.write(reinterpret_cast<const char *>(&_value), sizeof(T));
+	}
+
+	template <typename T>
+	inline bool read(std::istream &_stream, T &_value)
+	{
+		static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be read.");
+		_stream.read(reinterpret_cast<char *>(&_value), sizeof(T));
+		return _stream.good();
+	}
+
+	inline void write(std::ostream &_stream, const bool &_value)
+	{
+		write(_stream, static_cast<uint8_t>(_value ? 1 : 0));
+	}
+
+	inline bool read(std::istream &_stream, bool &_value)
+	{
+		uint8_t value = 0;
+		if (!read(_stream, value)) return false;
+		_value = (value != 0);
+		return true;
+	}
+
+	inline void write(std::ostream &_stream, const std::string &_value)
+	{
+		write(_stream, static_cast<uint64_t>(_value.size()));
+		_stream.write(_value.data(), _value.size());
+	}
+
+	inline bool read(std::istream &_stream, std::string &_value)
+	{
+		uint64_t size = 0;
+		if (!read(_stream, size)) return false;
+		_value.resize(size);
+		if (size > 0) _stream.read(&_value[0], size);
+		return _stream.good();
+	}
+
+	template <typename Scalar, int N>
+	inline void write(std::ostream &_stream, const OpenMesh::VectorT<Scalar, N> &_value)
+	{
+		for (int i = 0; i < N; ++i)
+			write(_stream, _value[i]);
+	}
+
+	template <typename Scalar, int N>
+	inline bool read(std::istream &_stream, OpenMesh::VectorT<Scalar, N> &_value)
+	{
+		for (int i = 0; i < N; ++i)
+			if (!read(_stream, _value[i])) return false;
+		return true;
+	}
+
+	template <typename T, size_t N>
+	inline void write(std::ostream &_stream, const std::array<T, N> &_value)
+	{
+		for (size_t i = 0; i < N; ++i)
+			write(_stream, _value[i]);
+	}
+
+	template <typename T, size_t N>
+	inline bool read(std::istream &_stream, std::array<T, N> &_value)
+	{
+		for (size_t i = 0; i < N; ++i)
+			if (!read(_stream, _value[i])) return false;
+		return true;
+	}
+
+	template <typename T1, typename T2>
+	inline void write(std::ostream &_stream, const std::pair<T1, T2> &_value)
+	{
+		write(_stream, _value.first);
+		write(_stream, _value.second);
+	}
+
+	template <typename T1, typename T2>
+	inline bool read(std::istream &_stream, std::pair<T1, T2> &_value)
+	{
+		return read(_stream, _value.first) && read(_stream, _value.second);
+	}
+
+	template <typename T>
+	inline void write(std::ostream &_stream, const std::vector<T> &_value)
+	{
+		write(_stream, static_cast<uint64_t>(_value.size()));
+		for (typename std::vector<T>::const_iterator it = _value.begin(); it != _value.end(); ++it)
+			write(_stream, *it);
+	}
+
+	template <typename T>
+	inline bool read(std::istream &_stream, std::vector<T> &_value)
+	{
+		uint64_t size = 0;
+		if (!read(_stream, size)) return false;
+		_value.clear();
+		_value.resize(size);
+		for (typename std::vector<T>::iterator it = _value.begin(); it != _value.end(); ++it)
+			if (!read(_stream, *it)) return false;
+		return true;
+	}
+
+	template <typename T>
+	inline void write(std::ostream &_stream, const std::list<T> &_value)
+	{
+		write(_stream, static_cast<uint64_t>(_value.size()));
+		for (typename std::list<T>::const_iterator it = _value.begin(); it != _value.end(); ++it)
+			write(_stream, *it);
+	}
+
+	template <typename T>
+	inline bool read(std::istream &_stream, std::list<T> &_value)
+	{
+		uint64_t size = 0;
+		if (!read(_stream, size)) return false;
+		_value.clear();
+		for (uint64_t i = 0; i < size; ++i)
+		{
+			_value.push_back(T());
+			if (!read(_stream, _value.back())) return false;
+		}
+		return true;
+	}
+
+	// Write a magic number and a version at the beginning of a file.
+	inline void write_header(std::ostream &_stream, const uint32_t _magic, const uint32_t _version)
+	{
+		write(_stream, _magic);
+		write(_stream, _version);
+	}
+
+	// Return false if the magic number or the version does not match.
+	inline bool read_header(std::istream &_stream, const uint32_t _magic, const uint32_t _version)
+	{
+		uint32_t magic = 0, version = 0;
+		if (!read(_stream, magic) || !read(_stream, version)) return false;
+		return (magic == _magic && version == _version);
+	}
+}
+
+#endif	// _BINARY_IO_H_
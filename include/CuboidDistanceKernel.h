@@ -0,0 +1,42 @@
+#ifndef _CUBOID_DISTANCE_KERNEL_H_
+#define _CUBOID_DISTANCE_KERNEL_H_
+
+#include <vector>
+#include <Eigen/Core>
+
+
+// NOTE:
+// Signed distances from points to cuboids (negative inside). Points are processed in blocks
+// in the structure-of-arrays layout, and the block kernel uses AVX2 (checked at runtime
+// with GCC/Clang on x86), NEON (aarch64), or scalar code.
+// No memory is allocated except for the output.
+namespace CuboidDistanceKernel {
+	struct Box
+	{
+		double center_[3];
+		// 'axes_[axis_index]' is a unit axis.
+		double axes_[3][3];
+		double half_size_[3];
+	};
+
+	// "avx2", "neon", or "scalar".
+	const char *get_instruction_set();
+
+	// '_points': Each column is a point.
+	// '_distances': (number of points) x (number of boxes) matrix.
+	void compute_signed_distances(const Eigen::MatrixXd &_points,
+		const std::vector<Box> &_boxes, Eigen::MatrixXd &_distances);
+
+	// Signed distances to a single box.
+	void compute_signed_distances(const Eigen::MatrixXd &_points,
+		const Box &_box, Eigen::VectorXd &_distances);
+
+	// Index and signed distance of the nearest box of each point.
+	// When distances are the same, the box of the smaller index is taken.
+	// The index is -1 if there is no box.
+	void compute_nearest_boxes(const Eigen::MatrixXd &_points,
+		const std::vector<Box> &_boxes, std::vector<int> &_box_indices,
+		Eigen::VectorXd &_distances);
+}
+
+#endif	// _CUBOID_DISTANCE_KERNEL_H_
@@ -0,0 +1,15 @@
+#ifndef _GEOMETRY_REAL_H_
+#define _GEOMETRY_REAL_H_
+
+// NOTE:
+// Scalar type of the geometry kernels (point hash grids and the occlusion visibility test).
+// Build with 'USE_FLOAT_GEOMETRY' (the CMake option of the same name) for single precision,
+// which halves the memory traffic and doubles the SIMD width of these kernels.
+// Solvers and statistical relations always use 'Real' (double).
+#ifdef USE_FLOAT_GEOMETRY
+typedef float GeometryReal;
+#else
+typedef double GeometryReal;
+#endif
+
+#endif	// _GEOMETRY_REAL_H_
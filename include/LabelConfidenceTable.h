@@ -0,0 +1,121 @@
+#ifndef _LABEL_CONFIDENCE_TABLE_H_
+#define _LABEL_CONFIDENCE_TABLE_H_
+
+#include "MyMesh.h"
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <Eigen/Core>
+
+
+// NOTE:
+// Label confidence values of all sample points in a single contiguous (points x labels) table.
+// Rows are indexed by sample point indices, and columns by label indices.
+// Values are in [0, 1], and are stored in one of the encodings:
+//   - 'FloatEncoding': 32-bit float.
+//   - 'HalfEncoding': 16-bit float (IEEE 754 half precision, about 3 decimal digits).
+//   - 'ByteEncoding': 8-bit unsigned integer (value * 255).
+// If 'top_k' is not zero, each row only keeps the largest 'top_k' values (and their label indices),
+// and the other values are zero.
+class LabelConfidenceTable
+{
+public:
+	typedef enum {
+		FloatEncoding = 0,
+		HalfEncoding,
+		ByteEncoding
+	} Encoding;
+
+	LabelConfidenceTable(const Encoding _encoding = FloatEncoding, const unsigned int _top_k = 0);
+
+	void clear();
+
+	inline Encoding get_encoding() const { return encoding_; }
+	inline unsigned int get_top_k() const { return top_k_; }
+	inline bool is_sparse() const { return (top_k_ > 0 && top_k_ < num_labels_); }
+
+	// Existing values are re-encoded.
+	void set_storage(const Encoding _encoding, const unsigned int _top_k);
+
+	inline unsigned int num_points() const { return num_points_; }
+	inline unsigned int num_labels() const { return num_labels_; }
+
+	// Bytes of the stored values (and label indices in the sparse mode).
+	size_t memory_size() const;
+
+	// NOTE:
+	// New values are zero. Existing values are kept if '_num_labels' is not changed.
+	void resize(const unsigned int _num_points, const unsigned int _num_labels);
+
+	// Add a point with zero values, and return its index.
+	unsigned int add_point();
+
+	// Remove points, and move the rest to the front in the same order.
+	void remove_points(const std::vector<bool> &_is_point_removed);
+
+	Real get(const unsigned int _point_index, const unsigned int _label_index) const;
+	void set(const unsigned int _point_index, const unsigned int _label_index, const Real _value);
+
+	void get_row(const unsigned int _point_index, std::vector<Real> &_values) const;
+	void set_row(const unsigned int _point_index, const std::vector<Real> &_values);
+
+	void set_zero(const unsigned int _point_index);
+	void set_one_hot(const unsigned int _point_index, const unsigned int _label_index);
+
+	// '_other' can be this table. The numbers of labels should be the same.
+	void copy_row(const unsigned int _point_index,
+		const LabelConfidenceTable &_other, const unsigned int _other_point_index);
+
+	// Move the values of each old label to the new labels in '_new_label_indices[old label]'.
+	void remap_labels(const std::vector< std::vector<unsigned int> > &_new_label_indices,
+		const unsigned int _num_new_labels);
+
+	// '_values': (points x labels) matrix.
+	void get_matrix(Eigen::MatrixXd &_values) const;
+	void set_matrix(const Eigen::MatrixXd &_values);
+
+	// -- Bulk operations -- //
+	// Label index of the largest value of each point (the smallest label index if tied).
+	// If '_max_values' is given, the largest values are also returned.
+	void get_argmax_labels(std::vector<unsigned int> &_label_indices,
+		std::vector<Real> *_max_values = NULL) const;
+
+	// Scale the values of each point so that their sum is one.
+	// Points with all zero values are not changed.
+	void normalize();
+
+	// Add the values of the given points to '_sums' (size of the number of labels).
+	void accumulate(const std::vector<unsigned int> &_point_indices, std::vector<Real> &_sums) const;
+	// ---- //
+
+	void write(std::ostream &_stream) const;
+	bool read(std::istream &_stream);
+
+private:
+	// Number of stored values (slots) of each point.
+	inline unsigned int num_slots() const { return is_sparse() ? top_k_ : num_labels_; }
+
+	// '_values': Values of all labels.
+	void decode_row(const unsigned int _point_index, float *_values) const;
+	void encode_row(const unsigned int _point_index, const float *_values);
+
+	float get_slot_value(const size_t _index) const;
+	void set_slot_value(const size_t _index, const float _value);
+
+	Encoding encoding_;
+	unsigned int top_k_;
+	unsigned int num_points_;
+	unsigned int num_labels_;
+
+	// Only the vector of the current encoding is used.
+	std::vector<float> float_values_;
+	std::vector<uint16_t> half_values_;
+	std::vector<uint8_t> byte_values_;
+
+	// Label index of each slot in the sparse mode. Unused slots have 'k_no_label' (and zero values).
+	std::vector<uint16_t> slot_labels_;
+	static const uint16_t k_no_label = 0xFFFF;
+};
+
+#endif	// _LABEL_CONFIDENCE_TABLE_H_
@@ -6,7 +6,10 @@
 #define CUBOID_SURFACE_SAMPLING_RANDOM_SEED	20130923
 
 #include "ICP.h"
+#include "LabelConfidenceTable.h"
+#include "MeshCuboidParameters.h"
 #include "MyMesh.h"
+#include "PointHashGrid.h"
 
 #include <array>
 #include <map>
@@ -45,7 +48,6 @@ public:
 		, bary_coord_(_other.bary_coord_)
 		, point_(_other.point_)
 		, normal_(_other.normal_)
-		, label_index_confidence_(_other.label_index_confidence_)
 		, error_(_other.error_)
 	{}
 
@@ -54,7 +56,9 @@ public:
 	MyMesh::Point bary_coord_;
 	MyMesh::Point point_;
 	MyMesh::Normal normal_;
-	std::vector<Real> label_index_confidence_;
+	// NOTE:
+	// Label confidence values are stored in 'MeshCuboidStructure::sample_label_confidences_'
+	// with 'sample_point_index_'.
 	Real error_;
 };
 
@@ -131,6 +135,20 @@ public:
 		const std::array<MyMesh::Normal, 3> &_axes);
 
 	static void compute_cuboid_surface_point_visibility(
+		const Real _modelview_matrix[16],
+		const Real _radius,
+		const std::vector<MeshSamplePoint *> &_given_sample_points,
+		const std::vector<MyMesh::Point> &_test_points,
+		const std::vector<MyMesh::Normal> *_test_normals,
+		const MeshCuboidParameters &_params,
+		std::vector<Real> &_visibility_values);
+
+	// NOTE:
+	// Occlusion test of 'compute_cuboid_surface_point_visibility()' in 'Scalar'
+	// (without the view plane mask). Both float and double are instantiated,
+	// and the pipeline uses 'GeometryReal'.
+	template <typename Scalar>
+	static void compute_occlusion_visibility(
 		const Real _modelview_matrix[16],
 		const Real _radius,
 		const std::vector<MeshSamplePoint *> &_given_sample_points,
@@ -140,11 +158,12 @@ public:
 
 	static void compute_view_plane_mask_visibility(const Real _modelview_matrix[16],
 		const std::vector<MyMesh::Point>& _points,
+		const MeshCuboidParameters &_params,
 		std::list<SamplePointIndex> &_masked_point_indices);
 
 	void set_axis_configuration(const unsigned int _axis_configuration_index);
 
-	bool compute_bbox();
+	bool compute_bbox(const MeshCuboidParameters &_params);
 
 	void clear_sample_points();
 	void clear_cuboid_surface_points();
@@ -217,12 +236,15 @@ public:
 	void update_center_size_corner_points();
 	void update_axes_center_size_corner_points();
 	// Update the label based on the label confidence values of sample points.
-	void update_label_using_sample_points();
+	void update_label_using_sample_points(const LabelConfidenceTable &_label_confidences);
 	void update_point_correspondences();
 
 	static MeshCuboid *merge_cuboids(const LabelIndex _label_index,
-		const std::vector<MeshCuboid *> _cuboids);
-	std::vector<MeshCuboid *> split_cuboid(const Real _object_diameter);
+		const std::vector<MeshCuboid *> _cuboids,
+		const MeshCuboidParameters &_params);
+	std::vector<MeshCuboid *> split_cuboid(const Real _object_diameter,
+		const LabelConfidenceTable &_label_confidences,
+		const MeshCuboidParameters &_params);
 
 	void create_random_points_on_cuboid_surface(
 		const unsigned int _num_cuboid_surface_points);
@@ -233,18 +255,40 @@ public:
 		const Real _modelview_matrix[16],
 		const Real _radius,
 		const std::vector<MeshSamplePoint *>& _given_sample_points,
+		const MeshCuboidParameters &_params,
 		bool _use_cuboid_normal = true);
 
 	bool is_point_inside_cuboid(const MyMesh::Point& _point)const;
 	void points_to_cuboid_distances(const Eigen::MatrixXd& _points,
 		Eigen::VectorXd &_distances);
 
-	// NOTE: Assume that cuboid surface points exist.
+	// '_distances': (number of points) x (number of cuboids) matrix of signed distances.
+	static void points_to_cuboids_distances(const Eigen::MatrixXd& _points,
+		const std::vector<MeshCuboid *> &_cuboids, Eigen::MatrixXd &_distances);
+
+	// Index of the nearest cuboid in '_cuboids' and its signed distance for each point
+	// (e.g. for segmentation). The index is -1 if there is no cuboid.
+	static void points_to_nearest_cuboids(const Eigen::MatrixXd& _points,
+		const std::vector<MeshCuboid *> &_cuboids, std::vector<int> &_cuboid_indices,
+		Eigen::VectorXd &_distances);
+
+	// Maximum distance from the surface of '_cuboid_2' to the surface of '_cuboid_1'
+	// (computed analytically). With '_symmetric', the maximum of both directions
+	// (Hausdorff distance) is returned.
 	static Real distance_between_cuboids(
+		const MeshCuboid *_cuboid_1, const MeshCuboid *_cuboid_2,
+		bool _symmetric = false);
+
+	// '_distances': (number of cuboids) x (number of cuboids) matrix, where (i, j) is
+	// 'distance_between_cuboids(_cuboids[i], _cuboids[j], _symmetric)'.
+	static void distances_between_cuboids(const std::vector<MeshCuboid *> &_cuboids,
+		Eigen::MatrixXd &_distances, bool _symmetric = false);
+
+	// True if the solid cuboids intersect (separating axis test).
+	static bool are_cuboids_overlapping(
 		const MeshCuboid *_cuboid_1, const MeshCuboid *_cuboid_2);
 
 	void print_cuboid()const;
-	void draw_cuboid()const;
 
 
 protected:
@@ -266,9 +310,15 @@ protected:
 
 	void compute_oriented_bbox();
 
-	void create_sub_cuboids(const Real _object_diameter, ANNkd_tree* _kd_tree, std::vector<MeshCuboid *> &_sub_cuboids);
+	// '_sample_points': Each column is a sample point.
+	// '_sample_point_grid': Hash grid of the sample points with the cell size of the neighbor distance.
+	void create_sub_cuboids(const Real _object_diameter,
+		const Eigen::MatrixXd &_sample_points, const PointHashGrid &_sample_point_grid,
+		const LabelConfidenceTable &_label_confidences,
+		const MeshCuboidParameters &_params, std::vector<MeshCuboid *> &_sub_cuboids);
 
-	void remove_small_sub_cuboids(std::vector<MeshCuboid *> &_sub_cuboids);
+	void remove_small_sub_cuboids(const MeshCuboidParameters &_params,
+		std::vector<MeshCuboid *> &_sub_cuboids);
 
 	//void align_sub_cuboids(const Real _object_diameter, std::vector<MeshCuboid *> &_sub_cuboids);
 	//void split_cuboid_recursive(ANNkd_tree* _kd_tree, std::vector<MeshCuboid *> &_sub_cuboids);
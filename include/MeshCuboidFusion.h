@@ -5,6 +5,9 @@
 #include "ICP.h"
 
 #include <Eigen/Core>
+#include <list>
+#include <string>
+#include <vector>
 
 
 typedef OpenMesh::Vec3i MeshCuboidVoxelIndex3D;
@@ -38,6 +41,56 @@ private:
 	MeshCuboidVoxelIndex3D n_voxels_;
 };
 
+// Fused sample points of a single output cuboid.
+struct MeshCuboidFusionOutput
+{
+	MeshCuboidFusionOutput(MeshCuboid *_output_cuboid)
+		: output_cuboid_(_output_cuboid) {}
+
+	void add_sample_point(const MyMesh::Point &_point, const MyMesh::Normal &_normal);
+
+	MeshCuboid *output_cuboid_;
+	std::vector<MyMesh::Point> points_;
+	std::vector<MyMesh::Normal> normals_;
+};
+
+// Thread-local result of a fusion work item.
+// NOTE:
+// Work items run in parallel and never touch the output cuboid structure.
+// Their buffers are merged into the output structure afterwards
+// in the work item order.
+struct MeshCuboidFusionBuffer
+{
+	std::list<MeshCuboidFusionOutput> outputs_;
+	std::vector<const MeshCuboid *> visited_symmetry_cuboids_;
+	std::vector<LabelIndex> visited_label_indices_;
+	std::string description_;
+};
+
+typedef enum
+{
+	SingleSymmetryFusion,
+	PairSymmetryFusion,
+	AsymmetryFusion
+}
+MeshCuboidFusionType;
+
+struct MeshCuboidFusionWorkItem
+{
+	MeshCuboidFusionWorkItem(MeshCuboidFusionType _fusion_type,
+		const MeshCuboidSymmetryGroup *_symmetry_group,
+		LabelIndex _label_index_1, LabelIndex _label_index_2 = 0)
+		: fusion_type_(_fusion_type)
+		, symmetry_group_(_symmetry_group)
+		, label_index_1_(_label_index_1)
+		, label_index_2_(_label_index_2) {}
+
+	MeshCuboidFusionType fusion_type_;
+	const MeshCuboidSymmetryGroup *symmetry_group_;
+	LabelIndex label_index_1_;
+	LabelIndex label_index_2_;
+};
+
 void run_part_ICP(
 	MeshCuboidStructure &_input,
 	const MeshCuboidStructure &_ground_truth);
@@ -67,10 +120,9 @@ void merge_symmetric_cuboids_visibility(
 void fill_voxels_using_visibility(
 	const MeshCuboidVoxelGrid &_voxels,
 	const std::vector<Real> &_voxel_visibility_values,
-	const MeshCuboid *symmetry_cuboid,
-	const MeshCuboid *database_cuboid,
-	MeshCuboidStructure &_output_cuboid_structure,
-	MeshCuboid *output_cuboid);
+	const MeshCuboid *_symmetry_cuboid,
+	const MeshCuboid *_database_cuboid,
+	MeshCuboidFusionOutput &_output);
 
 void reconstruct_fusion_simple(
 	const MeshCuboidStructure &_symmetry_reconstruction,
@@ -4,19 +4,32 @@
 #include "MeshCuboid.h"
 #include "MeshCuboidRelation.h"
 #include "MeshCuboidPredictor.h"
+#include "MeshCuboidRotationSymmetryFunction.h"
 #include "MeshCuboidSymmetryGroup.h"
 
 // IPOPT.
 #include "NLPFormulation.h"
 #include "NLPEigenQuadFunction.h"
 #include "NLPVectorExpression.h"
+#ifdef USE_IPOPT
 #include "IPOPTSolver.h"
 #include "IpIpoptApplication.hpp"
+#endif
 
-#include "ANN/ANN.h"
 #include <Eigen/Core>
 
 
+// NOTE:
+// The IPOPT backend is built only with 'USE_IPOPT' (see 'cmake/LinkLibraries.cmake').
+// Otherwise, 'IPOPTSolverBackend' falls back to the augmented Lagrangian solver.
+typedef enum
+{
+	IPOPTSolverBackend,
+	AugmentedLagrangianSolverBackend
+}
+MeshCuboidNonLinearSolverBackend;
+
+
 class MeshCuboidNonLinearSolver
 {
 public:
@@ -26,7 +39,8 @@ public:
 		const std::vector<MeshCuboidRotationSymmetryGroup *>& _rotation_symmetry_groups,
 		const Real _squared_neighbor_distance,
 		const unsigned int _min_num_symmetry_point_pairs,
-		const Real _symmetry_energy_term_weight);
+		const Real _symmetry_energy_term_weight,
+		MeshCuboidSamplePointGrids *_cuboid_sample_point_grids = NULL);
 	~MeshCuboidNonLinearSolver();
 
 
@@ -72,7 +86,9 @@ public:
 		const Eigen::VectorXd& _cuboid_linear_term,
 		const double _cuboid_constant_term,
 		Eigen::VectorXd* _init_values_vec = NULL,
-		const std::vector<unsigned int> *_fixed_cuboid_indices = NULL);
+		const std::vector<unsigned int> *_fixed_cuboid_indices = NULL,
+		const MeshCuboidNonLinearSolverBackend _backend = IPOPTSolverBackend,
+		const bool _compare_backends = false);
 
 
 private:
@@ -90,13 +106,25 @@ private:
 	void update(const std::vector< Number >& _values);
 
 
+	// Solver backends.
+	// Return true if the problem is solved.
+#ifdef USE_IPOPT
+	bool solve_ipopt(NLPFormulation &_formulation) const;
+#endif
+	bool solve_augmented_lagrangian(NLPFormulation &_formulation) const;
+
+	// Solve the same formulation with all backends, print their energies,
+	// constraint violations, and running times, and keep the result of '_backend'.
+	void compare_solver_backends(NLPFormulation &_formulation,
+		const MeshCuboidNonLinearSolverBackend _backend) const;
+
+
 	// Energy functions.
 	NLPFunction *create_reflection_symmetry_group_energy_function();
 
 	void create_reflection_symmetry_group_energy_function(
 		const unsigned int _symmetry_group_index,
-		const std::vector<ANNpointArray>& _cuboid_ann_points,
-		const std::vector<ANNkd_tree *>& _cuboid_ann_kd_tree,
+		const MeshCuboidSamplePointGrids& _cuboid_sample_point_grids,
 		Eigen::MatrixXd& _quadratic_term,
 		Eigen::VectorXd& _linear_term,
 		double &_constant_term);
@@ -105,17 +133,12 @@ private:
 
 	void create_rotation_symmetry_group_energy_function(
 		const unsigned int _symmetry_group_index,
-		const std::vector<ANNpointArray>& _cuboid_ann_points,
-		const std::vector<ANNkd_tree *>& _cuboid_ann_kd_tree,
-		NLPExpression &_expression);
+		const MeshCuboidSamplePointGrids& _cuboid_sample_point_grids,
+		MeshCuboidRotationSymmetryFunction &_function);
 
-	void create_cuboid_sample_point_ann_trees(
-		std::vector<ANNpointArray>& _cuboid_ann_points,
-		std::vector<ANNkd_tree *>& _cuboid_ann_kd_tree) const;
-
-	void delete_cuboid_sample_point_ann_trees(
-		std::vector<ANNpointArray>& _cuboid_ann_points,
-		std::vector<ANNkd_tree *>& _cuboid_ann_kd_tree) const;
+	// NOTE:
+	// Grids given in the constructor are reused if the sample points are not changed.
+	MeshCuboidSamplePointGrids &update_cuboid_sample_point_grids();
 
 
 	// Constraint functions.
@@ -180,6 +203,9 @@ private:
 	const double symmetry_energy_term_weight_;
 	const unsigned int min_num_symmetric_point_pairs_;
 
+	MeshCuboidSamplePointGrids *cuboid_sample_point_grids_;
+	MeshCuboidSamplePointGrids own_cuboid_sample_point_grids_;
+
 	unsigned int num_cuboids_;
 	unsigned int num_reflection_symmetry_groups_;
 	unsigned int num_rotation_symmetry_groups_;
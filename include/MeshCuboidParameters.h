@@ -2,10 +2,13 @@
 #define _MESH_CUBOID_PARAMETERS_H_
 
 #include <gflags/gflags.h>
+#include <string>
 
 // -- Parameters -- //
 //
 DECLARE_bool(param_optimize_training_cuboids);
+DECLARE_bool(param_opt_use_augmented_lagrangian);
+DECLARE_bool(param_opt_compare_solver_backends);
 
 DECLARE_int32(param_num_sample_point_neighbors);
 DECLARE_int32(param_min_num_cuboid_sample_points);
@@ -15,6 +18,13 @@ DECLARE_int32(param_intra_cuboid_symmetry_axis);
 DECLARE_int32(param_eval_num_neighbor_range_samples);
 DECLARE_int32(param_opt_max_iterations);
 
+// NOTE:
+// Storage of the sample point label confidences ('LabelConfidenceTable').
+// 'param_label_confidence_encoding': 0 (float), 1 (half), or 2 (8-bit).
+// 'param_label_confidence_top_k': If not zero, only the largest k values of each point are kept.
+DECLARE_int32(param_label_confidence_encoding);
+DECLARE_int32(param_label_confidence_top_k);
+
 DECLARE_double(param_min_sample_point_confidence);
 DECLARE_double(param_min_num_confidence_tol_sample_points);
 DECLARE_double(param_min_cuboid_bbox_size);
@@ -55,11 +65,74 @@ DECLARE_bool(disable_part_relation_terms);
 // ---- //
 
 
+// NOTE:
+// Parameters of a single job.
+// The pipeline reads the parameters only from this struct, which is filled with
+// the flag values above by default. Each job owns its own instance, and the
+// instance is passed as a const reference once the job starts.
+struct MeshCuboidParameters
+{
+	MeshCuboidParameters();
+
+	// Read/write the view plane mask range (min x, min y, max x, max y in each line).
+	bool load_view_plane_mask(const std::string &_filename);
+	bool save_view_plane_mask(const std::string &_filename) const;
+
+	bool opt_use_augmented_lagrangian_;
+	bool opt_compare_solver_backends_;
+
+	int num_sample_point_neighbors_;
+	int min_num_cuboid_sample_points_;
+	int min_num_symmetric_point_pairs_;
+	int num_cuboid_surface_points_;
+	int intra_cuboid_symmetry_axis_;
+	int eval_num_neighbor_range_samples_;
+	int opt_max_iterations_;
+	int label_confidence_encoding_;
+	int label_confidence_top_k_;
+
+	double min_sample_point_confidence_;
+	double min_cuboid_bbox_size_;
+	double min_cuboid_bbox_diag_length_;
+	double sparse_neighbor_distance_;
+	double cuboid_split_neighbor_distance_;
+	double occlusion_test_neighbor_distance_;
+	double eval_min_neighbor_distance_;
+	double eval_max_neighbor_distance_;
+	double min_cuboid_overall_visibility_;
+	double max_potential_;
+	double dummy_potential_;
+	double null_cuboid_probability_;
+	double fusion_visibility_smoothing_prior_;
+	double fusion_grid_size_;
+	double opt_single_energy_term_weight_;
+	double opt_symmetry_energy_term_weight_;
+	double part_assembly_window_size_;
+	double part_assembly_voxel_size_;
+	double part_assembly_voxel_variance_;
+
+	bool use_view_plane_mask_;
+	double view_plane_mask_proportion_;
+	double view_plane_mask_min_x_;
+	double view_plane_mask_min_y_;
+	double view_plane_mask_max_x_;
+	double view_plane_mask_max_y_;
+
+	bool disable_symmetry_terms_;
+	bool disable_per_point_classifier_terms_;
+	bool disable_label_smoothness_terms_;
+	bool disable_part_relation_terms_;
+
+	bool optimize_individual_reflection_symmetry_group_;
+};
+
+
 // -- Experiments -- //
 //
 DECLARE_bool(run_ground_truth_cuboids);
 DECLARE_bool(run_training);
 DECLARE_bool(run_prediction);
+DECLARE_bool(run_batch_prediction);
 DECLARE_bool(run_part_assembly);
 DECLARE_bool(run_symmetry_detection);
 DECLARE_bool(run_baseline);
@@ -126,6 +199,60 @@ DECLARE_string(object_list_filename);
 
 DECLARE_int32(random_view_seed);
 
+// NOTE: In the batch prediction mode, jobs in the manifest file are distributed
+// to 'batch_num_workers' processes, and this process runs the jobs of
+// 'batch_worker_index'.
+DECLARE_string(batch_job_manifest_filename);
+DECLARE_int32(batch_num_workers);
+DECLARE_int32(batch_worker_index);
+
+// NOTE: Snapshots are written in a background thread ('png', 'ppm', or 'qoi').
+// 'snapshot_stage_mask' selects the snapshots in the prediction:
+// 1 (view), 2 (input), 4 (intermediate). Set 0 to skip all intermediate images.
+// Final reconstruction snapshots are always written.
+DECLARE_string(snapshot_format);
+DECLARE_int32(snapshot_queue_size);
+DECLARE_int32(snapshot_stage_mask);
+
+// NOTE: If true, pipeline stages of each prediction are recorded and saved to
+// 'trace.json' (Chrome trace event format) in the output directory of the mesh.
+DECLARE_bool(trace_pipeline);
+
+// NOTE: If true, the candidate exploration of each prediction is saved to 'temp/checkpoint.bin'
+// in the output directory of the mesh after each stage. If the file exists when the prediction
+// starts (e.g. the job was preempted), the prediction resumes from the saved stage.
+// The file is removed when the prediction is finished.
+DECLARE_bool(checkpoint_prediction);
+
+// NOTE: If not empty, the cuboid structure after the preprocessing (occlusion, initial cuboids,
+// and cuboid surface points) is cached in this directory, and the file name is a hash of
+// the input files, the occlusion pose, and the preprocessing parameters.
+// Predictions with the same inputs (e.g. sweeps over optimization parameters) reuse the cache.
+DECLARE_string(preprocessing_cache_dir);
+
+// NOTE: If not empty, meshes are cached in this directory after normalization ('MyMesh::open_mesh'),
+// and the file name is a hash of the mesh file. Loading the same mesh file again reads the cache
+// instead of parsing the file. The directory should exist.
+DECLARE_string(mesh_cache_dir);
+
+// NOTE: If true, inconsistent face normals of meshes are inverted when meshes are loaded
+// ('MyMesh::make_face_normal_consistent').
+DECLARE_bool(make_face_normal_consistent);
+
+// NOTE: If true, points are sampled on the mesh surface instead of loading the sample point files
+// ('PoissonDiskSampler'). The sample point label files (for the test data) should be
+// computed from the points sampled with the same numbers of points and seed.
+DECLARE_bool(sample_points_from_mesh);
+DECLARE_int32(num_sample_points);
+DECLARE_int32(num_dense_sample_points);
+DECLARE_int32(sample_points_seed);
+
+// NOTE: If not zero, the input sample points are downsampled to at most this number of points
+// after the preprocessing in 'MeshViewerCore::predict()' ('MeshCuboidStructure::downsample_sample_points()').
+// The labels and cuboids of the downsampled points are propagated back to all input points
+// before the reconstruction.
+DECLARE_int32(max_num_prediction_sample_points);
+
 // To be removed.
 //DECLARE_bool(use_symmetric_group_cuboids, false, "");
 //
@@ -0,0 +1,63 @@
+#ifndef _MESH_CUBOID_PREDICTION_CHECKPOINT_H_
+#define _MESH_CUBOID_PREDICTION_CHECKPOINT_H_
+
+#include "MyMesh.h"
+#include "MeshCuboid.h"
+#include "MeshCuboidParameters.h"
+#include "MeshCuboidStructure.h"
+
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+
+// NOTE:
+// State of the candidate exploration in 'StructureCompletion::explore_candidates()'.
+// The first candidate is in progress and resumes from 'next_stage_'.
+// The other candidates have not been started.
+class MeshCuboidPredictionCheckpoint
+{
+public:
+	typedef enum {
+		RecognizeStage = 0,
+		SegmentStage,
+		OptimizeStage,
+		AddMissingCuboidsStage,
+		ReconstructStage,
+		NumStages
+	} Stage;
+
+	// '_mesh' and '_params' are set to the loaded cuboid structures.
+	MeshCuboidPredictionCheckpoint(const MyMesh *_mesh,
+		const MeshCuboidParameters &_params = MeshCuboidParameters());
+
+	void clear();
+
+	// NOTE:
+	// The file is written to a temporary file first, and then renamed.
+	// Thus, the previous checkpoint remains if the process is killed while writing.
+	// '_input_key' is a hash of the inputs of the prediction (see 'MeshCuboidPreprocessingCache'),
+	// and 'load()' returns false if the checkpoint was saved with a different key.
+	bool save(const std::string &_filename, const std::string &_input_key) const;
+	bool load(const std::string &_filename, const std::string &_input_key);
+
+	std::list< std::pair<std::string, MeshCuboidStructure> > candidates_;
+	unsigned int next_stage_;
+	bool first_iteration_;
+	std::set<LabelIndex> ignored_label_indices_;
+	unsigned int num_final_candidates_;
+
+	// NOTE:
+	// If the sample points are downsampled ('MeshCuboidStructure::downsample_sample_points()'),
+	// the sample points before downsampling and the index of the representative of each point.
+	// Otherwise, 'representative_indices_' is empty.
+	MeshCuboidStructure full_resolution_structure_;
+	std::vector<SamplePointIndex> representative_indices_;
+
+private:
+	const MyMesh *mesh_;
+	MeshCuboidParameters params_;
+};
+
+#endif	// _MESH_CUBOID_PREDICTION_CHECKPOINT_H_
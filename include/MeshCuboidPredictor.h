@@ -2,6 +2,7 @@
 #define _MESH_CUBOID_PREDICTOR_H_
 
 #include "MeshCuboid.h"
+#include "MeshCuboidParameters.h"
 #include "MeshCuboidRelation.h"
 #include "MeshCuboidStructure.h"
 
@@ -11,13 +12,18 @@
 // Recognize primitive labels and local coordinates.
 class MeshCuboidPredictor {
 public:
-	MeshCuboidPredictor(unsigned int _num_labels);
+	// NOTE:
+	// '_params' is not copied, and must outlive the predictor.
+	MeshCuboidPredictor(unsigned int _num_labels, const MeshCuboidParameters &_params);
+
+	const MeshCuboidParameters &get_parameters() const { return params_; }
 
 	virtual void get_missing_label_indices(
 		const std::list<LabelIndex> &_given_label_indices,
 		std::list<LabelIndex> &_missing_label_indices)const;
 
 	virtual Real get_single_potential(const MeshCuboid *_cuboid,
+		const LabelConfidenceTable &_label_confidences,
 		const MeshCuboidAttributes *_attributes,
 		const MeshCuboidTransformation *_transformation,
 		const LabelIndex _label_index)const;
@@ -43,13 +49,15 @@ public:
 
 protected:
 	const unsigned int num_labels_;
+	const MeshCuboidParameters &params_;
 };
 
 // Use joint normal relations for binary terms.
 class MeshCuboidJointNormalRelationPredictor : public MeshCuboidPredictor{
 public:
 	MeshCuboidJointNormalRelationPredictor(
-		const std::vector< std::vector<MeshCuboidJointNormalRelations *> > &_relations);
+		const std::vector< std::vector<MeshCuboidJointNormalRelations *> > &_relations,
+		const MeshCuboidParameters &_params);
 
 	virtual void get_missing_label_indices(
 		const std::list<LabelIndex> &_given_label_indices,
@@ -79,7 +87,8 @@ private:
 class MeshCuboidCondNormalRelationPredictor : public MeshCuboidPredictor{
 public:
 	MeshCuboidCondNormalRelationPredictor(
-		const std::vector< std::vector<MeshCuboidCondNormalRelations *> > &_relations);
+		const std::vector< std::vector<MeshCuboidCondNormalRelations *> > &_relations,
+		const MeshCuboidParameters &_params);
 
 	virtual void get_missing_label_indices(
 		const std::list<LabelIndex> &_given_label_indices,
@@ -143,6 +152,7 @@ public:
 		const std::vector< std::vector<MeshCuboidStats> > &_pair_stats);
 
 	virtual Real get_single_potential(const MeshCuboid *_cuboid,
+		const LabelConfidenceTable &_label_confidences,
 		const MeshCuboidAttributes *_attributes,
 		const MeshCuboidTransformation *_transformation,
 		const LabelIndex _label_index)const;
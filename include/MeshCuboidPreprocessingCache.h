@@ -0,0 +1,64 @@
+#ifndef _MESH_CUBOID_PREPROCESSING_CACHE_H_
+#define _MESH_CUBOID_PREPROCESSING_CACHE_H_
+
+#include "MeshCuboidParameters.h"
+#include "MeshCuboidStructure.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+
+// NOTE:
+// Content-addressed cache of the cuboid structure before the candidate exploration
+// (occlusion, initial cuboids, and cuboid surface points).
+// The key is a hash of all inputs of the preprocessing (input files, poses and parameters),
+// and thus any change of the inputs gives a different cache file.
+// Parameters used only after the preprocessing (e.g. optimization weights) are not hashed,
+// and parameter sweeps over them reuse the same cache file.
+class MeshCuboidPreprocessingCache
+{
+public:
+	MeshCuboidPreprocessingCache(const std::string &_cache_dir);
+
+	// Add the contents of a file to the key. Return false if the file cannot be read.
+	bool add_file(const std::string &_filename);
+
+	void add_data(const void *_data, const size_t _size);
+
+	template <typename T>
+	void add_value(const T &_value)
+	{
+		static_assert(std::is_arithmetic<T>::value, "Only arithmetic types can be hashed.");
+		add_data(&_value, sizeof(T));
+	}
+
+	// Add the parameters affecting the preprocessing.
+	void add_parameters(const MeshCuboidParameters &_params);
+
+	// Add all parameters, including those used only after the preprocessing.
+	void add_all_parameters(const MeshCuboidParameters &_params);
+
+	// Hexadecimal string of the hash.
+	std::string get_key() const;
+
+	std::string get_filename() const;
+
+	// Return false if there is no cache file of the key.
+	bool load(MeshCuboidStructure &_cuboid_structure) const;
+
+	bool save(const MeshCuboidStructure &_cuboid_structure) const;
+
+	// NOTE:
+	// Name of a temporary file for writing '_filename', with the process id and a random suffix.
+	// Concurrent processes (and threads) writing the same file never share the temporary file.
+	static std::string get_temp_filename(const std::string &_filename);
+
+private:
+	std::string cache_dir_;
+
+	// Two 64-bit FNV-1a hashes with different offset bases.
+	uint64_t hash_[2];
+};
+
+#endif	// _MESH_CUBOID_PREPROCESSING_CACHE_H_
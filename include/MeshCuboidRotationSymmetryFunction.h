@@ -0,0 +1,73 @@
+#ifndef _MESH_CUBOID_ROTATION_SYMMETRY_FUNCTION_H_
+#define _MESH_CUBOID_ROTATION_SYMMETRY_FUNCTION_H_
+
+#include "NLPFormulation.h"
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+
+// For each rotation symmetry group with axis variables 'n' and 't',
+// E = \| t \|_2^2 + \sum_k w_k \| R(n, a_k)(x_k - t) - (y_k - t) \|_2^2,
+// where R(n, a) is the Rodrigues' rotation matrix
+// R(n, a) = cos(a) I + sin(a) [n]_x + (1 - cos(a)) nn^T.
+// NOTE:
+// Point pairs are accumulated to moments for each rotation angle,
+// and the value, gradient, and Hessian are computed from the moments.
+class MeshCuboidRotationSymmetryFunction : public NLPFunction
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	MeshCuboidRotationSymmetryFunction(const Index _num_vars, const Number _weight = 1.0);
+	~MeshCuboidRotationSymmetryFunction();
+
+	// Return the index of the added symmetry group.
+	// '_n_index', '_t_index': Indices of the first element of 'n' and 't' variables.
+	unsigned int add_symmetry_group(const Index _n_index, const Index _t_index);
+
+	void add_point_pair(const unsigned int _group_index,
+		const Eigen::Vector3d &_x, const Eigen::Vector3d &_y,
+		const Number _weight, const Number _angle);
+
+	virtual Number eval(const Number* _x) const;
+	virtual void eval_gradient(const Number* _x, Number* _output) const;
+	virtual void eval_hessian(const Number* _x, const Number _weight,
+		Number* _output) const;
+
+private:
+	typedef Eigen::Matrix<double, 6, 1> Vector6d;
+	typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+	struct AngleMoments
+	{
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+		AngleMoments(const Number _angle);
+
+		Number angle_;
+		Number sum_weight_;
+		Eigen::Vector3d sum_x_;
+		Eigen::Vector3d sum_y_;
+		Eigen::Matrix3d sum_xx_;
+		Eigen::Matrix3d sum_xy_;
+		Number sum_yy_;
+	};
+
+	struct SymmetryGroup
+	{
+		Index n_index_;
+		Index t_index_;
+		std::vector<AngleMoments, Eigen::aligned_allocator<AngleMoments> > angle_moments_;
+	};
+
+	// Local variable order: (n, t).
+	void eval_symmetry_group(const SymmetryGroup &_group, const Number* _x,
+		Number &_value, Vector6d *_gradient, Matrix6d *_hessian) const;
+
+	Number weight_;
+	std::vector<SymmetryGroup> symmetry_groups_;
+};
+
+#endif	// _MESH_CUBOID_ROTATION_SYMMETRY_FUNCTION_H_
@@ -1,16 +1,27 @@
 #ifndef _MESH_CUBOID_SOLVER_H_
 #define _MESH_CUBOID_SOLVER_H_
 
-#include "GLViewerCore.h"
 #include "MeshCuboid.h"
 #include "MeshCuboidRelation.h"
 #include "MeshCuboidPredictor.h"
+#include "MeshCuboidSymmetryGroup.h"
 
 #include <vector>
 #include <string>
 #include <Eigen/Core>
 
 
+// NOTE:
+// Notified whenever cuboids are updated during the optimization
+// (e.g. viewers redraw the scene). The solver itself does not depend on GL.
+class MeshCuboidSolverObserver
+{
+public:
+	virtual ~MeshCuboidSolverObserver() {}
+	virtual void cuboids_updated() = 0;
+};
+
+
 std::vector<int> solve_markov_random_field(
 	const unsigned int _num_nodes,
 	const unsigned int _num_labels,
@@ -47,6 +58,7 @@ void recognize_labels_and_axes_configurations(
 void test_recognize_labels_and_axes_configurations(
 	const std::vector<Label> &_labels,
 	const std::vector<MeshCuboid *>& _cuboids,
+	const LabelConfidenceTable &_label_confidences,
 	const MeshCuboidPredictor &_predictor);
 
 void get_optimization_formulation(
@@ -73,7 +85,8 @@ void optimize_attributes_once(
 	const MeshCuboidPredictor &_predictor,
 	const double _single_energy_term_weight,
 	const double _symmetry_energy_term_weight,
-	bool _use_symmetry);
+	bool _use_symmetry,
+	MeshCuboidSamplePointGrids *_cuboid_sample_point_grids = NULL);
 
 void optimize_attributes(
 	MeshCuboidStructure &_cuboid_structure,
@@ -83,7 +96,7 @@ void optimize_attributes(
 	const double _symmetry_energy_term_weight,
 	const unsigned int _max_num_iterations,
 	const std::string _log_filename,
-	GLViewerCore *_viewer,
+	MeshCuboidSolverObserver *_observer,
 	bool _use_symmetry);
 
 void add_missing_cuboids_once(
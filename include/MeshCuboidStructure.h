@@ -11,15 +11,18 @@
 
 #include "MyMesh.h"
 #include "MeshCuboid.h"
+#include "MeshCuboidParameters.h"
 #include "MeshCuboidSymmetryGroup.h"
 
+#include <iostream>
 #include <vector>
 #include <set>
 
 
 class MeshCuboidStructure {
 public:
-	MeshCuboidStructure(const MyMesh *_mesh);
+	MeshCuboidStructure(const MyMesh *_mesh,
+		const MeshCuboidParameters &_params = MeshCuboidParameters());
 	MeshCuboidStructure(const MeshCuboidStructure& _other);	// Copy constructor.
 	~MeshCuboidStructure();
 
@@ -33,11 +36,26 @@ public:
 
 	void clear_label_sample_points(const std::vector<LabelIndex> &_label_indices);
 
+	// NOTE:
+	// Parameters are not cleared in 'clear()', and are copied with the structure.
+	// The storage of the label confidences is changed with the parameters.
+	const MeshCuboidParameters &get_parameters() const { return params_; }
+	void set_parameters(const MeshCuboidParameters &_params);
+
 	bool load_cuboids(const std::string _filename, bool _verbose = true);
 	bool save_cuboids(const std::string _filename, bool _verbose = true) const;
 
 	bool save_symmetry_groups(const std::string _filename, bool _verbose = true) const;
 
+	// Binary snapshot of labels, sample points (with label confidences), cuboids
+	// (with cuboid surface points) and symmetry groups.
+	// NOTE:
+	// The mesh and the parameters are not stored, and are kept when loading.
+	void save_binary(std::ostream &_stream) const;
+	bool load_binary(std::istream &_stream);
+	bool save_binary(const std::string _filename, bool _verbose = true) const;
+	bool load_binary(const std::string _filename, bool _verbose = true);
+
 	void apply_mesh_transformation();
 
 	inline unsigned int num_sample_points()const {
@@ -67,6 +85,18 @@ public:
 	// Compute segmentation of dense samples using segmented sparse samples.
 	bool load_dense_sample_points(const char *_filename, bool _verbose = true);
 
+	// NOTE:
+	// Sample points on the mesh surface instead of loading the sample point files
+	// (see 'PoissonDiskSampler'). The same numbers of points and seed give the same points.
+	bool sample_points_on_mesh(const unsigned int _num_sample_points,
+		const unsigned int _num_dense_sample_points, const unsigned int _seed, bool _verbose = true);
+
+	// Same with 'load_dense_sample_points()', but the dense points are sampled on the mesh
+	// with the same arguments of 'sample_points_on_mesh()'. Each dense sample point takes
+	// the segmentation of its closest current sample point.
+	bool sample_dense_points_on_mesh(const unsigned int _num_sample_points,
+		const unsigned int _num_dense_sample_points, const unsigned int _seed, bool _verbose = true);
+
 	bool save_sample_points(const char *_filename, bool _verbose = true) const;
 
 	bool save_sample_points_to_ply(const char *_filename, bool _verbose = true) const;
@@ -80,6 +110,10 @@ public:
 	void get_all_cuboid_surface_points(
 		std::vector<MeshCuboidSurfacePoint *> &all_cuboid_surface_points) const;
 
+	// Distances between all pairs of cuboids in the order of 'get_all_cuboids()'
+	// (see 'MeshCuboid::distances_between_cuboids()').
+	void get_all_cuboid_distances(Eigen::MatrixXd &_distances, bool _symmetric = false) const;
+
 	// Get sample point labels from the confidence values.
 	void get_sample_point_label_indices_from_confidences(std::vector<LabelIndex> &_sample_point_label_indices);
 
@@ -90,6 +124,9 @@ public:
 
 	MeshSamplePoint *add_sample_point(const MyMesh::Point& _point, const MyMesh::Normal& _normal);
 
+	// Add a copy of a sample point of this structure (with its label confidence values).
+	MeshSamplePoint *add_sample_point_copy(const MeshSamplePoint *_sample_point);
+
 	void add_sample_points_from_mesh_vertices();
 
 	// Apple mesh face labels to sample points
@@ -97,6 +134,22 @@ public:
 
 	void remove_sample_points(const bool *is_sample_point_removed);
 
+	// NOTE:
+	// Keep one sample point for each (voxel, most confident label) pair, so that points of
+	// different labels in a voxel (e.g. near part boundaries) are not merged. The kept point is
+	// the most confident one. The voxel size is increased until at most '_max_num_sample_points'
+	// points remain (unless all points are in a single voxel).
+	// '_representative_indices': The (new) index of the kept point for each previous sample point.
+	// Return the voxel size, or zero if no point is removed.
+	Real downsample_sample_points(const unsigned int _max_num_sample_points,
+		std::vector<SamplePointIndex> &_representative_indices);
+
+	// Replace the sample points with copies of the sample points of '_other', which were downsampled
+	// to the current sample points ('downsample_sample_points()'). Each point takes the cuboids and
+	// the label confidence values of its representative.
+	void upsample_sample_points(const MeshCuboidStructure &_other,
+		const std::vector<SamplePointIndex> &_representative_indices);
+
 	void compute_label_cuboids();
 
 	// Apple mesh face labels to both sample points and parts,
@@ -156,11 +209,25 @@ public:
 private:
 	inline Label get_new_label()const;
 
+	// Replace the sample points with '_dense_sample_points' (in the mesh coordinates), and copy
+	// the cuboids and label confidences of '_sparse_sample_point_indices' (for each dense point).
+	void set_dense_sample_points(const std::vector<MeshSamplePoint *> &_dense_sample_points,
+		const std::vector<SamplePointIndex> &_sparse_sample_point_indices);
+
+	// Index of the closest current sample point for each of '_points'.
+	void get_closest_sample_point_indices(const std::vector<MeshSamplePoint *> &_points,
+		std::vector<SamplePointIndex> &_closest_sample_point_indices) const;
+
+	MeshCuboidParameters params_;
+
 
 public:
 	const MyMesh *mesh_;
 
 	std::vector<MeshSamplePoint *> sample_points_;
+	// NOTE:
+	// (Sample points x labels) table, which is always resized with the sample points and the labels.
+	LabelConfidenceTable sample_label_confidences_;
 	std::vector<Label> labels_;
 	std::vector<std::string> label_names_;
 	std::vector< std::list<LabelIndex> > label_symmetries_;
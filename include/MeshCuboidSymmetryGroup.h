@@ -11,10 +11,11 @@
 
 #include "MyMesh.h"
 #include "MeshCuboid.h"
+#include "PointHashGrid.h"
 
-#include "ANN/ANN.h"
 #include <array>
 #include <vector>
+#include <Eigen/Core>
 
 
 typedef enum
@@ -39,6 +40,38 @@ struct MeshCuboidSymmetryGroupInfo
 };
 
 
+// NOTE:
+// Sample point grids of cuboids are kept until the sample points of a cuboid change,
+// so that they can be reused across solver iterations.
+class MeshCuboidSamplePointGrids
+{
+public:
+	MeshCuboidSamplePointGrids();
+	~MeshCuboidSamplePointGrids();
+
+	void clear();
+
+	// Return the number of rebuilt grids.
+	unsigned int update(const std::vector<MeshCuboid *> &_cuboids, const Real _neighbor_distance);
+
+	inline unsigned int num_cuboids() const { return grids_.size(); }
+
+	// Each column is a sample point.
+	const Eigen::MatrixXd &get_sample_points(const unsigned int _cuboid_index) const;
+
+	// Return NULL if the cuboid has no sample point.
+	const PointHashGrid *get_grid(const unsigned int _cuboid_index) const;
+
+private:
+	MeshCuboidSamplePointGrids(const MeshCuboidSamplePointGrids &_other);
+	MeshCuboidSamplePointGrids &operator=(const MeshCuboidSamplePointGrids &_other);
+
+	Real neighbor_distance_;
+	std::vector<Eigen::MatrixXd> sample_points_;
+	std::vector<PointHashGrid *> grids_;
+};
+
+
 class MeshCuboidSymmetryGroup
 {
 public:
@@ -49,6 +82,7 @@ public:
 
 	struct WeightedPointPair
 	{
+		WeightedPointPair() : weight_(0.0), angle_(0.0) {}
 		WeightedPointPair(const MyMesh::Point _p1, const MyMesh::Point _p2,
 			const Real _weight = 1.0, Real _angle = 0.0)
 			: p1_(_p1), p2_(_p2), weight_(_weight), angle_(_angle) {}
@@ -75,30 +109,42 @@ public:
 	void get_pair_cuboid_indices(const std::vector<MeshCuboid *>& _cuboids,
 		std::vector< std::pair<unsigned int, unsigned int> > &_pair_cuboid_indices) const;
 
+	// NOTE:
+	// Point pairs are written to a flat buffer. The order of pairs is the same
+	// regardless of the number of threads.
 	void get_symmetric_sample_point_pairs(
 		const std::vector<MeshCuboid *> &_cuboids,
-		const std::vector<ANNpointArray> &_cuboid_ann_points,
-		const std::vector<ANNkd_tree *> &_cuboid_ann_kd_tree,
-		const Real _squared_neighbor_distance,
-		std::list<WeightedPointPair> &_sample_point_pairs) const;
-
-	void get_symmetric_sample_point_pairs(
-		const MeshCuboid *_cuboid_1,
-		const ANNpointArray &_cuboid_ann_points_2,
-		ANNkd_tree *_cuboid_ann_kd_tree_2,
+		const MeshCuboidSamplePointGrids &_cuboid_sample_point_grids,
 		const Real _squared_neighbor_distance,
-		std::list<WeightedPointPair> &_sample_point_pairs) const;
+		std::vector<WeightedPointPair> &_sample_point_pairs) const;
 
+	// '_points_1', '_points_2': Each column is a point.
+	// '_grid_2' should be built from '_points_2'.
 	void get_symmetric_sample_point_pairs(
-		const std::vector<MyMesh::Point> &_cuboid_1_sample_points,
-		const ANNpointArray &_cuboid_ann_points_2,
-		ANNkd_tree *_cuboid_ann_kd_tree_2,
+		const Eigen::MatrixXd &_points_1,
+		const Eigen::MatrixXd &_points_2,
+		const PointHashGrid &_grid_2,
 		const Real _squared_neighbor_distance,
-		std::list<WeightedPointPair> &_sample_point_pairs) const;
+		std::vector<WeightedPointPair> &_sample_point_pairs) const;
 
 	MeshCuboidSymmetryGroupInfo get_symmetry_group_info()const { return info_; }
 
 protected:
+	struct SamplePointPairTask
+	{
+		SamplePointPairTask(const Eigen::MatrixXd *_points_1,
+			const Eigen::MatrixXd *_points_2, const PointHashGrid *_grid_2)
+			: points_1_(_points_1), points_2_(_points_2), grid_2_(_grid_2) {}
+		const Eigen::MatrixXd *points_1_;
+		const Eigen::MatrixXd *points_2_;
+		const PointHashGrid *grid_2_;
+	};
+
+	void get_symmetric_sample_point_pairs(
+		const std::vector<SamplePointPairTask> &_tasks,
+		const Real _squared_neighbor_distance,
+		std::vector<WeightedPointPair> &_sample_point_pairs) const;
+
 	const MeshCuboidSymmetryGroupInfo info_;
 	unsigned int num_symmetry_orders_;
 };
@@ -160,7 +206,8 @@ class MeshCuboidRotationSymmetryGroup : public MeshCuboidSymmetryGroup
 public:
 	static MeshCuboidRotationSymmetryGroup* constructor(
 		const MeshCuboidSymmetryGroupInfo &_info,
-		const std::vector<MeshCuboid *>& _cuboids);
+		const std::vector<MeshCuboid *>& _cuboids,
+		const Real _neighbor_distance);
 	virtual ~MeshCuboidRotationSymmetryGroup();
 	
 	MeshCuboidRotationSymmetryGroup(const MeshCuboidSymmetryGroupInfo &_info);
@@ -176,10 +223,12 @@ public:
 	virtual MeshCuboidSymmetryGroupType get_symmetry_type() const;
 
 
-	bool compute_rotation_angle(const std::vector<MeshCuboid *> &_cuboids);
+	bool compute_rotation_angle(const std::vector<MeshCuboid *> &_cuboids,
+		const Real _neighbor_distance);
 
 	void get_rotation_axis(MyMesh::Normal &_n, MyMesh::Point &_t) const;
 	void set_rotation_axis(const MyMesh::Normal &_n, const MyMesh::Point &_t);
+	void set_num_symmetry_orders(const unsigned int _num_symmetry_orders);
 	void get_rotation_axis_corners(const MyMesh::Point &_point, const Real _size,
 		std::array<MyMesh::Point, 2>& _corners) const;
 
@@ -8,6 +8,7 @@
 
 #include "MeshCuboidStructure.h"
 #include "MeshCuboidPredictor.h"
+#include "MeshCuboidSolver.h"
 #include "MeshCuboidSymmetryGroup.h"
 #include "MeshCuboidTrainer.h"
 
@@ -31,13 +32,16 @@
 
 //== CLASS DEFINITION =========================================================
 
-class MeshViewerCore : public MeshViewerCoreT<MyMesh>
+class MeshViewerCore : public MeshViewerCoreT<MyMesh>, public MeshCuboidSolverObserver
 {
 public:
 	/// default constructor
 	MeshViewerCore(GLViewerBase &_widget);
 	virtual ~MeshViewerCore();
 
+	// Redraw intermediate results of the cuboid solver.
+	virtual void cuboids_updated() { updateGL(); }
+
 	bool open_modelview_matrix_file(const char* _filename);
 	bool save_modelview_matrix_file(const char* _filename);
 	bool save_projection_matrix_file(const char* _filename);
@@ -59,6 +63,7 @@ public:
 	void train();
 	void batch_predict();
 	void predict();
+	void run_batch_prediction();
 	void run_part_assembly();
 	void run_symmetry_detection();
 	void run_symmetry_detection_msh2pln();
@@ -86,6 +91,23 @@ public:
 
 
 private:
+	// Load label information and training data used for prediction.
+	bool load_prediction_info(MeshCuboidTrainer &_trainer);
+
+	void predict(const MeshCuboidTrainer &_trainer);
+
+	// Snapshots and file outputs of the candidate exploration in 'predict()'.
+	class PredictionObserver;
+
+	typedef enum {
+		SnapshotView = 0x01,
+		SnapshotInput = 0x02,
+		SnapshotIntermediate = 0x04
+	} SnapshotStage;
+
+	// Return true if the snapshot of '_stage' is enabled in 'FLAGS_snapshot_stage_mask'.
+	bool is_snapshot_enabled(const SnapshotStage _stage) const;
+
 	typedef enum {
 		LoadMesh,
 		LoadSamplePoints,
@@ -152,7 +174,10 @@ private:
 
 	void set_random_view_direction(bool _set_modelview_matrix = false);
 
-	void compute_view_plane_mask_range(const Real _modelview_matrix[16]);
+	// Compute the mask range covering 'view_plane_mask_proportion_' of the sample points,
+	// and set the range to '_params'.
+	void compute_view_plane_mask_range(const Real _modelview_matrix[16],
+		MeshCuboidParameters &_params);
 
 
 public:
@@ -182,6 +207,8 @@ protected:
 	virtual void draw_scene(const std::string& _draw_mode);
 	virtual void draw_openmesh(const std::string& _drawmode);
 
+	void draw_cuboid(const MeshCuboid *_cuboid);
+
 
 private:
 	double point_size_;
@@ -22,6 +22,7 @@
 #include <OpenMesh/Core/IO/Options.hh>
 #include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
 #include <list>
+#include <string>
 #include <vector>
 
 
@@ -87,6 +88,11 @@ public:
 
 	virtual void clear();
 	void initialize(bool _verbose = true);
+
+	// NOTE:
+	// If '--mesh_cache_dir' is given, the normalized mesh is cached in a binary file
+	// keyed by the hash of the file contents, and the next loads of the same file
+	// skip parsing the file.
 	bool open_mesh(const char* _filename, bool _verbose = true);
 
 	OpenMesh::IO::Options& options() { return options_; }
@@ -95,6 +101,8 @@ public:
 
 	void translate(const Normal _translate);
 	void scale(const Real _scale);
+	// Scale first, and then translate.
+	void scale_and_translate(const Real _scale, const Normal _translate);
 	void reset_transformation();
 
 	// (vertex area) = (sum of adjacent face areas) / (num of adjacent faces)
@@ -149,6 +157,9 @@ public:
 	void extract_zero_value_feature_vertices(const RealArray &_values,
 		const Real _zero_threshold = 0.01);
 
+	// NOTE:
+	// Faces are connected across edges sharing vertex positions, and the normals
+	// of the minority of each connected component are inverted.
 	void make_face_normal_consistent();
 
 	void print_vertex_information(unsigned int _vid) const;
@@ -161,8 +172,26 @@ public:
 
 	static void gray_to_rgb_color(const Real _gray, Real &_r, Real &_g, Real &_b);
 
+	static void hsv_to_rgb_color(const Real _h, const Real _s, const Real _v,
+		Real &_r, Real &_g, Real &_b);
+
 
 private:
+	// Compute the bounding box and the object diameter, and normalize the mesh.
+	// The normals are updated in the same passes if requested.
+	void preprocess(const bool _update_face_normals, const bool _update_vertex_normals,
+		const bool _make_face_normal_consistent, bool _verbose = true);
+
+	// Normalized sum of the adjacent face normals.
+	MyMesh::Normal compute_vertex_normal(const VertexHandle _vh) const;
+
+	// Invert the face normals inconsistent with the majority of each connected component,
+	// and return the number of inverted faces. The vertex normals are not updated.
+	unsigned int orient_face_normals();
+
+	bool load_mesh_cache(const std::string &_filename, bool _verbose = true);
+	bool save_mesh_cache(const std::string &_filename) const;
+
 	bool load_color_map(const char *_filename, bool _verbose = true);
 	bool save_color_map(const char *_filename, bool _verbose = true) const;
 
@@ -0,0 +1,52 @@
+#ifndef _ORIENTED_BBOX_FITTER_H_
+#define _ORIENTED_BBOX_FITTER_H_
+
+#include <vector>
+#include <Eigen/Core>
+
+
+// NOTE:
+// Minimum-volume oriented bounding box of a point set. The initial axes are the principal axes,
+// and then for each axis, the other two axes are rotated about the axis so that the projection
+// of the points has the minimum-area bounding rectangle (rotating calipers on the 2D convex hull).
+// The rotations are repeated while the volume decreases.
+// The workspace is kept in the instance, and no memory is allocated once it is large enough.
+// Use one instance per thread.
+class OrientedBBoxFitter
+{
+public:
+	// '_points': x, y, and z coordinates of each point in order.
+	// '_axes': Each column is a box axis. The axes are in the decreasing order of
+	// the point variances (before the rotation) and form a right-handed frame.
+	void fit(const double *_points, const unsigned int _num_points,
+		Eigen::Matrix3d &_axes, Eigen::Vector3d &_center, Eigen::Vector3d &_size);
+
+private:
+	struct Point2D
+	{
+		double x_;
+		double y_;
+
+		inline bool operator<(const Point2D &_other) const {
+			return (x_ < _other.x_ || (x_ == _other.x_ && y_ < _other.y_));
+		}
+	};
+
+	// Rotate the other two axes about '_axis_index' to the minimum-area bounding rectangle
+	// of the projected points. Return the volume of the new box.
+	double rotate_about_axis(const double *_points, const unsigned int _num_points,
+		const unsigned int _axis_index, Eigen::Matrix3d &_axes);
+
+	// Rotation angle in [-pi/4, pi/4] of the minimum-area bounding rectangle
+	// of the first '_num_points' points in 'points_2d_'.
+	double compute_min_area_rectangle_angle(const unsigned int _num_points, double &_area);
+
+	// Convex hull of the first '_num_points' points in 'points_2d_' in counter-clockwise order.
+	// Return the number of hull points.
+	unsigned int compute_convex_hull(const unsigned int _num_points);
+
+	std::vector<Point2D> points_2d_;
+	std::vector<Point2D> hull_;
+};
+
+#endif	// _ORIENTED_BBOX_FITTER_H_
@@ -0,0 +1,94 @@
+#ifndef _POINT_HASH_GRID_H_
+#define _POINT_HASH_GRID_H_
+
+#include "GeometryReal.h"
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+
+
+// NOTE:
+// In contrast to ANN kd-trees, all queries are read-only and
+// can be called from multiple threads at the same time.
+// Points are stored (and distances are computed) in 'Scalar'. Cells are always computed
+// in double precision, and thus both scalar types give the same cells.
+template <typename Scalar>
+class PointHashGridT
+{
+public:
+	typedef Eigen::Matrix<Scalar, 3, 1> Vector3;
+	typedef Eigen::Matrix<Scalar, 3, Eigen::Dynamic> Matrix3X;
+
+	// '_points': Each column is a point.
+	PointHashGridT(const Eigen::MatrixXd &_points, const double _cell_size);
+	~PointHashGridT();
+
+	inline unsigned int num_points() const {
+		return static_cast<unsigned int>(point_indices_.size());
+	}
+
+	inline unsigned int num_cells() const {
+		return static_cast<unsigned int>(cell_keys_.size());
+	}
+
+	inline double get_cell_size() const { return cell_size_; }
+
+	// Return -1 if the cell has no point.
+	int get_cell_index(const Eigen::Vector3d &_point) const;
+	int get_point_cell_index(const unsigned int _point_index) const;
+
+	// Point indices in a cell are stored in [cell_begin, cell_end) of 'get_cell_point_index()'.
+	inline unsigned int cell_begin(const unsigned int _cell_index) const {
+		return cell_offsets_[_cell_index];
+	}
+	inline unsigned int cell_end(const unsigned int _cell_index) const {
+		return cell_offsets_[_cell_index + 1];
+	}
+	inline unsigned int get_cell_point_index(const unsigned int _offset) const {
+		return point_indices_[_offset];
+	}
+
+	// Non-empty cells within '_cell_radius' cells along each axis around (and including) the given cell
+	// (27 cells when '_cell_radius' is 1).
+	void get_neighbor_cells(const unsigned int _cell_index, const int _cell_radius,
+		std::vector<unsigned int> &_neighbor_cell_indices) const;
+
+	// NOTE:
+	// '_radius' should not be greater than the cell size.
+	bool has_neighbor(const Eigen::Vector3d &_query, const double _radius) const;
+
+	// Return -1 if there is no point within '_radius'.
+	int find_closest_point(const Eigen::Vector3d &_query, const double _radius,
+		double *_distance = NULL) const;
+
+	void get_neighbors(const Eigen::Vector3d &_query, const double _radius,
+		std::vector<unsigned int> &_neighbor_point_indices) const;
+
+private:
+	bool get_cell_coord(const Eigen::Vector3d &_point, Eigen::Vector3i &_coord) const;
+	uint64_t get_cell_key(const Eigen::Vector3i &_coord) const;
+	int find_cell(const uint64_t _key) const;
+
+	// Calls '_func(point_index)' for all points in the 27 cells around '_query'.
+	template<typename Func>
+	void for_each_candidate(const Eigen::Vector3d &_query, Func &_func) const;
+
+	double cell_size_;
+	Eigen::Vector3d min_;
+	Eigen::Vector3i num_axis_cells_;
+
+	// Points sorted by their cells.
+	Matrix3X sorted_points_;
+	std::vector<unsigned int> point_indices_;
+	std::vector<int> point_cell_indices_;
+
+	// Sorted cell keys and the offsets of their points in 'point_indices_'.
+	std::vector<uint64_t> cell_keys_;
+	std::vector<unsigned int> cell_offsets_;
+};
+
+// Both 'PointHashGridT<float>' and 'PointHashGridT<double>' are available.
+typedef PointHashGridT<GeometryReal> PointHashGrid;
+
+#endif	// _POINT_HASH_GRID_H_
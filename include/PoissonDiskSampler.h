@@ -0,0 +1,56 @@
+#ifndef _POISSON_DISK_SAMPLER_H_
+#define _POISSON_DISK_SAMPLER_H_
+
+#include "MyMesh.h"
+
+#include <vector>
+
+
+// NOTE:
+// Sample points on the mesh surface at two densities (instead of loading the sample point files).
+// Dense points are area-weighted random points on the faces, and sparse points are
+// a Poisson-disk subset of the dense points selected by weighted sample elimination
+// [Yuksel 2015]. Thus, each sparse point is also a dense point, and each dense point is
+// mapped to its closest sparse point.
+// Dense points are generated in parallel, but each point takes the same random numbers
+// from a single random sequence, and thus the same seed always gives the same points
+// regardless of the number of threads.
+namespace PoissonDiskSampler {
+	struct SamplePoint
+	{
+		FaceIndex corr_fid_;
+		MyMesh::Point bary_coord_;
+		MyMesh::Point point_;
+		MyMesh::Normal normal_;
+	};
+
+	struct SampleSet
+	{
+		std::vector<SamplePoint> dense_sample_points_;
+
+		// Index of each sparse point in 'dense_sample_points_' (in ascending order).
+		std::vector<unsigned int> sparse_to_dense_indices_;
+
+		// Index of the closest sparse point of each dense point (in 'sparse_to_dense_indices_').
+		std::vector<unsigned int> dense_to_sparse_indices_;
+	};
+
+	// Points are in the current (normalized) mesh coordinates, and normals are the face normals.
+	// '_num_sparse_points' should not be greater than '_num_dense_points'.
+	void sample_points(const MyMesh &_mesh,
+		const unsigned int _num_sparse_points, const unsigned int _num_dense_points,
+		const unsigned int _seed, SampleSet &_sample_set);
+
+	// Area-weighted random points on the faces. Return the surface area.
+	Real sample_dense_points(const MyMesh &_mesh, const unsigned int _num_points,
+		const unsigned int _seed, std::vector<SamplePoint> &_sample_points);
+
+	// Weighted sample elimination of the first '_num_candidate_points' points
+	// (which are already random) down to '_num_sparse_points' points.
+	// '_surface_area': Total area of the surface where the points are sampled.
+	void eliminate_sample_points(const std::vector<SamplePoint> &_sample_points,
+		const unsigned int _num_candidate_points, const unsigned int _num_sparse_points,
+		const Real _surface_area, std::vector<unsigned int> &_sparse_to_dense_indices);
+}
+
+#endif	// _POISSON_DISK_SAMPLER_H_
@@ -0,0 +1,95 @@
+#ifndef _SNAPSHOT_WRITER_H_
+#define _SNAPSHOT_WRITER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct SnapshotImage
+{
+	SnapshotImage() : width_(0), height_(0), num_channels_(3), is_bottom_up_(false) {}
+
+	// Return the pixels of the row 'y' from the top.
+	const unsigned char *row(const unsigned int _y) const;
+
+	unsigned int width_;
+	unsigned int height_;
+
+	// NOTE:
+	// Only the first three channels (RGB) are written.
+	unsigned int num_channels_;
+
+	// True if the rows are stored from the bottom (as in the OpenGL frame buffer).
+	bool is_bottom_up_;
+
+	std::vector<unsigned char> data_;
+};
+
+
+// NOTE:
+// Snapshot images are pushed to a bounded queue, and encoded and written to files
+// in a background thread. 'push()' blocks only when the queue is full.
+class SnapshotWriter
+{
+public:
+	// Write '_image' to '_filename'. Return false if the file cannot be written.
+	typedef bool (*Encoder)(const std::string &_filename, const SnapshotImage &_image);
+
+	SnapshotWriter(const unsigned int _max_queue_size = 8);
+
+	// Write all remaining snapshots before return.
+	~SnapshotWriter();
+
+	// NOTE:
+	// The image data is moved to the queue, and '_image' becomes empty.
+	void push(const std::string &_filename, SnapshotImage &_image, Encoder _encoder);
+
+	// Wait until all pushed snapshots are written.
+	void flush();
+
+	unsigned int num_written() const;
+
+	// Binary PPM (P6).
+	static bool write_ppm(const std::string &_filename, const SnapshotImage &_image);
+
+	// QOI (https://qoiformat.org), RGB channels.
+	static bool write_qoi(const std::string &_filename, const SnapshotImage &_image);
+
+	// Return the encoder and the file extension (e.g. ".ppm") of '_format' ("ppm" or "qoi").
+	// Return false if the format is not supported.
+	static bool get_encoder(const std::string &_format, Encoder &_encoder, std::string &_extension);
+
+private:
+	// Not copyable.
+	SnapshotWriter(const SnapshotWriter &);
+	SnapshotWriter& operator=(const SnapshotWriter &);
+
+	struct Job
+	{
+		std::string filename_;
+		SnapshotImage image_;
+		Encoder encoder_;
+	};
+
+	void run();
+
+	const unsigned int max_queue_size_;
+
+	std::deque<Job> queue_;
+	mutable std::mutex mutex_;
+	std::condition_variable job_pushed_;
+	std::condition_variable job_popped_;
+	std::condition_variable job_done_;
+
+	bool is_running_job_;
+	bool is_stopped_;
+	unsigned int num_written_;
+
+	std::thread thread_;
+};
+
+#endif	// _SNAPSHOT_WRITER_H_
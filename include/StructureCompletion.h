@@ -0,0 +1,151 @@
+/**
+* file:	StructureCompletion.h
+* description:	GL-free and Qt-free interface of the structure completion pipeline.
+*/
+
+#ifndef _STRUCTURE_COMPLETION_H_
+#define _STRUCTURE_COMPLETION_H_
+
+#include "MyMesh.h"
+#include "MeshCuboid.h"
+#include "MeshCuboidParameters.h"
+#include "MeshCuboidRelation.h"
+#include "MeshCuboidStructure.h"
+#include "MeshCuboidTrainer.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+
+
+class MeshCuboidJointNormalRelationPredictor;
+class MeshCuboidPredictionCheckpoint;
+class MeshCuboidSolverObserver;
+
+
+// NOTE:
+// Hooks of the candidate exploration ('StructureCompletion::explore_candidates()').
+// The viewers render snapshots and write files in the hooks. The default hooks do nothing.
+class StructureCompletionObserver
+{
+public:
+	virtual ~StructureCompletionObserver() {}
+
+	// Log file of the candidate. No log is written if it is empty.
+	virtual std::string get_log_filename(const std::string &_candidate_name) { return std::string(); }
+
+	// Notified during the cuboid attribute optimization.
+	virtual MeshCuboidSolverObserver *get_solver_observer() { return NULL; }
+
+	// Called when the candidate starts (or resumes) from '_start_stage'.
+	virtual void candidate_started(const std::string &_candidate_name,
+		const unsigned int _start_stage) {}
+
+	// Called when '_stage' of the candidate is finished (except the last stage).
+	virtual void stage_finished(const std::string &_candidate_name,
+		const unsigned int _stage) {}
+
+	// If true, 'save_checkpoint()' is called with the exploration state after each stage.
+	virtual bool is_checkpoint_enabled() const { return false; }
+	virtual void save_checkpoint(const MeshCuboidPredictionCheckpoint &_state) {}
+
+	// Called for each final cuboid structure. '_final_candidate_index' starts from zero.
+	virtual void candidate_finished(const std::string &_candidate_name,
+		const unsigned int _final_candidate_index,
+		MeshCuboidStructure &_cuboid_structure) {}
+};
+
+
+// NOTE:
+// The model (label information, symmetry groups, and training data) is loaded once,
+// and 'complete()' can be called for any number of inputs (with different parameters).
+// 'complete()' does not modify the model, but it is NOT reentrant since ANN kd-tree searches
+// use global states. Do not call 'complete()' from multiple threads at the same time
+// (use multiple processes instead).
+class StructureCompletion
+{
+public:
+	struct Cuboid
+	{
+		Label label_;
+		MyMesh::Point bbox_center_;
+		std::array<MyMesh::Normal, 3> bbox_axes_;
+		MyMesh::Normal bbox_size_;
+	};
+
+	// One result for each final cuboid structure candidate.
+	struct Result
+	{
+		std::vector<Cuboid> cuboids_;
+
+		// Input points and their copies at the symmetric positions.
+		// 3 x (number of points) matrices.
+		Eigen::MatrixXd points_;
+		Eigen::MatrixXd normals_;
+		std::vector<Label> point_labels_;
+	};
+
+	StructureCompletion();
+	~StructureCompletion();
+
+	void clear();
+
+	// '_label_info_path': Directory containing label information files.
+	// '_training_dir': Directory containing training files.
+	bool load_model(const std::string &_label_info_path,
+		const std::string &_training_dir, bool _verbose = true);
+
+	// Load the model from the paths in the parameters.
+	bool load_model(bool _verbose = true);
+
+	bool is_model_loaded() const { return is_model_loaded_; }
+
+	// '_points', '_normals': 3 x (number of points) matrices of the visible points.
+	// '_point_label_confidences': (number of points) x (number of labels) matrix.
+	// '_modelview_matrix': Modelview matrix of the view point in the normalized
+	// coordinates (as in the pose files), where the object diameter is 1 and
+	// the object stands on the z = 0 plane.
+	// '_params': Parameters of this input. Use 'MeshCuboidParameters()' for the flag values.
+	// Outputs are in the same coordinates with the input points.
+	// Return false if no cuboid is recognized.
+	bool complete(const Eigen::MatrixXd &_points,
+		const Eigen::MatrixXd &_normals,
+		const Eigen::MatrixXd &_point_label_confidences,
+		const Real _modelview_matrix[16],
+		const MeshCuboidParameters &_params,
+		std::vector<Result> &_results) const;
+
+	unsigned int num_labels() const { return label_info_.num_labels(); }
+
+	// Explore the cuboid structure candidates in '_state' (see 'MeshCuboidPredictionCheckpoint').
+	// For each candidate, labels and axes are recognized, sample points are segmented,
+	// cuboid attributes are optimized, and new candidates with missing cuboids are added.
+	// A candidate becomes a final one if no missing cuboid is added.
+	// The current candidate is copied to '_cuboid_structure' (e.g. for rendering).
+	// '_modelview_matrix': Modelview matrix of the occlusion test.
+	static void explore_candidates(MeshCuboidPredictionCheckpoint &_state,
+		MeshCuboidStructure &_cuboid_structure,
+		const MeshCuboidTrainer &_trainer,
+		const MeshCuboidJointNormalRelationPredictor &_predictor,
+		const Real _modelview_matrix[16],
+		const MeshCuboidParameters &_params,
+		StructureCompletionObserver *_observer = NULL);
+
+private:
+	// Not copyable.
+	StructureCompletion(const StructureCompletion &);
+	StructureCompletion& operator=(const StructureCompletion &);
+
+	bool is_model_loaded_;
+
+	// NOTE:
+	// Only labels and symmetry information are stored in 'label_info_'.
+	// 'label_info_mesh_' is an empty mesh, and must be declared before 'label_info_'.
+	MyMesh label_info_mesh_;
+	MeshCuboidStructure label_info_;
+	MeshCuboidTrainer trainer_;
+	std::vector< std::vector<MeshCuboidJointNormalRelations *> > joint_normal_relations_;
+};
+
+#endif	// _STRUCTURE_COMPLETION_H_
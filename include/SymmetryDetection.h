@@ -1,6 +1,20 @@
 #ifndef _SYMMETRY_DETECTION_H_
 #define _SYMMETRY_DETECTION_H_
 
+// Maximum/minimum number of RANSAC hypotheses.
+#define SYMMETRY_DETECTION_MAX_NUM_ITERATIONS	1000
+#define SYMMETRY_DETECTION_MIN_NUM_ITERATIONS	100
+#define SYMMETRY_DETECTION_BATCH_SIZE			64
+// Stop when the plane hit by the fewest hypotheses would have been found with this probability.
+#define SYMMETRY_DETECTION_CONFIDENCE			0.99
+// Number of hypotheses after the last new plane before stopping.
+#define SYMMETRY_DETECTION_MIN_NUM_ITERATIONS_AFTER_NEW_PLANE	300
+// Number of points used for pre-scoring each hypothesis.
+#define SYMMETRY_DETECTION_NUM_PRESCORE_POINTS	32
+// Planes whose normals differ less than this angle (in degree) are merged.
+#define SYMMETRY_DETECTION_MERGE_ANGLE			5.0
+#define SYMMETRY_DETECTION_RANDOM_SEED			1000
+
 #include <list>
 #include <vector>
 #include <ANN/ANN.h>
@@ -16,16 +30,22 @@ namespace SymmetryDetection {
 		std::vector<unsigned int> inlier_indices_;
 	};
 
+	// NOTE:
+	// Hypotheses are evaluated in parallel, but each of them has its own
+	// random number stream derived from '_seed' and the hypothesis index.
+	// Thus, the result is the same for a given seed regardless of the number of threads.
 	void detect_reflectional_symmetry(
 		const Eigen::MatrixXd &_points,
 		const double &_inlier_dist, const double &_inlier_ratio,
-		std::list<ReflectionPlane> &_reflection_planes);
+		std::list<ReflectionPlane> &_reflection_planes,
+		const unsigned int _seed = SYMMETRY_DETECTION_RANDOM_SEED);
 
 	void detect_reflectional_symmetry(
 		const Eigen::MatrixXd &_sparse_points,
 		const Eigen::MatrixXd &_dense_points,
 		const double &_inlier_dist, const double &_inlier_ratio,
-		std::list<ReflectionPlane> &_reflection_planes);
+		std::list<ReflectionPlane> &_reflection_planes,
+		const unsigned int _seed = SYMMETRY_DETECTION_RANDOM_SEED);
 }
 
 #endif	// _SYMMETRY_DETECTION_H_
\ No newline at end of file
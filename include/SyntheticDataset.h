@@ -0,0 +1,144 @@
+/**
+* file:	SyntheticDataset.h
+* description:	Procedural cuboid-assembly objects (chairs, tables, ...) and
+*	datasets in the same layout with the shape2pose data.
+*/
+
+#ifndef _SYNTHETIC_DATASET_H_
+#define _SYNTHETIC_DATASET_H_
+
+#define SYNTHETIC_DATASET_RANDOM_SEED	20160101
+#define SYNTHETIC_DATASET_AZIMUTH_DEGREES	(-30.0)
+#define SYNTHETIC_DATASET_ELEVATION_DEGREES	30.0
+
+#include "MyMesh.h"
+#include "MeshCuboid.h"
+#include "MeshCuboidSymmetryGroup.h"
+
+#include <array>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+
+
+// NOTE:
+// Objects stand on the z = 0 plane, and their front faces the -y direction.
+// All objects are normalized so that the object diameter is 1 (as done in 'MyMesh::initialize()'),
+// and thus ground truth cuboids are in the same coordinates with the loaded meshes.
+namespace SyntheticDataset {
+	// Box rotated about the z-axis.
+	struct Box
+	{
+		MyMesh::Point center_;
+		MyMesh::Normal size_;
+		Real angle_;
+	};
+
+	struct Part
+	{
+		LabelIndex label_index_;
+		std::vector<Box> boxes_;
+	};
+
+	struct Object
+	{
+		std::string name_;
+		std::vector<Part> parts_;
+	};
+
+	struct Category
+	{
+		std::string name_;
+		std::vector<std::string> label_names_;
+		// Sets of symmetric labels for the local classifiers ('regions_symmetry.txt').
+		std::vector< std::vector<LabelIndex> > label_symmetries_;
+		// Symmetry groups of the part structure ('symmetry_groups.txt').
+		std::vector<MeshCuboidSymmetryGroupInfo> symmetry_groups_;
+	};
+
+	struct SamplePoint
+	{
+		FaceIndex corr_fid_;
+		MyMesh::Point bary_coord_;
+		MyMesh::Point point_;
+		MyMesh::Normal normal_;
+	};
+
+	struct Options
+	{
+		Options();
+
+		std::string output_path_;
+		std::vector<std::string> category_names_;
+		unsigned int num_objects_;
+		unsigned int num_sample_points_;
+		unsigned int num_dense_sample_points_;
+		// Probability that the local classifier predicts a wrong label for a point.
+		Real label_noise_;
+		unsigned int seed_;
+
+		// NOTE:
+		// File names read by the pipeline. The defaults are the default values of
+		// the flags of the same names, and callers pass the flag values if they are changed.
+		std::string training_dir_;
+		std::string label_info_filename_;
+		std::string label_symmetry_info_filename_;
+		std::string symmetry_group_info_filename_;
+		std::string pose_filename_;
+		std::string object_list_filename_;
+		std::string feature_filename_prefix_;
+		std::string transformation_filename_prefix_;
+		std::string joint_normal_relation_filename_prefix_;
+		std::string batch_job_manifest_filename_;
+	};
+
+	// Names of all supported categories.
+	std::vector<std::string> get_category_names();
+
+	// Return false if the category is not supported.
+	bool get_category(const std::string &_category_name, Category &_category);
+
+	// Generate a random object of the category. The same seed gives the same object.
+	void generate_object(const Category &_category, const std::string &_object_name,
+		const unsigned int _seed, Object &_object);
+
+	// Triangle mesh of all boxes. '_face_labels' are label indices of faces.
+	void get_mesh(const Object &_object,
+		std::vector<MyMesh::Point> &_vertices,
+		std::vector< std::array<VertexIndex, 3> > &_faces,
+		std::vector<Label> &_face_labels);
+
+	// Area-weighted random points on the mesh.
+	void sample_points(const std::vector<MyMesh::Point> &_vertices,
+		const std::vector< std::array<VertexIndex, 3> > &_faces,
+		const unsigned int _num_points, const unsigned int _seed,
+		std::vector<SamplePoint> &_sample_points);
+
+	// Simulated local classifier outputs: (number of points) x (number of labels) matrix.
+	void get_label_confidences(const std::vector<SamplePoint> &_sample_points,
+		const std::vector<Label> &_face_labels, const unsigned int _num_labels,
+		const Real _label_noise, const unsigned int _seed,
+		Eigen::MatrixXd &_label_confidences);
+
+	// Axis-aligned bounding box of each part. The caller should delete the cuboids.
+	void get_ground_truth_cuboids(const Object &_object,
+		std::vector<MeshCuboid *> &_cuboids);
+
+	// Modelview matrix (column-major, as in the pose files) of a camera looking at
+	// the center of a normalized object. The default pose is written as the pose file.
+	void get_modelview_matrix(const Real _azimuth_degrees, const Real _elevation_degrees,
+		Real _modelview_matrix[16]);
+
+	// Points facing the camera.
+	// NOTE:
+	// Occlusion by other parts is not considered (unlike rendering in 'MeshViewerCore').
+	void get_visible_sample_points(const std::vector<SamplePoint> &_sample_points,
+		const Real _modelview_matrix[16],
+		std::vector<SamplePoint> &_visible_sample_points);
+
+	// Write label information, meshes, face labels, sample points, sample point labels,
+	// training files, a pose file, an argument file and a job manifest of each category.
+	bool generate_dataset(const Options &_options, bool _verbose = true);
+}
+
+#endif	// _SYNTHETIC_DATASET_H_
@@ -0,0 +1,107 @@
+#ifndef _TRACE_RECORDER_H_
+#define _TRACE_RECORDER_H_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// NOTE:
+// Records pipeline stages as Chrome trace events ('chrome://tracing' or Perfetto).
+// When recording is not started, scopes and counters only check a flag.
+class TraceRecorder
+{
+public:
+	// Clear all events and start recording.
+	static void start();
+
+	// Stop recording and write all events to '_filename' as trace event JSON.
+	// Return false if the file cannot be written.
+	static bool stop(const std::string &_filename);
+
+	// Stop recording and discard all events.
+	static void stop();
+
+	struct StageSummary
+	{
+		unsigned long long count_;
+		// In microseconds.
+		long long total_duration_;
+	};
+
+	// Number of calls and total duration of each stage recorded so far.
+	// NOTE:
+	// Nested stages are also counted in their parent stages.
+	static void get_stage_summaries(std::map<std::string, StageSummary> &_summaries);
+
+	static bool is_recording() { return is_recording_.load(std::memory_order_relaxed); }
+
+	// Set the value of a counter track.
+	static void set_counter(const char *_name, const double _value)
+	{
+		if (is_recording()) record_counter(_name, _value, false);
+	}
+
+	// Add '_value' to a counter track (e.g. the number of kd-tree queries).
+	static void add_counter(const char *_name, const double _value)
+	{
+		if (is_recording()) record_counter(_name, _value, true);
+	}
+
+private:
+	friend class TraceScope;
+
+	struct Event
+	{
+		// 'X': Complete event, 'C': Counter event.
+		char phase_;
+		std::string name_;
+		unsigned int thread_id_;
+		long long timestamp_;
+		long long duration_;
+		std::vector< std::pair<std::string, double> > args_;
+	};
+
+	// Microseconds from the start of recording.
+	static long long now();
+
+	// Small sequential id of the calling thread.
+	static unsigned int thread_id();
+
+	static void record_counter(const char *_name, const double _value, bool _accumulate);
+	static void record(Event &_event);
+
+	static std::atomic<bool> is_recording_;
+	static std::chrono::steady_clock::time_point start_time_;
+	static std::mutex mutex_;
+	static std::vector<Event> events_;
+	static std::map<std::string, double> counters_;
+};
+
+
+// Record the time from the construction to the destruction as a stage.
+// '_name' must be a string literal (or outlive the scope).
+class TraceScope
+{
+public:
+	explicit TraceScope(const char *_name);
+	~TraceScope();
+
+	// Attach a value shown with the stage (e.g. the number of points).
+	void add_arg(const char *_name, const double _value);
+
+private:
+	// Not copyable.
+	TraceScope(const TraceScope &);
+	TraceScope& operator=(const TraceScope &);
+
+	const char *name_;
+	bool is_recording_;
+	long long start_timestamp_;
+	std::vector< std::pair<std::string, double> > args_;
+};
+
+#endif	// _TRACE_RECORDER_H_
@@ -0,0 +1,297 @@
+#include "NLPAugmentedLagrangianSolver.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#include <Eigen/Cholesky>
+
+
+NLPAugmentedLagrangianSolver::NLPAugmentedLagrangianSolver(NLPFormulation *_formulation)
+	: max_num_outer_iterations_(50)
+	, max_num_inner_iterations_(100)
+	, constraint_tolerance_(1.0E-8)
+	, gradient_tolerance_(1.0E-8)
+	, initial_penalty_(1.0E2)
+	, max_penalty_(1.0E14)
+	, formulation_(_formulation)
+	, rho_(0.0)
+	, num_outer_iterations_(0)
+	, num_inner_iterations_(0)
+{
+	assert(formulation_);
+	num_vars_ = formulation_->num_variables();
+	num_constraints_ = formulation_->num_contraints();
+	nnz_constraint_gradients_ = static_cast<Index>(formulation_->nnz_constraint_gradients());
+
+	constraint_lower_bounds_.resize(num_constraints_);
+	constraint_upper_bounds_.resize(num_constraints_);
+	if (num_constraints_ > 0)
+	{
+		formulation_->get_constraint_bounds(
+			&constraint_lower_bounds_[0], &constraint_upper_bounds_[0]);
+	}
+
+	// The structure of the constraint Jacobian does not change.
+	jacobian_constraint_indices_.resize(nnz_constraint_gradients_);
+	jacobian_variable_indices_.resize(nnz_constraint_gradients_);
+	if (nnz_constraint_gradients_ > 0)
+	{
+		std::vector<Number> x;
+		formulation_->get_values(x);
+		formulation_->eval_constraint_gradients(&x[0],
+			&jacobian_constraint_indices_[0], &jacobian_variable_indices_[0], NULL);
+	}
+}
+
+NLPAugmentedLagrangianSolver::~NLPAugmentedLagrangianSolver()
+{
+
+}
+
+Number NLPAugmentedLagrangianSolver::max_constraint_violation(const Number* _x) const
+{
+	if (num_constraints_ == 0)
+		return 0;
+
+	std::vector<Number> constraint_values(num_constraints_);
+	formulation_->eval_constraints(_x, &constraint_values[0]);
+
+	Number max_violation = 0;
+	for (Index i = 0; i < num_constraints_; ++i)
+	{
+		Number violation = std::max(constraint_lower_bounds_[i] - constraint_values[i],
+			constraint_values[i] - constraint_upper_bounds_[i]);
+		max_violation = std::max(max_violation, violation);
+	}
+	return max_violation;
+}
+
+Number NLPAugmentedLagrangianSolver::eval_augmented_lagrangian(const Number* _x,
+	std::vector<Number> &_constraint_values,
+	std::vector<Number> &_multipliers) const
+{
+	Number output = formulation_->eval_function(_x);
+
+	_constraint_values.resize(num_constraints_);
+	_multipliers.resize(num_constraints_);
+	if (num_constraints_ > 0)
+		formulation_->eval_constraints(_x, &_constraint_values[0]);
+
+	for (Index i = 0; i < num_constraints_; ++i)
+	{
+		// PHR: (rho / 2) * dist(c + lambda / rho, [l, u])^2 - lambda^2 / (2 rho).
+		Number shifted_value = _constraint_values[i] + lambda_[i] / rho_;
+		Number projected_value = std::min(std::max(shifted_value,
+			constraint_lower_bounds_[i]), constraint_upper_bounds_[i]);
+		Number diff = shifted_value - projected_value;
+
+		_multipliers[i] = rho_ * diff;
+		output += 0.5 * rho_ * diff * diff - 0.5 * lambda_[i] * lambda_[i] / rho_;
+	}
+
+	return output;
+}
+
+void NLPAugmentedLagrangianSolver::eval_augmented_lagrangian_gradient(const Number* _x,
+	const std::vector<Number> &_multipliers,
+	Eigen::VectorXd &_gradient) const
+{
+	_gradient.resize(num_vars_);
+	formulation_->eval_function_gredient(_x, _gradient.data());
+
+	if (nnz_constraint_gradients_ == 0)
+		return;
+
+	std::vector<Number> jacobian_values(nnz_constraint_gradients_);
+	formulation_->eval_constraint_gradients(_x, NULL, NULL, &jacobian_values[0]);
+
+	for (Index k = 0; k < nnz_constraint_gradients_; ++k)
+	{
+		_gradient[jacobian_variable_indices_[k]] +=
+			_multipliers[jacobian_constraint_indices_[k]] * jacobian_values[k];
+	}
+}
+
+void NLPAugmentedLagrangianSolver::eval_augmented_lagrangian_hessian(const Number* _x,
+	const std::vector<Number> &_multipliers,
+	Eigen::MatrixXd &_hessian) const
+{
+	// Hessian of the Lagrangian with the effective multipliers.
+	const Index nnz_hessian = static_cast<Index>(formulation_->nnz_hessian());
+	std::vector<Number> hessian_values(nnz_hessian);
+	formulation_->eval_hessian(_x, 1.0, (num_constraints_ > 0) ? &_multipliers[0] : NULL,
+		NULL, NULL, &hessian_values[0]);
+
+	_hessian.resize(num_vars_, num_vars_);
+	for (Index index_i = 0; index_i < num_vars_; ++index_i)
+	{
+		for (Index index_j = 0; index_j <= index_i; ++index_j)
+		{
+			Index index = index_i * (index_i + 1) / 2 + index_j;
+			_hessian(index_i, index_j) = _hessian(index_j, index_i) = hessian_values[index];
+		}
+	}
+
+	if (nnz_constraint_gradients_ == 0)
+		return;
+
+	// Gauss-Newton term, rho * J^T J, for active constraints.
+	std::vector<Number> jacobian_values(nnz_constraint_gradients_);
+	formulation_->eval_constraint_gradients(_x, NULL, NULL, &jacobian_values[0]);
+
+	// NOTE:
+	// Jacobian entries are ordered by constraints.
+	Index begin = 0;
+	while (begin < nnz_constraint_gradients_)
+	{
+		const Index constraint_index = jacobian_constraint_indices_[begin];
+		Index end = begin;
+		while (end < nnz_constraint_gradients_ && jacobian_constraint_indices_[end] == constraint_index)
+			++end;
+
+		const bool is_equality = (constraint_upper_bounds_[constraint_index]
+			- constraint_lower_bounds_[constraint_index] <= constraint_tolerance_);
+		if (is_equality || _multipliers[constraint_index] != 0)
+		{
+			for (Index k1 = begin; k1 < end; ++k1)
+				for (Index k2 = begin; k2 < end; ++k2)
+					_hessian(jacobian_variable_indices_[k1], jacobian_variable_indices_[k2]) +=
+					rho_ * jacobian_values[k1] * jacobian_values[k2];
+		}
+
+		begin = end;
+	}
+}
+
+bool NLPAugmentedLagrangianSolver::minimize_subproblem(std::vector<Number> &_x)
+{
+	std::vector<Number> constraint_values, multipliers;
+	Eigen::VectorXd gradient;
+	Eigen::MatrixXd hessian;
+
+	Number value = eval_augmented_lagrangian(&_x[0], constraint_values, multipliers);
+
+	for (unsigned int iteration = 0; iteration < max_num_inner_iterations_; ++iteration)
+	{
+		++num_inner_iterations_;
+
+		eval_augmented_lagrangian_gradient(&_x[0], multipliers, gradient);
+		if (gradient.lpNorm<Eigen::Infinity>() <= gradient_tolerance_ * std::max(1.0, std::abs(value)))
+			return true;
+
+		eval_augmented_lagrangian_hessian(&_x[0], multipliers, hessian);
+
+		// Damped Newton direction.
+		Eigen::VectorXd direction;
+		Number damping = 0;
+		const Number min_damping = 1.0E-10 * std::max(1.0, hessian.diagonal().cwiseAbs().maxCoeff());
+		bool is_descent_direction = false;
+
+		for (unsigned int trial = 0; trial < 20; ++trial)
+		{
+			Eigen::MatrixXd damped_hessian = hessian;
+			damped_hessian.diagonal().array() += damping;
+			Eigen::LDLT<Eigen::MatrixXd> ldlt(damped_hessian);
+
+			if (ldlt.info() == Eigen::Success && ldlt.isPositive())
+			{
+				direction = ldlt.solve(-gradient);
+				if (direction.allFinite() && gradient.dot(direction) < 0)
+				{
+					is_descent_direction = true;
+					break;
+				}
+			}
+
+			damping = std::max(10 * damping, min_damping);
+		}
+
+		if (!is_descent_direction)
+			direction = -gradient;
+
+		// Backtracking line search.
+		const Number slope = gradient.dot(direction);
+		std::vector<Number> new_x(num_vars_);
+		Number step_size = 1.0;
+		bool is_step_accepted = false;
+
+		for (unsigned int trial = 0; trial < 40; ++trial)
+		{
+			for (Index i = 0; i < num_vars_; ++i)
+				new_x[i] = _x[i] + step_size * direction[i];
+
+			Number new_value = eval_augmented_lagrangian(&new_x[0], constraint_values, multipliers);
+			if (new_value <= value + 1.0E-4 * step_size * slope)
+			{
+				value = new_value;
+				is_step_accepted = true;
+				break;
+			}
+			step_size *= 0.5;
+		}
+
+		if (!is_step_accepted)
+		{
+			// Restore the multipliers at the current point.
+			eval_augmented_lagrangian(&_x[0], constraint_values, multipliers);
+			return false;
+		}
+
+		Number max_step = step_size * direction.lpNorm<Eigen::Infinity>();
+		_x.swap(new_x);
+
+		if (max_step <= 1.0E-15 * std::max(1.0, Eigen::Map<Eigen::VectorXd>(&_x[0], num_vars_).lpNorm<Eigen::Infinity>()))
+			return true;
+	}
+
+	return false;
+}
+
+bool NLPAugmentedLagrangianSolver::solve()
+{
+	num_outer_iterations_ = 0;
+	num_inner_iterations_ = 0;
+
+	std::vector<Number> x;
+	formulation_->get_values(x);
+	assert(x.size() == num_vars_);
+
+	lambda_.clear();
+	lambda_.resize(num_constraints_, 0);
+	rho_ = initial_penalty_ * std::max(1.0, std::abs(formulation_->eval_function(&x[0])));
+
+	Number prev_violation = max_constraint_violation(&x[0]);
+	bool is_feasible = false;
+
+	std::vector<Number> constraint_values, multipliers;
+
+	for (unsigned int iteration = 0; iteration < max_num_outer_iterations_; ++iteration)
+	{
+		++num_outer_iterations_;
+
+		bool is_converged = minimize_subproblem(x);
+
+		Number violation = max_constraint_violation(&x[0]);
+		if (violation <= constraint_tolerance_ && is_converged)
+		{
+			is_feasible = true;
+			break;
+		}
+
+		// Update multipliers.
+		eval_augmented_lagrangian(&x[0], constraint_values, multipliers);
+		lambda_ = multipliers;
+
+		if (violation > 0.25 * prev_violation)
+			rho_ = std::min(10 * rho_, max_penalty_);
+		prev_violation = violation;
+	}
+
+	if (!is_feasible)
+		is_feasible = (max_constraint_violation(&x[0]) <= constraint_tolerance_);
+
+	formulation_->set_values(x);
+	return is_feasible;
+}
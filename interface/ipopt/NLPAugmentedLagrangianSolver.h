@@ -0,0 +1,73 @@
+#ifndef __NLP_AUGMENTED_LAGRANGIAN_SOLVER_H__
+#define __NLP_AUGMENTED_LAGRANGIAN_SOLVER_H__
+
+#include <vector>
+
+#include "NLPFormulation.h"
+
+#include <Eigen/Core>
+
+
+// NOTE:
+// Solves an 'NLPFormulation' without the IPOPT application.
+// Each constraint l <= c(x) <= u is handled with a PHR augmented Lagrangian term,
+// and each subproblem is solved with damped Gauss-Newton steps on the dense Hessian.
+class NLPAugmentedLagrangianSolver
+{
+public:
+	NLPAugmentedLagrangianSolver(NLPFormulation *_formulation);
+	~NLPAugmentedLagrangianSolver();
+
+	// Start from the current values of the formulation and store the result to it.
+	// Return true if all constraints are satisfied within the tolerance.
+	bool solve();
+
+	Number max_constraint_violation(const Number* _x) const;
+
+	unsigned int num_outer_iterations() const { return num_outer_iterations_; }
+	unsigned int num_inner_iterations() const { return num_inner_iterations_; }
+
+
+	unsigned int max_num_outer_iterations_;
+	unsigned int max_num_inner_iterations_;
+	Number constraint_tolerance_;
+	Number gradient_tolerance_;
+	Number initial_penalty_;
+	Number max_penalty_;
+
+private:
+	// Return the augmented Lagrangian value.
+	// '_multipliers': Effective multipliers, rho * (c + lambda / rho - proj(c + lambda / rho)).
+	Number eval_augmented_lagrangian(const Number* _x,
+		std::vector<Number> &_constraint_values,
+		std::vector<Number> &_multipliers) const;
+
+	void eval_augmented_lagrangian_gradient(const Number* _x,
+		const std::vector<Number> &_multipliers,
+		Eigen::VectorXd &_gradient) const;
+
+	void eval_augmented_lagrangian_hessian(const Number* _x,
+		const std::vector<Number> &_multipliers,
+		Eigen::MatrixXd &_hessian) const;
+
+	// Return true if the gradient norm is less than the tolerance.
+	bool minimize_subproblem(std::vector<Number> &_x);
+
+	NLPFormulation *formulation_;
+	Index num_vars_;
+	Index num_constraints_;
+	Index nnz_constraint_gradients_;
+
+	std::vector<Number> constraint_lower_bounds_;
+	std::vector<Number> constraint_upper_bounds_;
+	std::vector<Index> jacobian_constraint_indices_;
+	std::vector<Index> jacobian_variable_indices_;
+
+	std::vector<Number> lambda_;
+	Number rho_;
+
+	unsigned int num_outer_iterations_;
+	unsigned int num_inner_iterations_;
+};
+
+#endif	// __NLP_AUGMENTED_LAGRANGIAN_SOLVER_H__
@@ -8,7 +8,7 @@
 #include <string>
 #include <vector>
 
-#include "IpTNLP.hpp"
+#include "NLPTypes.h"
 
 using namespace Ipopt;
 //typedef double Number;
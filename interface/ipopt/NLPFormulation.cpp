@@ -365,6 +365,8 @@ void NLPFormulation::eval_function_gredient(const Number* _x, Number* _output) c
 
 		for (int i = 0; i < num_vars_; ++i)
 			_output[i] += temp[i];
+
+		delete[] temp;
 	}
 }
 
@@ -0,0 +1,15 @@
+#ifndef __NLP_TYPES_H__
+#define __NLP_TYPES_H__
+
+// NOTE:
+// The same types as in 'IpTypes.hpp'. The NLP formulation and
+// 'NLPAugmentedLagrangianSolver' do not require the IPOPT headers,
+// and the IPOPT interface ('IPOPTSolver') includes 'IpTNLP.hpp' itself.
+// A typedef can be redeclared with the same type, and thus both headers can be included.
+namespace Ipopt
+{
+	typedef double Number;
+	typedef int Index;
+}
+
+#endif	// __NLP_TYPES_H__
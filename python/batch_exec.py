@@ -20,6 +20,7 @@ dataDir = ""
 expDir = ""
 disallowParallel = False
 disallowRandomView = False
+residentWorkers = False
 numProcessors = 4
 
 
@@ -41,6 +42,7 @@ if len(sys.argv) < 4:
     print("   -n")
     print("   -disallowParallel")
     print("   -disallowRandomView")
+    print("   -resident")
     exit()
 else:
     execType = sys.argv[1]
@@ -55,6 +57,8 @@ else:
             disallowParallel = True
         elif (sys.argv[i] == "-disallowRandomView"):
             disallowRandomView = True
+        elif (sys.argv[i] == "-resident"):
+            residentWorkers = True
         else:
             print("[ERROR] Unknown argument " + sys.argv[i])
             exit()
@@ -76,6 +80,56 @@ removeFiles = []
 cmdList = []
 count = 0
 
+if residentWorkers:
+    # Each worker process loads the training data once and runs its share of
+    # the jobs listed in the manifest file.
+    if execType != "prediction":
+        print("[ERROR] -resident is supported only for prediction.")
+        exit()
+
+    if not os.path.isdir("script"):
+        os.mkdir("script")
+    if not os.path.isdir("script/" + execType):
+        os.mkdir("script/" + execType)
+
+    manifestFile = "script/" + execType + "/manifest.txt"
+    f = open(manifestFile, 'w')
+    for mName in mListTest:
+        count = count + 1
+        mesh_name = os.path.splitext(mName)[0]
+        temp_occlusion_pose_filepath = "output/" + mesh_name + "/occlusion_pose.txt"
+        if os.path.isfile(temp_occlusion_pose_filepath):
+            f.write(mName + " " + temp_occlusion_pose_filepath + "\n")
+        elif not disallowRandomView:
+            f.write(mName + " - " + str(count) + "\n")
+        else:
+            f.write(mName + "\n")
+    f.close()
+
+    mListTest = []
+    count = 0
+    for workerIndex in range(numProcessors):
+        count = count + 1
+        wName = "worker" + str(workerIndex)
+        cmd = binDir + "OSMesaViewer" + " "
+        cmd += "--flagfile=arguments.txt" + " "
+        cmd += "--run_batch_" + execType + " "
+        cmd += "--batch_job_manifest_filename=" + manifestFile + " "
+        cmd += "--batch_num_workers=" + str(numProcessors) + " "
+        cmd += "--batch_worker_index=" + str(workerIndex) + " "
+
+        scriptFile = "script/" + execType + "/" + wName
+        if not disallowParallel:
+            jobIDs += fas.ScheduleJob(cmd, wName, scriptFile)
+            removeFiles += fas.TmpFilesNames(scriptFile)
+
+        logFile = scriptFile + ".out"
+        f = open(scriptFile + ".sh", 'w');
+        f.write(cmd);
+        f.close();
+        os.system("chmod 777 " + scriptFile + ".sh");
+        cmdList.append((wName, cmd, logFile))
+
 for mName in mListTest:
     count = count + 1
     cmd = binDir + "OSMesaViewer" + " "
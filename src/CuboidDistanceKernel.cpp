@@ -0,0 +1,302 @@
+#include "CuboidDistanceKernel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CUBOID_DISTANCE_KERNEL_AVX2
+#define CUBOID_DISTANCE_KERNEL_AVX2_RUNTIME_CHECK
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#define CUBOID_DISTANCE_KERNEL_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define CUBOID_DISTANCE_KERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+
+namespace CuboidDistanceKernel {
+
+// Number of points in a block. A multiple of the number of SIMD lanes.
+static const unsigned int k_block_size = 64;
+
+// Points of a block in the structure-of-arrays layout.
+struct alignas(32) PointBlock
+{
+	double x_[k_block_size];
+	double y_[k_block_size];
+	double z_[k_block_size];
+};
+
+typedef void(*BlockKernel)(const PointBlock &_block, const Box &_box, double *_distances);
+
+
+// NOTE:
+// For local coordinates 'q' and half sizes 'h', the signed distance is
+// |max(|q| - h, 0)| + min(max_i(|q_i| - h_i), 0).
+static void compute_block_distances_scalar(const PointBlock &_block, const Box &_box,
+	double *_distances)
+{
+	for (unsigned int i = 0; i < k_block_size; ++i)
+	{
+		const double dx = _block.x_[i] - _box.center_[0];
+		const double dy = _block.y_[i] - _box.center_[1];
+		const double dz = _block.z_[i] - _box.center_[2];
+
+		double outside_distance = 0.0;
+		double max_axis_distance = -std::numeric_limits<double>::max();
+		for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+		{
+			const double *axis = _box.axes_[axis_index];
+			const double axis_distance = std::abs(axis[0] * dx + axis[1] * dy + axis[2] * dz)
+				- _box.half_size_[axis_index];
+			const double clamped_axis_distance = std::max(axis_distance, 0.0);
+			outside_distance += clamped_axis_distance * clamped_axis_distance;
+			max_axis_distance = std::max(max_axis_distance, axis_distance);
+		}
+
+		// NOTE:
+		// 'max_axis_distance' is positive outside the box.
+		_distances[i] = (max_axis_distance > 0.0) ? std::sqrt(outside_distance) : max_axis_distance;
+	}
+}
+
+#ifdef CUBOID_DISTANCE_KERNEL_AVX2
+#ifdef CUBOID_DISTANCE_KERNEL_AVX2_RUNTIME_CHECK
+__attribute__((target("avx2,fma")))
+#endif
+static void compute_block_distances_avx2(const PointBlock &_block, const Box &_box,
+	double *_distances)
+{
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256d sign_mask = _mm256_set1_pd(-0.0);
+	const __m256d cx = _mm256_set1_pd(_box.center_[0]);
+	const __m256d cy = _mm256_set1_pd(_box.center_[1]);
+	const __m256d cz = _mm256_set1_pd(_box.center_[2]);
+
+	__m256d axes[3][3], half_sizes[3];
+	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+	{
+		for (unsigned int i = 0; i < 3; ++i)
+			axes[axis_index][i] = _mm256_set1_pd(_box.axes_[axis_index][i]);
+		half_sizes[axis_index] = _mm256_set1_pd(_box.half_size_[axis_index]);
+	}
+
+	for (unsigned int i = 0; i < k_block_size; i += 4)
+	{
+		const __m256d dx = _mm256_sub_pd(_mm256_load_pd(_block.x_ + i), cx);
+		const __m256d dy = _mm256_sub_pd(_mm256_load_pd(_block.y_ + i), cy);
+		const __m256d dz = _mm256_sub_pd(_mm256_load_pd(_block.z_ + i), cz);
+
+		__m256d outside_distance = zero;
+		__m256d max_axis_distance = _mm256_set1_pd(-std::numeric_limits<double>::max());
+		for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+		{
+			__m256d axis_distance = _mm256_mul_pd(axes[axis_index][0], dx);
+			axis_distance = _mm256_fmadd_pd(axes[axis_index][1], dy, axis_distance);
+			axis_distance = _mm256_fmadd_pd(axes[axis_index][2], dz, axis_distance);
+			axis_distance = _mm256_sub_pd(_mm256_andnot_pd(sign_mask, axis_distance), half_sizes[axis_index]);
+
+			const __m256d clamped_axis_distance = _mm256_max_pd(axis_distance, zero);
+			outside_distance = _mm256_fmadd_pd(clamped_axis_distance, clamped_axis_distance, outside_distance);
+			max_axis_distance = _mm256_max_pd(max_axis_distance, axis_distance);
+		}
+
+		_mm256_storeu_pd(_distances + i, _mm256_add_pd(_mm256_sqrt_pd(outside_distance),
+			_mm256_min_pd(max_axis_distance, zero)));
+	}
+}
+#endif	// CUBOID_DISTANCE_KERNEL_AVX2
+
+#ifdef CUBOID_DISTANCE_KERNEL_NEON
+static void compute_block_distances_neon(const PointBlock &_block, const Box &_box,
+	double *_distances)
+{
+	const float64x2_t zero = vdupq_n_f64(0.0);
+	const float64x2_t cx = vdupq_n_f64(_box.center_[0]);
+	const float64x2_t cy = vdupq_n_f64(_box.center_[1]);
+	const float64x2_t cz = vdupq_n_f64(_box.center_[2]);
+
+	float64x2_t axes[3][3], half_sizes[3];
+	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+	{
+		for (unsigned int i = 0; i < 3; ++i)
+			axes[axis_index][i] = vdupq_n_f64(_box.axes_[axis_index][i]);
+		half_sizes[axis_index] = vdupq_n_f64(_box.half_size_[axis_index]);
+	}
+
+	for (unsigned int i = 0; i < k_block_size; i += 2)
+	{
+		const float64x2_t dx = vsubq_f64(vld1q_f64(_block.x_ + i), cx);
+		const float64x2_t dy = vsubq_f64(vld1q_f64(_block.y_ + i), cy);
+		const float64x2_t dz = vsubq_f64(vld1q_f64(_block.z_ + i), cz);
+
+		float64x2_t outside_distance = zero;
+		float64x2_t max_axis_distance = vdupq_n_f64(-std::numeric_limits<double>::max());
+		for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+		{
+			float64x2_t axis_distance = vmulq_f64(axes[axis_index][0], dx);
+			axis_distance = vfmaq_f64(axis_distance, axes[axis_index][1], dy);
+			axis_distance = vfmaq_f64(axis_distance, axes[axis_index][2], dz);
+			axis_distance = vsubq_f64(vabsq_f64(axis_distance), half_sizes[axis_index]);
+
+			const float64x2_t clamped_axis_distance = vmaxq_f64(axis_distance, zero);
+			outside_distance = vfmaq_f64(outside_distance, clamped_axis_distance, clamped_axis_distance);
+			max_axis_distance = vmaxq_f64(max_axis_distance, axis_distance);
+		}
+
+		vst1q_f64(_distances + i, vaddq_f64(vsqrtq_f64(outside_distance),
+			vminq_f64(max_axis_distance, zero)));
+	}
+}
+#endif	// CUBOID_DISTANCE_KERNEL_NEON
+
+static BlockKernel get_block_kernel()
+{
+#if defined(CUBOID_DISTANCE_KERNEL_AVX2_RUNTIME_CHECK)
+	static const BlockKernel kernel =
+		(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ?
+		compute_block_distances_avx2 : compute_block_distances_scalar;
+	return kernel;
+#elif defined(CUBOID_DISTANCE_KERNEL_AVX2)
+	return compute_block_distances_avx2;
+#elif defined(CUBOID_DISTANCE_KERNEL_NEON)
+	return compute_block_distances_neon;
+#else
+	return compute_block_distances_scalar;
+#endif
+}
+
+const char *get_instruction_set()
+{
+	const BlockKernel kernel = get_block_kernel();
+#ifdef CUBOID_DISTANCE_KERNEL_AVX2
+	if (kernel == compute_block_distances_avx2) return "avx2";
+#endif
+#ifdef CUBOID_DISTANCE_KERNEL_NEON
+	if (kernel == compute_block_distances_neon) return "neon";
+#endif
+	assert(kernel == compute_block_distances_scalar);
+	return "scalar";
+}
+
+// Copy points in [_begin, _begin + k_block_size) to the block.
+// The last point is repeated if there are not enough points.
+static unsigned int load_block(const Eigen::MatrixXd &_points, const unsigned int _begin,
+	PointBlock &_block)
+{
+	const unsigned int num_points = static_cast<unsigned int>(_points.cols());
+	const unsigned int num_block_points = std::min(k_block_size, num_points - _begin);
+	assert(num_block_points > 0);
+
+	for (unsigned int i = 0; i < k_block_size; ++i)
+	{
+		const unsigned int point_index = _begin + std::min(i, num_block_points - 1);
+		_block.x_[i] = _points(0, point_index);
+		_block.y_[i] = _points(1, point_index);
+		_block.z_[i] = _points(2, point_index);
+	}
+
+	return num_block_points;
+}
+
+// Run the kernel for a block, and write the distances of the block points to '_distances'.
+// NOTE:
+// A full block is written directly to the output, since the kernels do not need aligned output.
+static void compute_block_distances(const BlockKernel _kernel, const PointBlock &_block,
+	const unsigned int _num_block_points, const Box &_box, double *_distances)
+{
+	if (_num_block_points == k_block_size)
+	{
+		_kernel(_block, _box, _distances);
+		return;
+	}
+
+	alignas(32) double block_distances[k_block_size];
+	_kernel(_block, _box, block_distances);
+	std::copy(block_distances, block_distances + _num_block_points, _distances);
+}
+
+void compute_signed_distances(const Eigen::MatrixXd &_points,
+	const std::vector<Box> &_boxes, Eigen::MatrixXd &_distances)
+{
+	assert(_points.rows() == 3);
+	const unsigned int num_points = static_cast<unsigned int>(_points.cols());
+	const unsigned int num_boxes = static_cast<unsigned int>(_boxes.size());
+	_distances.resize(num_points, num_boxes);
+
+	const BlockKernel kernel = get_block_kernel();
+	PointBlock block;
+
+	for (unsigned int begin = 0; begin < num_points; begin += k_block_size)
+	{
+		const unsigned int num_block_points = load_block(_points, begin, block);
+
+		for (unsigned int box_index = 0; box_index < num_boxes; ++box_index)
+		{
+			compute_block_distances(kernel, block, num_block_points, _boxes[box_index],
+				_distances.col(box_index).data() + begin);
+		}
+	}
+}
+
+void compute_signed_distances(const Eigen::MatrixXd &_points,
+	const Box &_box, Eigen::VectorXd &_distances)
+{
+	assert(_points.rows() == 3);
+	const unsigned int num_points = static_cast<unsigned int>(_points.cols());
+	_distances.resize(num_points);
+
+	const BlockKernel kernel = get_block_kernel();
+	PointBlock block;
+
+	for (unsigned int begin = 0; begin < num_points; begin += k_block_size)
+	{
+		const unsigned int num_block_points = load_block(_points, begin, block);
+		compute_block_distances(kernel, block, num_block_points, _box,
+			_distances.data() + begin);
+	}
+}
+
+void compute_nearest_boxes(const Eigen::MatrixXd &_points,
+	const std::vector<Box> &_boxes, std::vector<int> &_box_indices,
+	Eigen::VectorXd &_distances)
+{
+	assert(_points.rows() == 3);
+	const unsigned int num_points = static_cast<unsigned int>(_points.cols());
+	const unsigned int num_boxes = static_cast<unsigned int>(_boxes.size());
+	_box_indices.assign(num_points, -1);
+	_distances.setConstant(num_points, std::numeric_limits<double>::max());
+
+	const BlockKernel kernel = get_block_kernel();
+	PointBlock block;
+	alignas(32) double block_distances[k_block_size];
+	alignas(32) double min_distances[k_block_size];
+	int min_box_indices[k_block_size];
+
+	for (unsigned int begin = 0; begin < num_points; begin += k_block_size)
+	{
+		const unsigned int num_block_points = load_block(_points, begin, block);
+		std::fill(min_distances, min_distances + k_block_size, std::numeric_limits<double>::max());
+		std::fill(min_box_indices, min_box_indices + k_block_size, -1);
+
+		for (unsigned int box_index = 0; box_index < num_boxes; ++box_index)
+		{
+			kernel(block, _boxes[box_index], block_distances);
+			for (unsigned int i = 0; i < k_block_size; ++i)
+			{
+				const bool is_closer = (block_distances[i] < min_distances[i]);
+				min_distances[i] = is_closer ? block_distances[i] : min_distances[i];
+				min_box_indices[i] = is_closer ? static_cast<int>(box_index) : min_box_indices[i];
+			}
+		}
+
+		std::copy(min_distances, min_distances + num_block_points, _distances.data() + begin);
+		std::copy(min_box_indices, min_box_indices + num_block_points, _box_indices.begin() + begin);
+	}
+}
+
+}
@@ -1,4 +1,5 @@
 #include "ICP.h"
+#include "TraceRecorder.h"
 
 #include <assert.h>
 #include <Eigen/Geometry>
@@ -70,6 +71,8 @@ namespace ICP {
 			_closest_data_values.col(point_index) = _data_values.col(closest_Y_point_index);
 		}
 
+		TraceRecorder::add_counter("kd_queries", num_queries);
+
 		// Deallocate ANN.
 		annDeallocPt(q);
 		delete[] nn_idx;
@@ -102,6 +105,8 @@ namespace ICP {
 			_distances[point_index] = std::sqrt(dd[0]);
 		}
 
+		TraceRecorder::add_counter("kd_queries", num_queries);
+
 		// Deallocate ANN.
 		annDeallocPt(q);
 		delete[] nn_idx;
@@ -0,0 +1,657 @@
+#include "LabelConfidenceTable.h"
+
+#include "BinaryIO.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+
+// IEEE 754 half precision (round to nearest even).
+static uint16_t float_to_half(const float _value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &_value, sizeof(bits));
+
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t abs_bits = bits & 0x7FFFFFFF;
+
+	// Infinity or NaN.
+	if (abs_bits >= 0x7F800000)
+		return static_cast<uint16_t>(sign | (abs_bits > 0x7F800000 ? 0x7E00 : 0x7C00));
+
+	// Overflow.
+	if (abs_bits >= 0x477FF000)
+		return static_cast<uint16_t>(sign | 0x7C00);
+
+	// Subnormal or zero.
+	if (abs_bits < 0x38800000)
+	{
+		if (abs_bits < 0x33000000)
+			return static_cast<uint16_t>(sign);
+
+		const uint32_t exponent = abs_bits >> 23;
+		const uint32_t mantissa = (abs_bits & 0x7FFFFF) | 0x800000;
+		const uint32_t shift = 126 - exponent;
+		uint32_t half_mantissa = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half_mantissa & 1)))
+			++half_mantissa;
+		return static_cast<uint16_t>(sign | half_mantissa);
+	}
+
+	uint32_t half_bits = (abs_bits - 0x38000000) >> 13;
+	const uint32_t remainder = abs_bits & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half_bits & 1)))
+		++half_bits;
+	return static_cast<uint16_t>(sign | half_bits);
+}
+
+static float half_to_float(const uint16_t _value)
+{
+	const uint32_t sign = static_cast<uint32_t>(_value & 0x8000) << 16;
+	const uint32_t exponent = (_value >> 10) & 0x1F;
+	const uint32_t mantissa = _value & 0x3FF;
+
+	if (exponent == 0)
+	{
+		const float value = std::ldexp(static_cast<float>(mantissa), -24);
+		return (sign ? -value : value);
+	}
+
+	uint32_t bits;
+	if (exponent == 31) bits = sign | 0x7F800000 | (mantissa << 13);
+	else bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// NOTE:
+// All encodings preserve the order of non-negative values,
+// and thus the largest value can be found without decoding.
+struct FloatCodec
+{
+	typedef float Type;
+	static inline float decode(const Type _value) { return _value; }
+	static inline Type encode(const float _value) { return _value; }
+};
+
+struct HalfCodec
+{
+	typedef uint16_t Type;
+	static inline float decode(const Type _value) { return half_to_float(_value); }
+	static inline Type encode(const float _value) { return float_to_half(_value); }
+};
+
+struct ByteCodec
+{
+	typedef uint8_t Type;
+	static inline float decode(const Type _value) { return _value * (1.0f / 255.0f); }
+	static inline Type encode(const float _value) {
+		return static_cast<Type>(std::min(std::max(_value, 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+};
+
+template <typename T>
+static void remove_rows(std::vector<T> &_values, const unsigned int _row_size,
+	const std::vector<bool> &_is_row_removed)
+{
+	size_t new_offset = 0;
+	for (size_t row = 0; row < _is_row_removed.size(); ++row)
+	{
+		if (_is_row_removed[row]) continue;
+		const size_t offset = row * _row_size;
+		if (new_offset != offset)
+			std::copy(_values.begin() + offset, _values.begin() + offset + _row_size,
+			_values.begin() + new_offset);
+		new_offset += _row_size;
+	}
+	_values.resize(new_offset);
+}
+
+template <typename Codec>
+static void get_dense_argmax_labels(const std::vector<typename Codec::Type> &_values,
+	const unsigned int _num_points, const unsigned int _num_labels,
+	std::vector<unsigned int> &_label_indices, std::vector<Real> *_max_values)
+{
+	typedef typename Codec::Type Type;
+
+	for (unsigned int point_index = 0; point_index < _num_points; ++point_index)
+	{
+		const Type *row = &_values[static_cast<size_t>(point_index) * _num_labels];
+		unsigned int max_label_index = 0;
+		Type max_value = row[0];
+		for (unsigned int label_index = 1; label_index < _num_labels; ++label_index)
+		{
+			if (row[label_index] > max_value)
+			{
+				max_value = row[label_index];
+				max_label_index = label_index;
+			}
+		}
+
+		_label_indices[point_index] = max_label_index;
+		if (_max_values) (*_max_values)[point_index] = Codec::decode(max_value);
+	}
+}
+
+template <typename Codec>
+static void normalize_rows(std::vector<typename Codec::Type> &_values,
+	const unsigned int _num_points, const unsigned int _row_size)
+{
+	typedef typename Codec::Type Type;
+	std::vector<float> row_values(_row_size);
+
+	for (unsigned int point_index = 0; point_index < _num_points; ++point_index)
+	{
+		Type *row = &_values[static_cast<size_t>(point_index) * _row_size];
+
+		float sum = 0.0f;
+		for (unsigned int i = 0; i < _row_size; ++i)
+		{
+			row_values[i] = Codec::decode(row[i]);
+			sum += row_values[i];
+		}
+		if (sum <= 0.0f) continue;
+
+		const float inv_sum = 1.0f / sum;
+		for (unsigned int i = 0; i < _row_size; ++i)
+			row[i] = Codec::encode(row_values[i] * inv_sum);
+	}
+}
+
+template <typename Codec>
+static void accumulate_rows(const std::vector<typename Codec::Type> &_values,
+	const unsigned int _row_size, const std::vector<unsigned int> &_point_indices,
+	const std::vector<uint16_t> *_slot_labels, std::vector<Real> &_sums)
+{
+	typedef typename Codec::Type Type;
+
+	for (std::vector<unsigned int>::const_iterator it = _point_indices.begin();
+		it != _point_indices.end(); ++it)
+	{
+		const size_t offset = static_cast<size_t>(*it) * _row_size;
+		const Type *row = &_values[offset];
+
+		if (!_slot_labels)
+		{
+			for (unsigned int i = 0; i < _row_size; ++i)
+				_sums[i] += Codec::decode(row[i]);
+		}
+		else
+		{
+			const uint16_t *labels = &(*_slot_labels)[offset];
+			for (unsigned int i = 0; i < _row_size; ++i)
+				if (labels[i] < _sums.size()) _sums[labels[i]] += Codec::decode(row[i]);
+		}
+	}
+}
+
+const uint16_t LabelConfidenceTable::k_no_label;
+
+#define DISPATCH_ENCODING(_function, ...) \
+	switch (encoding_) { \
+	case FloatEncoding: _function<FloatCodec>(float_values_, __VA_ARGS__); break; \
+	case HalfEncoding: _function<HalfCodec>(half_values_, __VA_ARGS__); break; \
+	case ByteEncoding: _function<ByteCodec>(byte_values_, __VA_ARGS__); break; \
+	default: assert(false); }
+
+LabelConfidenceTable::LabelConfidenceTable(const Encoding _encoding, const unsigned int _top_k)
+	: encoding_(_encoding)
+	, top_k_(_top_k)
+	, num_points_(0)
+	, num_labels_(0)
+{
+}
+
+void LabelConfidenceTable::clear()
+{
+	num_points_ = 0;
+	num_labels_ = 0;
+	float_values_.clear();
+	half_values_.clear();
+	byte_values_.clear();
+	slot_labels_.clear();
+}
+
+void LabelConfidenceTable::set_storage(const Encoding _encoding, const unsigned int _top_k)
+{
+	if (_encoding == encoding_ && _top_k == top_k_)
+		return;
+
+	LabelConfidenceTable table(_encoding, _top_k);
+	table.resize(num_points_, num_labels_);
+
+	std::vector<float> values(num_labels_);
+	for (unsigned int point_index = 0; point_index < num_points_ && num_labels_ > 0; ++point_index)
+	{
+		decode_row(point_index, &values[0]);
+		table.encode_row(point_index, &values[0]);
+	}
+
+	*this = table;
+}
+
+size_t LabelConfidenceTable::memory_size() const
+{
+	return float_values_.size() * sizeof(float) + half_values_.size() * sizeof(uint16_t)
+		+ byte_values_.size() * sizeof(uint8_t) + slot_labels_.size() * sizeof(uint16_t);
+}
+
+void LabelConfidenceTable::resize(const unsigned int _num_points, const unsigned int _num_labels)
+{
+	if (_num_labels != num_labels_)
+	{
+		// NOTE:
+		// Label indices are stored in 16 bits in the sparse mode.
+		assert(_num_labels < k_no_label);
+		clear();
+		num_labels_ = _num_labels;
+	}
+
+	num_points_ = _num_points;
+	const size_t num_values = static_cast<size_t>(num_points_) * num_slots();
+
+	switch (encoding_)
+	{
+	case FloatEncoding: float_values_.resize(num_values, 0.0f); break;
+	case HalfEncoding: half_values_.resize(num_values, 0); break;
+	case ByteEncoding: byte_values_.resize(num_values, 0); break;
+	default: assert(false);
+	}
+
+	if (is_sparse()) slot_labels_.resize(num_values, k_no_label);
+	else slot_labels_.clear();
+}
+
+unsigned int LabelConfidenceTable::add_point()
+{
+	resize(num_points_ + 1, num_labels_);
+	return (num_points_ - 1);
+}
+
+void LabelConfidenceTable::remove_points(const std::vector<bool> &_is_point_removed)
+{
+	assert(_is_point_removed.size() == num_points_);
+
+	switch (encoding_)
+	{
+	case FloatEncoding: remove_rows(float_values_, num_slots(), _is_point_removed); break;
+	case HalfEncoding: remove_rows(half_values_, num_slots(), _is_point_removed); break;
+	case ByteEncoding: remove_rows(byte_values_, num_slots(), _is_point_removed); break;
+	default: assert(false);
+	}
+
+	if (is_sparse()) remove_rows(slot_labels_, num_slots(), _is_point_removed);
+
+	num_points_ = static_cast<unsigned int>(
+		std::count(_is_point_removed.begin(), _is_point_removed.end(), false));
+}
+
+Real LabelConfidenceTable::get(const unsigned int _point_index, const unsigned int _label_index) const
+{
+	assert(_point_index < num_points_);
+	assert(_label_index < num_labels_);
+
+	size_t index = static_cast<size_t>(_point_index) * num_slots();
+	if (!is_sparse())
+	{
+		index += _label_index;
+	}
+	else
+	{
+		const size_t end = index + top_k_;
+		while (index < end && slot_labels_[index] != _label_index) ++index;
+		if (index == end) return 0.0;
+	}
+
+	return get_slot_value(index);
+}
+
+void LabelConfidenceTable::set(const unsigned int _point_index, const unsigned int _label_index,
+	const Real _value)
+{
+	assert(_point_index < num_points_);
+	assert(_label_index < num_labels_);
+	assert(_value >= 0.0);
+
+	if (!is_sparse())
+	{
+		set_slot_value(static_cast<size_t>(_point_index) * num_labels_ + _label_index,
+			static_cast<float>(_value));
+		return;
+	}
+
+	// NOTE:
+	// In the sparse mode, the value replaces the smallest value of the point
+	// if the label is not stored and all slots are used.
+	std::vector<float> values(num_labels_);
+	decode_row(_point_index, &values[0]);
+	values[_label_index] = static_cast<float>(_value);
+
+	unsigned int num_nonzero_values = 0;
+	for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+		if (values[label_index] > 0.0f) ++num_nonzero_values;
+
+	if (num_nonzero_values > top_k_)
+	{
+		unsigned int min_label_index = num_labels_;
+		for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+		{
+			if (label_index == _label_index || values[label_index] <= 0.0f) continue;
+			if (min_label_index == num_labels_ || values[label_index] < values[min_label_index])
+				min_label_index = label_index;
+		}
+
+		assert(min_label_index < num_labels_);
+		if (values[min_label_index] >= values[_label_index]) return;
+		values[min_label_index] = 0.0f;
+	}
+
+	encode_row(_point_index, &values[0]);
+}
+
+void LabelConfidenceTable::get_row(const unsigned int _point_index, std::vector<Real> &_values) const
+{
+	assert(_point_index < num_points_);
+	const size_t offset = static_cast<size_t>(_point_index) * num_slots();
+	_values.assign(num_labels_, 0.0);
+
+	if (!is_sparse())
+	{
+		for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+			_values[label_index] = get_slot_value(offset + label_index);
+		return;
+	}
+
+	for (unsigned int slot = 0; slot < top_k_; ++slot)
+	{
+		const uint16_t label_index = slot_labels_[offset + slot];
+		if (label_index != k_no_label) _values[label_index] = get_slot_value(offset + slot);
+	}
+}
+
+void LabelConfidenceTable::set_row(const unsigned int _point_index, const std::vector<Real> &_values)
+{
+	assert(_values.size() == num_labels_);
+	std::vector<float> values(_values.begin(), _values.end());
+	if (num_labels_ > 0) encode_row(_point_index, &values[0]);
+}
+
+void LabelConfidenceTable::set_zero(const unsigned int _point_index)
+{
+	std::vector<float> values(num_labels_, 0.0f);
+	if (num_labels_ > 0) encode_row(_point_index, &values[0]);
+}
+
+void LabelConfidenceTable::set_one_hot(const unsigned int _point_index, const unsigned int _label_index)
+{
+	assert(_label_index < num_labels_);
+	std::vector<float> values(num_labels_, 0.0f);
+	values[_label_index] = 1.0f;
+	encode_row(_point_index, &values[0]);
+}
+
+void LabelConfidenceTable::copy_row(const unsigned int _point_index,
+	const LabelConfidenceTable &_other, const unsigned int _other_point_index)
+{
+	assert(_other.num_labels_ == num_labels_);
+	std::vector<float> values(num_labels_);
+	if (num_labels_ == 0) return;
+	_other.decode_row(_other_point_index, &values[0]);
+	encode_row(_point_index, &values[0]);
+}
+
+void LabelConfidenceTable::remap_labels(
+	const std::vector< std::vector<unsigned int> > &_new_label_indices,
+	const unsigned int _num_new_labels)
+{
+	assert(_new_label_indices.size() == num_labels_);
+
+	LabelConfidenceTable table(encoding_, top_k_);
+	table.resize(num_points_, _num_new_labels);
+
+	std::vector<float> values(num_labels_);
+	std::vector<float> new_values(_num_new_labels);
+
+	for (unsigned int point_index = 0; point_index < num_points_; ++point_index)
+	{
+		if (num_labels_ > 0) decode_row(point_index, &values[0]);
+		std::fill(new_values.begin(), new_values.end(), 0.0f);
+
+		for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+		{
+			for (std::vector<unsigned int>::const_iterator it = _new_label_indices[label_index].begin();
+				it != _new_label_indices[label_index].end(); ++it)
+			{
+				assert(*it < _num_new_labels);
+				new_values[*it] = values[label_index];
+			}
+		}
+
+		if (_num_new_labels > 0) table.encode_row(point_index, &new_values[0]);
+	}
+
+	*this = table;
+}
+
+void LabelConfidenceTable::get_matrix(Eigen::MatrixXd &_values) const
+{
+	_values.setZero(num_points_, num_labels_);
+	std::vector<float> values(num_labels_);
+
+	for (unsigned int point_index = 0; point_index < num_points_ && num_labels_ > 0; ++point_index)
+	{
+		decode_row(point_index, &values[0]);
+		for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+			_values(point_index, label_index) = values[label_index];
+	}
+}
+
+void LabelConfidenceTable::set_matrix(const Eigen::MatrixXd &_values)
+{
+	resize(static_cast<unsigned int>(_values.rows()), static_cast<unsigned int>(_values.cols()));
+	std::vector<float> values(num_labels_);
+
+	for (unsigned int point_index = 0; point_index < num_points_ && num_labels_ > 0; ++point_index)
+	{
+		for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+			values[label_index] = static_cast<float>(_values(point_index, label_index));
+		encode_row(point_index, &values[0]);
+	}
+}
+
+void LabelConfidenceTable::get_argmax_labels(std::vector<unsigned int> &_label_indices,
+	std::vector<Real> *_max_values) const
+{
+	_label_indices.clear();
+	_label_indices.resize(num_points_, 0);
+	if (_max_values)
+	{
+		_max_values->clear();
+		_max_values->resize(num_points_, 0.0);
+	}
+
+	if (num_labels_ == 0) return;
+
+	if (!is_sparse())
+	{
+		DISPATCH_ENCODING(get_dense_argmax_labels, num_points_, num_labels_, _label_indices, _max_values);
+		return;
+	}
+
+	for (unsigned int point_index = 0; point_index < num_points_; ++point_index)
+	{
+		const size_t offset = static_cast<size_t>(point_index) * top_k_;
+		unsigned int max_label_index = num_labels_;
+		Real max_value = 0.0;
+
+		for (unsigned int slot = 0; slot < top_k_; ++slot)
+		{
+			const unsigned int label_index = slot_labels_[offset + slot];
+			if (label_index == k_no_label) continue;
+
+			const Real value = get_slot_value(offset + slot);
+			if (value > max_value || (value == max_value && label_index < max_label_index))
+			{
+				max_value = value;
+				max_label_index = label_index;
+			}
+		}
+
+		// All values are zero.
+		if (max_label_index == num_labels_) max_label_index = 0;
+
+		_label_indices[point_index] = max_label_index;
+		if (_max_values) (*_max_values)[point_index] = max_value;
+	}
+}
+
+void LabelConfidenceTable::normalize()
+{
+	if (num_labels_ == 0) return;
+	DISPATCH_ENCODING(normalize_rows, num_points_, num_slots());
+}
+
+void LabelConfidenceTable::accumulate(const std::vector<unsigned int> &_point_indices,
+	std::vector<Real> &_sums) const
+{
+	assert(_sums.size() == num_labels_);
+	if (num_labels_ == 0) return;
+
+	const std::vector<uint16_t> *slot_labels = (is_sparse() ? &slot_labels_ : NULL);
+	DISPATCH_ENCODING(accumulate_rows, num_slots(), _point_indices, slot_labels, _sums);
+}
+
+void LabelConfidenceTable::write(std::ostream &_stream) const
+{
+	BinaryIO::write(_stream, static_cast<uint32_t>(encoding_));
+	BinaryIO::write(_stream, top_k_);
+	BinaryIO::write(_stream, num_points_);
+	BinaryIO::write(_stream, num_labels_);
+	BinaryIO::write(_stream, float_values_);
+	BinaryIO::write(_stream, half_values_);
+	BinaryIO::write(_stream, byte_values_);
+	BinaryIO::write(_stream, slot_labels_);
+}
+
+bool LabelConfidenceTable::read(std::istream &_stream)
+{
+	clear();
+
+	uint32_t encoding = 0;
+	bool ret = BinaryIO::read(_stream, encoding);
+	ret = ret && (encoding <= ByteEncoding);
+	if (ret) encoding_ = static_cast<Encoding>(encoding);
+	ret = ret && BinaryIO::read(_stream, top_k_);
+	ret = ret && BinaryIO::read(_stream, num_points_);
+	ret = ret && BinaryIO::read(_stream, num_labels_);
+	ret = ret && BinaryIO::read(_stream, float_values_);
+	ret = ret && BinaryIO::read(_stream, half_values_);
+	ret = ret && BinaryIO::read(_stream, byte_values_);
+	ret = ret && BinaryIO::read(_stream, slot_labels_);
+
+	if (ret)
+	{
+		const size_t num_values = static_cast<size_t>(num_points_) * num_slots();
+		ret = (float_values_.size() == (encoding_ == FloatEncoding ? num_values : 0))
+			&& (half_values_.size() == (encoding_ == HalfEncoding ? num_values : 0))
+			&& (byte_values_.size() == (encoding_ == ByteEncoding ? num_values : 0))
+			&& (slot_labels_.size() == (is_sparse() ? num_values : 0));
+	}
+
+	if (!ret) clear();
+	return ret;
+}
+
+void LabelConfidenceTable::decode_row(const unsigned int _point_index, float *_values) const
+{
+	assert(_point_index < num_points_);
+	const size_t offset = static_cast<size_t>(_point_index) * num_slots();
+
+	if (!is_sparse())
+	{
+		for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+			_values[label_index] = get_slot_value(offset + label_index);
+		return;
+	}
+
+	std::fill(_values, _values + num_labels_, 0.0f);
+	for (unsigned int slot = 0; slot < top_k_; ++slot)
+	{
+		const uint16_t label_index = slot_labels_[offset + slot];
+		if (label_index == k_no_label) continue;
+		assert(label_index < num_labels_);
+		_values[label_index] = get_slot_value(offset + slot);
+	}
+}
+
+void LabelConfidenceTable::encode_row(const unsigned int _point_index, const float *_values)
+{
+	assert(_point_index < num_points_);
+	const size_t offset = static_cast<size_t>(_point_index) * num_slots();
+
+	if (!is_sparse())
+	{
+		for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+			set_slot_value(offset + label_index, _values[label_index]);
+		return;
+	}
+
+	// NOTE:
+	// The largest 'top_k' non-zero values (the smaller label index first if tied).
+	std::vector<unsigned int> label_indices;
+	for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
+		if (_values[label_index] > 0.0f) label_indices.push_back(label_index);
+
+	const unsigned int num_stored = std::min(top_k_, static_cast<unsigned int>(label_indices.size()));
+	std::partial_sort(label_indices.begin(), label_indices.begin() + num_stored, label_indices.end(),
+		[_values](const unsigned int _label_index_1, const unsigned int _label_index_2) {
+		return (_values[_label_index_1] > _values[_label_index_2]
+			|| (_values[_label_index_1] == _values[_label_index_2] && _label_index_1 < _label_index_2));
+	});
+
+	for (unsigned int slot = 0; slot < top_k_; ++slot)
+	{
+		if (slot < num_stored)
+		{
+			slot_labels_[offset + slot] = static_cast<uint16_t>(label_indices[slot]);
+			set_slot_value(offset + slot, _values[label_indices[slot]]);
+		}
+		else
+		{
+			slot_labels_[offset + slot] = k_no_label;
+			set_slot_value(offset + slot, 0.0f);
+		}
+	}
+}
+
+float LabelConfidenceTable::get_slot_value(const size_t _index) const
+{
+	switch (encoding_)
+	{
+	case FloatEncoding: return FloatCodec::decode(float_values_[_index]);
+	case HalfEncoding: return HalfCodec::decode(half_values_[_index]);
+	case ByteEncoding: return ByteCodec::decode(byte_values_[_index]);
+	default: assert(false);
+	}
+	return 0.0f;
+}
+
+void LabelConfidenceTable::set_slot_value(const size_t _index, const float _value)
+{
+	assert(_value >= 0.0f);
+
+	switch (encoding_)
+	{
+	case FloatEncoding: float_values_[_index] = FloatCodec::encode(_value); break;
+	case HalfEncoding: half_values_[_index] = HalfCodec::encode(_value); break;
+	case ByteEncoding: byte_values_[_index] = ByteCodec::encode(_value); break;
+	default: assert(false);
+	}
+}
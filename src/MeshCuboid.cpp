@@ -1,6 +1,10 @@
 #include "MeshCuboid.h"
 
+#include "CuboidDistanceKernel.h"
+#include "GeometryReal.h"
 #include "MeshCuboidParameters.h"
+#include "OrientedBBoxFitter.h"
+#include "TraceRecorder.h"
 #include "Utilities.h"
 #include "simplerandom.h"
 
@@ -18,12 +22,6 @@
 #include <Eigen/SVD>
 #include <Eigen/Geometry>
 
-#if __APPLE__
-#include <GLUT/glut.h>
-#else
-#include <GL/glut.h>
-#endif
-
 // Corners.
 // [0]: - - -
 // [1]: - - +
@@ -622,7 +620,7 @@ void MeshCuboid::rotate(const Eigen::Matrix3d _rotation_mat, bool _update_center
 
 	if (_update_center_size)
 	{
-		assert(num_sample_points() >= FLAGS_param_min_num_cuboid_sample_points);
+		assert(num_sample_points() > 0);
 
 		Eigen::Matrix3d local_coord_rotation_mat;
 		for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
@@ -734,7 +732,7 @@ void MeshCuboid::create_random_points_on_cuboid_surface(
 	assert(all_faces_area > 0);
 
 	// Sample points on each face.
-	static SimpleRandomCong_t rng_cong;
+	SimpleRandomCong_t rng_cong;
 	simplerandom_cong_seed(&rng_cong, CUBOID_SURFACE_SAMPLING_RANDOM_SEED);
 	
 
@@ -974,7 +972,15 @@ void MeshCuboid::update_point_correspondences()
 	delete Y_ann_kd_tree;
 }
 
-void MeshCuboid::compute_cuboid_surface_point_visibility(
+// NOTE:
+// A test point is occluded by an observed point if the observed point is in front of the test point
+// and the angle between them (from the camera) is not greater than atan(radius / |observed point|).
+// The angle is tested with the chord between the unit directions of the points,
+// i.e. |surface / |surface| - observed / |observed||^2 <= 2 * (1 - |observed| / sqrt(|observed|^2 + radius^2)),
+// since comparing cosines close to one is not accurate in single precision.
+// The observed points are transformed once, and the test is done in 'Scalar'.
+template <typename Scalar>
+void MeshCuboid::compute_occlusion_visibility(
 	const Real _modelview_matrix[16],
 	const Real _radius,
 	const std::vector<MeshSamplePoint *> &_given_sample_points,
@@ -985,15 +991,51 @@ void MeshCuboid::compute_cuboid_surface_point_visibility(
 	assert(_modelview_matrix);
 	assert(_radius > 0);
 
+	const unsigned int block_size = 64;
+
 	Eigen::Matrix4d modelview_matrix;
 	for (unsigned int col = 0; col < 4; ++col)
 		for (unsigned int row = 0; row < 4; ++row)
 			modelview_matrix(row, col) = _modelview_matrix[4 * col + row];
 
 	MyMesh::Normal view_direction(
-		-_modelview_matrix[2], -_modelview_matrix[6], -_modelview_matrix[10]);
+		-modelview_matrix(2, 0), -modelview_matrix(2, 1), -modelview_matrix(2, 2));
+
+	// Observed point depths and directions in the model view coordinates (structure of arrays).
+	std::vector<Scalar> observed_z, observed_dir_x, observed_dir_y, observed_dir_z, observed_squared_chord;
+	observed_z.reserve(_given_sample_points.size());
+	observed_dir_x.reserve(_given_sample_points.size());
+	observed_dir_y.reserve(_given_sample_points.size());
+	observed_dir_z.reserve(_given_sample_points.size());
+	observed_squared_chord.reserve(_given_sample_points.size());
+
+	for (std::vector<MeshSamplePoint *>::const_iterator it = _given_sample_points.begin();
+		it != _given_sample_points.end(); it++)
+	{
+		Eigen::Vector4d observed_point_4;
+		observed_point_4 << (*it)->point_[0], (*it)->point_[1], (*it)->point_[2], 1.0;
 
-	unsigned int num_test_points = _test_points.size();
+		Eigen::Vector4d lc_observed_point_4 = modelview_matrix * observed_point_4;
+		Eigen::Vector3d lc_observed_point = lc_observed_point_4.topRows(3) / lc_observed_point_4[3];
+		lc_observed_point[2] -= _radius;
+
+		// Ignore a sample point if it is not visible from this model view.
+		const Real squared_lc_observed_point_len = lc_observed_point.squaredNorm();
+		if (lc_observed_point[2] >= 0 || squared_lc_observed_point_len == 0)
+			continue;
+
+		const Real lc_observed_point_len = std::sqrt(squared_lc_observed_point_len);
+		const Eigen::Vector3d lc_observed_dir = lc_observed_point / lc_observed_point_len;
+		observed_z.push_back(static_cast<Scalar>(lc_observed_point[2]));
+		observed_dir_x.push_back(static_cast<Scalar>(lc_observed_dir[0]));
+		observed_dir_y.push_back(static_cast<Scalar>(lc_observed_dir[1]));
+		observed_dir_z.push_back(static_cast<Scalar>(lc_observed_dir[2]));
+		observed_squared_chord.push_back(static_cast<Scalar>(2.0 * (1.0 - lc_observed_point_len /
+			std::sqrt(squared_lc_observed_point_len + _radius * _radius))));
+	}
+
+	const unsigned int num_observed_points = observed_z.size();
+	const unsigned int num_test_points = _test_points.size();
 	assert(!_test_normals || (*_test_normals).size() == num_test_points);
 	_visibility_values.resize(num_test_points);
 
@@ -1009,82 +1051,75 @@ void MeshCuboid::compute_cuboid_surface_point_visibility(
 			continue;
 		}
 
-		Eigen::Vector3d surface_point;
-		for (unsigned int i = 0; i < 3; ++i)
-			surface_point[i] = _test_points[test_point_index][i];
-
 		Eigen::Vector4d surface_point_4;
-		surface_point_4 << surface_point, 1.0;
+		surface_point_4 << _test_points[test_point_index][0], _test_points[test_point_index][1],
+			_test_points[test_point_index][2], 1.0;
 
-		for (std::vector<MeshSamplePoint *>::const_iterator jt = _given_sample_points.begin();
-			jt != _given_sample_points.end(); jt++)
-		{
-			Eigen::Vector3d observed_point;
-			for (unsigned int i = 0; i < 3; ++i)
-				observed_point[i] = (*jt)->point_[i];
-
-			Eigen::Vector4d observed_point_4;
-			observed_point_4 << observed_point, 1.0;
-
-			// Positions in the model view coordinates.
-			Eigen::Vector4d lc_observed_point_4 = modelview_matrix * observed_point_4;
-			Eigen::Vector3d lc_observed_point = lc_observed_point_4.topRows(3) / lc_observed_point_4[3];
-			lc_observed_point[2] -= _radius;
+		Eigen::Vector4d lc_surface_point_4 = modelview_matrix * surface_point_4;
+		Eigen::Vector3d lc_surface_point = lc_surface_point_4.topRows(3) / lc_surface_point_4[3];
+		const Real lc_surface_point_len = lc_surface_point.norm();
 
-			Eigen::Vector4d lc_surface_point_4 = modelview_matrix * surface_point_4;
-			Eigen::Vector3d lc_surface_point = lc_surface_point_4.topRows(3) / lc_surface_point_4[3];
-
-			Real lc_surface_point_len = lc_surface_point.norm();
-			Real lc_observed_point_len = lc_observed_point.norm();
-
-			Real dot_prod = lc_surface_point.dot(lc_observed_point);
+		// Ignore the surface point if it is not visible from this model view.
+		if (lc_surface_point[2] >= 0 || lc_surface_point_len == 0)
+			continue;
 
-			// Ignore a sample point if either it or the voxel point is not visible
-			// from this model view.
-			if (lc_observed_point[2] >= 0 || lc_surface_point[2] >= 0
-				|| lc_observed_point[2] <= lc_surface_point[2]
-				|| lc_surface_point_len == 0 || lc_observed_point_len == 0)
-				continue;
+		const Scalar sz = static_cast<Scalar>(lc_surface_point[2]);
+		const Scalar sx_dir = static_cast<Scalar>(lc_surface_point[0] / lc_surface_point_len);
+		const Scalar sy_dir = static_cast<Scalar>(lc_surface_point[1] / lc_surface_point_len);
+		const Scalar sz_dir = static_cast<Scalar>(lc_surface_point[2] / lc_surface_point_len);
 
-			Real cos_angle = dot_prod / (lc_surface_point_len * lc_observed_point_len);
-			if (std::acos(cos_angle) <= std::atan(_radius / lc_observed_point_len))
+		// NOTE:
+		// Each block is tested without branches so that the loop is vectorized.
+		for (unsigned int begin = 0; begin < num_observed_points && visibility > 0; begin += block_size)
+		{
+			const unsigned int end = std::min(begin + block_size, num_observed_points);
+			int is_occluded = 0;
+			for (unsigned int k = begin; k < end; ++k)
 			{
-				visibility = 0;
+				const Scalar dx = sx_dir - observed_dir_x[k];
+				const Scalar dy = sy_dir - observed_dir_y[k];
+				const Scalar dz = sz_dir - observed_dir_z[k];
+				is_occluded |= static_cast<int>((observed_z[k] > sz)
+					& (dx * dx + dy * dy + dz * dz <= observed_squared_chord[k]));
 			}
 
-			//Real cos_angle = dot_prod / (lc_surface_point_len * lc_observed_point_len);
-			//Real sin_angle = std::sqrt(1 - cos_angle * cos_angle);
-			//Real tan_angle = sin_angle / cos_angle;
-
-			//if (dot_prod < lc_observed_point_len * lc_observed_point_len)
-			//{
-			//	// NOTE:
-			//	// If the following code is uncommented, a point is considered as a sphere.
-			//	//Real distance = (surface_point - observed_point).norm() / _radius;
-			//	//visibility = min(frag_color.a, distance);
-			//}
-			//else
-			//{
-			//	Real distance = (lc_observed_point_len * tan_angle) / _radius;
-			//	//visibility = min(visibility, distance);
-			//	// NOTE:
-			//	//
-			//	if (distance < 1) visibility = 0;
-			//}
+			if (is_occluded) visibility = 0.0;
 		}
 
 		assert(visibility >= 0.0);
 		assert(visibility <= 1.0);
 	}
+}
+
+template void MeshCuboid::compute_occlusion_visibility<float>(const Real _modelview_matrix[16],
+	const Real _radius, const std::vector<MeshSamplePoint *> &_given_sample_points,
+	const std::vector<MyMesh::Point> &_test_points, const std::vector<MyMesh::Normal> *_test_normals,
+	std::vector<Real> &_visibility_values);
+template void MeshCuboid::compute_occlusion_visibility<double>(const Real _modelview_matrix[16],
+	const Real _radius, const std::vector<MeshSamplePoint *> &_given_sample_points,
+	const std::vector<MyMesh::Point> &_test_points, const std::vector<MyMesh::Normal> *_test_normals,
+	std::vector<Real> &_visibility_values);
+
+void MeshCuboid::compute_cuboid_surface_point_visibility(
+	const Real _modelview_matrix[16],
+	const Real _radius,
+	const std::vector<MeshSamplePoint *> &_given_sample_points,
+	const std::vector<MyMesh::Point> &_test_points,
+	const std::vector<MyMesh::Normal> *_test_normals,
+	const MeshCuboidParameters &_params,
+	std::vector<Real> &_visibility_values)
+{
+	compute_occlusion_visibility<GeometryReal>(_modelview_matrix, _radius,
+		_given_sample_points, _test_points, _test_normals, _visibility_values);
 
 
 	// Test 2D view plane mask for occlusion.
 	//
-	if (FLAGS_use_view_plane_mask)
+	if (_params.use_view_plane_mask_)
 	{
 		std::list<SamplePointIndex> occluded_test_point_indices;
 		MeshCuboid::compute_view_plane_mask_visibility(_modelview_matrix,
-			_test_points, occluded_test_point_indices);
+			_test_points, _params, occluded_test_point_indices);
 
 		for (std::list<SamplePointIndex>::iterator it = occluded_test_point_indices.begin();
 			it != occluded_test_point_indices.end(); ++it)
@@ -1099,6 +1134,7 @@ void MeshCuboid::compute_cuboid_surface_point_visibility(
 
 void MeshCuboid::compute_view_plane_mask_visibility(const Real _modelview_matrix[16],
 	const std::vector<MyMesh::Point>& _points,
+	const MeshCuboidParameters &_params,
 	std::list<SamplePointIndex> &_masked_point_indices)
 {
 	Eigen::Matrix3d rotation_mat;
@@ -1130,8 +1166,8 @@ void MeshCuboid::compute_view_plane_mask_visibility(const Real _modelview_matrix
 
 	Eigen::Vector2d view_plane_mask_range_min;
 	Eigen::Vector2d view_plane_mask_range_max;
-	view_plane_mask_range_min << FLAGS_param_view_plane_mask_min_x, FLAGS_param_view_plane_mask_min_y;
-	view_plane_mask_range_max << FLAGS_param_view_plane_mask_max_x, FLAGS_param_view_plane_mask_max_y;
+	view_plane_mask_range_min << _params.view_plane_mask_min_x_, _params.view_plane_mask_min_y_;
+	view_plane_mask_range_max << _params.view_plane_mask_max_x_, _params.view_plane_mask_max_y_;
 
 	
 	_masked_point_indices.clear();
@@ -1151,6 +1187,7 @@ void MeshCuboid::compute_cuboid_surface_point_visibility(
 	const Real _modelview_matrix[16],
 	const Real _radius,
 	const std::vector<MeshSamplePoint *>& _given_sample_points,
+	const MeshCuboidParameters &_params,
 	bool _use_cuboid_normal)
 {
 	std::vector<MyMesh::Point> test_points(num_cuboid_surface_points());
@@ -1168,10 +1205,10 @@ void MeshCuboid::compute_cuboid_surface_point_visibility(
 
 	if (_use_cuboid_normal)
 		compute_cuboid_surface_point_visibility(_modelview_matrix, _radius,
-		_given_sample_points, test_points, &test_normals, visibility_values);
+		_given_sample_points, test_points, &test_normals, _params, visibility_values);
 	else
 		compute_cuboid_surface_point_visibility(_modelview_matrix, _radius,
-		_given_sample_points, test_points, NULL, visibility_values);
+		_given_sample_points, test_points, NULL, _params, visibility_values);
 
 	assert(visibility_values.size() == num_cuboid_surface_points());
 
@@ -1358,9 +1395,9 @@ void MeshCuboid::update_axes_center_size_corner_points()
 	update_center_size_corner_points();
 }
 
-bool MeshCuboid::compute_bbox()
+bool MeshCuboid::compute_bbox(const MeshCuboidParameters &_params)
 {
-	if (num_sample_points() < FLAGS_param_min_num_cuboid_sample_points)
+	if (num_sample_points() < _params.min_num_cuboid_sample_points_)
 		return false;
 
 #ifdef AXIS_ALIGNED_INITIAL_CUBOID
@@ -1377,78 +1414,35 @@ bool MeshCuboid::compute_bbox()
 
 void MeshCuboid::compute_oriented_bbox()
 {
-	assert(num_sample_points() >= FLAGS_param_min_num_cuboid_sample_points);
+	assert(num_sample_points() > 0);
 
-	Eigen::MatrixXd sample_points_mat(3, num_sample_points());
+	// NOTE:
+	// The buffers are reused in each thread, and no memory is allocated
+	// once they are large enough.
+	static thread_local OrientedBBoxFitter bbox_fitter;
+	static thread_local std::vector<double> sample_point_coords;
+
+	sample_point_coords.resize(3 * num_sample_points());
 	for (SamplePointIndex sapmle_point_index = 0; sapmle_point_index < num_sample_points();
 		++sapmle_point_index)
 	{
-		const MyMesh::Point sample_point = sample_points_[sapmle_point_index]->point_;
+		const MyMesh::Point &sample_point = sample_points_[sapmle_point_index]->point_;
 		for (unsigned int i = 0; i < 3; ++i)
-			sample_points_mat(i, sapmle_point_index) = sample_point[i];
+			sample_point_coords[3 * sapmle_point_index + i] = sample_point[i];
 	}
 
-	Eigen::Vector3d sample_point_mean = sample_points_mat.rowwise().mean();
-	Eigen::MatrixXd centered_sample_points_mat = sample_points_mat.colwise()
-		- sample_point_mean;
-
-	Eigen::Matrix3d rotation_mat;
-	Eigen::Vector3d translation_vec;
-
-	// Initialize (PCA).
-	//Eigen::MatrixXd cov = centered_sample_points_mat * centered_sample_points_mat.adjoint();
-	//Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig(cov);
-	Eigen::JacobiSVD<Eigen::MatrixXd> svd(centered_sample_points_mat, Eigen::ComputeFullU);
-
-
-	// Note:
-	// The eigenvalues are sorted in increasing order.
-	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
-		//rotation_mat.row(axis_index) = eig.eigenvectors().col(3 - axis_index - 1);
-		rotation_mat.row(axis_index) = svd.matrixU().col(axis_index);
-
-	// Fix z-axis direction.
-	if ((rotation_mat.row(0).cross(rotation_mat.row(1))).dot(rotation_mat.row(2)) < 0)
-		rotation_mat.row(2) = -rotation_mat.row(2);
-
-	// Set identity first, and rotate.
-	bbox_axes_[0] = MyMesh::Normal(1.0, 0.0, 0.0);
-	bbox_axes_[1] = MyMesh::Normal(0.0, 1.0, 0.0);
-	bbox_axes_[2] = MyMesh::Normal(0.0, 0.0, 1.0);
-
-	rotate(rotation_mat, true);
+	// Principal axes, and then the minimum-area rectangle about each axis.
+	Eigen::Matrix3d bbox_axes_mat;
+	Eigen::Vector3d bbox_center_vec, bbox_size_vec;
+	bbox_fitter.fit(&sample_point_coords[0], num_sample_points(),
+		bbox_axes_mat, bbox_center_vec, bbox_size_vec);
 
-	// Rotate by each axis and find the minimum size of bounding box.
 	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
 	{
-		Eigen::Vector3d axis_vec;
 		for (unsigned int i = 0; i < 3; ++i)
-			axis_vec[i] = bbox_axes_[axis_index][i];
-
-		const double angle_interval = 1.0 / 180.0 * M_PI;
-		double min_angle = 0.0;
-		double min_bbox_size = std::numeric_limits<double>::max();
-
-		for (double angle = -M_PI_4; angle <= M_PI_4; angle += angle_interval)
-		{
-			MeshCuboid copy_cuboid(*this);
-			Eigen::AngleAxisd axis_rotation(angle, axis_vec);
-			copy_cuboid.rotate(axis_rotation.toRotationMatrix(), true);
-
-			Real bbox_size = 1.0;
-			for (unsigned int i = 0; i < 3; ++i)
-				if (i != axis_index)
-					bbox_size *= copy_cuboid.get_bbox_size()[i];
-			
-			if (bbox_size < min_bbox_size)
-			{
-				min_angle = angle;
-				min_bbox_size = bbox_size;
-			}
-		}
-
-		Eigen::AngleAxisd axis_rotation(min_angle, axis_vec);
-		rotate(axis_rotation.toRotationMatrix(), true);
+			bbox_axes_[axis_index][i] = bbox_axes_mat.col(axis_index)(i);
+		bbox_center_[axis_index] = bbox_center_vec[axis_index];
+		bbox_size_[axis_index] = bbox_size_vec[axis_index];
 	}
 
 	//// ICP-style iterative optimization.
@@ -1517,7 +1511,7 @@ void MeshCuboid::compute_oriented_bbox()
 
 void MeshCuboid::compute_axis_aligned_bbox()
 {
-	assert(num_sample_points() >= FLAGS_param_min_num_cuboid_sample_points);
+	assert(num_sample_points() > 0);
 
 	bbox_axes_[0] = MyMesh::Normal(1.0, 0.0, 0.0);
 	bbox_axes_[1] = MyMesh::Normal(0.0, 1.0, 0.0);
@@ -1541,29 +1535,24 @@ void MeshCuboid::compute_axis_aligned_bbox()
 	bbox_size_ = bbox_max - bbox_min;
 }
 
-void MeshCuboid::update_label_using_sample_points()
+void MeshCuboid::update_label_using_sample_points(const LabelConfidenceTable &_label_confidences)
 {
 	// Update the label based on the label confidence values of sample points.
 	if (num_sample_points() == 0)
 		return;
 	assert(!sample_points_.empty());
 
-	unsigned int num_labels = sample_points_.front()->label_index_confidence_.size();
+	unsigned int num_labels = _label_confidences.num_labels();
 	assert(num_labels > 0);
 
-	std::vector<Real> accumulated_label_confidence(num_labels, 0.0);
-
+	std::vector<SamplePointIndex> sample_point_indices;
+	sample_point_indices.reserve(num_sample_points());
 	for (std::vector<MeshSamplePoint *>::iterator it = sample_points_.begin();
 		it != sample_points_.end(); ++it)
-	{
-		const std::vector<Real>& label_confidence = (*it)->label_index_confidence_;
-		assert(label_confidence.size() == num_labels);
+		sample_point_indices.push_back((*it)->sample_point_index_);
 
-		for (LabelIndex label_index = 0; label_index < num_labels; ++label_index)
-		{
-			accumulated_label_confidence[label_index] += label_confidence[label_index];
-		}
-	}
+	std::vector<Real> accumulated_label_confidence(num_labels, 0.0);
+	_label_confidences.accumulate(sample_point_indices, accumulated_label_confidence);
 
 	LabelIndex new_label_index = 0;
 	for (LabelIndex label_index = 1; label_index < num_labels; ++label_index)
@@ -1578,49 +1567,67 @@ void MeshCuboid::update_label_using_sample_points()
 	label_index_ = new_label_index;
 }
 
-std::vector<MeshCuboid *> MeshCuboid::split_cuboid(const Real _object_diameter)
+std::vector<MeshCuboid *> MeshCuboid::split_cuboid(const Real _object_diameter,
+	const LabelConfidenceTable &_label_confidences,
+	const MeshCuboidParameters &_params)
 {
 	std::vector<MeshCuboid *> sub_cuboids;
+	if (num_sample_points() == 0)
+		return sub_cuboids;
 
-	// Construct a KD-tree.
-	const int dim = 3;
-	ANNpointArray data_pts = annAllocPts(num_sample_points(), dim);	// allocate data points
-
+	// Construct a hash grid.
+	Eigen::MatrixXd sample_points_mat(3, num_sample_points());
 	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
 		++sample_point_index)
 	{
-		for (int i = 0; i < dim; i++)
-			data_pts[sample_point_index][i] = sample_points_[sample_point_index]->point_[i];
+		for (unsigned int i = 0; i < 3; i++)
+			sample_points_mat(i, sample_point_index) = sample_points_[sample_point_index]->point_[i];
 	}
 
-	ANNkd_tree *kd_tree = new ANNkd_tree(data_pts, num_sample_points(), dim);
-	
-	create_sub_cuboids(_object_diameter, kd_tree, sub_cuboids);
-	remove_small_sub_cuboids(sub_cuboids);
+	// NOTE:
+	// Any two points in a cell of size (neighbor distance) / sqrt(3) are within the neighbor distance.
+	// The cell size is slightly reduced so that the rounding error does not break this condition
+	// in 'create_sub_cuboids()'.
+	const Real neighbor_distance = _params.cuboid_split_neighbor_distance_ *
+		std::sqrt(_object_diameter);
+	PointHashGrid sample_point_grid(sample_points_mat, (1.0 - 1.0e-9) * neighbor_distance / std::sqrt(3.0));
+
+	create_sub_cuboids(_object_diameter, sample_points_mat, sample_point_grid,
+		_label_confidences, _params, sub_cuboids);
+	remove_small_sub_cuboids(_params, sub_cuboids);
 	//align_sub_cuboids(_object_diameter, sub_cuboids);
 
-	if (data_pts) annDeallocPts(data_pts);
-	delete kd_tree;
-	annClose();
-
 	return sub_cuboids;
 }
 
+// Union-find root with path halving.
+static unsigned int find_root(std::vector<unsigned int> &_parents, unsigned int _index)
+{
+	while (_parents[_index] != _index)
+	{
+		_parents[_index] = _parents[_parents[_index]];
+		_index = _parents[_index];
+	}
+	return _index;
+}
+
+// The smaller index becomes the root so that the result does not depend on the order of unions.
+static void union_roots(std::vector<unsigned int> &_parents, unsigned int _root_1, unsigned int _root_2)
+{
+	if (_root_1 < _root_2) _parents[_root_2] = _root_1;
+	else if (_root_2 < _root_1) _parents[_root_1] = _root_2;
+}
+
 void MeshCuboid::create_sub_cuboids(const Real _object_diameter,
-	ANNkd_tree* _kd_tree, std::vector<MeshCuboid *> &_sub_cuboids)
+	const Eigen::MatrixXd &_sample_points, const PointHashGrid &_sample_point_grid,
+	const LabelConfidenceTable &_label_confidences,
+	const MeshCuboidParameters &_params, std::vector<MeshCuboid *> &_sub_cuboids)
 {
-	const int dim = 3;
-	const Real squared_neighbor_distance = FLAGS_param_cuboid_split_neighbor_distance *
-		FLAGS_param_cuboid_split_neighbor_distance * _object_diameter;
-	const int num_neighbors = std::min(FLAGS_param_num_sample_point_neighbors,
-		static_cast<int>(num_sample_points()));
-	
-	ANNpoint q = annAllocPt(dim);
-	ANNidxArray nn_idx = new ANNidx[num_neighbors];
-	ANNdistArray dd = new ANNdist[num_neighbors];
+	assert(_sample_points.cols() == num_sample_points());
+	assert(_sample_point_grid.num_points() == num_sample_points());
 
-	bool *is_sample_visited = new bool[num_sample_points()];
-	memset(is_sample_visited, false, num_sample_points() * sizeof(bool));
+	const double squared_neighbor_distance = _params.cuboid_split_neighbor_distance_ *
+		_params.cuboid_split_neighbor_distance_ * _object_diameter;
 
 
 	for (std::vector<MeshCuboid *>::iterator it = _sub_cuboids.begin(); it != _sub_cuboids.end(); ++it)
@@ -1628,92 +1635,179 @@ void MeshCuboid::create_sub_cuboids(const Real _object_diameter,
 	_sub_cuboids.clear();
 
 
-	while (true)
-	{
-		std::vector<MeshSamplePoint *> sub_cuboid_sample_points;
-		sub_cuboid_sample_points.reserve(sample_points_.size());
+	// 1. Connect points within the neighbor distance.
+	// NOTE:
+	// When the cell diagonal is not longer than the neighbor distance, all points in a cell
+	// are connected without the distance test. Then, all points in a cell have the same root,
+	// and pairs of points in two cells are tested only until the cells are connected.
+	// Otherwise, each pair of points is tested unless the points are already connected.
+	std::vector<unsigned int> parents(num_sample_points());
+	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
+		++sample_point_index)
+		parents[sample_point_index] = sample_point_index;
+
+	const double cell_size = _sample_point_grid.get_cell_size();
+	const bool is_cell_connected = (3 * cell_size * cell_size <= squared_neighbor_distance);
+	const int cell_radius = static_cast<int>(std::ceil(std::sqrt(squared_neighbor_distance) / cell_size));
 
-		// 1. Find the seed point that has the highest confidence.
-		int seed_sample_point_index = -1;
+	std::vector<unsigned int> neighbor_cell_indices;
+	unsigned int num_point_pairs = 0;
+
+	for (unsigned int cell_index = 0; cell_index < _sample_point_grid.num_cells(); ++cell_index)
+	{
+		// NOTE:
+		// Point indices in each cell are in ascending order.
+		const unsigned int cell_begin = _sample_point_grid.cell_begin(cell_index);
+		const unsigned int cell_end = _sample_point_grid.cell_end(cell_index);
 
-		for (SamplePointIndex sample_point_index = 0;
-			sample_point_index < num_sample_points(); sample_point_index++)
+		for (unsigned int offset = cell_begin + 1; offset < cell_end; ++offset)
 		{
-			if (is_sample_visited[sample_point_index])
+			const unsigned int sample_point_index = _sample_point_grid.get_cell_point_index(offset);
+			if (is_cell_connected)
 			{
+				parents[sample_point_index] = _sample_point_grid.get_cell_point_index(cell_begin);
 				continue;
 			}
-			else if (seed_sample_point_index < 0)
+
+			for (unsigned int neighbor_offset = cell_begin; neighbor_offset < offset; ++neighbor_offset)
 			{
-				seed_sample_point_index = sample_point_index;
-				continue;
+				const unsigned int neighbor_sample_point_index =
+					_sample_point_grid.get_cell_point_index(neighbor_offset);
+
+				const unsigned int root = find_root(parents, sample_point_index);
+				const unsigned int neighbor_root = find_root(parents, neighbor_sample_point_index);
+				if (root == neighbor_root) continue;
+
+				++num_point_pairs;
+				if ((_sample_points.col(sample_point_index) - _sample_points.col(neighbor_sample_point_index))
+					.squaredNorm() <= squared_neighbor_distance)
+					union_roots(parents, root, neighbor_root);
 			}
-			assert(seed_sample_point_index >= 0);
+		}
+	}
 
-			MeshSamplePoint* sample_point = sample_points_[sample_point_index];
-			MeshSamplePoint* seed_sample_point = sample_points_[seed_sample_point_index];
+	for (unsigned int cell_index = 0; cell_index < _sample_point_grid.num_cells(); ++cell_index)
+	{
+		_sample_point_grid.get_neighbor_cells(cell_index, cell_radius, neighbor_cell_indices);
+		const unsigned int first_sample_point_index = _sample_point_grid.get_cell_point_index(
+			_sample_point_grid.cell_begin(cell_index));
 
-			assert(sample_point);
-			assert(seed_sample_point);
-			assert(label_index_ < sample_point->label_index_confidence_.size());
-			assert(label_index_ < seed_sample_point->label_index_confidence_.size());
+		for (std::vector<unsigned int>::const_iterator it = neighbor_cell_indices.begin();
+			it != neighbor_cell_indices.end(); ++it)
+		{
+			const unsigned int neighbor_cell_index = (*it);
+			if (neighbor_cell_index <= cell_index) continue;
+
+			const unsigned int neighbor_first_sample_point_index = _sample_point_grid.get_cell_point_index(
+				_sample_point_grid.cell_begin(neighbor_cell_index));
+			if (is_cell_connected && find_root(parents, first_sample_point_index)
+				== find_root(parents, neighbor_first_sample_point_index))
+				continue;
 
-			if (sample_point->label_index_confidence_[label_index_] >
-				seed_sample_point->label_index_confidence_[label_index_])
+			bool is_connected = false;
+			for (unsigned int offset = _sample_point_grid.cell_begin(cell_index);
+				!is_connected && offset < _sample_point_grid.cell_end(cell_index); ++offset)
 			{
-				seed_sample_point_index = sample_point_index;
+				const unsigned int sample_point_index = _sample_point_grid.get_cell_point_index(offset);
+
+				for (unsigned int neighbor_offset = _sample_point_grid.cell_begin(neighbor_cell_index);
+					neighbor_offset < _sample_point_grid.cell_end(neighbor_cell_index); ++neighbor_offset)
+				{
+					const unsigned int neighbor_sample_point_index =
+						_sample_point_grid.get_cell_point_index(neighbor_offset);
+
+					if (!is_cell_connected && find_root(parents, sample_point_index)
+						== find_root(parents, neighbor_sample_point_index))
+						continue;
+
+					++num_point_pairs;
+					if ((_sample_points.col(sample_point_index) - _sample_points.col(neighbor_sample_point_index))
+						.squaredNorm() <= squared_neighbor_distance)
+					{
+						union_roots(parents, find_root(parents, sample_point_index),
+							find_root(parents, neighbor_sample_point_index));
+
+						if (is_cell_connected)
+						{
+							is_connected = true;
+							break;
+						}
+					}
+				}
 			}
 		}
+	}
 
-		if (seed_sample_point_index < 0) break;
-		assert(!is_sample_visited[seed_sample_point_index]);
-		assert(sample_points_[seed_sample_point_index]->label_index_confidence_[label_index_]
-			>= FLAGS_param_min_sample_point_confidence);
+	TraceRecorder::add_counter("split_point_pairs", num_point_pairs);
 
 
-		// 2. Propagate to close points.
-		std::deque<SamplePointIndex> queue;
-		queue.push_back((SamplePointIndex)seed_sample_point_index);
-		is_sample_visited[seed_sample_point_index] = true;
+	// 2. Take seed points in the decreasing order of confidence, and create a sub-cuboid
+	// from the component of each seed point.
+	assert(label_index_ < _label_confidences.num_labels());
+	std::vector<SamplePointIndex> seed_sample_point_indices(num_sample_points());
+	std::vector<Real> confidences(num_sample_points());
+	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
+		++sample_point_index)
+	{
+		seed_sample_point_indices[sample_point_index] = sample_point_index;
+		confidences[sample_point_index] = _label_confidences.get(
+			sample_points_[sample_point_index]->sample_point_index_, label_index_);
+	}
 
-		while (!queue.empty())
-		{
-			int curr_sample_point_index = queue.front();
-			queue.pop_front();
-			assert(curr_sample_point_index >= 0 && curr_sample_point_index < num_sample_points());
+	// NOTE:
+	// Points with the same confidence are in the order of indices.
+	std::stable_sort(seed_sample_point_indices.begin(), seed_sample_point_indices.end(),
+		[&confidences](const SamplePointIndex _index_1, const SamplePointIndex _index_2) {
+		return confidences[_index_1] > confidences[_index_2];
+	});
+
+	// Points of each component in the order of indices.
+	std::vector<unsigned int> component_offsets(num_sample_points() + 1, 0);
+	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
+		++sample_point_index)
+		++component_offsets[find_root(parents, sample_point_index) + 1];
+	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
+		++sample_point_index)
+		component_offsets[sample_point_index + 1] += component_offsets[sample_point_index];
 
-			sub_cuboid_sample_points.push_back(sample_points_[curr_sample_point_index]);
+	std::vector<MeshSamplePoint *> component_sample_points(num_sample_points());
+	{
+		std::vector<unsigned int> component_ends(component_offsets.begin(), component_offsets.end() - 1);
+		for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
+			++sample_point_index)
+		{
+			const unsigned int root = find_root(parents, sample_point_index);
+			component_sample_points[component_ends[root]++] = sample_points_[sample_point_index];
+		}
+	}
 
-			MyMesh::Point curr_pos = sample_points_[curr_sample_point_index]->point_;
-			q[0] = curr_pos[0]; q[1] = curr_pos[1]; q[2] = curr_pos[2];
+	std::vector<bool> is_component_visited(num_sample_points(), false);
+	for (std::vector<SamplePointIndex>::const_iterator it = seed_sample_point_indices.begin();
+		it != seed_sample_point_indices.end(); ++it)
+	{
+		const unsigned int root = find_root(parents, *it);
+		if (is_component_visited[root]) continue;
+		is_component_visited[root] = true;
 
-			int num_searched_neighbors = _kd_tree->annkFRSearch(q,
-				squared_neighbor_distance, num_neighbors, nn_idx);
+		assert(confidences[*it] >= _params.min_sample_point_confidence_);
 
-			for (int i = 0; i < std::min(num_neighbors, num_searched_neighbors); i++)
-			{
-				unsigned int next_sample_point_index = (int)nn_idx[i];
-				if (!is_sample_visited[next_sample_point_index])
-				{
-					queue.push_back(next_sample_point_index);
-					is_sample_visited[next_sample_point_index] = true;
-				}
-			}
-		}
+		std::vector<MeshSamplePoint *> sub_cuboid_sample_points(
+			component_sample_points.begin() + component_offsets[root],
+			component_sample_points.begin() + component_offsets[root + 1]);
 
-		if (sub_cuboid_sample_points.size() < FLAGS_param_min_num_cuboid_sample_points)
+		if (sub_cuboid_sample_points.size() < _params.min_num_cuboid_sample_points_)
 			continue;
 
 		MeshCuboid *cuboid = new MeshCuboid(label_index_);
 		cuboid->add_sample_points(sub_cuboid_sample_points);
-		cuboid->compute_bbox();
+		cuboid->compute_bbox(_params);
 
 
 		// Delete too small parts.
 		MyMesh::Normal bb_size = cuboid->get_bbox_size();
-		if (bb_size[0] < FLAGS_param_min_cuboid_bbox_size * _object_diameter
-			&& bb_size[1] < FLAGS_param_min_cuboid_bbox_size * _object_diameter
-			&& bb_size[2] < FLAGS_param_min_cuboid_bbox_size * _object_diameter)
+		if (bb_size[0] < _params.min_cuboid_bbox_size_ * _object_diameter
+			&& bb_size[1] < _params.min_cuboid_bbox_size_ * _object_diameter
+			&& bb_size[2] < _params.min_cuboid_bbox_size_ * _object_diameter)
 		{
 			delete cuboid;
 			continue;
@@ -1723,14 +1817,10 @@ void MeshCuboid::create_sub_cuboids(const Real _object_diameter,
 			_sub_cuboids.push_back(cuboid);
 		}
 	}
-
-	delete[] is_sample_visited;
-	delete[] nn_idx;
-	delete[] dd;
-	annDeallocPt(q);
 }
 
-void MeshCuboid::remove_small_sub_cuboids(std::vector<MeshCuboid *> &_sub_cuboids)
+void MeshCuboid::remove_small_sub_cuboids(const MeshCuboidParameters &_params,
+	std::vector<MeshCuboid *> &_sub_cuboids)
 {
 	if (_sub_cuboids.empty())
 		return;
@@ -1761,7 +1851,7 @@ void MeshCuboid::remove_small_sub_cuboids(std::vector<MeshCuboid *> &_sub_cuboid
 	{
 		Real bb_diag_size = (*it)->get_bbox_diag_length();
 		//assert(bb_diag_size <= seed_cuboid->get_bb_diag_size());
-		if (bb_diag_size < (1 - FLAGS_param_min_cuboid_bbox_diag_length) * seed_cuboid->get_bbox_diag_length())
+		if (bb_diag_size < (1 - _params.min_cuboid_bbox_diag_length_) * seed_cuboid->get_bbox_diag_length())
 		{
 			it = _sub_cuboids.erase(it);
 		}
@@ -1773,7 +1863,8 @@ void MeshCuboid::remove_small_sub_cuboids(std::vector<MeshCuboid *> &_sub_cuboid
 }
 
 MeshCuboid *MeshCuboid::merge_cuboids(const LabelIndex _label_index,
-	const std::vector<MeshCuboid *> _cuboids)
+	const std::vector<MeshCuboid *> _cuboids,
+	const MeshCuboidParameters &_params)
 {
 	MeshCuboid *merged_cuboid = NULL;
 
@@ -1790,7 +1881,7 @@ MeshCuboid *MeshCuboid::merge_cuboids(const LabelIndex _label_index,
 			it != _cuboids.end(); ++it)
 			merged_cuboid->add_sample_points((*it)->sample_points_);
 
-		merged_cuboid->compute_bbox();
+		merged_cuboid->compute_bbox(_params);
 	}
 
 	return merged_cuboid;
@@ -1815,20 +1906,20 @@ void MeshCuboid::print_cuboid()const
 	std::cout << " - volume: " << get_bbox_volume() << std::endl;
 }
 
-void MeshCuboid::draw_cuboid()const
+static void get_cuboid_box(const MeshCuboid *_cuboid, CuboidDistanceKernel::Box &_box)
 {
-	for (unsigned int face_index = 0; face_index < k_num_faces; ++face_index)
+	assert(_cuboid);
+	const MyMesh::Point center = _cuboid->get_bbox_center();
+	const std::array<MyMesh::Normal, 3> axes = _cuboid->get_bbox_axes();
+	const MyMesh::Normal size = _cuboid->get_bbox_size();
+
+	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
 	{
-		glBegin(GL_QUADS);
-		for (unsigned int i = 0; i < k_num_face_corners; ++i)
-		{
-			unsigned int corner_index = k_face_corner_indices[face_index][i];
-			glVertex3f(
-				bbox_corners_[corner_index][0],
-				bbox_corners_[corner_index][1],
-				bbox_corners_[corner_index][2]);
-		}
-		glEnd();
+		const MyMesh::Normal axis = axes[axis_index].normalized();
+		for (unsigned int i = 0; i < 3; ++i)
+			_box.axes_[axis_index][i] = axis[i];
+		_box.center_[axis_index] = center[axis_index];
+		_box.half_size_[axis_index] = 0.5 * std::abs(size[axis_index]);
 	}
 }
 
@@ -1838,105 +1929,286 @@ void MeshCuboid::points_to_cuboid_distances(const Eigen::MatrixXd& _points,
 	// NOTE:
 	// Do not use corner points, but use only center, size, and axes.
 	// The distance becomes less than zero when the point is inside the cuboid.
-	unsigned int num_points = _points.cols();
+	CuboidDistanceKernel::Box box;
+	get_cuboid_box(this, box);
+	CuboidDistanceKernel::compute_signed_distances(_points, box, _distances);
+}
 
-	Eigen::Vector3d bbox_center_vec;
-	for (unsigned int i = 0; i < 3; ++i)
-		bbox_center_vec[i] = bbox_center_[i];
+void MeshCuboid::points_to_cuboids_distances(const Eigen::MatrixXd& _points,
+	const std::vector<MeshCuboid *> &_cuboids, Eigen::MatrixXd &_distances)
+{
+	std::vector<CuboidDistanceKernel::Box> boxes(_cuboids.size());
+	for (unsigned int cuboid_index = 0; cuboid_index < _cuboids.size(); ++cuboid_index)
+		get_cuboid_box(_cuboids[cuboid_index], boxes[cuboid_index]);
 
-	Eigen::MatrixXd centered_points = (_points.colwise() - bbox_center_vec);
-	Eigen::MatrixXd axis_distances(3, num_points);
+	CuboidDistanceKernel::compute_signed_distances(_points, boxes, _distances);
+}
 
-	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
-	{
-		Eigen::Vector3d bbox_axis_vec;
-		for (unsigned int i = 0; i < 3; ++i)
-			bbox_axis_vec[i] = bbox_axes_[axis_index][i];
-		bbox_axis_vec.normalize();
+void MeshCuboid::points_to_nearest_cuboids(const Eigen::MatrixXd& _points,
+	const std::vector<MeshCuboid *> &_cuboids, std::vector<int> &_cuboid_indices,
+	Eigen::VectorXd &_distances)
+{
+	std::vector<CuboidDistanceKernel::Box> boxes(_cuboids.size());
+	for (unsigned int cuboid_index = 0; cuboid_index < _cuboids.size(); ++cuboid_index)
+		get_cuboid_box(_cuboids[cuboid_index], boxes[cuboid_index]);
 
-		// Distance from center along each direction.
-		axis_distances.row(axis_index) =
-			(bbox_axis_vec.transpose() * centered_points).array();
+	CuboidDistanceKernel::compute_nearest_boxes(_points, boxes, _cuboid_indices, _distances);
+}
 
-		axis_distances.row(axis_index) = axis_distances.row(axis_index).cwiseAbs();
+// Eigen view of a kernel box. The axes are the columns of 'axes_'.
+struct CuboidBox
+{
+	CuboidBox(const CuboidDistanceKernel::Box &_box)
+		: center_(_box.center_)
+		, axes_(&_box.axes_[0][0])
+		, half_size_(_box.half_size_)
+	{}
+
+	Eigen::Map<const Eigen::Vector3d> center_;
+	Eigen::Map<const Eigen::Matrix3d> axes_;
+	Eigen::Map<const Eigen::Vector3d> half_size_;
+};
 
-		// Compute the distance from cuboid surface.
-		axis_distances.row(axis_index) = axis_distances.row(axis_index).array()
-			- (0.5 * bbox_size_[axis_index]);
+// Distance from a point to the solid box (zero inside the box).
+static double point_to_box_distance(const Eigen::Vector3d &_point, const CuboidBox &_box)
+{
+	const Eigen::Vector3d local_point = _box.axes_.transpose() * (_point - _box.center_);
+	return (local_point.cwiseAbs() - _box.half_size_).cwiseMax(0.0).norm();
+}
+
+// Maximum depth of a rectangle inside the box, where the depth of a point is the distance
+// to the box surface (zero outside the box).
+// The rectangle is '_center + s0 * _axis_0 + s1 * _axis_1' for |s0| <= _half_size_0 and |s1| <= _half_size_1.
+static double max_rectangle_depth_in_box(const Eigen::Vector3d &_center,
+	const Eigen::Vector3d &_axis_0, const double _half_size_0,
+	const Eigen::Vector3d &_axis_1, const double _half_size_1,
+	const CuboidBox &_box)
+{
+	const double tol = 1.0e-12;
+
+	// NOTE:
+	// On the rectangle, the depth is min(0, g(s)), where g(s) is the minimum of six affine functions
+	// 'h_i -/+ q_i(s)' for the box half sizes 'h_i' and the local coordinates 'q_i(s)'.
+	// g(s) is concave, and its maximum is at either a rectangle corner, a point on a rectangle edge
+	// where two functions are the same, or a point where three functions are the same.
+	const Eigen::Vector3d local_center = _box.axes_.transpose() * (_center - _box.center_);
+	const Eigen::Vector3d local_axis_0 = _box.axes_.transpose() * _axis_0;
+	const Eigen::Vector3d local_axis_1 = _box.axes_.transpose() * _axis_1;
+
+	double c[6];
+	Eigen::Vector2d d[6];
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		c[2 * i + 0] = _box.half_size_[i] - local_center[i];
+		d[2 * i + 0] = Eigen::Vector2d(-local_axis_0[i], -local_axis_1[i]);
+		c[2 * i + 1] = _box.half_size_[i] + local_center[i];
+		d[2 * i + 1] = Eigen::Vector2d(local_axis_0[i], local_axis_1[i]);
 	}
 
-	_distances = Eigen::VectorXd(num_points);
-	for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+	const Eigen::Vector2d half_size(_half_size_0, _half_size_1);
+	double max_depth = 0.0;
+
+	auto update_max_depth = [&](const Eigen::Vector2d &_s)
+	{
+		if (std::abs(_s[0]) > half_size[0] + tol || std::abs(_s[1]) > half_size[1] + tol)
+			return;
+		double depth = std::numeric_limits<double>::max();
+		for (unsigned int j = 0; j < 6; ++j)
+			depth = std::min(depth, c[j] + d[j].dot(_s));
+		max_depth = std::max(max_depth, depth);
+	};
+
+	// Rectangle corners.
+	for (unsigned int corner_index = 0; corner_index < 4; ++corner_index)
+		update_max_depth(Eigen::Vector2d((corner_index & 1) ? half_size[0] : -half_size[0],
+			(corner_index & 2) ? half_size[1] : -half_size[1]));
+
+	for (unsigned int j = 0; j < 6; ++j)
 	{
-		Eigen::Vector3d axis_distance = axis_distances.col(point_index);
-		if ((axis_distance.array() <= 0).all())
+		for (unsigned int k = j + 1; k < 6; ++k)
 		{
-			_distances[point_index] = axis_distance.maxCoeff();
+			// Points where functions 'j' and 'k' are the same: 'dc + dd * s = 0'.
+			const double dc = c[j] - c[k];
+			const Eigen::Vector2d dd = d[j] - d[k];
+
+			// Rectangle edges.
+			for (unsigned int axis_index = 0; axis_index < 2; ++axis_index)
+			{
+				const unsigned int other_axis_index = 1 - axis_index;
+				if (std::abs(dd[other_axis_index]) < tol) continue;
+
+				for (int sign = -1; sign <= 1; sign += 2)
+				{
+					Eigen::Vector2d s;
+					s[axis_index] = sign * half_size[axis_index];
+					s[other_axis_index] = -(dc + dd[axis_index] * s[axis_index]) / dd[other_axis_index];
+					update_max_depth(s);
+				}
+			}
+
+			// Points where functions 'j', 'k', and 'l' are the same.
+			for (unsigned int l = k + 1; l < 6; ++l)
+			{
+				const double dc_2 = c[j] - c[l];
+				const Eigen::Vector2d dd_2 = d[j] - d[l];
+				const double det = dd[0] * dd_2[1] - dd[1] * dd_2[0];
+				if (std::abs(det) < tol) continue;
+
+				const Eigen::Vector2d s((-dc * dd_2[1] + dc_2 * dd[1]) / det,
+					(-dc_2 * dd[0] + dc * dd_2[0]) / det);
+				update_max_depth(s);
+			}
 		}
-		else
+	}
+
+	return max_depth;
+}
+
+// Maximum distance from the surface of '_box_1' to the surface of '_box_2'.
+static double directed_distance_between_boxes(const CuboidBox &_box_1, const CuboidBox &_box_2)
+{
+	// NOTE:
+	// The distance from a point to the surface of '_box_2' is the distance to the solid box
+	// outside the box, and the depth inside the box. The former is convex, and thus its maximum
+	// on the surface of '_box_1' is at a corner.
+	double max_distance = 0.0;
+	for (unsigned int corner_index = 0; corner_index < MeshCuboid::k_num_corners; ++corner_index)
+	{
+		Eigen::Vector3d corner = _box_1.center_;
+		for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+			corner += ((corner_index & (1 << axis_index)) ? 1.0 : -1.0) *
+			_box_1.half_size_[axis_index] * _box_1.axes_.col(axis_index);
+		max_distance = std::max(max_distance, point_to_box_distance(corner, _box_2));
+	}
+
+	// The depth cannot be greater than the smallest half size.
+	if (max_distance >= _box_2.half_size_.minCoeff())
+		return max_distance;
+
+	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+	{
+		const unsigned int axis_index_0 = (axis_index + 1) % 3;
+		const unsigned int axis_index_1 = (axis_index + 2) % 3;
+
+		for (int sign = -1; sign <= 1; sign += 2)
 		{
-			axis_distance = (axis_distance.array() < 0).select(0, axis_distance);
-			_distances[point_index] = axis_distance.norm();
+			const Eigen::Vector3d face_center = _box_1.center_ +
+				(sign * _box_1.half_size_[axis_index]) * _box_1.axes_.col(axis_index);
+			max_distance = std::max(max_distance, max_rectangle_depth_in_box(face_center,
+				_box_1.axes_.col(axis_index_0), _box_1.half_size_[axis_index_0],
+				_box_1.axes_.col(axis_index_1), _box_1.half_size_[axis_index_1], _box_2));
 		}
 	}
+
+	return max_distance;
+}
+
+// NOTE:
+// Without '_symmetric', the distance from the surface of '_box_2' to the surface of '_box_1',
+// which is the value of the previous surface point sampling implementation.
+static double distance_between_boxes(const CuboidBox &_box_1, const CuboidBox &_box_2,
+	bool _symmetric)
+{
+	const double distance_21 = directed_distance_between_boxes(_box_2, _box_1);
+	if (!_symmetric)
+		return distance_21;
+	return std::max(directed_distance_between_boxes(_box_1, _box_2), distance_21);
 }
 
 Real MeshCuboid::distance_between_cuboids(
-	const MeshCuboid *_cuboid_1, const MeshCuboid *_cuboid_2)
+	const MeshCuboid *_cuboid_1, const MeshCuboid *_cuboid_2,
+	bool _symmetric)
 {
-	// NOTE: Assume that cuboid surface points exist.
 	assert(_cuboid_1);
 	assert(_cuboid_2);
 
-	unsigned int num_cuboid_surface_points_1 = _cuboid_1->cuboid_surface_points_.size();
-	unsigned int num_cuboid_surface_points_2 = _cuboid_2->cuboid_surface_points_.size();
+	CuboidDistanceKernel::Box box_1, box_2;
+	get_cuboid_box(_cuboid_1, box_1);
+	get_cuboid_box(_cuboid_2, box_2);
 
-	// TODO: Pre-compute KD-trees.
-	Eigen::MatrixXd cuboid_surface_points_1(3, num_cuboid_surface_points_1);
-	Eigen::MatrixXd cuboid_surface_points_2(3, num_cuboid_surface_points_2);
+	return distance_between_boxes(CuboidBox(box_1), CuboidBox(box_2), _symmetric);
+}
 
-	for (unsigned int point_index = 0; point_index < num_cuboid_surface_points_1; ++point_index)
-	{
-		for (unsigned int i = 0; i < 3; ++i)
-			cuboid_surface_points_1.col(point_index)(i) =
-			_cuboid_1->cuboid_surface_points_[point_index]->point_[i];
-	}
+void MeshCuboid::distances_between_cuboids(const std::vector<MeshCuboid *> &_cuboids,
+	Eigen::MatrixXd &_distances, bool _symmetric)
+{
+	const unsigned int num_cuboids = _cuboids.size();
+
+	std::vector<CuboidDistanceKernel::Box> kernel_boxes(num_cuboids);
+	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+		get_cuboid_box(_cuboids[cuboid_index], kernel_boxes[cuboid_index]);
+	const std::vector<CuboidBox> boxes(kernel_boxes.begin(), kernel_boxes.end());
 
-	for (unsigned int point_index = 0; point_index < num_cuboid_surface_points_2; ++point_index)
+	// NOTE:
+	// Each directed distance is computed once, and both entries of a pair are filled from them.
+	_distances = Eigen::MatrixXd::Zero(num_cuboids, num_cuboids);
+	for (unsigned int cuboid_index_1 = 0; cuboid_index_1 < num_cuboids; ++cuboid_index_1)
 	{
-		for (unsigned int i = 0; i < 3; ++i)
-			cuboid_surface_points_2.col(point_index)(i) =
-			_cuboid_2->cuboid_surface_points_[point_index]->point_[i];
+		for (unsigned int cuboid_index_2 = cuboid_index_1 + 1; cuboid_index_2 < num_cuboids; ++cuboid_index_2)
+		{
+			const double distance_12 = directed_distance_between_boxes(
+				boxes[cuboid_index_1], boxes[cuboid_index_2]);
+			const double distance_21 = directed_distance_between_boxes(
+				boxes[cuboid_index_2], boxes[cuboid_index_1]);
+
+			if (_symmetric)
+			{
+				_distances(cuboid_index_1, cuboid_index_2) = std::max(distance_12, distance_21);
+				_distances(cuboid_index_2, cuboid_index_1) = std::max(distance_12, distance_21);
+			}
+			else
+			{
+				_distances(cuboid_index_1, cuboid_index_2) = distance_21;
+				_distances(cuboid_index_2, cuboid_index_1) = distance_12;
+			}
+		}
 	}
+}
 
-	ANNpointArray ann_points_1 = NULL;
-	ANNkd_tree* ann_kd_tree_1 = ICP::create_kd_tree(cuboid_surface_points_1, ann_points_1);
-	assert(ann_kd_tree_1);
+bool MeshCuboid::are_cuboids_overlapping(
+	const MeshCuboid *_cuboid_1, const MeshCuboid *_cuboid_2)
+{
+	assert(_cuboid_1);
+	assert(_cuboid_2);
 
-	ANNpointArray ann_points_2 = NULL;
-	ANNkd_tree* ann_kd_tree_2 = ICP::create_kd_tree(cuboid_surface_points_2, ann_points_2);
-	assert(ann_kd_tree_2);
+	CuboidDistanceKernel::Box kernel_box_1, kernel_box_2;
+	get_cuboid_box(_cuboid_1, kernel_box_1);
+	get_cuboid_box(_cuboid_2, kernel_box_2);
+	const CuboidBox box_1(kernel_box_1), box_2(kernel_box_2);
 
-	// 1 -> 2.
-	Eigen::VectorXd distances_12;
-	ICP::get_closest_points(ann_kd_tree_2, cuboid_surface_points_1, distances_12);
-	assert(distances_12.rows() == num_cuboid_surface_points_1);
+	// Separating axis test with the face normals of both boxes and their cross products.
+	const double tol = 1.0e-12;
+	const Eigen::Matrix3d rotation_mat = box_1.axes_.transpose() * box_2.axes_;
+	const Eigen::Matrix3d abs_rotation_mat = rotation_mat.cwiseAbs().array() + tol;
+	const Eigen::Vector3d translation_vec = box_1.axes_.transpose() * (box_2.center_ - box_1.center_);
+	const Eigen::Vector3d h1 = box_1.half_size_, h2 = box_2.half_size_;
 
-	// 2 -> 1.
-	Eigen::VectorXd distances_21;
-	ICP::get_closest_points(ann_kd_tree_1, cuboid_surface_points_2, distances_21);
-	assert(distances_21.rows() == num_cuboid_surface_points_2);
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		if (std::abs(translation_vec[i]) > h1[i] + abs_rotation_mat.row(i).dot(h2))
+			return false;
+		if (std::abs(rotation_mat.col(i).dot(translation_vec)) > abs_rotation_mat.col(i).dot(h1) + h2[i])
+			return false;
+	}
 
-	if (ann_points_1) annDeallocPts(ann_points_1);
-	if (ann_points_2) annDeallocPts(ann_points_2);
-	delete ann_kd_tree_1;
-	delete ann_kd_tree_2;
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		const unsigned int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		for (unsigned int j = 0; j < 3; ++j)
+		{
+			const unsigned int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			const double distance = std::abs(translation_vec[i2] * rotation_mat(i1, j)
+				- translation_vec[i1] * rotation_mat(i2, j));
+			const double radius_1 = h1[i1] * abs_rotation_mat(i2, j) + h1[i2] * abs_rotation_mat(i1, j);
+			const double radius_2 = h2[j1] * abs_rotation_mat(i, j2) + h2[j2] * abs_rotation_mat(i, j1);
+			if (distance > radius_1 + radius_2)
+				return false;
+		}
+	}
 
-	Real max_distance = (distances_12.maxCoeff(), distances_21.maxCoeff());
-	return max_distance;
+	return true;
 }
 
-
 /*
 void MeshCuboid::split_cuboid_recursive(ANNkd_tree* _kd_tree, std::vector<MeshCuboid *> &_sub_cuboids)
 {
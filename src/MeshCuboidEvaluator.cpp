@@ -2,6 +2,7 @@
 
 #include "MeshCuboidParameters.h"
 #include "ICP.h"
+#include "TraceRecorder.h"
 
 #include <fstream>
 #include <iostream>
@@ -25,6 +26,10 @@ void MeshCuboidEvaluator::evaluate_point_to_point_distances(
 	const std::vector<MeshSamplePoint *> _test_sample_points,
 	const char *_filename, bool _record_error)
 {
+	// NOTE:
+	// Evaluation parameters are taken from the ground truth cuboid structure.
+	const MeshCuboidParameters &params = ground_truth_cuboid_structure_->get_parameters();
+
 	const unsigned int num_ground_truth_sample_points = _ground_truth_sample_points.size();
 	const unsigned int num_test_sample_points = _test_sample_points.size();
 
@@ -33,8 +38,8 @@ void MeshCuboidEvaluator::evaluate_point_to_point_distances(
 
 
 	Eigen::VectorXd neighbor_ranges;
-	neighbor_ranges.setLinSpaced(FLAGS_param_eval_num_neighbor_range_samples,
-		0.0, FLAGS_param_eval_max_neighbor_distance);
+	neighbor_ranges.setLinSpaced(params.eval_num_neighbor_range_samples_,
+		0.0, params.eval_max_neighbor_distance_);
 
 
 	// Create a ground truth sample point KD-tree.
@@ -88,8 +93,8 @@ void MeshCuboidEvaluator::evaluate_point_to_point_distances(
 
 	if (_record_error)
 	{
-		double eval_neighbor_distance_min_max_range = FLAGS_param_eval_max_neighbor_distance
-			- FLAGS_param_eval_min_neighbor_distance;
+		double eval_neighbor_distance_min_max_range = params.eval_max_neighbor_distance_
+			- params.eval_min_neighbor_distance_;
 		assert(eval_neighbor_distance_min_max_range);
 
 		// Accuracy.
@@ -99,9 +104,9 @@ void MeshCuboidEvaluator::evaluate_point_to_point_distances(
 			_test_sample_points[sample_point_index]->error_ = 0.0;
 
 			double distance = test_to_ground_truth_distances[sample_point_index];
-			if (distance >= FLAGS_param_eval_min_neighbor_distance)
+			if (distance >= params.eval_min_neighbor_distance_)
 			{
-				double error = (distance - FLAGS_param_eval_min_neighbor_distance) / eval_neighbor_distance_min_max_range;
+				double error = (distance - params.eval_min_neighbor_distance_) / eval_neighbor_distance_min_max_range;
 				error = std::min(error, 1.0);
 
 				// Map (min, max) to 0.5, 1.0.
@@ -117,9 +122,9 @@ void MeshCuboidEvaluator::evaluate_point_to_point_distances(
 			_ground_truth_sample_points[sample_point_index]->error_ = 0.0;
 
 			double distance = ground_truth_to_test_distances[sample_point_index];
-			if (distance >= FLAGS_param_eval_min_neighbor_distance)
+			if (distance >= params.eval_min_neighbor_distance_)
 			{
-				double error = (distance - FLAGS_param_eval_min_neighbor_distance) / eval_neighbor_distance_min_max_range;
+				double error = (distance - params.eval_min_neighbor_distance_) / eval_neighbor_distance_min_max_range;
 				error = std::min(error, 1.0);
 
 				// Map (min, max) to 0.5, 1.0.
@@ -130,10 +135,10 @@ void MeshCuboidEvaluator::evaluate_point_to_point_distances(
 	}
 
 
-	Eigen::VectorXd accuracy(FLAGS_param_eval_num_neighbor_range_samples);
-	Eigen::VectorXd completeness(FLAGS_param_eval_num_neighbor_range_samples);
+	Eigen::VectorXd accuracy(params.eval_num_neighbor_range_samples_);
+	Eigen::VectorXd completeness(params.eval_num_neighbor_range_samples_);
 
-	for (unsigned int i = 0; i < FLAGS_param_eval_num_neighbor_range_samples; ++i)
+	for (unsigned int i = 0; i < params.eval_num_neighbor_range_samples_; ++i)
 	{
 		accuracy[i] = static_cast<double>(
 			(test_to_ground_truth_distances.array() <= neighbor_ranges[i]).count())
@@ -174,6 +179,9 @@ void MeshCuboidEvaluator::evaluate_point_to_point_distances(
 {
 	assert(_test_cuboid_structure);
 
+	TraceScope trace_scope("evaluate_point_to_point_distances");
+	trace_scope.add_arg("points", _test_cuboid_structure->num_sample_points());
+
 	std::stringstream output_filename_sstr;
 
 
@@ -245,6 +253,8 @@ void MeshCuboidEvaluator::evaluate_point_labeling(
 {
 	assert(_test_cuboid_structure);
 
+	TraceScope trace_scope("evaluate_point_labeling");
+
 	const MyMesh *mesh = _test_cuboid_structure->mesh_;
 	assert(mesh);
 
@@ -352,6 +362,8 @@ void MeshCuboidEvaluator::evaluate_cuboid_distance(
 {
 	assert(_test_cuboid_structure);
 
+	TraceScope trace_scope("evaluate_cuboid_distance");
+
 	const MyMesh *mesh = _test_cuboid_structure->mesh_;
 	assert(mesh);
 
@@ -397,8 +409,10 @@ void MeshCuboidEvaluator::evaluate_cuboid_distance(
 				continue;
 
 			// NOTE: Cuboid surface points are replaced.
-			ground_truth_cuboid->create_grid_points_on_cuboid_surface(FLAGS_param_num_cuboid_surface_points);
-			test_cuboid->create_grid_points_on_cuboid_surface(FLAGS_param_num_cuboid_surface_points);
+			ground_truth_cuboid->create_grid_points_on_cuboid_surface(
+				ground_truth_cuboid_structure_->get_parameters().num_cuboid_surface_points_);
+			test_cuboid->create_grid_points_on_cuboid_surface(
+				ground_truth_cuboid_structure_->get_parameters().num_cuboid_surface_points_);
 
 			Real cuboid_distance = MeshCuboid::distance_between_cuboids(ground_truth_cuboid, test_cuboid);
 			max_cuboid_distance = std::max(cuboid_distance, max_cuboid_distance);
@@ -463,7 +477,7 @@ void MeshCuboidEvaluator::evaluate_cuboid_distance(
 	delete ann_kd_tree_1;
 	delete ann_kd_tree_2;
 
-	Real total_max_cuboid_distance = (distances_12.maxCoeff(), distances_21.maxCoeff());
+	Real total_max_cuboid_distance = std::max(distances_12.maxCoeff(), distances_21.maxCoeff());
 
 	file << "all,";
 	if (total_max_cuboid_distance < 0)
@@ -2,8 +2,10 @@
 
 #include "MeshCuboidParameters.h"
 #include "ICP.h"
+#include "TraceRecorder.h"
 #include "Utilities.h"
 
+#include <sstream>
 #include <Eigen/Core>
 #include <MRFEnergy.h>
 
@@ -201,9 +203,18 @@ void MeshCuboidVoxelGrid::get_distance_map(ANNpointArray &_ann_points, ANNkd_tre
 	ICP::get_closest_points(__ann_kd_tree, center_points_mat, _voxel_to_point_distances);
 }
 
+void MeshCuboidFusionOutput::add_sample_point(
+	const MyMesh::Point &_point, const MyMesh::Normal &_normal)
+{
+	points_.push_back(_point);
+	normals_.push_back(_normal);
+}
+
 void run_part_ICP(MeshCuboidStructure &_input, const MeshCuboidStructure &_ground_truth)
 {
-	const Real neighbor_distance = FLAGS_param_sparse_neighbor_distance
+	TraceScope trace_scope("run_part_ICP");
+
+	const Real neighbor_distance = _input.get_parameters().sparse_neighbor_distance_
 		* _ground_truth.mesh_->get_object_diameter();
 
 	unsigned int num_labels = _ground_truth.num_labels();
@@ -404,8 +415,7 @@ void fill_voxels_using_visibility(
 	const std::vector<Real> &_voxel_visibility_values,
 	const MeshCuboid *_symmetry_cuboid,
 	const MeshCuboid *_database_cuboid,
-	MeshCuboidStructure &_output_cuboid_structure,
-	MeshCuboid *_output_cuboid)
+	MeshCuboidFusionOutput &_output)
 {
 	std::vector<MyMesh::Point> symmetry_points;
 	std::vector<int> symmetry_points_to_voxels;
@@ -439,10 +449,7 @@ void fill_voxels_using_visibility(
 			{
 				MeshSamplePoint *sample_point = _symmetry_cuboid->get_sample_point(*it);
 				assert(sample_point);
-
-				MeshSamplePoint *new_sample_point = _output_cuboid_structure.add_sample_point(
-					sample_point->point_, sample_point->normal_);
-				_output_cuboid->add_sample_point(new_sample_point);
+				_output.add_sample_point(sample_point->point_, sample_point->normal_);
 			}
 		}
 		else
@@ -452,10 +459,7 @@ void fill_voxels_using_visibility(
 			{
 				MeshSamplePoint *sample_point = _database_cuboid->get_sample_point(*it);
 				assert(sample_point);
-
-				MeshSamplePoint *new_sample_point = _output_cuboid_structure.add_sample_point(
-					sample_point->point_, sample_point->normal_);
-				_output_cuboid->add_sample_point(new_sample_point);
+				_output.add_sample_point(sample_point->point_, sample_point->normal_);
 			}
 		}
 	}
@@ -466,9 +470,11 @@ void reconstruct_fusion_simple(
 	const MeshCuboidStructure &_database_cuboid_structure,
 	MeshCuboidStructure &_output_cuboid_structure)
 {
+	TraceScope trace_scope("reconstruct_fusion_simple");
+
 	assert(_symmetry_cuboid_structure.num_labels() == _database_cuboid_structure.num_labels());
 
-	const Real neighbor_distance = FLAGS_param_sparse_neighbor_distance
+	const Real neighbor_distance = _symmetry_cuboid_structure.get_parameters().sparse_neighbor_distance_
 		* _output_cuboid_structure.mesh_->get_object_diameter();
 
 	_output_cuboid_structure = _symmetry_cuboid_structure;
@@ -602,19 +608,16 @@ void mark_cuboid_sample_points(
 }
 
 void copy_sample_points(const MeshCuboid *_from_cuboid,
-	MeshCuboidStructure &_to_cuboid_structure, MeshCuboid *_to_cuboid)
+	MeshCuboidFusionOutput &_output)
 {
 	assert(_from_cuboid);
-	assert(_to_cuboid);
+	assert(_output.output_cuboid_);
 
 	for (unsigned int i = 0; i < _from_cuboid->num_sample_points(); ++i)
 	{
 		MeshSamplePoint *sample_point = _from_cuboid->get_sample_point(i);
 		assert(sample_point);
-
-		MeshSamplePoint *new_sample_point = _to_cuboid_structure.add_sample_point(
-			sample_point->point_, sample_point->normal_);
-		_to_cuboid->add_sample_point(new_sample_point);
+		_output.add_sample_point(sample_point->point_, sample_point->normal_);
 	}
 }
 
@@ -624,16 +627,14 @@ void fusing_single_symmetry_cuboid(LabelIndex _label_index,
 	const MeshCuboidStructure &_original_cuboid_structure,
 	const MeshCuboidStructure &_symmetry_cuboid_structure,
 	const MeshCuboidStructure &_database_cuboid_structure,
-	MeshCuboidStructure &_output_cuboid_structure,
-	bool *_is_symmetry_point_visited,
-	bool *_is_label_index_visited)
+	const MeshCuboidStructure &_output_cuboid_structure,
+	MeshCuboidFusionBuffer &_buffer)
 {
 	assert(_occlusion_modelview_matrix);
-	assert(_is_symmetry_point_visited);
-	assert(_is_label_index_visited);
 
-	const Real occlusion_radius = FLAGS_param_fusion_grid_size;
-	const Real visibility_smoothing_prior = FLAGS_param_fusion_visibility_smoothing_prior;
+	const MeshCuboidParameters &params = _original_cuboid_structure.get_parameters();
+	const Real occlusion_radius = params.fusion_grid_size_;
+	const Real visibility_smoothing_prior = params.fusion_visibility_smoothing_prior_;
 
 	MeshCuboid *symmetry_cuboid = NULL, *database_cuboid = NULL, *output_cuboid = NULL;
 	bool ret = get_fusion_cuboids(_label_index,
@@ -644,19 +645,22 @@ void fusing_single_symmetry_cuboid(LabelIndex _label_index,
 	{
 		if (output_cuboid)
 		{
+			_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid));
 			if (symmetry_cuboid)
-				copy_sample_points(symmetry_cuboid, _output_cuboid_structure, output_cuboid);
+				copy_sample_points(symmetry_cuboid, _buffer.outputs_.back());
 			else if (database_cuboid)
-				copy_sample_points(database_cuboid, _output_cuboid_structure, output_cuboid);
+				copy_sample_points(database_cuboid, _buffer.outputs_.back());
 		}
 		return;
 	}
 
-	_is_label_index_visited[_label_index] = true;
-	std::cout << "Single symmetry: (" << _label_index << ")" << std::endl;
+	std::stringstream description;
+	description << "Single symmetry: (" << _label_index << ")";
+	_buffer.description_ = description.str();
+	_buffer.visited_label_indices_.push_back(_label_index);
 
 	// Mark visited symmetry sample points.
-	mark_cuboid_sample_points(symmetry_cuboid, _symmetry_cuboid_structure, _is_symmetry_point_visited);
+	_buffer.visited_symmetry_cuboids_.push_back(symmetry_cuboid);
 
 	// Define local coordinates voxel grid.
 	MyMesh::Point bbox_min, bbox_max;
@@ -666,29 +670,26 @@ void fusing_single_symmetry_cuboid(LabelIndex _label_index,
 	voxels.get_centers(voxel_centers);
 
 
-	std::cout << "Computing visibility values... ";
-
+	// Compute visibility values.
 	std::vector<Real> voxel_visibility;
 	MeshCuboid::compute_cuboid_surface_point_visibility(
 		_occlusion_modelview_matrix, occlusion_radius, _original_cuboid_structure.sample_points_,
-		voxel_centers, NULL, voxel_visibility);
+		voxel_centers, NULL, params, voxel_visibility);
 
 	// Merge visibility values for voxels in symmetric cuboids.
 	merge_symmetric_cuboids_visibility(_symmetry_group, voxels, voxels, voxel_visibility, voxel_visibility);
-	
+
 	// Smoothing.
 	get_smoothed_voxel_visibility(
 		voxels, symmetry_cuboid, _occlusion_modelview_matrix, _original_cuboid_structure,
 		occlusion_radius, visibility_smoothing_prior, voxel_visibility);
 
-	std::cout << "Done." << std::endl;
-
 
-	std::cout << "Filling voxels... ";
+	// Fill voxels.
+	_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid));
 	fill_voxels_using_visibility(
 		voxels, voxel_visibility, symmetry_cuboid, database_cuboid,
-		_output_cuboid_structure, output_cuboid);
-	std::cout << "Done." << std::endl;
+		_buffer.outputs_.back());
 }
 
 void fusing_pair_symmetry_cuboids(LabelIndex _label_index_1, LabelIndex _label_index_2,
@@ -697,16 +698,14 @@ void fusing_pair_symmetry_cuboids(LabelIndex _label_index_1, LabelIndex _label_i
 	const MeshCuboidStructure &_original_cuboid_structure,
 	const MeshCuboidStructure &_symmetry_cuboid_structure,
 	const MeshCuboidStructure &_database_cuboid_structure,
-	MeshCuboidStructure &_output_cuboid_structure,
-	bool *_is_symmetry_point_visited,
-	bool *_is_label_index_visited)
+	const MeshCuboidStructure &_output_cuboid_structure,
+	MeshCuboidFusionBuffer &_buffer)
 {
 	assert(_occlusion_modelview_matrix);
-	assert(_is_symmetry_point_visited);
-	assert(_is_label_index_visited);
 
-	const Real occlusion_radius = FLAGS_param_fusion_grid_size;
-	const Real visibility_smoothing_prior = FLAGS_param_fusion_visibility_smoothing_prior;
+	const MeshCuboidParameters &params = _original_cuboid_structure.get_parameters();
+	const Real occlusion_radius = params.fusion_grid_size_;
+	const Real visibility_smoothing_prior = params.fusion_visibility_smoothing_prior_;
 
 
 	MeshCuboid *symmetry_cuboid_1 = NULL, *database_cuboid_1 = NULL, *output_cuboid_1 = NULL;
@@ -725,25 +724,31 @@ void fusing_pair_symmetry_cuboids(LabelIndex _label_index_1, LabelIndex _label_i
 		{
 			if (symmetry_cuboid_1 && symmetry_cuboid_2)
 			{
-				copy_sample_points(symmetry_cuboid_1, _output_cuboid_structure, output_cuboid_1);
-				copy_sample_points(symmetry_cuboid_2, _output_cuboid_structure, output_cuboid_2);
+				_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid_1));
+				copy_sample_points(symmetry_cuboid_1, _buffer.outputs_.back());
+				_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid_2));
+				copy_sample_points(symmetry_cuboid_2, _buffer.outputs_.back());
 			}
 			else if (database_cuboid_1 && database_cuboid_2)
 			{
-				copy_sample_points(database_cuboid_1, _output_cuboid_structure, output_cuboid_1);
-				copy_sample_points(database_cuboid_2, _output_cuboid_structure, output_cuboid_2);
+				_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid_1));
+				copy_sample_points(database_cuboid_1, _buffer.outputs_.back());
+				_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid_2));
+				copy_sample_points(database_cuboid_2, _buffer.outputs_.back());
 			}
 		}
 		return;
 	}
 
-	_is_label_index_visited[_label_index_1] = true;
-	_is_label_index_visited[_label_index_2] = true;
-	std::cout << "Pair symmetry: (" << _label_index_1 << ", " << _label_index_2 << ")" << std::endl;
+	std::stringstream description;
+	description << "Pair symmetry: (" << _label_index_1 << ", " << _label_index_2 << ")";
+	_buffer.description_ = description.str();
+	_buffer.visited_label_indices_.push_back(_label_index_1);
+	_buffer.visited_label_indices_.push_back(_label_index_2);
 
 	// Mark visited symmetry sample points.
-	mark_cuboid_sample_points(symmetry_cuboid_1, _symmetry_cuboid_structure, _is_symmetry_point_visited);
-	mark_cuboid_sample_points(symmetry_cuboid_2, _symmetry_cuboid_structure, _is_symmetry_point_visited);
+	_buffer.visited_symmetry_cuboids_.push_back(symmetry_cuboid_1);
+	_buffer.visited_symmetry_cuboids_.push_back(symmetry_cuboid_2);
 
 	// Define local coordinates voxel grid.
 	MyMesh::Point bbox_min_1, bbox_max_1;
@@ -759,22 +764,21 @@ void fusing_pair_symmetry_cuboids(LabelIndex _label_index_1, LabelIndex _label_i
 	voxels_2.get_centers(voxel_centers_2);
 
 
-	std::cout << "Computing visibility values... ";
-
+	// Compute visibility values.
 	std::vector<Real> voxel_visibility_1;
 	MeshCuboid::compute_cuboid_surface_point_visibility(
 		_occlusion_modelview_matrix, occlusion_radius, _original_cuboid_structure.sample_points_,
-		voxel_centers_1, NULL, voxel_visibility_1);
+		voxel_centers_1, NULL, params, voxel_visibility_1);
 
 	std::vector<Real> voxel_visibility_2;
 	MeshCuboid::compute_cuboid_surface_point_visibility(
 		_occlusion_modelview_matrix, occlusion_radius, _original_cuboid_structure.sample_points_,
-		voxel_centers_2, NULL, voxel_visibility_2);
+		voxel_centers_2, NULL, params, voxel_visibility_2);
 
 	// Merge visibility values for voxels in symmetric cuboids.
 	merge_symmetric_cuboids_visibility(_symmetry_group, voxels_1, voxels_2, voxel_visibility_1, voxel_visibility_2);
 	merge_symmetric_cuboids_visibility(_symmetry_group, voxels_2, voxels_1, voxel_visibility_2, voxel_visibility_1);
-	
+
 
 	// Smoothing.
 	get_smoothed_voxel_visibility(
@@ -784,15 +788,150 @@ void fusing_pair_symmetry_cuboids(LabelIndex _label_index_1, LabelIndex _label_i
 		voxels_2, symmetry_cuboid_2, _occlusion_modelview_matrix, _original_cuboid_structure,
 		occlusion_radius, visibility_smoothing_prior, voxel_visibility_2);
 
-	std::cout << "Done." << std::endl;
-
 
-	std::cout << "Filling voxels... ";
+	// Fill voxels.
+	_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid_1));
 	fill_voxels_using_visibility(
-		voxels_1, voxel_visibility_1, symmetry_cuboid_1, database_cuboid_1, _output_cuboid_structure, output_cuboid_1);
+		voxels_1, voxel_visibility_1, symmetry_cuboid_1, database_cuboid_1, _buffer.outputs_.back());
+	_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid_2));
 	fill_voxels_using_visibility(
-		voxels_2, voxel_visibility_2, symmetry_cuboid_2, database_cuboid_2, _output_cuboid_structure, output_cuboid_2);
-	std::cout << "Done." << std::endl;
+		voxels_2, voxel_visibility_2, symmetry_cuboid_2, database_cuboid_2, _buffer.outputs_.back());
+}
+
+void fusing_asymmetry_cuboid(LabelIndex _label_index,
+	const double *_occlusion_modelview_matrix,
+	const MeshCuboidStructure &_original_cuboid_structure,
+	const MeshCuboidStructure &_symmetry_cuboid_structure,
+	const MeshCuboidStructure &_database_cuboid_structure,
+	const MeshCuboidStructure &_output_cuboid_structure,
+	MeshCuboidFusionBuffer &_buffer)
+{
+	assert(_occlusion_modelview_matrix);
+
+	const MeshCuboidParameters &params = _original_cuboid_structure.get_parameters();
+	const Real occlusion_radius = params.fusion_grid_size_;
+	const Real visibility_smoothing_prior = params.fusion_visibility_smoothing_prior_;
+
+	MeshCuboid *symmetry_cuboid, *database_cuboid, *output_cuboid;
+	bool ret = get_fusion_cuboids(_label_index,
+		_symmetry_cuboid_structure, _database_cuboid_structure, _output_cuboid_structure,
+		symmetry_cuboid, database_cuboid, output_cuboid);
+	if (!ret) return;
+
+	std::stringstream description;
+	description << "Asymmetry: (" << _label_index << ")";
+	_buffer.description_ = description.str();
+	_buffer.visited_label_indices_.push_back(_label_index);
+
+	// Mark visited symmetry sample points.
+	_buffer.visited_symmetry_cuboids_.push_back(symmetry_cuboid);
+
+	// Define local coordinates voxel grid.
+	MyMesh::Point bbox_min, bbox_max;
+	create_voxel_grid(symmetry_cuboid, database_cuboid,
+		bbox_min, bbox_max);
+	MeshCuboidVoxelGrid voxels(bbox_min, bbox_max, occlusion_radius);
+	std::vector<MyMesh::Point> voxel_centers;
+	voxels.get_centers(voxel_centers);
+
+	// Compute visibility values.
+	std::vector<Real> voxel_visibility;
+	MeshCuboid::compute_cuboid_surface_point_visibility(
+		_occlusion_modelview_matrix, occlusion_radius, _original_cuboid_structure.sample_points_,
+		voxel_centers, NULL, params, voxel_visibility);
+
+	get_smoothed_voxel_visibility(
+		voxels, symmetry_cuboid, _occlusion_modelview_matrix, _original_cuboid_structure,
+		occlusion_radius, visibility_smoothing_prior, voxel_visibility);
+
+	// Fill voxels.
+	_buffer.outputs_.push_back(MeshCuboidFusionOutput(output_cuboid));
+	fill_voxels_using_visibility(
+		voxels, voxel_visibility, symmetry_cuboid, database_cuboid, _buffer.outputs_.back());
+}
+
+void run_fusion_work_items(
+	const std::vector<MeshCuboidFusionWorkItem> &_work_items,
+	const double *_occlusion_modelview_matrix,
+	const MeshCuboidStructure &_original_cuboid_structure,
+	const MeshCuboidStructure &_symmetry_cuboid_structure,
+	const MeshCuboidStructure &_database_cuboid_structure,
+	MeshCuboidStructure &_output_cuboid_structure,
+	bool *_is_symmetry_point_visited,
+	bool *_is_label_index_visited)
+{
+	assert(_is_symmetry_point_visited);
+	assert(_is_label_index_visited);
+
+	const int num_work_items = static_cast<int>(_work_items.size());
+	std::vector<MeshCuboidFusionBuffer> buffers(num_work_items);
+
+	// NOTE:
+	// Work items are independent of each other until their points are added
+	// to the output structure. Each of them writes only to its own buffer.
+#pragma omp parallel for schedule(dynamic)
+	for (int item_index = 0; item_index < num_work_items; ++item_index)
+	{
+		const MeshCuboidFusionWorkItem &work_item = _work_items[item_index];
+		MeshCuboidFusionBuffer &buffer = buffers[item_index];
+
+		switch (work_item.fusion_type_)
+		{
+		case SingleSymmetryFusion:
+			fusing_single_symmetry_cuboid(work_item.label_index_1_, work_item.symmetry_group_,
+				_occlusion_modelview_matrix, _original_cuboid_structure,
+				_symmetry_cuboid_structure, _database_cuboid_structure, _output_cuboid_structure,
+				buffer);
+			break;
+		case PairSymmetryFusion:
+			fusing_pair_symmetry_cuboids(work_item.label_index_1_, work_item.label_index_2_,
+				work_item.symmetry_group_,
+				_occlusion_modelview_matrix, _original_cuboid_structure,
+				_symmetry_cuboid_structure, _database_cuboid_structure, _output_cuboid_structure,
+				buffer);
+			break;
+		case AsymmetryFusion:
+			fusing_asymmetry_cuboid(work_item.label_index_1_,
+				_occlusion_modelview_matrix, _original_cuboid_structure,
+				_symmetry_cuboid_structure, _database_cuboid_structure, _output_cuboid_structure,
+				buffer);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+
+	// Merge buffers in the work item order so that the output is deterministic.
+	for (int item_index = 0; item_index < num_work_items; ++item_index)
+	{
+		const MeshCuboidFusionBuffer &buffer = buffers[item_index];
+		if (!buffer.description_.empty())
+			std::cout << buffer.description_ << std::endl;
+
+		for (std::vector<LabelIndex>::const_iterator it = buffer.visited_label_indices_.begin();
+			it != buffer.visited_label_indices_.end(); ++it)
+			_is_label_index_visited[*it] = true;
+
+		for (std::vector<const MeshCuboid *>::const_iterator it = buffer.visited_symmetry_cuboids_.begin();
+			it != buffer.visited_symmetry_cuboids_.end(); ++it)
+			mark_cuboid_sample_points(*it, _symmetry_cuboid_structure, _is_symmetry_point_visited);
+
+		for (std::list<MeshCuboidFusionOutput>::const_iterator it = buffer.outputs_.begin();
+			it != buffer.outputs_.end(); ++it)
+		{
+			const MeshCuboidFusionOutput &output = (*it);
+			assert(output.output_cuboid_);
+			assert(output.points_.size() == output.normals_.size());
+
+			for (unsigned int point_index = 0; point_index < output.points_.size(); ++point_index)
+			{
+				MeshSamplePoint *new_sample_point = _output_cuboid_structure.add_sample_point(
+					output.points_[point_index], output.normals_[point_index]);
+				output.output_cuboid_->add_sample_point(new_sample_point);
+			}
+		}
+	}
 }
 
 void reconstruct_fusion(const char *_mesh_filepath,
@@ -804,10 +943,11 @@ void reconstruct_fusion(const char *_mesh_filepath,
 	MeshCuboidStructure &_output_cuboid_structure,
 	bool _add_outliers)
 {
-	assert(_symmetry_cuboid_structure.num_labels() == _database_cuboid_structure.num_labels());
+	TraceScope trace_scope("reconstruct_fusion");
+	trace_scope.add_arg("symmetry_points", _symmetry_cuboid_structure.num_sample_points());
+	trace_scope.add_arg("database_points", _database_cuboid_structure.num_sample_points());
 
-	const Real occlusion_radius = FLAGS_param_fusion_grid_size;
-	const Real visibility_smoothing_prior = FLAGS_param_fusion_visibility_smoothing_prior;
+	assert(_symmetry_cuboid_structure.num_labels() == _database_cuboid_structure.num_labels());
 
 
 	_output_cuboid_structure.clear_sample_points();
@@ -827,6 +967,8 @@ void reconstruct_fusion(const char *_mesh_filepath,
 	memset(is_label_index_visited, false, _symmetry_cuboid_structure.num_labels() * sizeof(bool));
 
 
+	std::vector<MeshCuboidFusionWorkItem> symmetry_work_items;
+
 	for (std::vector< MeshCuboidReflectionSymmetryGroup* >::const_iterator it = _symmetry_cuboid_structure.reflection_symmetry_groups_.begin();
 		it != _symmetry_cuboid_structure.reflection_symmetry_groups_.end(); ++it)
 	{
@@ -838,23 +980,16 @@ void reconstruct_fusion(const char *_mesh_filepath,
 		for (std::vector<LabelIndex>::const_iterator jt = symmetry_group_info.single_label_indices_.begin();
 			jt != symmetry_group_info.single_label_indices_.end(); ++jt)
 		{
-			LabelIndex label_index = (*jt);
-			fusing_single_symmetry_cuboid(label_index, symmetry_group,
-				_occlusion_modelview_matrix, _original_cuboid_structure,
-				_symmetry_cuboid_structure, aligned_database_cuboid_structure, _output_cuboid_structure,
-				is_symmetry_point_visited, is_label_index_visited);
+			symmetry_work_items.push_back(MeshCuboidFusionWorkItem(
+				SingleSymmetryFusion, symmetry_group, (*jt)));
 		}
 
 		// Pair symmetric cuboids.
 		for (std::vector< std::pair<LabelIndex, LabelIndex> >::const_iterator jt = symmetry_group_info.pair_label_indices_.begin();
 			jt != symmetry_group_info.pair_label_indices_.end(); ++jt)
 		{
-			LabelIndex label_index_1 = (*jt).first;
-			LabelIndex label_index_2 = (*jt).second;
-			fusing_pair_symmetry_cuboids(label_index_1, label_index_2, symmetry_group,
-				_occlusion_modelview_matrix, _original_cuboid_structure,
-				_symmetry_cuboid_structure, aligned_database_cuboid_structure, _output_cuboid_structure,
-				is_symmetry_point_visited, is_label_index_visited);
+			symmetry_work_items.push_back(MeshCuboidFusionWorkItem(
+				PairSymmetryFusion, symmetry_group, (*jt).first, (*jt).second));
 		}
 	}
 
@@ -869,62 +1004,42 @@ void reconstruct_fusion(const char *_mesh_filepath,
 		for (std::vector<LabelIndex>::const_iterator jt = symmetry_group_info.single_label_indices_.begin();
 			jt != symmetry_group_info.single_label_indices_.end(); ++jt)
 		{
-			LabelIndex label_index = (*jt);
-			fusing_single_symmetry_cuboid(label_index, symmetry_group,
-				_occlusion_modelview_matrix, _original_cuboid_structure,
-				_symmetry_cuboid_structure, aligned_database_cuboid_structure, _output_cuboid_structure,
-				is_symmetry_point_visited, is_label_index_visited);
+			symmetry_work_items.push_back(MeshCuboidFusionWorkItem(
+				SingleSymmetryFusion, symmetry_group, (*jt)));
 		}
 
 		// NOTE:
 		// Pairwise rotational symmetry is not considered.
 	}
 
+	std::cout << "Fusing symmetric cuboids... " << std::endl;
+	run_fusion_work_items(symmetry_work_items,
+		_occlusion_modelview_matrix, _original_cuboid_structure,
+		_symmetry_cuboid_structure, aligned_database_cuboid_structure, _output_cuboid_structure,
+		is_symmetry_point_visited, is_label_index_visited);
+	std::cout << "Done." << std::endl;
+
 
 	// Other single cuboids.
+	std::vector<MeshCuboidFusionWorkItem> asymmetry_work_items;
+
 	unsigned int num_labels = _symmetry_cuboid_structure.num_labels();
 	for (LabelIndex label_index = 0; label_index < num_labels; ++label_index)
 	{
 		if (is_label_index_visited[label_index])
 			continue;
 
-		MeshCuboid *symmetry_cuboid, *database_cuboid, *output_cuboid;
-		bool ret = get_fusion_cuboids(label_index,
-			_symmetry_cuboid_structure, aligned_database_cuboid_structure, _output_cuboid_structure,
-			symmetry_cuboid, database_cuboid, output_cuboid);
-		if (!ret) continue;
-
-		is_label_index_visited[label_index] = true;
-		std::cout << "Asymmetry: (" << label_index << ")" << std::endl;
-
-		// Mark visited symmetry sample points.
-		mark_cuboid_sample_points(symmetry_cuboid, _symmetry_cuboid_structure, is_symmetry_point_visited);
-
-		// Define local coordinates voxel grid.
-		MyMesh::Point bbox_min, bbox_max;
-		create_voxel_grid(symmetry_cuboid, database_cuboid,
-			bbox_min, bbox_max);
-		MeshCuboidVoxelGrid voxels(bbox_min, bbox_max, occlusion_radius);
-		std::vector<MyMesh::Point> voxel_centers;
-		voxels.get_centers(voxel_centers);
-
-		std::cout << "Computing visibility values... ";
-		std::vector<Real> voxel_visibility;
-		MeshCuboid::compute_cuboid_surface_point_visibility(
-			_occlusion_modelview_matrix, occlusion_radius, _original_cuboid_structure.sample_points_,
-			voxel_centers, NULL, voxel_visibility);
-
-		get_smoothed_voxel_visibility(
-			voxels, symmetry_cuboid, _occlusion_modelview_matrix, _original_cuboid_structure,
-			occlusion_radius, visibility_smoothing_prior, voxel_visibility);
-		std::cout << "Done." << std::endl;
-
-		std::cout << "Filling voxels... ";
-		fill_voxels_using_visibility(
-			voxels, voxel_visibility, symmetry_cuboid, database_cuboid, _output_cuboid_structure, output_cuboid);
-		std::cout << "Done." << std::endl;
+		asymmetry_work_items.push_back(MeshCuboidFusionWorkItem(
+			AsymmetryFusion, NULL, label_index));
 	}
 
+	std::cout << "Fusing other cuboids... " << std::endl;
+	run_fusion_work_items(asymmetry_work_items,
+		_occlusion_modelview_matrix, _original_cuboid_structure,
+		_symmetry_cuboid_structure, aligned_database_cuboid_structure, _output_cuboid_structure,
+		is_symmetry_point_visited, is_label_index_visited);
+	std::cout << "Done." << std::endl;
+
 
 	// Add unvisited (unsegmented) sample points in symmetry reconstruction.
 	for (SamplePointIndex sample_point_index = 0; sample_point_index < _symmetry_cuboid_structure.num_sample_points();
@@ -941,4 +1056,4 @@ void reconstruct_fusion(const char *_mesh_filepath,
 
 	delete[] is_symmetry_point_visited;
 	delete[] is_label_index_visited;
-}
\ No newline at end of file
+}
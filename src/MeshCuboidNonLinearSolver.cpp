@@ -1,6 +1,9 @@
 #include "MeshCuboidNonLinearSolver.h"
+#include "NLPAugmentedLagrangianSolver.h"
+#include "TraceRecorder.h"
 
 #include <bitset>
+#include <OpenMesh/Tools/Utils/Timer.hh>
 
 #include <Eigen/Eigenvalues> 
 
@@ -11,13 +14,15 @@ MeshCuboidNonLinearSolver::MeshCuboidNonLinearSolver(
 	const std::vector<MeshCuboidRotationSymmetryGroup *>& _rotation_symmetry_groups,
 	const Real _squared_neighbor_distance,
 	const unsigned int _min_num_symmetry_point_pairs,
-	const Real _symmetry_energy_term_weight)
+	const Real _symmetry_energy_term_weight,
+	MeshCuboidSamplePointGrids *_cuboid_sample_point_grids)
 	: cuboids_(_cuboids)
 	, reflection_symmetry_groups_(_reflection_symmetry_groups)
 	, rotation_symmetry_groups_(_rotation_symmetry_groups)
 	, squared_neighbor_distance_(_squared_neighbor_distance)
 	, min_num_symmetric_point_pairs_(_min_num_symmetry_point_pairs)
 	, symmetry_energy_term_weight_(_symmetry_energy_term_weight)
+	, cuboid_sample_point_grids_(_cuboid_sample_point_grids)
 	, num_cuboid_corner_variables_(MeshCuboidAttributes::k_num_attributes)
 	, num_cuboid_axis_variables_(3 * 3)
 	, num_reflection_symmetry_group_variables_(MeshCuboidReflectionSymmetryGroup::num_axis_parameters())
@@ -241,29 +246,22 @@ NLPFunction *MeshCuboidNonLinearSolver::create_reflection_symmetry_group_energy_
 	Eigen::VectorXd linear_term = Eigen::VectorXd::Zero(num_total_variables());
 	double constant_term = 0;
 
-	std::vector<ANNpointArray> cuboid_ann_points;
-	std::vector<ANNkd_tree *> cuboid_ann_kd_tree;
-
-	create_cuboid_sample_point_ann_trees(cuboid_ann_points, cuboid_ann_kd_tree);
+	const MeshCuboidSamplePointGrids &cuboid_sample_point_grids = update_cuboid_sample_point_grids();
 
 	for (unsigned int symmetry_group_index = 0; symmetry_group_index < num_reflection_symmetry_groups_;
 		++symmetry_group_index)
 	{
 		create_reflection_symmetry_group_energy_function(symmetry_group_index,
-			cuboid_ann_points, cuboid_ann_kd_tree,
-			quadratic_term, linear_term, constant_term);
+			cuboid_sample_point_grids, quadratic_term, linear_term, constant_term);
 	}
 
-	delete_cuboid_sample_point_ann_trees(cuboid_ann_points, cuboid_ann_kd_tree);
-
 	NLPFunction *function = new NLPEigenQuadFunction(quadratic_term, linear_term, constant_term);
 	return function;
 }
 
 void MeshCuboidNonLinearSolver::create_reflection_symmetry_group_energy_function(
 	const unsigned int _symmetry_group_index,
-	const std::vector<ANNpointArray>& _cuboid_ann_points,
-	const std::vector<ANNkd_tree *>& _cuboid_ann_kd_tree,
+	const MeshCuboidSamplePointGrids& _cuboid_sample_point_grids,
 	Eigen::MatrixXd& _quadratic_term,
 	Eigen::VectorXd& _linear_term,
 	double &_constant_term)
@@ -271,9 +269,9 @@ void MeshCuboidNonLinearSolver::create_reflection_symmetry_group_energy_function
 	const MeshCuboidSymmetryGroup* symmetry_group = reflection_symmetry_groups_[_symmetry_group_index];
 	assert(symmetry_group);
 
-	std::list<MeshCuboidSymmetryGroup::WeightedPointPair> sample_point_pairs;
+	std::vector<MeshCuboidSymmetryGroup::WeightedPointPair> sample_point_pairs;
 	symmetry_group->get_symmetric_sample_point_pairs(cuboids_,
-		_cuboid_ann_points, _cuboid_ann_kd_tree, squared_neighbor_distance_,
+		_cuboid_sample_point_grids, squared_neighbor_distance_,
 		sample_point_pairs);
 
 	if (sample_point_pairs.size() < min_num_symmetric_point_pairs_)
@@ -292,7 +290,7 @@ void MeshCuboidNonLinearSolver::create_reflection_symmetry_group_energy_function
 	Real c = 0;
 
 	Real sum_weight = 0.0;
-	for (std::list<MeshCuboidSymmetryGroup::WeightedPointPair>::iterator it = sample_point_pairs.begin();
+	for (std::vector<MeshCuboidSymmetryGroup::WeightedPointPair>::const_iterator it = sample_point_pairs.begin();
 		it != sample_point_pairs.end(); ++it)
 	{
 		assert((*it).weight_ >= 0);
@@ -302,7 +300,7 @@ void MeshCuboidNonLinearSolver::create_reflection_symmetry_group_energy_function
 	if (sum_weight == 0)
 		return;
 
-	for (std::list<MeshCuboidSymmetryGroup::WeightedPointPair>::iterator it = sample_point_pairs.begin();
+	for (std::vector<MeshCuboidSymmetryGroup::WeightedPointPair>::const_iterator it = sample_point_pairs.begin();
 		it != sample_point_pairs.end(); ++it)
 	{
 		Real weight = (*it).weight_ / sum_weight;
@@ -338,72 +336,60 @@ void MeshCuboidNonLinearSolver::create_reflection_symmetry_group_energy_function
 
 NLPFunction *MeshCuboidNonLinearSolver::create_rotation_symmetry_group_energy_function()
 {
-	NLPExpression expression;
+	MeshCuboidRotationSymmetryFunction *function = new MeshCuboidRotationSymmetryFunction(
+		num_total_variables(), symmetry_energy_term_weight_);
 
-	std::vector<ANNpointArray> cuboid_ann_points;
-	std::vector<ANNkd_tree *> cuboid_ann_kd_tree;
-
-	create_cuboid_sample_point_ann_trees(cuboid_ann_points, cuboid_ann_kd_tree);
+	const MeshCuboidSamplePointGrids &cuboid_sample_point_grids = update_cuboid_sample_point_grids();
 
 	for (unsigned int symmetry_group_index = 0; symmetry_group_index < num_rotation_symmetry_groups_;
 		++symmetry_group_index)
 	{
-		// Minimize \| t \|_2^2.
-		NLPVectorExpression t_variable = create_rotation_symmetry_group_variable_t(symmetry_group_index);
-		expression += NLPVectorExpression::dot_product(t_variable, t_variable);
-
 		create_rotation_symmetry_group_energy_function(symmetry_group_index,
-			cuboid_ann_points, cuboid_ann_kd_tree, expression);
+			cuboid_sample_point_grids, *function);
 	}
 
-	delete_cuboid_sample_point_ann_trees(cuboid_ann_points, cuboid_ann_kd_tree);
-
-	expression *= symmetry_energy_term_weight_;
-
-	NLPFunction *function = new NLPSparseFunction(num_total_variables(), expression);
 	return function;
 }
 
 void MeshCuboidNonLinearSolver::create_rotation_symmetry_group_energy_function(
 	const unsigned int _symmetry_group_index,
-	const std::vector<ANNpointArray>& _cuboid_ann_points,
-	const std::vector<ANNkd_tree *>& _cuboid_ann_kd_tree,
-	NLPExpression &_expression)
+	const MeshCuboidSamplePointGrids& _cuboid_sample_point_grids,
+	MeshCuboidRotationSymmetryFunction &_function)
 {
 	const MeshCuboidRotationSymmetryGroup* symmetry_group = rotation_symmetry_groups_[_symmetry_group_index];
 	assert(symmetry_group);
 
-	NLPVectorExpression n_variable = create_rotation_symmetry_group_variable_n(_symmetry_group_index);
-	NLPVectorExpression t_variable = create_rotation_symmetry_group_variable_t(_symmetry_group_index);
+	// NOTE:
+	// \| t \|_2^2 is minimized even when there are not enough point pairs.
+	std::pair<Index, Index> n_index_size = get_rotation_symmetry_group_variable_n_index_size(_symmetry_group_index);
+	std::pair<Index, Index> t_index_size = get_rotation_symmetry_group_variable_t_index_size(_symmetry_group_index);
+	unsigned int function_group_index = _function.add_symmetry_group(n_index_size.first, t_index_size.first);
 
 
-	std::list<MeshCuboidSymmetryGroup::WeightedPointPair> sample_point_pairs;
+	std::vector<MeshCuboidSymmetryGroup::WeightedPointPair> sample_point_pairs;
 	symmetry_group->get_symmetric_sample_point_pairs(cuboids_,
-		_cuboid_ann_points, _cuboid_ann_kd_tree, squared_neighbor_distance_,
+		_cuboid_sample_point_grids, squared_neighbor_distance_,
 		sample_point_pairs);
 
 	if (sample_point_pairs.size() < min_num_symmetric_point_pairs_)
 		return;
 
 	Real sum_weight = 0.0;
-	for (std::list<MeshCuboidSymmetryGroup::WeightedPointPair>::iterator it = sample_point_pairs.begin();
+	for (std::vector<MeshCuboidSymmetryGroup::WeightedPointPair>::const_iterator it = sample_point_pairs.begin();
 		it != sample_point_pairs.end(); ++it)
 	{
 		assert((*it).weight_ >= 0);
 		sum_weight += (*it).weight_;
 	}
 
-	for (std::list<MeshCuboidSymmetryGroup::WeightedPointPair>::iterator it = sample_point_pairs.begin();
+	if (sum_weight == 0)
+		return;
+
+	for (std::vector<MeshCuboidSymmetryGroup::WeightedPointPair>::const_iterator it = sample_point_pairs.begin();
 		it != sample_point_pairs.end(); ++it)
 	{
 		Real weight = (*it).weight_ / sum_weight;
 
-		MyMesh::Normal n; MyMesh::Point t;
-		symmetry_group->get_rotation_axis(n, t);
-
-		int symmetry_order = static_cast<int>(std::round((*it).angle_ / symmetry_group->get_rotation_angle()));
-		MyMesh::Point symmetry_point_1 = symmetry_group->get_symmetric_point((*it).p1_, symmetry_order);
-
 		Eigen::Vector3d x_vec, y_vec;
 		for (int i = 0; i < 3; ++i)
 		{
@@ -411,74 +397,7 @@ void MeshCuboidNonLinearSolver::create_rotation_symmetry_group_energy_function(
 			y_vec[i] = (*it).p2_[i];
 		}
 
-		// Debug.
-		//Eigen::Vector3d n_vec, t_vec, symm_x_vec;
-		//for (int i = 0; i < 3; ++i)
-		//{
-		//	n_vec[i] = n[i];
-		//	t_vec[i] = t[i];
-		//	symm_x_vec[i] = symmetry_point_1[i];
-		//}
-
-		//Eigen::AngleAxisd axis_rotation((*it).angle_, n_vec);
-		//Eigen::VectorXd transf_x_vec = axis_rotation.toRotationMatrix() * (x_vec - t_vec) + t_vec;
-
-		//Eigen::VectorXd diff_1 = transf_x_vec - symm_x_vec;
-		//if (diff_1.norm() > 1.0E-8)
-		//{
-		//	std::cout << "distance = " << diff_1.norm() << std::endl;
-		//	std::cout << "angle = " << (*it).angle_ << std::endl;
-		//	std::cout << "symmetry_order = " << symmetry_order << std::endl;
-		//	std::cout << symm_x_vec.transpose() << std::endl;
-		//	std::cout << transf_x_vec.transpose() << std::endl;
-		//	system("pause");
-		//}
-
-		//Eigen::VectorXd diff_2 = transf_x_vec - y_vec;
-		//if (diff_2.norm() > neighbor_distance_)
-		//{
-		//	std::cout << "distance = " << diff_2.norm() << std::endl;
-		//	std::cout << "neighbor_distance = " << neighbor_distance_ << std::endl;
-		//	std::cout << "weight = " << (neighbor_distance_ - sqrt((*it).weight_)) << std::endl;
-		//	std::cout << symm_x_vec.transpose() << std::endl;
-		//	std::cout << transf_x_vec.transpose() << std::endl;
-		//	system("pause");
-		//}
-
-		Real sin_angle = std::sin((*it).angle_);
-		Real cos_angle = std::cos((*it).angle_);
-
-		NLPVectorExpression x_minus_t = (x_vec - t_variable);
-		NLPVectorExpression y_minus_t = (y_vec - t_variable);
-
-		NLPVectorExpression term_1 = x_minus_t * cos_angle;
-		NLPVectorExpression term_2 = NLPVectorExpression::cross_product(n_variable, x_minus_t) * sin_angle;
-		NLPVectorExpression term_3 = n_variable * NLPVectorExpression::dot_product(n_variable, x_minus_t) * (1 - cos_angle);
-		NLPVectorExpression all_terms = term_1 + term_2 + term_3 - y_minus_t;
-		NLPExpression squared_all_terms = NLPVectorExpression::dot_product(all_terms, all_terms);
-
-		// Debug.
-		//Number *x = new Number[num_total_variables()];
-		//std::pair<Index, Index> n_index_size = get_rotation_symmetry_group_variable_n_index_size(_symmetry_group_index);
-		//std::pair<Index, Index> t_index_size = get_rotation_symmetry_group_variable_t_index_size(_symmetry_group_index);
-		//for (Index i = 0; i < n_index_size.second; ++i)
-		//	x[n_index_size.first + i] = n[i];
-		//for (Index i = 0; i < t_index_size.second; ++i)
-		//	x[t_index_size.first + i] = t[i];
-		//std::cout << "eval = " << squared_all_terms.eval(x) << std::endl;
-
-		//Eigen::Vector3d term_1_vec = cos_angle * (x_vec - t_vec);
-		//Eigen::Vector3d term_2_vec = sin_angle * n_vec.cross(x_vec - t_vec);
-		//Eigen::Vector3d term_3_vec = (1 - cos_angle) * n_vec.dot(x_vec - t_vec) * n_vec;
-		//Eigen::Vector3d term_4_vec = -(y_vec - t_vec);
-		//Eigen::Vector3d all_terms_vec = term_1_vec + term_2_vec + term_3_vec + term_4_vec;
-		//std::cout << "eval = " << all_terms_vec.squaredNorm() << std::endl;
-
-		//delete[] x;
-		//system("pause");
-		//
-
-		_expression += squared_all_terms;
+		_function.add_point_pair(function_group_index, x_vec, y_vec, weight, (*it).angle_);
 	}
 }
 
@@ -913,17 +832,13 @@ void MeshCuboidNonLinearSolver::optimize(
 	const Eigen::VectorXd& _cuboid_linear_term,
 	const double _cuboid_constant_term,
 	Eigen::VectorXd* _init_values_vec,
-	const std::vector<unsigned int> *_fixed_cuboid_indices)
+	const std::vector<unsigned int> *_fixed_cuboid_indices,
+	const MeshCuboidNonLinearSolverBackend _backend,
+	const bool _compare_backends)
 {
-	// Update rotation angle.
-	for (unsigned int symmetry_group_index = 0; symmetry_group_index < num_rotation_symmetry_groups_;
-		++symmetry_group_index)
-	{
-		MeshCuboidRotationSymmetryGroup* symmetry_group = rotation_symmetry_groups_[symmetry_group_index];
-		assert(symmetry_group);
-		symmetry_group->compute_rotation_angle(cuboids_);
-	}
-
+	// NOTE:
+	// Rotation angles of the rotation symmetry groups should be updated
+	// before calling this function.
 	std::vector<NLPFunction *> functions;
 	create_energy_functions(_cuboid_quadratic_term, _cuboid_linear_term, _cuboid_constant_term, functions);
 	NLPFormulation formulation(functions);
@@ -958,10 +873,51 @@ void MeshCuboidNonLinearSolver::optimize(
 	}
 
 
+#ifdef USE_IPOPT
+	const MeshCuboidNonLinearSolverBackend backend = _backend;
+#else
+	// NOTE: Only the augmented Lagrangian solver is built without 'USE_IPOPT'.
+	const MeshCuboidNonLinearSolverBackend backend = AugmentedLagrangianSolverBackend;
+#endif
+
+	if (_compare_backends)
+		compare_solver_backends(formulation, backend);
+#ifdef USE_IPOPT
+	else if (backend == IPOPTSolverBackend)
+		solve_ipopt(formulation);
+#endif
+	else
+		solve_augmented_lagrangian(formulation);
+
+
+	// DEBUG.
+	//formulation.print_constraint_evaluations();
+
+	std::vector< Number > output;
+	formulation.get_values(output);
+	assert(output.size() == num_total_variables());
+	//std::cout << "final = " << formulation.eval_function(&(output[0])) << ")" << std::endl;
+
+	std::cout << "Final error = ";
+	for (int i = 0; i < functions.size(); ++i)
+		std::cout << functions[i]->eval(&output[0]) << ", ";
+	std::cout << std::endl;
+
+
+	// Update symmetry groups.
+	update(output);
+}
+
+#ifdef USE_IPOPT
+bool MeshCuboidNonLinearSolver::solve_ipopt(NLPFormulation &_formulation) const
+{
+	TraceScope trace_scope("solve_ipopt");
+	trace_scope.add_arg("variables", num_total_variables());
+
 	// ---- //
 	// Create a new instance of your nlp
 	//  (use a SmartPtr, not raw)
-	SmartPtr<TNLP> mynlp = new IPOPTSolver(&formulation);
+	SmartPtr<TNLP> mynlp = new IPOPTSolver(&_formulation);
 	//SmartPtr<TNLP> mynlp = new HS071_NLP();
 
 	// Create a new instance of IpoptApplication
@@ -994,7 +950,15 @@ void MeshCuboidNonLinearSolver::optimize(
 	// Ask Ipopt to solve the problem
 	status = app->OptimizeTNLP(mynlp);
 
-	if (status == Solve_Succeeded) {
+	if (IsValid(app->Statistics()))
+	{
+		const Index num_iterations = app->Statistics()->IterationCount();
+		trace_scope.add_arg("iterations", num_iterations);
+		TraceRecorder::add_counter("solver_iterations", num_iterations);
+	}
+
+	bool ret = (status == Solve_Succeeded);
+	if (ret) {
 		//std::cout << std::endl << std::endl << "*** The problem solved!" << std::endl;
 	}
 	else {
@@ -1008,23 +972,85 @@ void MeshCuboidNonLinearSolver::optimize(
 	// be deleted.
 	// ---- //
 
+	return ret;
+}
+#endif	// USE_IPOPT
 
-	// DEBUG.
-	//formulation.print_constraint_evaluations();
+bool MeshCuboidNonLinearSolver::solve_augmented_lagrangian(NLPFormulation &_formulation) const
+{
+	TraceScope trace_scope("solve_augmented_lagrangian");
+	trace_scope.add_arg("variables", num_total_variables());
 
-	std::vector< Number > output;
-	formulation.get_values(output);
-	assert(output.size() == num_total_variables());
-	//std::cout << "final = " << formulation.eval_function(&(output[0])) << ")" << std::endl;
+	NLPAugmentedLagrangianSolver solver(&_formulation);
+	bool ret = solver.solve();
 
-	std::cout << "Final error = ";
-	for (int i = 0; i < functions.size(); ++i)
-		std::cout << functions[i]->eval(&output[0]) << ", ";
-	std::cout << std::endl;
+	trace_scope.add_arg("iterations", solver.num_inner_iterations());
+	TraceRecorder::add_counter("solver_iterations", solver.num_inner_iterations());
 
+	if (!ret) {
+		std::vector< Number > values;
+		_formulation.get_values(values);
+		std::cout << std::endl << std::endl << "*** The problem FAILED!"
+			<< " (max constraint violation = " << solver.max_constraint_violation(&values[0])
+			<< ")" << std::endl;
+	}
 
-	// Update symmetry groups.
-	update(output);
+	return ret;
+}
+
+void MeshCuboidNonLinearSolver::compare_solver_backends(NLPFormulation &_formulation,
+	const MeshCuboidNonLinearSolverBackend _backend) const
+{
+#ifdef USE_IPOPT
+	const unsigned int num_backends = 2;
+	const MeshCuboidNonLinearSolverBackend backends[num_backends] = {
+		IPOPTSolverBackend, AugmentedLagrangianSolverBackend };
+	const char *backend_names[num_backends] = { "IPOPT", "Augmented Lagrangian" };
+#else
+	const unsigned int num_backends = 1;
+	const MeshCuboidNonLinearSolverBackend backends[num_backends] = {
+		AugmentedLagrangianSolverBackend };
+	const char *backend_names[num_backends] = { "Augmented Lagrangian" };
+#endif
+
+	// NOTE:
+	// Both backends start from the same initial values on the same formulation.
+	std::vector< Number > init_values;
+	_formulation.get_values(init_values);
+	std::vector< Number > selected_values = init_values;
+
+	// Used only for measuring constraint violations.
+	NLPAugmentedLagrangianSolver evaluator(&_formulation);
+
+	std::cout << "Solver backend comparison:" << std::endl;
+
+	for (unsigned int i = 0; i < num_backends; ++i)
+	{
+		_formulation.set_values(init_values);
+
+		OpenMesh::Utils::Timer timer;
+		timer.start();
+#ifdef USE_IPOPT
+		bool ret = (backends[i] == AugmentedLagrangianSolverBackend) ?
+			solve_augmented_lagrangian(_formulation) : solve_ipopt(_formulation);
+#else
+		bool ret = solve_augmented_lagrangian(_formulation);
+#endif
+		timer.stop();
+
+		std::vector< Number > values;
+		_formulation.get_values(values);
+		std::cout << " - " << backend_names[i] << ": "
+			<< "energy = " << _formulation.eval_function(&values[0])
+			<< ", max constraint violation = " << evaluator.max_constraint_violation(&values[0])
+			<< ", time = " << timer.as_string()
+			<< (ret ? "" : " (FAILED)") << std::endl;
+
+		if (backends[i] == _backend)
+			selected_values = values;
+	}
+
+	_formulation.set_values(selected_values);
 }
 
 void MeshCuboidNonLinearSolver::update(const std::vector< Number >& _values)
@@ -1170,56 +1196,10 @@ void MeshCuboidNonLinearSolver::update_rotation_symmetry_groups(const std::vecto
 	}
 }
 
-void MeshCuboidNonLinearSolver::create_cuboid_sample_point_ann_trees(
-	std::vector<ANNpointArray>& _cuboid_ann_points,
-	std::vector<ANNkd_tree *>& _cuboid_ann_kd_tree) const
-{
-	delete_cuboid_sample_point_ann_trees(_cuboid_ann_points, _cuboid_ann_kd_tree);
-	_cuboid_ann_points.resize(num_cuboids_);
-	_cuboid_ann_kd_tree.resize(num_cuboids_);
-
-	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids_; ++cuboid_index)
-	{
-		_cuboid_ann_kd_tree[cuboid_index] = NULL;
-		_cuboid_ann_points[cuboid_index] = NULL;
-
-		MeshCuboid *cuboid = cuboids_[cuboid_index];
-		unsigned int num_cuboid_sample_points = cuboid->num_sample_points();
-		if (num_cuboid_sample_points == 0)
-			continue;
-
-		Eigen::MatrixXd cuboid_sample_points(3, num_cuboid_sample_points);
-
-		for (unsigned int point_index = 0; point_index < num_cuboid_sample_points; ++point_index)
-		{
-			for (unsigned int i = 0; i < 3; ++i)
-				cuboid_sample_points.col(point_index)(i) =
-				cuboid->get_sample_point(point_index)->point_[i];
-		}
-
-		_cuboid_ann_kd_tree[cuboid_index] = ICP::create_kd_tree(cuboid_sample_points,
-			_cuboid_ann_points[cuboid_index]);
-		assert(_cuboid_ann_points[cuboid_index]);
-		assert(_cuboid_ann_kd_tree[cuboid_index]);
-	}
-}
-
-void MeshCuboidNonLinearSolver::delete_cuboid_sample_point_ann_trees(
-	std::vector<ANNpointArray>& _cuboid_ann_points,
-	std::vector<ANNkd_tree *>& _cuboid_ann_kd_tree) const
+MeshCuboidSamplePointGrids &MeshCuboidNonLinearSolver::update_cuboid_sample_point_grids()
 {
-	if (_cuboid_ann_points.empty() && _cuboid_ann_kd_tree.empty())
-		return;
-
-	assert(_cuboid_ann_points.size() == num_cuboids_);
-	assert(_cuboid_ann_kd_tree.size() == num_cuboids_);
-
-	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids_; ++cuboid_index)
-	{
-		if (_cuboid_ann_points[cuboid_index]) annDeallocPts(_cuboid_ann_points[cuboid_index]);
-		if (_cuboid_ann_kd_tree[cuboid_index]) delete _cuboid_ann_kd_tree[cuboid_index];
-	}
-
-	_cuboid_ann_points.clear();
-	_cuboid_ann_kd_tree.clear();
+	MeshCuboidSamplePointGrids &cuboid_sample_point_grids = cuboid_sample_point_grids_ ?
+		(*cuboid_sample_point_grids_) : own_cuboid_sample_point_grids_;
+	cuboid_sample_point_grids.update(cuboids_, std::sqrt(squared_neighbor_distance_));
+	return cuboid_sample_point_grids;
 }
@@ -1,8 +1,13 @@
 #include "MeshCuboidParameters.h"
 
+#include <cstdlib>
+#include <fstream>
+
 // -- Parameters -- //
 //
 DEFINE_bool(param_optimize_training_cuboids, true, "");
+DEFINE_bool(param_opt_use_augmented_lagrangian, false, "");
+DEFINE_bool(param_opt_compare_solver_backends, false, "");
 
 DEFINE_int32(param_num_sample_point_neighbors, 8, "");
 DEFINE_int32(param_min_num_cuboid_sample_points, 10, "");
@@ -11,6 +16,8 @@ DEFINE_int32(param_num_cuboid_surface_points, 1000, "");
 DEFINE_int32(param_intra_cuboid_symmetry_axis, 0, "");
 DEFINE_int32(param_eval_num_neighbor_range_samples, 1001, "");
 DEFINE_int32(param_opt_max_iterations, 5, "");
+DEFINE_int32(param_label_confidence_encoding, 0, "");
+DEFINE_int32(param_label_confidence_top_k, 0, "");
 
 DEFINE_double(param_min_sample_point_confidence, 0.7, "");
 DEFINE_double(param_min_num_confidence_tol_sample_points, 0.5, "");
@@ -57,6 +64,7 @@ DEFINE_bool(disable_part_relation_terms, false, "");
 DEFINE_bool(run_ground_truth_cuboids, false, "");
 DEFINE_bool(run_training, false, "");
 DEFINE_bool(run_prediction, false, "");
+DEFINE_bool(run_batch_prediction, false, "");
 DEFINE_bool(run_part_assembly, false, "");
 DEFINE_bool(run_symmetry_detection, false, "");
 DEFINE_bool(run_baseline, false, "");
@@ -110,7 +118,104 @@ DEFINE_string(object_list_filename, "object_list.txt", "");
 
 DEFINE_int32(random_view_seed, 20150416, "");
 
+DEFINE_string(batch_job_manifest_filename, "jobs.txt", "");
+DEFINE_int32(batch_num_workers, 1, "");
+DEFINE_int32(batch_worker_index, 0, "");
+
+DEFINE_string(snapshot_format, "png", "");
+DEFINE_int32(snapshot_queue_size, 8, "");
+DEFINE_int32(snapshot_stage_mask, 7, "");
+
+DEFINE_bool(trace_pipeline, false, "");
+
+DEFINE_bool(checkpoint_prediction, false, "");
+
+DEFINE_string(preprocessing_cache_dir, "", "");
+DEFINE_string(mesh_cache_dir, "", "");
+DEFINE_bool(make_face_normal_consistent, true, "");
+DEFINE_bool(sample_points_from_mesh, false, "");
+DEFINE_int32(num_sample_points, 1000, "");
+DEFINE_int32(num_dense_sample_points, 100000, "");
+DEFINE_int32(sample_points_seed, 20150416, "");
+DEFINE_int32(max_num_prediction_sample_points, 0, "");
+
 // To be removed.
 //DEFINE_bool(use_symmetric_group_cuboids, false, "");
 //
 // ---- //
+
+
+MeshCuboidParameters::MeshCuboidParameters()
+	: opt_use_augmented_lagrangian_(FLAGS_param_opt_use_augmented_lagrangian)
+	, opt_compare_solver_backends_(FLAGS_param_opt_compare_solver_backends)
+	, num_sample_point_neighbors_(FLAGS_param_num_sample_point_neighbors)
+	, min_num_cuboid_sample_points_(FLAGS_param_min_num_cuboid_sample_points)
+	, min_num_symmetric_point_pairs_(FLAGS_param_min_num_symmetric_point_pairs)
+	, num_cuboid_surface_points_(FLAGS_param_num_cuboid_surface_points)
+	, intra_cuboid_symmetry_axis_(FLAGS_param_intra_cuboid_symmetry_axis)
+	, eval_num_neighbor_range_samples_(FLAGS_param_eval_num_neighbor_range_samples)
+	, opt_max_iterations_(FLAGS_param_opt_max_iterations)
+	, label_confidence_encoding_(FLAGS_param_label_confidence_encoding)
+	, label_confidence_top_k_(FLAGS_param_label_confidence_top_k)
+	, min_sample_point_confidence_(FLAGS_param_min_sample_point_confidence)
+	, min_cuboid_bbox_size_(FLAGS_param_min_cuboid_bbox_size)
+	, min_cuboid_bbox_diag_length_(FLAGS_param_min_cuboid_bbox_diag_length)
+	, sparse_neighbor_distance_(FLAGS_param_sparse_neighbor_distance)
+	, cuboid_split_neighbor_distance_(FLAGS_param_cuboid_split_neighbor_distance)
+	, occlusion_test_neighbor_distance_(FLAGS_param_occlusion_test_neighbor_distance)
+	, eval_min_neighbor_distance_(FLAGS_param_eval_min_neighbor_distance)
+	, eval_max_neighbor_distance_(FLAGS_param_eval_max_neighbor_distance)
+	, min_cuboid_overall_visibility_(FLAGS_param_min_cuboid_overall_visibility)
+	, max_potential_(FLAGS_param_max_potential)
+	, dummy_potential_(FLAGS_param_dummy_potential)
+	, null_cuboid_probability_(FLAGS_param_null_cuboid_probability)
+	, fusion_visibility_smoothing_prior_(FLAGS_param_fusion_visibility_smoothing_prior)
+	, fusion_grid_size_(FLAGS_param_fusion_grid_size)
+	, opt_single_energy_term_weight_(FLAGS_param_opt_single_energy_term_weight)
+	, opt_symmetry_energy_term_weight_(FLAGS_param_opt_symmetry_energy_term_weight)
+	, part_assembly_window_size_(FLAGS_param_part_assembly_window_size)
+	, part_assembly_voxel_size_(FLAGS_param_part_assembly_voxel_size)
+	, part_assembly_voxel_variance_(FLAGS_param_part_assembly_voxel_variance)
+	, use_view_plane_mask_(FLAGS_use_view_plane_mask)
+	, view_plane_mask_proportion_(FLAGS_param_view_plane_mask_proportion)
+	, view_plane_mask_min_x_(FLAGS_param_view_plane_mask_min_x)
+	, view_plane_mask_min_y_(FLAGS_param_view_plane_mask_min_y)
+	, view_plane_mask_max_x_(FLAGS_param_view_plane_mask_max_x)
+	, view_plane_mask_max_y_(FLAGS_param_view_plane_mask_max_y)
+	, disable_symmetry_terms_(FLAGS_disable_symmetry_terms)
+	, disable_per_point_classifier_terms_(FLAGS_disable_per_point_classifier_terms)
+	, disable_label_smoothness_terms_(FLAGS_disable_label_smoothness_terms)
+	, disable_part_relation_terms_(FLAGS_disable_part_relation_terms)
+	, optimize_individual_reflection_symmetry_group_(FLAGS_optimize_individual_reflection_symmetry_group)
+{
+
+}
+
+bool MeshCuboidParameters::load_view_plane_mask(const std::string &_filename)
+{
+	std::ifstream file(_filename.c_str());
+	if (!file.is_open())
+		return false;
+
+	std::string buffer;
+	std::getline(file, buffer); view_plane_mask_min_x_ = std::atof(buffer.c_str());
+	std::getline(file, buffer); view_plane_mask_min_y_ = std::atof(buffer.c_str());
+	std::getline(file, buffer); view_plane_mask_max_x_ = std::atof(buffer.c_str());
+	std::getline(file, buffer); view_plane_mask_max_y_ = std::atof(buffer.c_str());
+	file.close();
+	return true;
+}
+
+bool MeshCuboidParameters::save_view_plane_mask(const std::string &_filename) const
+{
+	std::ofstream file(_filename.c_str());
+	if (!file.is_open())
+		return false;
+
+	file << view_plane_mask_min_x_ << std::endl;
+	file << view_plane_mask_min_y_ << std::endl;
+	file << view_plane_mask_max_x_ << std::endl;
+	file << view_plane_mask_max_y_ << std::endl;
+	file.close();
+	return true;
+}
@@ -286,11 +286,12 @@ void MeshViewerCore::run_part_assembly_match_parts(const std::string _mesh_filep
 	const MeshCuboidTrainer &_trainer, std::vector<std::string> &_label_matched_objects)
 {
 	// Parameters.
-	const Real part_assembly_window_size = FLAGS_param_part_assembly_window_size *
+	const MeshCuboidParameters &params = cuboid_structure_.get_parameters();
+	const Real part_assembly_window_size = params.part_assembly_window_size_ *
 		cuboid_structure_.mesh_->get_object_diameter();
-	const Real part_assembly_voxel_size = FLAGS_param_part_assembly_voxel_size *
+	const Real part_assembly_voxel_size = params.part_assembly_voxel_size_ *
 		cuboid_structure_.mesh_->get_object_diameter();
-	const Real part_assembly_voxel_variance = FLAGS_param_part_assembly_voxel_variance *
+	const Real part_assembly_voxel_variance = params.part_assembly_voxel_variance_ *
 		cuboid_structure_.mesh_->get_object_diameter();
 	const Real distance_param = 2 * part_assembly_voxel_variance * part_assembly_voxel_variance;
 	assert(distance_param > 0);
@@ -535,8 +536,8 @@ void MeshViewerCore::run_part_assembly_reconstruction(const std::string _mesh_fi
 			MyMesh::Normal normal = sample_point->normal_;
 			MeshSamplePoint *new_sample_point = cuboid_structure_.add_sample_point(point, normal);
 
-			new_sample_point->label_index_confidence_.resize(num_labels, 0.0);
-			new_sample_point->label_index_confidence_[label_index] = 1.0;
+			cuboid_structure_.sample_label_confidences_.set_one_hot(
+				new_sample_point->sample_point_index_, label_index);
 
 			cuboid->add_sample_point(new_sample_point);
 		}
@@ -663,25 +664,19 @@ void MeshViewerCore::run_part_assembly()
 	}
 
 	// View plane mask.
-	if (FLAGS_use_view_plane_mask)
+	MeshCuboidParameters params;
+	if (params.use_view_plane_mask_)
 	{
 		std::string mesh_output_path = FLAGS_output_dir + std::string("/") + mesh_name;
 		std::string view_plane_mask_filename = mesh_output_path + std::string("/view_mask.txt");
-		std::ifstream view_plane_mask_file(view_plane_mask_filename.c_str());
 
-		if (!view_plane_mask_file.is_open())
+		if (!params.load_view_plane_mask(view_plane_mask_filename))
 		{
 			std::cerr << "Error: The view plane mask file is not opened (" << view_plane_mask_filename << ")." << std::endl;
 			return;
 		}
-
-		std::string buffer;
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_min_x = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_min_y = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_max_x = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_max_y = std::atof(buffer.c_str());
-		view_plane_mask_file.close();
 	}
+	cuboid_structure_.set_parameters(params);
 
 
 	std::string filename_prefix = std::string("/") + mesh_name + std::string("_");
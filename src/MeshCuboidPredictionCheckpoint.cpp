@@ -0,0 +1,145 @@
+#include "MeshCuboidPredictionCheckpoint.h"
+
+#include "BinaryIO.h"
+#include "MeshCuboidPreprocessingCache.h"
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+
+// NOTE:
+// Increase the version when the binary format is changed.
+#define PREDICTION_CHECKPOINT_MAGIC		0x4350434D	// "MCPC"
+#define PREDICTION_CHECKPOINT_VERSION	3
+
+
+MeshCuboidPredictionCheckpoint::MeshCuboidPredictionCheckpoint(const MyMesh *_mesh,
+	const MeshCuboidParameters &_params)
+	: full_resolution_structure_(_mesh, _params)
+	, mesh_(_mesh)
+	, params_(_params)
+{
+	assert(_mesh);
+	clear();
+}
+
+void MeshCuboidPredictionCheckpoint::clear()
+{
+	candidates_.clear();
+	next_stage_ = RecognizeStage;
+	first_iteration_ = true;
+	ignored_label_indices_.clear();
+	num_final_candidates_ = 0;
+	full_resolution_structure_.clear();
+	representative_indices_.clear();
+}
+
+bool MeshCuboidPredictionCheckpoint::save(const std::string &_filename,
+	const std::string &_input_key) const
+{
+	const std::string temp_filename = MeshCuboidPreprocessingCache::get_temp_filename(_filename);
+	{
+		std::ofstream file(temp_filename.c_str(), std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "Error: Cannot save the checkpoint (" << temp_filename << ")." << std::endl;
+			return false;
+		}
+
+		BinaryIO::write_header(file, PREDICTION_CHECKPOINT_MAGIC, PREDICTION_CHECKPOINT_VERSION);
+		BinaryIO::write(file, _input_key);
+		BinaryIO::write(file, next_stage_);
+		BinaryIO::write(file, first_iteration_);
+		BinaryIO::write(file, std::vector<LabelIndex>(
+			ignored_label_indices_.begin(), ignored_label_indices_.end()));
+		BinaryIO::write(file, num_final_candidates_);
+		BinaryIO::write(file, representative_indices_);
+		full_resolution_structure_.save_binary(file);
+
+		BinaryIO::write(file, static_cast<uint64_t>(candidates_.size()));
+		for (std::list< std::pair<std::string, MeshCuboidStructure> >::const_iterator it = candidates_.begin();
+			it != candidates_.end(); ++it)
+		{
+			BinaryIO::write(file, (*it).first);
+			(*it).second.save_binary(file);
+		}
+
+		if (!file.good())
+		{
+			std::cerr << "Error: Cannot save the checkpoint (" << temp_filename << ")." << std::endl;
+			file.close();
+			std::remove(temp_filename.c_str());
+			return false;
+		}
+	}
+
+	// NOTE:
+	// 'std::rename()' does not overwrite an existing file on Windows.
+#ifdef _WIN32
+	std::remove(_filename.c_str());
+#endif
+	if (std::rename(temp_filename.c_str(), _filename.c_str()) != 0)
+	{
+		std::cerr << "Error: Cannot save the checkpoint (" << _filename << ")." << std::endl;
+		std::remove(temp_filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCuboidPredictionCheckpoint::load(const std::string &_filename,
+	const std::string &_input_key)
+{
+	clear();
+
+	std::ifstream file(_filename.c_str(), std::ios::binary);
+	if (!file)
+		return false;
+
+	std::string input_key;
+	std::vector<LabelIndex> ignored_label_indices;
+	uint64_t num_candidates = 0;
+
+	bool ret = BinaryIO::read_header(file, PREDICTION_CHECKPOINT_MAGIC, PREDICTION_CHECKPOINT_VERSION);
+	ret = ret && BinaryIO::read(file, input_key);
+
+	// NOTE:
+	// The inputs were changed after the checkpoint was saved.
+	if (ret && input_key != _input_key)
+	{
+		std::cerr << "Warning: The checkpoint is ignored since the inputs are changed ("
+			<< _filename << ")." << std::endl;
+		return false;
+	}
+
+	ret = ret && BinaryIO::read(file, next_stage_);
+	ret = ret && BinaryIO::read(file, first_iteration_);
+	ret = ret && BinaryIO::read(file, ignored_label_indices);
+	ret = ret && BinaryIO::read(file, num_final_candidates_);
+	ret = ret && BinaryIO::read(file, representative_indices_);
+	ret = ret && full_resolution_structure_.load_binary(file);
+	ret = ret && BinaryIO::read(file, num_candidates);
+	ret = ret && (next_stage_ < NumStages);
+
+	for (uint64_t i = 0; ret && i < num_candidates; ++i)
+	{
+		std::string name;
+		ret = ret && BinaryIO::read(file, name);
+
+		candidates_.push_back(std::make_pair(name, MeshCuboidStructure(mesh_, params_)));
+		ret = ret && candidates_.back().second.load_binary(file);
+	}
+
+	if (!ret)
+	{
+		std::cerr << "Error: Invalid checkpoint file (" << _filename << ")." << std::endl;
+		clear();
+		return false;
+	}
+
+	ignored_label_indices_.insert(ignored_label_indices.begin(), ignored_label_indices.end());
+	return true;
+}
@@ -12,8 +12,10 @@
 #include <Eigen/Eigenvalues>
 
 
-MeshCuboidPredictor::MeshCuboidPredictor(unsigned int _num_labels)
+MeshCuboidPredictor::MeshCuboidPredictor(unsigned int _num_labels,
+	const MeshCuboidParameters &_params)
 	: num_labels_(_num_labels)
+	, params_(_params)
 {
 
 }
@@ -27,6 +29,7 @@ void MeshCuboidPredictor::get_missing_label_indices(
 
 Real MeshCuboidPredictor::get_single_potential(
 	const MeshCuboid *_cuboid,
+	const LabelConfidenceTable &_label_confidences,
 	const MeshCuboidAttributes *_attributes,
 	const MeshCuboidTransformation *_transformation,
 	const LabelIndex _label_index)const
@@ -55,31 +58,32 @@ Real MeshCuboidPredictor::get_single_potential(
 	//	potential = FLAGS_param_max_potential;
 	//}
 	
+	if (_label_index >= _label_confidences.num_labels())
+	{
+		// Dummy label.
+		return -std::log(params_.null_cuboid_probability_);
+	}
+
 	for (std::vector<MeshSamplePoint *>::const_iterator sample_it = _cuboid->get_sample_points().begin();
 		sample_it != _cuboid->get_sample_points().end(); ++sample_it)
 	{
-		if (_label_index >= (*sample_it)->label_index_confidence_.size())
-		{
-			// Dummy label.
-			return -std::log(FLAGS_param_null_cuboid_probability);
-		}
-
-		assert((*sample_it)->label_index_confidence_[_label_index] >= 0.0);
-		assert((*sample_it)->label_index_confidence_[_label_index] <= 1.0);
-		if ((*sample_it)->label_index_confidence_[_label_index] < 10E-12)
+		const Real confidence = _label_confidences.get((*sample_it)->sample_point_index_, _label_index);
+		assert(confidence >= 0.0);
+		assert(confidence <= 1.0);
+		if (confidence < 10E-12)
 		{
 			potential += 12;
 		}
 		else
 		{
-			potential -= std::log((*sample_it)->label_index_confidence_[_label_index]);
+			potential -= std::log(confidence);
 		}
 		++num_sample_points;
 	}
 
 	if (num_sample_points == 0)
 	{
-		return -std::log(FLAGS_param_null_cuboid_probability);
+		return -std::log(params_.null_cuboid_probability_);
 	}
 	else
 	{
@@ -313,8 +317,9 @@ Real MeshCuboidPredictor::get_pair_conditional_quadratic_form(
 }
 
 MeshCuboidJointNormalRelationPredictor::MeshCuboidJointNormalRelationPredictor(
-	const std::vector< std::vector<MeshCuboidJointNormalRelations *> > &_relations)
-	: MeshCuboidPredictor(_relations.size())
+	const std::vector< std::vector<MeshCuboidJointNormalRelations *> > &_relations,
+	const MeshCuboidParameters &_params)
+	: MeshCuboidPredictor(_relations.size(), _params)
 	, relations_(_relations)
 {
 	for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
@@ -381,7 +386,7 @@ Real MeshCuboidJointNormalRelationPredictor::get_pair_potential(
 	// Now considering only different label pairs.
 	//assert(_label_index_1 != _label_index_2);
 
-	Real potential = FLAGS_param_max_potential;
+	Real potential = params_.max_potential_;
 
 	//const MeshCuboidJointNormalRelations *relation_12 = relations_[_label_index_1][_label_index_2];
 	//const MeshCuboidJointNormalRelations *relation_21 = relations_[_label_index_2][_label_index_1];
@@ -719,8 +724,9 @@ Real MeshCuboidJointNormalRelationPredictor::get_pair_conditional_quadratic_form
 }
 
 MeshCuboidCondNormalRelationPredictor::MeshCuboidCondNormalRelationPredictor(
-	const std::vector< std::vector<MeshCuboidCondNormalRelations *> > &_relations)
-	: MeshCuboidPredictor(_relations.size())
+	const std::vector< std::vector<MeshCuboidCondNormalRelations *> > &_relations,
+	const MeshCuboidParameters &_params)
+	: MeshCuboidPredictor(_relations.size(), _params)
 	, relations_(_relations)
 {
 	for (unsigned int label_index = 0; label_index < num_labels_; ++label_index)
@@ -787,7 +793,7 @@ Real MeshCuboidCondNormalRelationPredictor::get_pair_potential(
 	// Now considering only different label pairs.
 	//assert(_label_index_1 != _label_index_2);
 
-	Real potential = FLAGS_param_max_potential;
+	Real potential = params_.max_potential_;
 
 	const MeshCuboidCondNormalRelations *relation_12 = relations_[_label_index_1][_label_index_2];
 	const MeshCuboidCondNormalRelations *relation_21 = relations_[_label_index_2][_label_index_1];
@@ -1203,6 +1209,7 @@ MeshCuboidManualRelationPredictor::MeshCuboidManualRelationPredictor(
 
 Real MeshCuboidManualRelationPredictor::get_single_potential(
 	const MeshCuboid *_cuboid,
+	const LabelConfidenceTable &_label_confidences,
 	const MeshCuboidAttributes *_attributes,
 	const MeshCuboidTransformation *_transformation,
 	const LabelIndex _label_index)const
@@ -0,0 +1,206 @@
+#include "MeshCuboidPreprocessingCache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+
+// NOTE:
+// Increase the version when the preprocessing or the binary format is changed
+// so that old cache files are not used.
+#define PREPROCESSING_CACHE_VERSION	1
+
+#define FNV_PRIME			1099511628211ULL
+#define FNV_OFFSET_BASIS	14695981039346656037ULL
+
+
+MeshCuboidPreprocessingCache::MeshCuboidPreprocessingCache(const std::string &_cache_dir)
+	: cache_dir_(_cache_dir)
+{
+	hash_[0] = FNV_OFFSET_BASIS;
+	hash_[1] = FNV_OFFSET_BASIS ^ 0x5bd1e9955bd1e995ULL;
+
+	add_value(static_cast<uint32_t>(PREPROCESSING_CACHE_VERSION));
+}
+
+void MeshCuboidPreprocessingCache::add_data(const void *_data, const size_t _size)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(_data);
+	for (size_t i = 0; i < _size; ++i)
+	{
+		hash_[0] = (hash_[0] ^ bytes[i]) * FNV_PRIME;
+		hash_[1] = (hash_[1] ^ bytes[i]) * FNV_PRIME;
+	}
+}
+
+bool MeshCuboidPreprocessingCache::add_file(const std::string &_filename)
+{
+	std::ifstream file(_filename.c_str(), std::ios::binary);
+	if (!file)
+	{
+		std::cerr << "Error: Cannot open the file (" << _filename << ")." << std::endl;
+		return false;
+	}
+
+	std::vector<char> buffer(1 << 16);
+	uint64_t file_size = 0;
+	while (file)
+	{
+		file.read(&buffer[0], buffer.size());
+		const size_t size = static_cast<size_t>(file.gcount());
+		add_data(&buffer[0], size);
+		file_size += size;
+	}
+
+	// NOTE:
+	// The size separates the contents of consecutive files.
+	add_value(file_size);
+	return true;
+}
+
+void MeshCuboidPreprocessingCache::add_parameters(const MeshCuboidParameters &_params)
+{
+	add_value(_params.num_sample_point_neighbors_);
+	add_value(_params.min_num_cuboid_sample_points_);
+	add_value(_params.num_cuboid_surface_points_);
+	add_value(_params.intra_cuboid_symmetry_axis_);
+	add_value(_params.label_confidence_encoding_);
+	add_value(_params.label_confidence_top_k_);
+	add_value(_params.min_sample_point_confidence_);
+	add_value(_params.min_cuboid_bbox_size_);
+	add_value(_params.min_cuboid_bbox_diag_length_);
+	add_value(_params.sparse_neighbor_distance_);
+	add_value(_params.cuboid_split_neighbor_distance_);
+	add_value(_params.occlusion_test_neighbor_distance_);
+	add_value(_params.min_cuboid_overall_visibility_);
+
+	add_value(_params.use_view_plane_mask_);
+	add_value(_params.view_plane_mask_proportion_);
+	add_value(_params.view_plane_mask_min_x_);
+	add_value(_params.view_plane_mask_min_y_);
+	add_value(_params.view_plane_mask_max_x_);
+	add_value(_params.view_plane_mask_max_y_);
+}
+
+void MeshCuboidPreprocessingCache::add_all_parameters(const MeshCuboidParameters &_params)
+{
+	add_parameters(_params);
+
+	add_value(_params.opt_use_augmented_lagrangian_);
+	add_value(_params.opt_compare_solver_backends_);
+	add_value(_params.min_num_symmetric_point_pairs_);
+	add_value(_params.eval_num_neighbor_range_samples_);
+	add_value(_params.opt_max_iterations_);
+	add_value(_params.eval_min_neighbor_distance_);
+	add_value(_params.eval_max_neighbor_distance_);
+	add_value(_params.max_potential_);
+	add_value(_params.dummy_potential_);
+	add_value(_params.null_cuboid_probability_);
+	add_value(_params.fusion_visibility_smoothing_prior_);
+	add_value(_params.fusion_grid_size_);
+	add_value(_params.opt_single_energy_term_weight_);
+	add_value(_params.opt_symmetry_energy_term_weight_);
+	add_value(_params.part_assembly_window_size_);
+	add_value(_params.part_assembly_voxel_size_);
+	add_value(_params.part_assembly_voxel_variance_);
+
+	add_value(_params.disable_symmetry_terms_);
+	add_value(_params.disable_per_point_classifier_terms_);
+	add_value(_params.disable_label_smoothness_terms_);
+	add_value(_params.disable_part_relation_terms_);
+	add_value(_params.optimize_individual_reflection_symmetry_group_);
+}
+
+std::string MeshCuboidPreprocessingCache::get_key() const
+{
+	std::stringstream key_sstr;
+	key_sstr << std::hex << std::setfill('0')
+		<< std::setw(16) << hash_[0] << std::setw(16) << hash_[1];
+	return key_sstr.str();
+}
+
+std::string MeshCuboidPreprocessingCache::get_filename() const
+{
+	return cache_dir_ + std::string("/") + get_key() + std::string(".bin");
+}
+
+bool MeshCuboidPreprocessingCache::load(MeshCuboidStructure &_cuboid_structure) const
+{
+	std::ifstream file(get_filename().c_str(), std::ios::binary);
+	if (!file)
+		return false;
+
+	// NOTE:
+	// The structure keeps its mesh and parameters.
+	MeshCuboidStructure cuboid_structure(_cuboid_structure);
+	if (!cuboid_structure.load_binary(file))
+	{
+		std::cerr << "Warning: Invalid cache file (" << get_filename() << ")." << std::endl;
+		return false;
+	}
+
+	_cuboid_structure = cuboid_structure;
+	return true;
+}
+
+bool MeshCuboidPreprocessingCache::save(const MeshCuboidStructure &_cuboid_structure) const
+{
+	// NOTE:
+	// Write a temporary file first so that concurrent jobs never read a partial file.
+	const std::string filename = get_filename();
+	const std::string temp_filename = get_temp_filename(filename);
+
+	{
+		std::ofstream file(temp_filename.c_str(), std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "Error: Cannot save the cache file (" << temp_filename << ")." << std::endl;
+			return false;
+		}
+
+		_cuboid_structure.save_binary(file);
+		if (!file.good())
+		{
+			std::cerr << "Error: Cannot save the cache file (" << temp_filename << ")." << std::endl;
+			file.close();
+			std::remove(temp_filename.c_str());
+			return false;
+		}
+	}
+
+#ifdef _WIN32
+	std::remove(filename.c_str());
+#endif
+	if (std::rename(temp_filename.c_str(), filename.c_str()) != 0)
+	{
+		std::remove(temp_filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+std::string MeshCuboidPreprocessingCache::get_temp_filename(const std::string &_filename)
+{
+#ifdef _WIN32
+	const int process_id = _getpid();
+#else
+	const int process_id = static_cast<int>(getpid());
+#endif
+	std::random_device random_device;
+
+	std::stringstream temp_filename_sstr;
+	temp_filename_sstr << _filename << "." << process_id << "." << std::hex
+		<< std::setfill('0') << std::setw(8) << random_device() << ".tmp";
+	return temp_filename_sstr.str();
+}
@@ -87,7 +87,11 @@ void MeshViewerCore::reconstruct(
 	cuboid_structure_.save_cuboids(output_filename_sstr.str());
 
 	//
-	ret = cuboid_structure_.load_dense_sample_points(dense_sample_filepath.c_str());
+	if (FLAGS_sample_points_from_mesh)
+		ret = cuboid_structure_.sample_dense_points_on_mesh(FLAGS_num_sample_points,
+			FLAGS_num_dense_sample_points, FLAGS_sample_points_seed);
+	else
+		ret = cuboid_structure_.load_dense_sample_points(dense_sample_filepath.c_str());
 	assert(ret);
 
 	set_modelview_matrix(_occlusion_modelview_matrix, false);
@@ -746,7 +750,11 @@ void MeshViewerCore::reconstruct_scan(
 	cuboid_structure_.save_cuboids(output_filename_sstr.str());
 
 	//
-	ret = cuboid_structure_.load_dense_sample_points(dense_sample_filepath.c_str());
+	if (FLAGS_sample_points_from_mesh)
+		ret = cuboid_structure_.sample_dense_points_on_mesh(FLAGS_num_sample_points,
+			FLAGS_num_dense_sample_points, FLAGS_sample_points_seed);
+	else
+		ret = cuboid_structure_.load_dense_sample_points(dense_sample_filepath.c_str());
 	assert(ret);
 
 	set_modelview_matrix(_occlusion_modelview_matrix, false);
@@ -877,7 +885,7 @@ void MeshViewerCore::reconstruct_database_prior(
 	const char *_mesh_filepath,
 	const std::vector<LabelIndex> *_reconstructed_label_indices)
 {
-	const Real part_assembly_voxel_size = FLAGS_param_part_assembly_voxel_size *
+	const Real part_assembly_voxel_size = cuboid_structure_.get_parameters().part_assembly_voxel_size_ *
 		cuboid_structure_.mesh_->get_object_diameter();
 
 
@@ -1154,7 +1162,8 @@ void MeshViewerCore::reconstruct_database_prior(
 				transformed_point, transformed_normal);
 
 			// Copy label confidence values.
-			new_sample_point->label_index_confidence_ = sample_point->label_index_confidence_;
+			cuboid_structure_.sample_label_confidences_.copy_row(new_sample_point->sample_point_index_,
+				example_cuboid_structure.sample_label_confidences_, sample_point->sample_point_index_);
 
 			cuboid->add_sample_point(new_sample_point);
 		}
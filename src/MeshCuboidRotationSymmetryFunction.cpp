@@ -0,0 +1,271 @@
+#include "MeshCuboidRotationSymmetryFunction.h"
+
+#include <cassert>
+#include <cmath>
+#include <string.h>
+
+
+MeshCuboidRotationSymmetryFunction::AngleMoments::AngleMoments(const Number _angle)
+	: angle_(_angle)
+	, sum_weight_(0.0)
+	, sum_x_(Eigen::Vector3d::Zero())
+	, sum_y_(Eigen::Vector3d::Zero())
+	, sum_xx_(Eigen::Matrix3d::Zero())
+	, sum_xy_(Eigen::Matrix3d::Zero())
+	, sum_yy_(0.0)
+{
+
+}
+
+MeshCuboidRotationSymmetryFunction::MeshCuboidRotationSymmetryFunction(
+	const Index _num_vars, const Number _weight)
+	: NLPFunction(_num_vars)
+	, weight_(_weight)
+{
+
+}
+
+MeshCuboidRotationSymmetryFunction::~MeshCuboidRotationSymmetryFunction()
+{
+
+}
+
+unsigned int MeshCuboidRotationSymmetryFunction::add_symmetry_group(
+	const Index _n_index, const Index _t_index)
+{
+	assert(_n_index >= 0 && _n_index + 3 <= num_vars_);
+	assert(_t_index >= 0 && _t_index + 3 <= num_vars_);
+
+	SymmetryGroup group;
+	group.n_index_ = _n_index;
+	group.t_index_ = _t_index;
+	symmetry_groups_.push_back(group);
+	return symmetry_groups_.size() - 1;
+}
+
+void MeshCuboidRotationSymmetryFunction::add_point_pair(const unsigned int _group_index,
+	const Eigen::Vector3d &_x, const Eigen::Vector3d &_y,
+	const Number _weight, const Number _angle)
+{
+	assert(_group_index < symmetry_groups_.size());
+	SymmetryGroup &group = symmetry_groups_[_group_index];
+
+	// NOTE:
+	// Point pairs have only a few distinct angles (multiples of the rotation angle).
+	AngleMoments *moments = NULL;
+	for (std::vector<AngleMoments, Eigen::aligned_allocator<AngleMoments> >::iterator it =
+		group.angle_moments_.begin(); it != group.angle_moments_.end(); ++it)
+	{
+		if (std::abs((*it).angle_ - _angle) < 1.0E-12)
+		{
+			moments = &(*it);
+			break;
+		}
+	}
+
+	if (!moments)
+	{
+		group.angle_moments_.push_back(AngleMoments(_angle));
+		moments = &group.angle_moments_.back();
+	}
+
+	moments->sum_weight_ += _weight;
+	moments->sum_x_ += _weight * _x;
+	moments->sum_y_ += _weight * _y;
+	moments->sum_xx_ += _weight * _x * _x.transpose();
+	moments->sum_xy_ += _weight * _x * _y.transpose();
+	moments->sum_yy_ += _weight * _y.squaredNorm();
+}
+
+void MeshCuboidRotationSymmetryFunction::eval_symmetry_group(
+	const SymmetryGroup &_group, const Number* _x,
+	Number &_value, Vector6d *_gradient, Matrix6d *_hessian) const
+{
+	Eigen::Vector3d n, t;
+	for (int i = 0; i < 3; ++i)
+	{
+		n[i] = _x[_group.n_index_ + i];
+		t[i] = _x[_group.t_index_ + i];
+	}
+
+	// \| t \|_2^2.
+	_value = t.squaredNorm();
+	if (_gradient)
+	{
+		_gradient->setZero();
+		_gradient->segment<3>(3) = 2 * t;
+	}
+	if (_hessian)
+	{
+		_hessian->setZero();
+		_hessian->block<3, 3>(3, 3) = 2 * Eigen::Matrix3d::Identity();
+	}
+
+	Eigen::Matrix3d n_cross;
+	n_cross << 0, -n[2], n[1],
+		n[2], 0, -n[0],
+		-n[1], n[0], 0;
+
+	Eigen::Matrix3d e_cross[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		Eigen::Vector3d e = Eigen::Vector3d::Unit(i);
+		e_cross[i] << 0, -e[2], e[1],
+			e[2], 0, -e[0],
+			-e[1], e[0], 0;
+	}
+
+	for (std::vector<AngleMoments, Eigen::aligned_allocator<AngleMoments> >::const_iterator it =
+		_group.angle_moments_.begin(); it != _group.angle_moments_.end(); ++it)
+	{
+		const AngleMoments &moments = (*it);
+		const Number sin_angle = std::sin(moments.angle_);
+		const Number cos_angle = std::cos(moments.angle_);
+		const Number W = moments.sum_weight_;
+		const Eigen::Matrix3d &Mxx = moments.sum_xx_;
+		const Eigen::Matrix3d &Mxy = moments.sum_xy_;
+		const Eigen::Vector3d &sx = moments.sum_x_;
+
+		// For each pair, r = A(x - t) - (y - t) = (Ax - y) - Bt, where B = A - I.
+		// \sum_k w_k r_k^T r_k = tr(A^T A Mxx) - 2 tr(A Mxy) + tr(Myy) - 2 p^T q + W q^T q,
+		// where p = A sx - sy and q = Bt.
+		Eigen::Matrix3d A = cos_angle * Eigen::Matrix3d::Identity() + sin_angle * n_cross
+			+ (1 - cos_angle) * n * n.transpose();
+		Eigen::Matrix3d B = A - Eigen::Matrix3d::Identity();
+		Eigen::Vector3d p = A * sx - moments.sum_y_;
+		Eigen::Vector3d q = B * t;
+
+		_value += (A.transpose() * A * Mxx).trace() - 2 * (A * Mxy).trace() + moments.sum_yy_
+			- 2 * p.dot(q) + W * q.squaredNorm();
+
+		if (!_gradient && !_hessian)
+			continue;
+
+		// Partial derivatives of A with respect to n_i.
+		Eigen::Matrix3d dA[3];
+		Eigen::Vector3d dA_sx[3], dA_t[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			Eigen::Vector3d e = Eigen::Vector3d::Unit(i);
+			dA[i] = sin_angle * e_cross[i] + (1 - cos_angle) * (e * n.transpose() + n * e.transpose());
+			dA_sx[i] = dA[i] * sx;
+			dA_t[i] = dA[i] * t;
+		}
+
+		if (_gradient)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				(*_gradient)[i] += 2 * (A.transpose() * dA[i] * Mxx).trace()
+					- 2 * (dA[i] * Mxy).trace()
+					- 2 * dA_sx[i].dot(q) - 2 * p.dot(dA_t[i])
+					+ 2 * W * q.dot(dA_t[i]);
+			}
+			_gradient->segment<3>(3) += -2 * B.transpose() * p + 2 * W * B.transpose() * q;
+		}
+
+		if (_hessian)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int j = 0; j <= i; ++j)
+				{
+					// Second partial derivative of A with respect to n_i and n_j.
+					Eigen::Vector3d e_i = Eigen::Vector3d::Unit(i);
+					Eigen::Vector3d e_j = Eigen::Vector3d::Unit(j);
+					Eigen::Matrix3d ddA = (1 - cos_angle) * (e_i * e_j.transpose() + e_j * e_i.transpose());
+
+					Number value = 2 * (dA[j].transpose() * dA[i] * Mxx).trace()
+						+ 2 * (A.transpose() * ddA * Mxx).trace()
+						- 2 * (ddA * Mxy).trace()
+						- 2 * ((ddA * sx).dot(q) + dA_sx[i].dot(dA_t[j]) + dA_sx[j].dot(dA_t[i]) + p.dot(ddA * t))
+						+ 2 * W * (dA_t[j].dot(dA_t[i]) + q.dot(ddA * t));
+
+					(*_hessian)(i, j) += value;
+					if (i != j) (*_hessian)(j, i) += value;
+				}
+
+				Eigen::Vector3d nt = -2 * (B.transpose() * dA_sx[i] + dA[i].transpose() * p)
+					+ 2 * W * (dA[i].transpose() * q + B.transpose() * dA_t[i]);
+				_hessian->block<3, 1>(3, i) += nt;
+				_hessian->block<1, 3>(i, 3) += nt.transpose();
+			}
+
+			_hessian->block<3, 3>(3, 3) += 2 * W * B.transpose() * B;
+		}
+	}
+}
+
+Number MeshCuboidRotationSymmetryFunction::eval(const Number* _x) const
+{
+	Number output = 0;
+	for (std::vector<SymmetryGroup>::const_iterator it = symmetry_groups_.begin();
+		it != symmetry_groups_.end(); ++it)
+	{
+		Number value = 0;
+		eval_symmetry_group((*it), _x, value, NULL, NULL);
+		output += value;
+	}
+	return weight_ * output;
+}
+
+void MeshCuboidRotationSymmetryFunction::eval_gradient(const Number* _x, Number* _output) const
+{
+	// Initialize all output values to zero.
+	memset(_output, 0, num_vars_ * sizeof(Number));
+
+	for (std::vector<SymmetryGroup>::const_iterator it = symmetry_groups_.begin();
+		it != symmetry_groups_.end(); ++it)
+	{
+		const SymmetryGroup &group = (*it);
+		Number value = 0;
+		Vector6d gradient;
+		eval_symmetry_group(group, _x, value, &gradient, NULL);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			_output[group.n_index_ + i] += weight_ * gradient[i];
+			_output[group.t_index_ + i] += weight_ * gradient[3 + i];
+		}
+	}
+}
+
+void MeshCuboidRotationSymmetryFunction::eval_hessian(const Number* _x,
+	const Number _weight, Number* _output) const
+{
+	// NOTE:
+	// Make dense Hessian matrix.
+
+	assert(_output != NULL);
+	// Assume that output values are initialized.
+
+	for (std::vector<SymmetryGroup>::const_iterator it = symmetry_groups_.begin();
+		it != symmetry_groups_.end(); ++it)
+	{
+		const SymmetryGroup &group = (*it);
+		Number value = 0;
+		Matrix6d hessian;
+		eval_symmetry_group(group, _x, value, NULL, &hessian);
+
+		Index indices[6];
+		for (int i = 0; i < 3; ++i)
+		{
+			indices[i] = group.n_index_ + i;
+			indices[3 + i] = group.t_index_ + i;
+		}
+
+		// Lower triangular part.
+		for (int i = 0; i < 6; ++i)
+		{
+			for (int j = 0; j < 6; ++j)
+			{
+				Index index_i = indices[i];
+				Index index_j = indices[j];
+				if (index_i < index_j) continue;
+
+				Index index = index_i * (index_i + 1) / 2 + index_j;
+				_output[index] += _weight * weight_ * hessian(i, j);
+			}
+		}
+	}
+}
@@ -2,6 +2,7 @@
 
 #include "MeshCuboidParameters.h"
 #include "MeshCuboidNonLinearSolver.h"
+#include "TraceRecorder.h"
 #include "Utilities.h"
 
 #include <cstdint>
@@ -401,19 +402,23 @@ void update_cuboid_surface_points(
 	MeshCuboidStructure &_cuboid_structure,
 	const Real _modelview_matrix[16])
 {
-	const Real radius = FLAGS_param_occlusion_test_neighbor_distance * _cuboid_structure.mesh_->get_object_diameter();
+	TraceScope trace_scope("update_cuboid_surface_points");
+
+	const MeshCuboidParameters &params = _cuboid_structure.get_parameters();
+	const Real radius = params.occlusion_test_neighbor_distance_ * _cuboid_structure.mesh_->get_object_diameter();
 
 	std::vector<MeshCuboid *> all_cuboids = _cuboid_structure.get_all_cuboids();
+	trace_scope.add_arg("cuboids", all_cuboids.size());
 	for (std::vector<MeshCuboid *>::iterator it = all_cuboids.begin(); it != all_cuboids.end(); ++it)
 	{
 		MeshCuboid *cuboid = (*it);
 		cuboid->create_grid_points_on_cuboid_surface(
-			FLAGS_param_num_cuboid_surface_points);
+			params.num_cuboid_surface_points_);
 
 		if (_modelview_matrix)
 		{
 			cuboid->compute_cuboid_surface_point_visibility(
-				_modelview_matrix, radius, _cuboid_structure.sample_points_);
+				_modelview_matrix, radius, _cuboid_structure.sample_points_, params);
 		}
 	}
 }
@@ -421,22 +426,25 @@ void update_cuboid_surface_points(
 void segment_sample_points(
 	MeshCuboidStructure &_cuboid_structure)
 {
-	// Parameter.
-	FLAGS_param_null_cuboid_probability = 0.1;
+	TraceScope trace_scope("segment_sample_points");
+
+	const MeshCuboidParameters &params = _cuboid_structure.get_parameters();
 	
 	assert(_cuboid_structure.mesh_);
-	double squared_neighbor_distance = FLAGS_param_sparse_neighbor_distance *
-		FLAGS_param_sparse_neighbor_distance *
+	double squared_neighbor_distance = params.sparse_neighbor_distance_ *
+		params.sparse_neighbor_distance_ *
 		_cuboid_structure.mesh_->get_object_diameter();
-	double lambda = -squared_neighbor_distance / std::log(FLAGS_param_null_cuboid_probability);
+	double lambda = -squared_neighbor_distance / std::log(params.null_cuboid_probability_);
 
 	unsigned int num_sample_points = _cuboid_structure.num_sample_points();
-	const int num_neighbors = std::min(FLAGS_param_num_sample_point_neighbors,
+	const int num_neighbors = std::min(params.num_sample_point_neighbors_,
 		static_cast<int>(num_sample_points));
 
 	std::vector<MeshCuboid *> all_cuboids = _cuboid_structure.get_all_cuboids();
 	unsigned int num_cuboids = all_cuboids.size();
 
+	trace_scope.add_arg("points", num_sample_points);
+	trace_scope.add_arg("cuboids", num_cuboids);
 
 
 	//
@@ -491,23 +499,23 @@ void segment_sample_points(
 			double squared_distance = dd[0];
 			assert(squared_distance >= 0);
 
-			double label_probability = sample_point->label_index_confidence_[label_index];
+			double label_probability = _cuboid_structure.sample_label_confidences_.get(point_index, label_index);
 
 			//
-			if (FLAGS_disable_per_point_classifier_terms)
+			if (params.disable_per_point_classifier_terms_)
 				label_probability = 1.0;
 			//
 
 			double energy = squared_distance - lambda * std::log(label_probability);
 
 			//if (cuboid->is_group_cuboid())
-			//	energy = FLAGS_param_max_potential;
+			//	energy = params.max_potential_;
 
 			single_potentials(point_index, cuboid_index) = energy;
 		}
 
 		// For null cuboid.
-		double energy = squared_neighbor_distance - lambda * std::log(FLAGS_param_null_cuboid_probability);
+		double energy = squared_neighbor_distance - lambda * std::log(params.null_cuboid_probability_);
 		single_potentials(point_index, num_cuboids) = energy;
 	}
 
@@ -516,6 +524,8 @@ void segment_sample_points(
 	delete[] nn_idx;
 	delete[] dd;
 
+	TraceRecorder::add_counter("kd_queries", num_sample_points * num_cuboids);
+
 	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
 	{
 		annDeallocPts(cuboid_ann_points[cuboid_index]);
@@ -550,7 +560,7 @@ void segment_sample_points(
 	// Pair potentials.
 	std::vector< Eigen::Triplet<double> > pair_potentials;
 
-	if (!FLAGS_disable_label_smoothness_terms)
+	if (!params.disable_label_smoothness_terms_)
 	{
 		pair_potentials.reserve(num_sample_points * num_neighbors);
 
@@ -579,6 +589,8 @@ void segment_sample_points(
 				pair_potentials.push_back(Eigen::Triplet<double>(point_index, n_point_index, energy));
 			}
 		}
+
+		TraceRecorder::add_counter("kd_queries", num_sample_points);
 	}
 
 	delete[] nn_idx;
@@ -691,6 +703,7 @@ void compute_labels_and_axes_configuration_potentials(
 	const std::vector< std::list<LabelIndex> > *_label_symmetries,
 	bool _add_dummy_label)
 {
+	const MeshCuboidParameters &params = _predictor.get_parameters();
 	unsigned int num_labels = _labels.size();
 	unsigned int num_cuboids = _cuboids.size();
 	unsigned int num_axis_configurations = MeshCuboid::num_axis_configurations();
@@ -777,10 +790,10 @@ void compute_labels_and_axes_configuration_potentials(
 			//assert(potential >= 0.0);
 
 			Real potential = 0.0;
-			if (!FLAGS_disable_per_point_classifier_terms)
+			if (!params.disable_per_point_classifier_terms_)
 			{
 				if (_cuboids[cuboid_index]->get_label_index() != label_index)
-					potential = FLAGS_param_max_potential;
+					potential = params.max_potential_;
 
 				// NOTE:
 				// If label symmetry information is given, symmetric labels have zero potential value.
@@ -861,8 +874,8 @@ void compute_labels_and_axes_configuration_potentials(
 					{
 						// NOTE:
 						// Currently, it is NOT allowed that multiple parts have the same label.
-						_potential_mat(mat_index_1, mat_index_2) = FLAGS_param_max_potential;
-						_potential_mat(mat_index_2, mat_index_1) = FLAGS_param_max_potential;
+						_potential_mat(mat_index_1, mat_index_2) = params.max_potential_;
+						_potential_mat(mat_index_2, mat_index_1) = params.max_potential_;
 						continue;
 					}
 					assert(label_1 != label_2);
@@ -885,7 +898,7 @@ void compute_labels_and_axes_configuration_potentials(
 	if (_add_dummy_label)
 	{
 		const unsigned int dummy_case_index = num_cases - 1;
-		const Real dummy_potential = FLAGS_param_dummy_potential;
+		const Real dummy_potential = params.dummy_potential_;
 
 		for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
 		{
@@ -926,13 +939,16 @@ void recognize_labels_and_axes_configurations(
 	bool _add_dummy_label)
 {
 	std::ofstream log_file(_log_filename, std::ofstream::out | std::ofstream::app);
-	assert(log_file);
+	assert(_log_filename.empty() || log_file);
 
 	const std::vector<Label>& labels = _cuboid_structure.labels_;
 	std::vector<MeshCuboid *> all_cuboids = _cuboid_structure.get_all_cuboids();
 
 	unsigned int num_labels = labels.size();
 	unsigned int num_cuboids = all_cuboids.size();
+
+	TraceScope trace_scope("recognize_labels_and_axes_configurations");
+	trace_scope.add_arg("cuboids", num_cuboids);
 	unsigned int num_axis_configurations = MeshCuboid::num_axis_configurations();
 	assert(num_axis_configurations > 0);
 	if (num_labels == 0 || num_cuboids == 0) return;
@@ -1072,11 +1088,12 @@ void recognize_labels_and_axes_configurations(
 void test_recognize_labels_and_axes_configurations(
 	const std::vector<Label>& _labels,
 	const std::vector<MeshCuboid *>& _cuboids,
+	const LabelConfidenceTable &_label_confidences,
 	const MeshCuboidPredictor &_predictor,
 	const std::string _log_filename)
 {
 	std::ofstream log_file(_log_filename, std::ofstream::out | std::ofstream::app);
-	assert(log_file);
+	assert(_log_filename.empty() || log_file);
 
 	unsigned int num_labels = _labels.size();
 	unsigned int num_cuboids = _cuboids.size();
@@ -1101,7 +1118,7 @@ void test_recognize_labels_and_axes_configurations(
 		transformation.compute_transformation(cuboid);
 
 		Real potential = _predictor.get_single_potential(
-			cuboid, &attributes, &transformation, label_index);
+			cuboid, _label_confidences, &attributes, &transformation, label_index);
 		assert(potential >= 0.0);
 
 		assert(potential_mat(label_index, label_index) == 0);
@@ -1402,9 +1419,11 @@ void optimize_attributes_once(
 	const MeshCuboidPredictor& _predictor,
 	const double _single_energy_term_weight,
 	const double _symmetry_energy_term_weight,
-	bool _use_symmetry)
+	bool _use_symmetry,
+	MeshCuboidSamplePointGrids *_cuboid_sample_point_grids)
 {
-	const Real squared_neighbor_distance = FLAGS_param_sparse_neighbor_distance *
+	const MeshCuboidParameters &params = _cuboid_structure.get_parameters();
+	const Real squared_neighbor_distance = params.sparse_neighbor_distance_ *
 		_cuboid_structure.mesh_->get_object_diameter();
 
 	std::vector<MeshCuboid *> all_cuboids = _cuboid_structure.get_all_cuboids();
@@ -1439,15 +1458,28 @@ void optimize_attributes_once(
 		all_rotation_symmetry_groups.clear();
 	}
 
+	// Update rotation angle.
+	for (std::vector<MeshCuboidRotationSymmetryGroup *>::iterator it = all_rotation_symmetry_groups.begin();
+		it != all_rotation_symmetry_groups.end(); ++it)
+	{
+		assert(*it);
+		(*it)->compute_rotation_angle(all_cuboids, params.sparse_neighbor_distance_);
+	}
+
 	MeshCuboidNonLinearSolver non_linear_solver(
 		all_cuboids,
 		all_reflection_symmetry_groups,
 		all_rotation_symmetry_groups,
 		squared_neighbor_distance,
-		FLAGS_param_min_num_symmetric_point_pairs,
-		_symmetry_energy_term_weight);
+		params.min_num_symmetric_point_pairs_,
+		_symmetry_energy_term_weight,
+		_cuboid_sample_point_grids);
+
+	MeshCuboidNonLinearSolverBackend backend = params.opt_use_augmented_lagrangian_ ?
+		AugmentedLagrangianSolverBackend : IPOPTSolverBackend;
 
-	non_linear_solver.optimize(quadratic_term, linear_term, constant_term, &init_values);
+	non_linear_solver.optimize(quadratic_term, linear_term, constant_term, &init_values,
+		NULL, backend, params.opt_compare_solver_backends_);
 }
 
 void optimize_attributes(
@@ -1458,17 +1490,23 @@ void optimize_attributes(
 	const double _symmetry_energy_term_weight,
 	const unsigned int _max_num_iterations,
 	const std::string _log_filename,
-	GLViewerCore *_viewer,
+	MeshCuboidSolverObserver *_observer,
 	bool _use_symmetry)
 {
+	// NOTE:
+	// Logs are not written if the log filename is empty.
 	std::ofstream log_file(_log_filename, std::ofstream::out | std::ofstream::app);
-	assert(log_file);
+	assert(_log_filename.empty() || log_file);
 
 	unsigned int num_labels = _cuboid_structure.num_labels();
 
 	std::vector<MeshCuboid *> all_cuboids = _cuboid_structure.get_all_cuboids();
 	unsigned int num_cuboids = all_cuboids.size();
 
+	TraceScope trace_scope(_use_symmetry ? "optimize_attributes (symmetry)" : "optimize_attributes");
+	trace_scope.add_arg("points", _cuboid_structure.num_sample_points());
+	trace_scope.add_arg("cuboids", num_cuboids);
+
 	std::stringstream sstr;
 	double single_total_energy, pair_total_energy, total_energy;
 
@@ -1478,8 +1516,12 @@ void optimize_attributes(
 	unsigned int final_cuboid_iteration = 0;
 	MeshCuboidStructure final_cuboid_structure = _cuboid_structure;
 
+	// NOTE:
+	// Sample point grids are reused across iterations while the sample points are not changed.
+	MeshCuboidSamplePointGrids cuboid_sample_point_grids;
+
 	update_cuboid_surface_points(_cuboid_structure, _modelview_matrix);
-	if (_viewer) _viewer->updateGL();
+	if (_observer) _observer->cuboids_updated();
 
 	//
 	get_optimization_error(all_cuboids, _predictor,
@@ -1506,7 +1548,7 @@ void optimize_attributes(
 		// orthogonal relations each other, the result might go wrong due to the
 		// numerical issue in the solver. We therefore optimize for each reflection
 		// symmetry group separately.
-		if (FLAGS_optimize_individual_reflection_symmetry_group)
+		if (_cuboid_structure.get_parameters().optimize_individual_reflection_symmetry_group_)
 		{
 			const std::vector<MeshCuboidReflectionSymmetryGroup *> all_reflection_symmetry_groups
 				= _cuboid_structure.reflection_symmetry_groups_;
@@ -1524,7 +1566,7 @@ void optimize_attributes(
 				optimize_attributes_once(
 					_cuboid_structure, _predictor,
 					_single_energy_term_weight, _symmetry_energy_term_weight,
-					_use_symmetry);
+					_use_symmetry, &cuboid_sample_point_grids);
 			}
 
 			_cuboid_structure.reflection_symmetry_groups_ = all_reflection_symmetry_groups;
@@ -1535,11 +1577,11 @@ void optimize_attributes(
 			optimize_attributes_once(
 				_cuboid_structure, _predictor,
 				_single_energy_term_weight, _symmetry_energy_term_weight,
-				_use_symmetry);
+				_use_symmetry, &cuboid_sample_point_grids);
 		}
 		
 		
-		if (_viewer) _viewer->updateGL();
+		if (_observer) _observer->cuboids_updated();
 
 		//
 		get_optimization_error(all_cuboids, _predictor,
@@ -1569,7 +1611,7 @@ void optimize_attributes(
 		}
 
 		update_cuboid_surface_points(_cuboid_structure, _modelview_matrix);
-		if (_viewer) _viewer->updateGL();
+		if (_observer) _observer->cuboids_updated();
 
 		//
 		get_optimization_error(all_cuboids, _predictor,
@@ -1620,7 +1662,7 @@ void optimize_attributes(
 	num_cuboids = all_cuboids.size();
 
 	update_cuboid_surface_points(_cuboid_structure, _modelview_matrix);
-	if (_viewer) _viewer->updateGL();
+	if (_observer) _observer->cuboids_updated();
 
 	//
 	sstr.str(std::string());
@@ -1857,7 +1899,11 @@ bool add_missing_cuboids(
 	if (_missing_label_indices.empty())
 		return false;
 
-	const Real radius = FLAGS_param_occlusion_test_neighbor_distance
+	TraceScope trace_scope("add_missing_cuboids");
+	trace_scope.add_arg("missing_labels", _missing_label_indices.size());
+
+	const MeshCuboidParameters &params = _cuboid_structure.get_parameters();
+	const Real radius = params.occlusion_test_neighbor_distance_
 		* _cuboid_structure.mesh_->get_object_diameter();
 	
 	// NOTE:
@@ -1914,16 +1960,16 @@ bool add_missing_cuboids(
 			LabelIndex symmetric_label_index = symmetric_label_indices[label_index];
 
 			cuboid->create_grid_points_on_cuboid_surface(
-				FLAGS_param_num_cuboid_surface_points);
+				params.num_cuboid_surface_points_);
 
 			// NOTE:
 			// Do not use normal directions when computing the overall visibility.
 			cuboid->compute_cuboid_surface_point_visibility(
-				_modelview_matrix, radius, _cuboid_structure.sample_points_, false);
+				_modelview_matrix, radius, _cuboid_structure.sample_points_, params, false);
 			Real overall_visibility = cuboid->get_cuboid_overvall_visibility();
 
 			bool is_occluded = (symmetric_label_index >= num_labels || !is_given_label_indices[symmetric_label_index])
-					&& (overall_visibility > FLAGS_param_min_cuboid_overall_visibility);
+					&& (overall_visibility > params.min_cuboid_overall_visibility_);
 			
 			if (is_occluded)
 			{
@@ -1933,7 +1979,7 @@ bool add_missing_cuboids(
 			else
 			{
 				cuboid->compute_cuboid_surface_point_visibility(
-					_modelview_matrix, radius, _cuboid_structure.sample_points_);
+					_modelview_matrix, radius, _cuboid_structure.sample_points_, params);
 
 				LabelIndex label_index = cuboid->get_label_index();
 				_cuboid_structure.label_cuboids_[label_index].push_back(cuboid);
@@ -1994,6 +2040,7 @@ bool add_missing_cuboids(
 /*
 void symmetrize_cuboids(MeshCuboidStructure &_cuboid_structure)
 {
+	const MeshCuboidParameters &params = _cuboid_structure.get_parameters();
 	unsigned int num_given_labels = _cuboid_structure.num_labels();
 
 	for (LabelIndex label_index_1 = 0; label_index_1 < num_given_labels; ++label_index_1)
@@ -2015,7 +2062,7 @@ void symmetrize_cuboids(MeshCuboidStructure &_cuboid_structure)
 		// Assume that all cuboids have either intra-cuboid or inter-cuboid symmetry.
 		if (cuboid_1 && _cuboid_structure.label_symmetries_[label_index_1].empty())
 		{
-			const int flip_axis_index = FLAGS_param_intra_cuboid_symmetry_axis;
+			const int flip_axis_index = params.intra_cuboid_symmetry_axis_;
 
 			Eigen::Vector3d reflection_plane_point(0.0, 0.0, 0.0);
 			Eigen::Vector3d reflection_plane_normal(0.0, 0.0, 0.0);
@@ -2042,7 +2089,7 @@ void symmetrize_cuboids(MeshCuboidStructure &_cuboid_structure)
 			for (std::vector<MeshSamplePoint *>::const_iterator it = cuboid_sample_points_1.begin();
 				it != cuboid_sample_points_1.end(); ++it)
 			{
-				MeshSamplePoint *new_sample_point = new MeshSamplePoint(**it);
+				MeshSamplePoint *new_sample_point = _cuboid_structure.add_sample_point_copy(*it);
 
 				Eigen::Vector3d p(0.0, 0.0, 0.0);
 				for (unsigned int i = 0; i < 3; ++i)
@@ -2052,7 +2099,6 @@ void symmetrize_cuboids(MeshCuboidStructure &_cuboid_structure)
 					new_sample_point->point_[i] = transformed_p[i];
 
 				cuboid_1->add_sample_point(new_sample_point);
-				_cuboid_structure.sample_points_.push_back(new_sample_point);
 			}
 		}
 
@@ -2239,7 +2285,7 @@ void symmetrize_cuboids(MeshCuboidStructure &_cuboid_structure)
 			for (std::vector<MeshSamplePoint *>::const_iterator it = cuboid_sample_points_1.begin();
 				it != cuboid_sample_points_1.end(); ++it)
 			{
-				MeshSamplePoint *new_sample_point = new MeshSamplePoint(**it);
+				MeshSamplePoint *new_sample_point = _cuboid_structure.add_sample_point_copy(*it);
 
 				Eigen::Vector3d p(0.0, 0.0, 0.0);
 				for (unsigned int i = 0; i < 3; ++i)
@@ -2249,14 +2295,13 @@ void symmetrize_cuboids(MeshCuboidStructure &_cuboid_structure)
 					new_sample_point->point_[i] = transformed_p[i];
 
 				cuboid_2->add_sample_point(new_sample_point);
-				_cuboid_structure.sample_points_.push_back(new_sample_point);
 			}
 
 			// 2 -> 1.
 			for (std::vector<MeshSamplePoint *>::const_iterator it = cuboid_sample_points_2.begin();
 				it != cuboid_sample_points_2.end(); ++it)
 			{
-				MeshSamplePoint *new_sample_point = new MeshSamplePoint(**it);
+				MeshSamplePoint *new_sample_point = _cuboid_structure.add_sample_point_copy(*it);
 
 				Eigen::Vector3d p(0.0, 0.0, 0.0);
 				for (unsigned int i = 0; i < 3; ++i)
@@ -2266,7 +2311,6 @@ void symmetrize_cuboids(MeshCuboidStructure &_cuboid_structure)
 					new_sample_point->point_[i] = transformed_p[i];
 
 				cuboid_1->add_sample_point(new_sample_point);
-				_cuboid_structure.sample_points_.push_back(new_sample_point);
 			}
 
 
@@ -1,15 +1,32 @@
 #include "MeshCuboidStructure.h"
 
+#include "BinaryIO.h"
 #include "MeshCuboidParameters.h"
 #include "ICP.h"
+#include "PointHashGrid.h"
+#include "PoissonDiskSampler.h"
+#include "TraceRecorder.h"
 
+#include <algorithm>
 #include <deque>
 #include <fstream>
 #include <iostream>
 
 
-MeshCuboidStructure::MeshCuboidStructure(const MyMesh* _mesh)
-	: mesh_(_mesh)
+static LabelConfidenceTable::Encoding get_label_confidence_encoding(const MeshCuboidParameters &_params)
+{
+	assert(_params.label_confidence_encoding_ >= LabelConfidenceTable::FloatEncoding);
+	assert(_params.label_confidence_encoding_ <= LabelConfidenceTable::ByteEncoding);
+	assert(_params.label_confidence_top_k_ >= 0);
+	return static_cast<LabelConfidenceTable::Encoding>(_params.label_confidence_encoding_);
+}
+
+
+MeshCuboidStructure::MeshCuboidStructure(const MyMesh* _mesh,
+	const MeshCuboidParameters &_params)
+	: params_(_params)
+	, mesh_(_mesh)
+	, sample_label_confidences_(get_label_confidence_encoding(_params), _params.label_confidence_top_k_)
 	, query_label_index_(0)
 	, translation_(0.0)
 	, scale_(1.0)
@@ -22,6 +39,13 @@ MeshCuboidStructure::~MeshCuboidStructure()
 	clear();
 }
 
+void MeshCuboidStructure::set_parameters(const MeshCuboidParameters &_params)
+{
+	params_ = _params;
+	sample_label_confidences_.set_storage(
+		get_label_confidence_encoding(params_), params_.label_confidence_top_k_);
+}
+
 MeshCuboidStructure::MeshCuboidStructure(const MeshCuboidStructure& _other)
 {
 	deep_copy(_other);
@@ -39,6 +63,7 @@ void MeshCuboidStructure::deep_copy(const MeshCuboidStructure& _other)
 	// NOTE:
 	// This instance should be cleaned prior to call this function.
 
+	this->params_ = _other.params_;
 	this->mesh_ = _other.mesh_;
 	this->translation_ = _other.translation_;
 	this->scale_ = _other.scale_;
@@ -62,6 +87,7 @@ void MeshCuboidStructure::deep_copy(const MeshCuboidStructure& _other)
 		MeshSamplePoint *sample_point = new MeshSamplePoint(**it);
 		this->sample_points_.push_back(sample_point);
 	}
+	this->sample_label_confidences_ = _other.sample_label_confidences_;
 
 	// Deep copy label cuboids.
 	assert(_other.label_cuboids_.size() == _other.num_labels());
@@ -136,6 +162,7 @@ void MeshCuboidStructure::clear_sample_points()
 		it != sample_points_.end(); ++it)
 		delete (*it);
 	sample_points_.clear();
+	sample_label_confidences_.resize(0, sample_label_confidences_.num_labels());
 
 	//
 	for (std::vector< std::vector<MeshCuboid *> >::iterator it = label_cuboids_.begin();
@@ -183,6 +210,7 @@ void MeshCuboidStructure::clear_label_sample_points(const std::vector<LabelIndex
 	}
 
 	// Delete sample points.
+	std::vector<bool> is_sample_point_removed(num_sample_points(), false);
 	for (std::list<SamplePointIndex>::iterator it = deleted_sample_point_indices.begin();
 		it != deleted_sample_point_indices.end(); ++it)
 	{
@@ -192,6 +220,7 @@ void MeshCuboidStructure::clear_label_sample_points(const std::vector<LabelIndex
 		assert(sample_point->sample_point_index_ == sample_point_index);
 		delete sample_point;
 		this->sample_points_[sample_point_index] = NULL;
+		is_sample_point_removed[sample_point_index] = true;
 	}
 
 	// Re-number sample points.
@@ -206,9 +235,12 @@ void MeshCuboidStructure::clear_label_sample_points(const std::vector<LabelIndex
 		else
 		{
 			(*it)->sample_point_index_ = new_sample_point_index;
+			++new_sample_point_index;
 			++it;
 		}
 	}
+
+	sample_label_confidences_.remove_points(is_sample_point_removed);
 }
 
 void MeshCuboidStructure::clear_cuboids()
@@ -242,6 +274,7 @@ void MeshCuboidStructure::clear_labels()
 	label_names_.clear();
 	label_symmetries_.clear();
 	//label_children_.clear();
+	sample_label_confidences_.resize(num_sample_points(), 0);
 
 	symmetry_group_info_.size();
 
@@ -484,6 +517,330 @@ bool MeshCuboidStructure::save_symmetry_groups(const std::string _filename, bool
 	return true;
 }
 
+// NOTE:
+// Increase the version when the binary format is changed.
+#define CUBOID_STRUCTURE_BINARY_MAGIC	0x4243534D	// "MSCB"
+#define CUBOID_STRUCTURE_BINARY_VERSION	2
+
+static void write_symmetry_group_info(std::ostream &_stream, const MeshCuboidSymmetryGroupInfo &_info)
+{
+	BinaryIO::write(_stream, static_cast<uint32_t>(_info.symmetry_type_));
+	BinaryIO::write(_stream, _info.aligned_global_axis_index_);
+	BinaryIO::write(_stream, _info.single_label_indices_);
+	BinaryIO::write(_stream, _info.pair_label_indices_);
+}
+
+static bool read_symmetry_group_info(std::istream &_stream, MeshCuboidSymmetryGroupInfo &_info)
+{
+	uint32_t symmetry_type = 0;
+	bool ret = BinaryIO::read(_stream, symmetry_type);
+	_info.symmetry_type_ = static_cast<MeshCuboidSymmetryGroupType>(symmetry_type);
+	ret = ret && BinaryIO::read(_stream, _info.aligned_global_axis_index_);
+	ret = ret && BinaryIO::read(_stream, _info.single_label_indices_);
+	ret = ret && BinaryIO::read(_stream, _info.pair_label_indices_);
+	return ret;
+}
+
+void MeshCuboidStructure::save_binary(std::ostream &_stream) const
+{
+	BinaryIO::write_header(_stream, CUBOID_STRUCTURE_BINARY_MAGIC, CUBOID_STRUCTURE_BINARY_VERSION);
+
+	BinaryIO::write(_stream, translation_);
+	BinaryIO::write(_stream, scale_);
+	BinaryIO::write(_stream, query_label_index_);
+
+	// Labels.
+	BinaryIO::write(_stream, labels_);
+	BinaryIO::write(_stream, label_names_);
+	BinaryIO::write(_stream, label_symmetries_);
+
+	BinaryIO::write(_stream, static_cast<uint64_t>(symmetry_group_info_.size()));
+	for (std::vector<MeshCuboidSymmetryGroupInfo>::const_iterator it = symmetry_group_info_.begin();
+		it != symmetry_group_info_.end(); ++it)
+		write_symmetry_group_info(_stream, *it);
+
+	// Sample points.
+	BinaryIO::write(_stream, static_cast<uint64_t>(sample_points_.size()));
+	for (std::vector<MeshSamplePoint *>::const_iterator it = sample_points_.begin();
+		it != sample_points_.end(); ++it)
+	{
+		const MeshSamplePoint *sample_point = (*it);
+		assert(sample_point);
+		BinaryIO::write(_stream, sample_point->sample_point_index_);
+		BinaryIO::write(_stream, sample_point->corr_fid_);
+		BinaryIO::write(_stream, sample_point->bary_coord_);
+		BinaryIO::write(_stream, sample_point->point_);
+		BinaryIO::write(_stream, sample_point->normal_);
+		BinaryIO::write(_stream, sample_point->error_);
+	}
+	sample_label_confidences_.write(_stream);
+
+	// Cuboids.
+	// NOTE:
+	// Sample points of cuboids are stored as their indices.
+	BinaryIO::write(_stream, static_cast<uint64_t>(label_cuboids_.size()));
+	for (std::vector< std::vector<MeshCuboid *> >::const_iterator it = label_cuboids_.begin();
+		it != label_cuboids_.end(); ++it)
+	{
+		BinaryIO::write(_stream, static_cast<uint64_t>((*it).size()));
+		for (std::vector<MeshCuboid *>::const_iterator jt = (*it).begin(); jt != (*it).end(); ++jt)
+		{
+			const MeshCuboid *cuboid = (*jt);
+			assert(cuboid);
+			BinaryIO::write(_stream, cuboid->label_index_);
+
+			std::vector<SamplePointIndex> sample_point_indices;
+			sample_point_indices.reserve(cuboid->sample_points_.size());
+			for (std::vector<MeshSamplePoint *>::const_iterator kt = cuboid->sample_points_.begin();
+				kt != cuboid->sample_points_.end(); ++kt)
+				sample_point_indices.push_back((*kt)->sample_point_index_);
+			BinaryIO::write(_stream, sample_point_indices);
+
+			BinaryIO::write(_stream, static_cast<uint64_t>(cuboid->cuboid_surface_points_.size()));
+			for (std::vector<MeshCuboidSurfacePoint *>::const_iterator kt = cuboid->cuboid_surface_points_.begin();
+				kt != cuboid->cuboid_surface_points_.end(); ++kt)
+			{
+				const MeshCuboidSurfacePoint *cuboid_surface_point = (*kt);
+				assert(cuboid_surface_point);
+				BinaryIO::write(_stream, cuboid_surface_point->point_);
+				BinaryIO::write(_stream, cuboid_surface_point->normal_);
+				BinaryIO::write(_stream, cuboid_surface_point->cuboid_face_index_);
+				BinaryIO::write(_stream, cuboid_surface_point->corner_weights_);
+				BinaryIO::write(_stream, cuboid_surface_point->visibility_);
+			}
+
+			BinaryIO::write(_stream, cuboid->sample_to_cuboid_surface_correspondence_);
+			BinaryIO::write(_stream, cuboid->cuboid_surface_to_sample_corresopndence_);
+
+			BinaryIO::write(_stream, cuboid->bbox_axes_);
+			BinaryIO::write(_stream, cuboid->bbox_center_);
+			BinaryIO::write(_stream, cuboid->bbox_size_);
+			BinaryIO::write(_stream, cuboid->bbox_corners_);
+		}
+	}
+
+	// Symmetry groups.
+	BinaryIO::write(_stream, static_cast<uint64_t>(reflection_symmetry_groups_.size()));
+	for (std::vector< MeshCuboidReflectionSymmetryGroup* >::const_iterator it = reflection_symmetry_groups_.begin();
+		it != reflection_symmetry_groups_.end(); ++it)
+	{
+		assert(*it);
+		MyMesh::Normal n;
+		double t;
+		(*it)->get_reflection_plane(n, t);
+
+		write_symmetry_group_info(_stream, (*it)->get_symmetry_group_info());
+		BinaryIO::write(_stream, n);
+		BinaryIO::write(_stream, t);
+	}
+
+	BinaryIO::write(_stream, static_cast<uint64_t>(rotation_symmetry_groups_.size()));
+	for (std::vector< MeshCuboidRotationSymmetryGroup* >::const_iterator it = rotation_symmetry_groups_.begin();
+		it != rotation_symmetry_groups_.end(); ++it)
+	{
+		assert(*it);
+		MyMesh::Normal n;
+		MyMesh::Point t;
+		(*it)->get_rotation_axis(n, t);
+
+		write_symmetry_group_info(_stream, (*it)->get_symmetry_group_info());
+		BinaryIO::write(_stream, n);
+		BinaryIO::write(_stream, t);
+		BinaryIO::write(_stream, (*it)->num_symmetry_orders());
+	}
+}
+
+bool MeshCuboidStructure::load_binary(std::istream &_stream)
+{
+	clear();
+
+	if (!BinaryIO::read_header(_stream, CUBOID_STRUCTURE_BINARY_MAGIC, CUBOID_STRUCTURE_BINARY_VERSION))
+		return false;
+
+	bool ret = true;
+	ret = ret && BinaryIO::read(_stream, translation_);
+	ret = ret && BinaryIO::read(_stream, scale_);
+	ret = ret && BinaryIO::read(_stream, query_label_index_);
+
+	// Labels.
+	ret = ret && BinaryIO::read(_stream, labels_);
+	ret = ret && BinaryIO::read(_stream, label_names_);
+	ret = ret && BinaryIO::read(_stream, label_symmetries_);
+
+	uint64_t num_symmetry_group_info = 0;
+	ret = ret && BinaryIO::read(_stream, num_symmetry_group_info);
+	symmetry_group_info_.clear();
+	for (uint64_t i = 0; ret && i < num_symmetry_group_info; ++i)
+	{
+		symmetry_group_info_.push_back(MeshCuboidSymmetryGroupInfo());
+		ret = ret && read_symmetry_group_info(_stream, symmetry_group_info_.back());
+	}
+
+	// Sample points.
+	uint64_t num_sample_points = 0;
+	ret = ret && BinaryIO::read(_stream, num_sample_points);
+	sample_points_.reserve(ret ? num_sample_points : 0);
+	for (uint64_t i = 0; ret && i < num_sample_points; ++i)
+	{
+		MeshSamplePoint *sample_point = new MeshSamplePoint(0, 0,
+			MyMesh::Point(0.0), MyMesh::Point(0.0), MyMesh::Normal(0.0));
+		sample_points_.push_back(sample_point);
+
+		ret = ret && BinaryIO::read(_stream, sample_point->sample_point_index_);
+		ret = ret && BinaryIO::read(_stream, sample_point->corr_fid_);
+		ret = ret && BinaryIO::read(_stream, sample_point->bary_coord_);
+		ret = ret && BinaryIO::read(_stream, sample_point->point_);
+		ret = ret && BinaryIO::read(_stream, sample_point->normal_);
+		ret = ret && BinaryIO::read(_stream, sample_point->error_);
+		ret = ret && (sample_point->sample_point_index_ == i);
+	}
+	ret = ret && sample_label_confidences_.read(_stream);
+	ret = ret && (sample_label_confidences_.num_points() == sample_points_.size());
+	ret = ret && (sample_label_confidences_.num_labels() == labels_.size());
+	if (ret)
+	{
+		sample_label_confidences_.set_storage(
+			get_label_confidence_encoding(params_), params_.label_confidence_top_k_);
+	}
+
+	// Cuboids.
+	uint64_t num_labels = 0;
+	ret = ret && BinaryIO::read(_stream, num_labels);
+	ret = ret && (num_labels == labels_.size());
+	label_cuboids_.clear();
+	label_cuboids_.resize(labels_.size());
+
+	for (uint64_t label_index = 0; ret && label_index < num_labels; ++label_index)
+	{
+		uint64_t num_cuboids = 0;
+		ret = ret && BinaryIO::read(_stream, num_cuboids);
+
+		for (uint64_t cuboid_index = 0; ret && cuboid_index < num_cuboids; ++cuboid_index)
+		{
+			MeshCuboid *cuboid = new MeshCuboid(static_cast<LabelIndex>(label_index));
+			label_cuboids_[label_index].push_back(cuboid);
+			ret = ret && BinaryIO::read(_stream, cuboid->label_index_);
+
+			std::vector<SamplePointIndex> sample_point_indices;
+			ret = ret && BinaryIO::read(_stream, sample_point_indices);
+			for (std::vector<SamplePointIndex>::const_iterator it = sample_point_indices.begin();
+				ret && it != sample_point_indices.end(); ++it)
+			{
+				ret = ret && ((*it) < sample_points_.size());
+				if (ret) cuboid->sample_points_.push_back(sample_points_[*it]);
+			}
+
+			uint64_t num_cuboid_surface_points = 0;
+			ret = ret && BinaryIO::read(_stream, num_cuboid_surface_points);
+			for (uint64_t i = 0; ret && i < num_cuboid_surface_points; ++i)
+			{
+				MeshCuboidSurfacePoint *cuboid_surface_point = new MeshCuboidSurfacePoint(
+					MyMesh::Point(0.0), MyMesh::Normal(0.0), 0, std::array<Real, 8>());
+				cuboid->cuboid_surface_points_.push_back(cuboid_surface_point);
+
+				ret = ret && BinaryIO::read(_stream, cuboid_surface_point->point_);
+				ret = ret && BinaryIO::read(_stream, cuboid_surface_point->normal_);
+				ret = ret && BinaryIO::read(_stream, cuboid_surface_point->cuboid_face_index_);
+				ret = ret && BinaryIO::read(_stream, cuboid_surface_point->corner_weights_);
+				ret = ret && BinaryIO::read(_stream, cuboid_surface_point->visibility_);
+			}
+
+			ret = ret && BinaryIO::read(_stream, cuboid->sample_to_cuboid_surface_correspondence_);
+			ret = ret && BinaryIO::read(_stream, cuboid->cuboid_surface_to_sample_corresopndence_);
+
+			ret = ret && BinaryIO::read(_stream, cuboid->bbox_axes_);
+			ret = ret && BinaryIO::read(_stream, cuboid->bbox_center_);
+			ret = ret && BinaryIO::read(_stream, cuboid->bbox_size_);
+			ret = ret && BinaryIO::read(_stream, cuboid->bbox_corners_);
+		}
+	}
+
+	// Symmetry groups.
+	uint64_t num_reflection_symmetry_groups = 0;
+	ret = ret && BinaryIO::read(_stream, num_reflection_symmetry_groups);
+	for (uint64_t i = 0; ret && i < num_reflection_symmetry_groups; ++i)
+	{
+		MeshCuboidSymmetryGroupInfo info;
+		MyMesh::Normal n;
+		double t = 0;
+		ret = ret && read_symmetry_group_info(_stream, info);
+		ret = ret && BinaryIO::read(_stream, n);
+		ret = ret && BinaryIO::read(_stream, t);
+		ret = ret && (info.symmetry_type_ == ReflectionSymmetryType);
+		if (!ret) break;
+
+		MeshCuboidReflectionSymmetryGroup *symmetry_group = new MeshCuboidReflectionSymmetryGroup(info);
+		symmetry_group->set_reflection_plane(n, t);
+		reflection_symmetry_groups_.push_back(symmetry_group);
+	}
+
+	uint64_t num_rotation_symmetry_groups = 0;
+	ret = ret && BinaryIO::read(_stream, num_rotation_symmetry_groups);
+	for (uint64_t i = 0; ret && i < num_rotation_symmetry_groups; ++i)
+	{
+		MeshCuboidSymmetryGroupInfo info;
+		MyMesh::Normal n;
+		MyMesh::Point t;
+		unsigned int num_symmetry_orders = 0;
+		ret = ret && read_symmetry_group_info(_stream, info);
+		ret = ret && BinaryIO::read(_stream, n);
+		ret = ret && BinaryIO::read(_stream, t);
+		ret = ret && BinaryIO::read(_stream, num_symmetry_orders);
+		ret = ret && (info.symmetry_type_ == RotationSymmetryType) && (num_symmetry_orders >= 2);
+		if (!ret) break;
+
+		MeshCuboidRotationSymmetryGroup *symmetry_group = new MeshCuboidRotationSymmetryGroup(info);
+		symmetry_group->set_rotation_axis(n, t);
+		symmetry_group->set_num_symmetry_orders(num_symmetry_orders);
+		rotation_symmetry_groups_.push_back(symmetry_group);
+	}
+
+	if (!ret)
+	{
+		clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCuboidStructure::save_binary(const std::string _filename, bool _verbose) const
+{
+	std::ofstream file(_filename, std::ios::binary);
+	if (!file)
+	{
+		std::cerr << "Can't save file: \"" << _filename << "\"" << std::endl;
+		return false;
+	}
+
+	if (_verbose)
+		std::cout << "Saving " << _filename << "..." << std::endl;
+
+	save_binary(file);
+	return file.good();
+}
+
+bool MeshCuboidStructure::load_binary(const std::string _filename, bool _verbose)
+{
+	std::ifstream file(_filename, std::ios::binary);
+	if (!file)
+	{
+		std::cerr << "Can't open file: \"" << _filename << "\"" << std::endl;
+		return false;
+	}
+
+	if (_verbose)
+		std::cout << "Loading " << _filename << "..." << std::endl;
+
+	if (!load_binary(file))
+	{
+		std::cerr << "Error: Invalid cuboid structure file: \"" << _filename << "\"" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
 void MeshCuboidStructure::apply_mesh_transformation()
 {
 	assert(mesh_);
@@ -592,6 +949,8 @@ bool MeshCuboidStructure::load_labels(const char *_filename, bool _verbose)
 
 	file.close();
 
+	sample_label_confidences_.resize(num_sample_points(), num_labels());
+
 
 	// NOTE:
 	// Draws all points.
@@ -837,6 +1196,8 @@ bool MeshCuboidStructure::load_sample_points(const char *_filename, bool _verbos
 
 	file.close();
 
+	sample_label_confidences_.resize(num_sample_points(), num_labels());
+
 	apply_mesh_transformation();
 	
 	/*
@@ -885,74 +1246,10 @@ bool MeshCuboidStructure::load_dense_sample_points(const char *_filename, bool _
 	if (_verbose)
 		std::cout << "Loading " << _filename << "..." << std::endl;
 
-
-	//
-	std::vector< std::list<MeshCuboid *> > sparse_sample_to_cuboids(num_sample_points());
-
-	for (std::vector< std::vector<MeshCuboid *> >::iterator it = label_cuboids_.begin();
-		it != label_cuboids_.end(); ++it)
-	{
-		for (std::vector<MeshCuboid *>::iterator jt = (*it).begin(); jt != (*it).end(); ++jt)
-		{
-			MeshCuboid* cuboid = (*jt);
-			const std::vector<MeshSamplePoint *> cuboid_sample_points = cuboid->get_sample_points();
-
-			for (std::vector<MeshSamplePoint *>::const_iterator kt = cuboid_sample_points.begin();
-				kt != cuboid_sample_points.end(); ++kt)
-			{
-				MeshSamplePoint* sample_point = (*kt);
-				assert(sample_point);
-				SamplePointIndex sample_point_index = sample_point->sample_point_index_;
-				assert(sample_point_index < num_sample_points());
-				sparse_sample_to_cuboids[sample_point_index].push_back(cuboid);
-			}
-		}
-	}
-
-	Eigen::MatrixXd sparse_sample_points(3, num_sample_points());
-
-	// FIXME:
-	// The type of indices should integer.
-	// But, it causes compile errors in the 'ICP::get_closest_points' function.
-	Eigen::MatrixXd sparse_sample_point_indices(1, num_sample_points());
-
-	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
-		++sample_point_index)
-	{
-		assert(sample_points_[sample_point_index]);
-		for (unsigned int i = 0; i < 3; ++i)
-			sparse_sample_points.col(sample_point_index)(i) =
-			sample_points_[sample_point_index]->point_[i];
-
-		sparse_sample_point_indices.col(sample_point_index)(0) = 
-			static_cast<double>(sample_point_index);
-	}
-
-	ANNpointArray sparse_sample_ann_points;
-	ANNkd_tree *sparse_sample_ann_kd_tree = ICP::create_kd_tree(sparse_sample_points,
-		sparse_sample_ann_points);
-	assert(sparse_sample_ann_points);
-	assert(sparse_sample_ann_kd_tree);
-
-
-	std::vector<MeshSamplePoint *> sparse_sample_points_copy;
-	sparse_sample_points_copy.resize(num_sample_points());
-	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
-			++sample_point_index)
-	{
-		assert(sample_points_[sample_point_index]);
-		MeshSamplePoint *sample_point = new MeshSamplePoint(*(sample_points_[sample_point_index]));
-		sparse_sample_points_copy[sample_point_index] = sample_point;
-	}
-	//
-
-
-	clear_sample_points();
-
-
 	assert(mesh_);
 	assert(mesh_->has_face_normals());
 
+	std::vector<MeshSamplePoint *> dense_sample_points;
 	std::string buffer;
 
 	for (SamplePointIndex sample_point_index = 0; !file.eof(); ++sample_point_index)
@@ -987,42 +1284,220 @@ bool MeshCuboidStructure::load_dense_sample_points(const char *_filename, bool _
 		pz = std::stof(token);
 		MyMesh::Point point = MyMesh::Point(px, py, pz);
 
+		// NOTE:
+		// Same with 'apply_mesh_transformation()'.
+		point = point * mesh_->get_scale();
+		point = point + mesh_->get_translation();
+
 		MyMesh::Normal normal = mesh_->normal(mesh_->face_handle(corr_fid));
 
 		MeshSamplePoint *sample_point = new MeshSamplePoint(sample_point_index, corr_fid, bary_coord, point, normal);
-		sample_points_.push_back(sample_point);
-		assert(sample_points_[sample_point_index] == sample_point);
+		dense_sample_points.push_back(sample_point);
+		assert(dense_sample_points[sample_point_index] == sample_point);
 	}
 
 	file.close();
 
+	std::vector<SamplePointIndex> closest_sample_point_indices;
+	get_closest_sample_point_indices(dense_sample_points, closest_sample_point_indices);
+	set_dense_sample_points(dense_sample_points, closest_sample_point_indices);
+
+	if (_verbose) std::cout << "Done." << std::endl;
+
+	return true;
+}
+
+bool MeshCuboidStructure::sample_points_on_mesh(const unsigned int _num_sample_points,
+	const unsigned int _num_dense_sample_points, const unsigned int _seed, bool _verbose)
+{
+	assert(mesh_);
+
+	if (_verbose)
+		std::cout << "Sampling " << _num_sample_points << " points on the mesh..." << std::endl;
+
+	PoissonDiskSampler::SampleSet sample_set;
+	PoissonDiskSampler::sample_points(*mesh_, _num_sample_points, _num_dense_sample_points,
+		_seed, sample_set);
+
+	if (sample_set.sparse_to_dense_indices_.empty())
+	{
+		std::cerr << "Error: No point is sampled on the mesh." << std::endl;
+		return false;
+	}
+
+
+	clear_sample_points();
+
+	// NOTE:
+	// Sample points are already in the mesh coordinates.
 	apply_mesh_transformation();
 
+	for (SamplePointIndex sample_point_index = 0;
+		sample_point_index < sample_set.sparse_to_dense_indices_.size(); ++sample_point_index)
+	{
+		const PoissonDiskSampler::SamplePoint &point = sample_set.dense_sample_points_[
+			sample_set.sparse_to_dense_indices_[sample_point_index]];
 
-	//
-	Eigen::MatrixXd dense_sample_points(3, num_sample_points());
-	Eigen::MatrixXd dense_sample_point_indices(1, num_sample_points());
+		MeshSamplePoint *sample_point = new MeshSamplePoint(sample_point_index,
+			point.corr_fid_, point.bary_coord_, point.point_, point.normal_);
+		sample_points_.push_back(sample_point);
+		assert(sample_points_[sample_point_index] == sample_point);
+	}
+
+	sample_label_confidences_.resize(num_sample_points(), num_labels());
+
+	if (_verbose) std::cout << "Done." << std::endl;
+
+	return true;
+}
+
+bool MeshCuboidStructure::sample_dense_points_on_mesh(const unsigned int _num_sample_points,
+	const unsigned int _num_dense_sample_points, const unsigned int _seed, bool _verbose)
+{
+	assert(mesh_);
+
+	if (_verbose)
+		std::cout << "Sampling " << _num_dense_sample_points << " dense points on the mesh..." << std::endl;
+
+	PoissonDiskSampler::SampleSet sample_set;
+	PoissonDiskSampler::sample_points(*mesh_, _num_sample_points, _num_dense_sample_points,
+		_seed, sample_set);
+
+	std::vector<MeshSamplePoint *> dense_sample_points;
+	dense_sample_points.reserve(sample_set.dense_sample_points_.size());
+
+	for (SamplePointIndex sample_point_index = 0;
+		sample_point_index < sample_set.dense_sample_points_.size(); ++sample_point_index)
+	{
+		const PoissonDiskSampler::SamplePoint &point = sample_set.dense_sample_points_[sample_point_index];
+		dense_sample_points.push_back(new MeshSamplePoint(sample_point_index,
+			point.corr_fid_, point.bary_coord_, point.point_, point.normal_));
+	}
+
+	// NOTE:
+	// The current sample points may be a subset of the sparse points of the same sampling
+	// (e.g. after 'remove_occluded_points()'), and thus 'dense_to_sparse_indices_' is not used.
+	std::vector<SamplePointIndex> closest_sample_point_indices;
+	get_closest_sample_point_indices(dense_sample_points, closest_sample_point_indices);
+	set_dense_sample_points(dense_sample_points, closest_sample_point_indices);
+
+	if (_verbose) std::cout << "Done." << std::endl;
+
+	return true;
+}
+
+void MeshCuboidStructure::get_closest_sample_point_indices(
+	const std::vector<MeshSamplePoint *> &_points,
+	std::vector<SamplePointIndex> &_closest_sample_point_indices) const
+{
+	_closest_sample_point_indices.clear();
+	_closest_sample_point_indices.resize(_points.size(), 0);
+	if (_points.empty() || num_sample_points() == 0)
+		return;
+
+	Eigen::MatrixXd sample_points(3, num_sample_points());
+
+	// FIXME:
+	// The type of indices should integer.
+	// But, it causes compile errors in the 'ICP::get_closest_points' function.
+	Eigen::MatrixXd sample_point_indices(1, num_sample_points());
 
 	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
 		++sample_point_index)
 	{
 		assert(sample_points_[sample_point_index]);
 		for (unsigned int i = 0; i < 3; ++i)
-			dense_sample_points.col(sample_point_index)(i) =
+			sample_points.col(sample_point_index)(i) =
 			sample_points_[sample_point_index]->point_[i];
+
+		sample_point_indices.col(sample_point_index)(0) =
+			static_cast<double>(sample_point_index);
 	}
 
-	ICP::get_closest_points(sparse_sample_ann_kd_tree, dense_sample_points,
-		sparse_sample_point_indices, dense_sample_point_indices);
-	assert(dense_sample_point_indices.rows() == 1);
-	assert(dense_sample_point_indices.cols() == num_sample_points());
+	Eigen::MatrixXd points(3, _points.size());
+	for (unsigned int point_index = 0; point_index < _points.size(); ++point_index)
+	{
+		assert(_points[point_index]);
+		for (unsigned int i = 0; i < 3; ++i)
+			points.col(point_index)(i) = _points[point_index]->point_[i];
+	}
+
+	ANNpointArray sample_ann_points;
+	ANNkd_tree *sample_ann_kd_tree = ICP::create_kd_tree(sample_points, sample_ann_points);
+	assert(sample_ann_points);
+	assert(sample_ann_kd_tree);
+
+	Eigen::MatrixXd closest_sample_point_indices;
+	ICP::get_closest_points(sample_ann_kd_tree, points,
+		sample_point_indices, closest_sample_point_indices);
+	assert(closest_sample_point_indices.rows() == 1);
+	assert(closest_sample_point_indices.cols() == _points.size());
+
+	for (unsigned int point_index = 0; point_index < _points.size(); ++point_index)
+	{
+		_closest_sample_point_indices[point_index] =
+			static_cast<SamplePointIndex>(closest_sample_point_indices.col(point_index)(0));
+	}
+
+	annDeallocPts(sample_ann_points);
+	delete sample_ann_kd_tree;
+}
+
+void MeshCuboidStructure::set_dense_sample_points(
+	const std::vector<MeshSamplePoint *> &_dense_sample_points,
+	const std::vector<SamplePointIndex> &_sparse_sample_point_indices)
+{
+	assert(_dense_sample_points.size() == _sparse_sample_point_indices.size());
+
+	//
+	std::vector< std::list<MeshCuboid *> > sparse_sample_to_cuboids(num_sample_points());
+
+	for (std::vector< std::vector<MeshCuboid *> >::iterator it = label_cuboids_.begin();
+		it != label_cuboids_.end(); ++it)
+	{
+		for (std::vector<MeshCuboid *>::iterator jt = (*it).begin(); jt != (*it).end(); ++jt)
+		{
+			MeshCuboid* cuboid = (*jt);
+			const std::vector<MeshSamplePoint *> cuboid_sample_points = cuboid->get_sample_points();
+
+			for (std::vector<MeshSamplePoint *>::const_iterator kt = cuboid_sample_points.begin();
+				kt != cuboid_sample_points.end(); ++kt)
+			{
+				MeshSamplePoint* sample_point = (*kt);
+				assert(sample_point);
+				SamplePointIndex sample_point_index = sample_point->sample_point_index_;
+				assert(sample_point_index < num_sample_points());
+				sparse_sample_to_cuboids[sample_point_index].push_back(cuboid);
+			}
+		}
+	}
+
+	LabelConfidenceTable sparse_sample_label_confidences = sample_label_confidences_;
+	//
+
+
+	clear_sample_points();
+
+	// NOTE:
+	// Dense sample points are already in the mesh coordinates.
+	apply_mesh_transformation();
+
+	for (SamplePointIndex sample_point_index = 0; sample_point_index < _dense_sample_points.size();
+		++sample_point_index)
+	{
+		MeshSamplePoint *sample_point = _dense_sample_points[sample_point_index];
+		assert(sample_point);
+		assert(sample_point->sample_point_index_ == sample_point_index);
+		sample_points_.push_back(sample_point);
+	}
+
+	sample_label_confidences_.resize(num_sample_points(), num_labels());
 
 	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
 		++sample_point_index)
 	{
-		assert(sample_points_[sample_point_index]);
-		SamplePointIndex sparse_sample_point_index =
-			static_cast<SamplePointIndex>(dense_sample_point_indices.col(sample_point_index)(0));
+		SamplePointIndex sparse_sample_point_index = _sparse_sample_point_indices[sample_point_index];
+		assert(sparse_sample_point_index < sparse_sample_to_cuboids.size());
 
 		for (std::list<MeshCuboid *>::iterator it = sparse_sample_to_cuboids[sparse_sample_point_index].begin();
 			it != sparse_sample_to_cuboids[sparse_sample_point_index].end(); ++it)
@@ -1031,25 +1506,9 @@ bool MeshCuboidStructure::load_dense_sample_points(const char *_filename, bool _
 			cuboid->add_sample_point(sample_points_[sample_point_index]);
 		}
 
-		MeshSamplePoint *sparse_sample_point = sparse_sample_points_copy[sparse_sample_point_index];
-		assert(sparse_sample_point);
-		sample_points_[sample_point_index]->label_index_confidence_
-			= sparse_sample_point->label_index_confidence_;
+		sample_label_confidences_.copy_row(sample_point_index,
+			sparse_sample_label_confidences, sparse_sample_point_index);
 	}
-
-
-	annDeallocPts(sparse_sample_ann_points);
-	delete sparse_sample_ann_kd_tree;
-
-	for (std::vector<MeshSamplePoint *>::iterator it = sparse_sample_points_copy.begin();
-		it != sparse_sample_points_copy.end(); ++it)
-		delete (*it);
-	sparse_sample_points_copy.clear();
-	//
-
-	if (_verbose) std::cout << "Done." << std::endl;
-
-	return true;
 }
 
 bool MeshCuboidStructure::save_sample_points(const char *_filename, bool _verbose) const
@@ -1180,6 +1639,10 @@ bool MeshCuboidStructure::load_sample_point_labels(const char *_filename, bool _
 	std::string buffer;
 	SamplePointIndex sample_point_index = 0;
 
+	assert(sample_label_confidences_.num_points() == num_sample_points());
+	assert(sample_label_confidences_.num_labels() == num_labels());
+	std::vector<Real> label_confidences(num_labels());
+
 	while (!file.eof() && sample_point_index < num_sample_points())
 	{
 		std::getline(file, buffer);
@@ -1206,10 +1669,8 @@ bool MeshCuboidStructure::load_sample_point_labels(const char *_filename, bool _
 			std::stringstream strstr(buffer);
 			std::string token;
 
-			MeshSamplePoint* sample_point = sample_points_[sample_point_index];
-			assert(sample_point);
-			sample_point->label_index_confidence_.clear();
-			sample_point->label_index_confidence_.resize(num_labels());
+			assert(sample_point_index < num_sample_points());
+			std::fill(label_confidences.begin(), label_confidences.end(), 0.0);
 
 			for (LabelIndex label_index = 0; label_index < num_labels(); ++label_index)
 			{
@@ -1220,9 +1681,10 @@ bool MeshCuboidStructure::load_sample_point_labels(const char *_filename, bool _
 					break;
 				}
 				else std::getline(strstr, token, ',');
-				sample_point->label_index_confidence_[label_index] = std::stof(token);
+				label_confidences[label_index] = std::stof(token);
 			}
 
+			sample_label_confidences_.set_row(sample_point_index, label_confidences);
 			++sample_point_index;
 		}
 	}
@@ -1268,16 +1730,18 @@ bool MeshCuboidStructure::save_sample_point_labels(const char *_filename, bool _
 		file << "@ATTRIBUTE prediction - " << label_index << " NUMERIC" << std::endl;
 	file << "@DATA" << std::endl;
 
+	std::vector<Real> label_confidences;
 	for (std::vector<MeshSamplePoint *>::const_iterator it = sample_points_.begin();
 		it != sample_points_.end(); ++it)
 	{
 		const MeshSamplePoint *sample_point = (*it);
 		assert(sample_point);
-		assert(sample_point->label_index_confidence_.size() == num_labels());
+		sample_label_confidences_.get_row(sample_point->sample_point_index_, label_confidences);
+		assert(label_confidences.size() == num_labels());
 
 		for (LabelIndex label_index = 0; label_index < num_labels(); ++label_index)
 		{
-			file << sample_point->label_index_confidence_[label_index];
+			file << label_confidences[label_index];
 			if (label_index + 1 < num_labels())
 				file << ",";
 		}
@@ -1350,6 +1814,8 @@ bool MeshCuboidStructure::test_load_cuboids(const char *_filename, bool _verbose
 		label_cuboids_.push_back(new_label_cuboid);
 	}
 
+	sample_label_confidences_.resize(num_sample_points(), num_labels());
+
 	SamplePointIndex sample_point_index = 0;
 	////
 	//for (unsigned int label_index = 0; label_index < num_labels(); ++label_index)
@@ -1382,14 +1848,10 @@ bool MeshCuboidStructure::test_load_cuboids(const char *_filename, bool _verbose
 				MyMesh::Point point = MyMesh::Point(px, py, pz);
 				MeshSamplePoint *sample_point = new MeshSamplePoint(sample_point_index, 0, MyMesh::Point(0.0),
 					point, MyMesh::Normal(0.0));
-				sample_point->label_index_confidence_.resize(num_labels());
+				sample_label_confidences_.add_point();
+				sample_label_confidences_.set_one_hot(sample_point_index, 0);
 				++sample_point_index;
 
-				for (unsigned int label_index = 0; label_index < num_labels(); label_index++)
-					sample_point->label_index_confidence_[label_index] = 0;
-
-				sample_point->label_index_confidence_[0] = 1.0;
-
 				sample_points_.push_back(sample_point);
 				new_cuboid->add_sample_point(sample_point);
 			}
@@ -1466,6 +1928,12 @@ void MeshCuboidStructure::get_all_cuboid_surface_points(
 	}
 }
 
+void MeshCuboidStructure::get_all_cuboid_distances(Eigen::MatrixXd &_distances,
+	bool _symmetric) const
+{
+	MeshCuboid::distances_between_cuboids(get_all_cuboids(), _distances, _symmetric);
+}
+
 MeshSamplePoint *MeshCuboidStructure::add_sample_point(
 	const MyMesh::Point& _point, const MyMesh::Normal& _normal)
 {
@@ -1475,6 +1943,26 @@ MeshSamplePoint *MeshCuboidStructure::add_sample_point(
 	MeshSamplePoint *new_sample_point = new MeshSamplePoint(
 		new_sample_point_index, 0, MyMesh::Point(0.0), _point, _normal);
 	sample_points_.push_back(new_sample_point);
+	sample_label_confidences_.add_point();
+	return new_sample_point;
+}
+
+MeshSamplePoint *MeshCuboidStructure::add_sample_point_copy(const MeshSamplePoint *_sample_point)
+{
+	assert(_sample_point);
+	assert(_sample_point->sample_point_index_ < num_sample_points());
+	assert(sample_points_[_sample_point->sample_point_index_] == _sample_point);
+
+	// NOTE:
+	// Assume that the sample point index is the same with the index in the 'sample_points_' vector.
+	SamplePointIndex new_sample_point_index = sample_points_.size();
+	MeshSamplePoint *new_sample_point = new MeshSamplePoint(*_sample_point);
+	new_sample_point->sample_point_index_ = new_sample_point_index;
+	sample_points_.push_back(new_sample_point);
+
+	sample_label_confidences_.add_point();
+	sample_label_confidences_.copy_row(new_sample_point_index,
+		sample_label_confidences_, _sample_point->sample_point_index_);
 	return new_sample_point;
 }
 
@@ -1514,11 +2002,10 @@ void MeshCuboidStructure::add_sample_points_from_mesh_vertices()
 
 			MeshSamplePoint *sample_point = new MeshSamplePoint(sample_point_index, corr_fid, bary_coord, point, normal);
 
-			sample_point->label_index_confidence_.clear();
-			sample_point->label_index_confidence_.resize(num_labels(), 0.0);
 			// Note:
 			// The confidence of the given label becomes '1.0'.
-			sample_point->label_index_confidence_[label_index] = 1.0;
+			sample_label_confidences_.add_point();
+			sample_label_confidences_.set_one_hot(sample_point_index, label_index);
 
 			sample_points_.push_back(sample_point);
 			++sample_point_index;
@@ -1544,6 +2031,9 @@ void MeshCuboidStructure::remove_sample_points(const bool *is_sample_point_remov
 	}
 	//
 
+	sample_label_confidences_.remove_points(std::vector<bool>(
+		is_sample_point_removed, is_sample_point_removed + num_sample_points()));
+
 	SamplePointIndex new_sample_point_index = 0;
 	for (std::vector<MeshSamplePoint *>::iterator it = sample_points_.begin();
 		it != sample_points_.end();)	// No increment.
@@ -1563,6 +2053,149 @@ void MeshCuboidStructure::remove_sample_points(const bool *is_sample_point_remov
 	}
 }
 
+Real MeshCuboidStructure::downsample_sample_points(const unsigned int _max_num_sample_points,
+	std::vector<SamplePointIndex> &_representative_indices)
+{
+	TraceScope trace_scope("downsample_sample_points");
+	trace_scope.add_arg("points", num_sample_points());
+
+	const int num_points = static_cast<int>(num_sample_points());
+	_representative_indices.resize(num_points);
+	for (int point_index = 0; point_index < num_points; ++point_index)
+		_representative_indices[point_index] = point_index;
+
+	if (_max_num_sample_points == 0 || num_points <= static_cast<int>(_max_num_sample_points))
+		return 0;
+
+
+	Eigen::MatrixXd points(3, num_points);
+	for (int point_index = 0; point_index < num_points; ++point_index)
+	{
+		assert(sample_points_[point_index]);
+		for (unsigned int i = 0; i < 3; ++i)
+			points(i, point_index) = sample_points_[point_index]->point_[i];
+	}
+
+	const Real diagonal = (points.rowwise().maxCoeff() - points.rowwise().minCoeff()).norm();
+
+	// NOTE:
+	// Points without any confidence value have their own label 'num_labels()'.
+	std::vector<unsigned int> point_label_indices;
+	std::vector<Real> point_max_confidences;
+	sample_label_confidences_.get_argmax_labels(point_label_indices, &point_max_confidences);
+	for (int point_index = 0; point_index < num_points; ++point_index)
+		if (point_max_confidences[point_index] <= 0)
+			point_label_indices[point_index] = num_labels();
+
+	// NOTE:
+	// Sample points are on surfaces, and thus the number of voxels is roughly inversely
+	// proportional to the squared voxel size. The voxel size starts from a small size, and is
+	// increased until the number of (voxel, label) pairs is within the budget
+	// (or all points are in a single voxel).
+	Real voxel_size = (diagonal > 0) ? (0.25 * diagonal / std::sqrt(static_cast<Real>(_max_num_sample_points))) : 1.0;
+	std::vector<uint64_t> point_keys(num_points);
+
+	while (true)
+	{
+		PointHashGrid point_grid(points, voxel_size);
+
+#pragma omp parallel for
+		for (int point_index = 0; point_index < num_points; ++point_index)
+		{
+			const int cell_index = point_grid.get_point_cell_index(point_index);
+			assert(cell_index >= 0);
+			point_keys[point_index] = static_cast<uint64_t>(cell_index) * (num_labels() + 1)
+				+ point_label_indices[point_index];
+		}
+
+		std::vector<uint64_t> keys = point_keys;
+		std::sort(keys.begin(), keys.end());
+		const unsigned int num_keys = static_cast<unsigned int>(
+			std::unique(keys.begin(), keys.end()) - keys.begin());
+
+		if (num_keys <= _max_num_sample_points || voxel_size > diagonal)
+			break;
+
+		voxel_size *= std::max(static_cast<Real>(1.05),
+			std::sqrt(static_cast<Real>(num_keys) / _max_num_sample_points));
+	}
+
+
+	// Keep the most confident point of each (voxel, label) pair.
+	std::vector<int> sorted_point_indices(num_points);
+	for (int point_index = 0; point_index < num_points; ++point_index)
+		sorted_point_indices[point_index] = point_index;
+
+	std::sort(sorted_point_indices.begin(), sorted_point_indices.end(), [&](const int _i, const int _j)
+	{
+		if (point_keys[_i] != point_keys[_j]) return point_keys[_i] < point_keys[_j];
+		if (point_max_confidences[_i] != point_max_confidences[_j])
+			return point_max_confidences[_i] > point_max_confidences[_j];
+		return _i < _j;
+	});
+
+	std::vector<int> representative_point_indices(num_points);
+	bool *is_sample_point_removed = new bool[num_points];
+	memset(is_sample_point_removed, true, num_points * sizeof(bool));
+
+	for (int offset = 0; offset < num_points; ++offset)
+	{
+		const int point_index = sorted_point_indices[offset];
+		if (offset == 0 || point_keys[point_index] != point_keys[sorted_point_indices[offset - 1]])
+		{
+			is_sample_point_removed[point_index] = false;
+			representative_point_indices[point_index] = point_index;
+		}
+		else
+		{
+			representative_point_indices[point_index] =
+				representative_point_indices[sorted_point_indices[offset - 1]];
+		}
+	}
+
+	// New indices of the remaining points.
+	std::vector<SamplePointIndex> new_point_indices(num_points);
+	SamplePointIndex new_point_index = 0;
+	for (int point_index = 0; point_index < num_points; ++point_index)
+	{
+		new_point_indices[point_index] = new_point_index;
+		if (!is_sample_point_removed[point_index]) ++new_point_index;
+	}
+
+	for (int point_index = 0; point_index < num_points; ++point_index)
+		_representative_indices[point_index] = new_point_indices[representative_point_indices[point_index]];
+
+	remove_sample_points(is_sample_point_removed);
+	delete[] is_sample_point_removed;
+
+	assert(num_sample_points() == new_point_index);
+	trace_scope.add_arg("remaining_points", num_sample_points());
+
+	return voxel_size;
+}
+
+void MeshCuboidStructure::upsample_sample_points(const MeshCuboidStructure &_other,
+	const std::vector<SamplePointIndex> &_representative_indices)
+{
+	TraceScope trace_scope("upsample_sample_points");
+	trace_scope.add_arg("points", _other.num_sample_points());
+
+	assert(_other.num_sample_points() == _representative_indices.size());
+
+	std::vector<MeshSamplePoint *> sample_points;
+	sample_points.reserve(_other.num_sample_points());
+
+	for (SamplePointIndex sample_point_index = 0; sample_point_index < _other.num_sample_points();
+		++sample_point_index)
+	{
+		assert(_other.sample_points_[sample_point_index]);
+		assert(_representative_indices[sample_point_index] < num_sample_points());
+		sample_points.push_back(new MeshSamplePoint(*_other.sample_points_[sample_point_index]));
+	}
+
+	set_dense_sample_points(sample_points, _representative_indices);
+}
+
 void MeshCuboidStructure::apply_mesh_face_labels_to_sample_points()
 {
 	assert(mesh_);
@@ -1577,9 +2210,6 @@ void MeshCuboidStructure::apply_mesh_face_labels_to_sample_points()
 		MyMesh::FaceHandle fh = mesh_->face_handle(fid);
 		Label label = mesh_->property(mesh_->face_label_, fh);
 
-		sample_point->label_index_confidence_.clear();
-		sample_point->label_index_confidence_.resize(num_labels(), 0.0);
-
 		LabelIndex label_index;
 		bool ret = exist_label(label, &label_index);
 
@@ -1591,7 +2221,11 @@ void MeshCuboidStructure::apply_mesh_face_labels_to_sample_points()
 
 			// Note:
 			// The confidence of the given label becomes '1.0'.
-			sample_point->label_index_confidence_[label_index] = 1.0;
+			sample_label_confidences_.set_one_hot(sample_point_index, label_index);
+		}
+		else
+		{
+			sample_label_confidences_.set_zero(sample_point_index);
 		}
 	}
 }
@@ -1610,7 +2244,7 @@ void MeshCuboidStructure::apply_mesh_face_labels_to_cuboids()
 		{
 			MeshCuboid *label_cuboid = (*jt);
 			// Update the label based on the label confidence values of sample points.
-			label_cuboid->update_label_using_sample_points();
+			label_cuboid->update_label_using_sample_points(sample_label_confidences_);
 			part_list.push_back(label_cuboid);
 		}
 	}
@@ -1632,27 +2266,36 @@ void MeshCuboidStructure::apply_mesh_face_labels_to_cuboids()
 
 void MeshCuboidStructure::compute_label_cuboids()
 {
+	TraceScope trace_scope("compute_label_cuboids");
+	trace_scope.add_arg("points", num_sample_points());
+
 	clear_cuboids();
 
+	// Select sample points which has sufficient confidence for each label.
+	// NOTE:
+	// The confidence table is read in the row order.
+	std::vector< std::vector<MeshSamplePoint *> > all_label_sample_points(num_labels());
+	std::vector<Real> label_confidences;
+
+	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
+		++sample_point_index)
+	{
+		MeshSamplePoint *sample_point = sample_points_[sample_point_index];
+		assert(sample_point);
+
+		sample_label_confidences_.get_row(sample_point_index, label_confidences);
+		for (LabelIndex label_index = 0; label_index < num_labels(); ++label_index)
+			if (label_confidences[label_index] >= params_.min_sample_point_confidence_)
+				all_label_sample_points[label_index].push_back(sample_point);
+	}
+
 	for (LabelIndex label_index = 0; label_index < num_labels(); ++label_index)
 	{
 		assert(label_cuboids_[label_index].empty());
 		MeshCuboid *cuboid = new MeshCuboid(label_index);
-		std::vector<MeshSamplePoint *> label_sample_points;
-
-		for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points();
-			++sample_point_index)
-		{
-			MeshSamplePoint *sample_point = sample_points_[sample_point_index];
-			assert(sample_point);
-
-			// Select sample points which has sufficient confidence for the given label.
-			if (sample_point->label_index_confidence_[label_index] >= FLAGS_param_min_sample_point_confidence)
-				label_sample_points.push_back(sample_point);
-		}
 
-		cuboid->add_sample_points(label_sample_points);
-		bool ret = cuboid->compute_bbox();
+		cuboid->add_sample_points(all_label_sample_points[label_index]);
+		bool ret = cuboid->compute_bbox(params_);
 		if (!ret)
 		{
 			delete cuboid;
@@ -1709,32 +2352,19 @@ void MeshCuboidStructure::find_the_largest_label_cuboids()
 void MeshCuboidStructure::get_sample_point_label_indices_from_confidences(
 	std::vector<LabelIndex> &_sample_point_label_indices)
 {
-	_sample_point_label_indices.resize(num_sample_points(), num_labels());
+	assert(sample_label_confidences_.num_points() == num_sample_points());
+	assert(sample_label_confidences_.num_labels() == num_labels());
+
+	std::vector<Real> max_confidences;
+	sample_label_confidences_.get_argmax_labels(_sample_point_label_indices, &max_confidences);
 
 	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points(); ++sample_point_index)
 	{
-		MeshSamplePoint* sample_point = sample_points_[sample_point_index];
-		assert(sample_point);
-		assert(sample_point->label_index_confidence_.size() == labels_.size());
-
-		Real max_confidence = 0;
-		LabelIndex max_confidence_label_index = num_labels();
-
-		for (LabelIndex label_index = 0; label_index < num_labels(); ++label_index)
-		{
-			Real confidence = sample_point->label_index_confidence_[label_index];
-
-			if (confidence > max_confidence)
-			{
-				max_confidence = confidence;
-				max_confidence_label_index = label_index;
-			}
-		}
-
 		// NOTE:
 		// If the maximum confidence is zero, the number of labels is assigned as the label index,
 		// which means that the sample point is not included in any cuboid.
-		_sample_point_label_indices[sample_point_index] = max_confidence_label_index;
+		if (max_confidences[sample_point_index] <= 0)
+			_sample_point_label_indices[sample_point_index] = num_labels();
 	}
 }
 
@@ -1772,12 +2402,7 @@ void MeshCuboidStructure::get_sample_point_label_indices_from_mesh(
 void MeshCuboidStructure::set_sample_point_label_confidence_using_cuboids()
 {
 	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points(); ++sample_point_index)
-	{
-		MeshSamplePoint* sample_point = sample_points_[sample_point_index];
-		assert(sample_point);
-		sample_point->label_index_confidence_.clear();
-		sample_point->label_index_confidence_.resize(num_labels(), 0.0);
-	}
+		sample_label_confidences_.set_zero(sample_point_index);
 
 	for (LabelIndex label_index = 0; label_index < num_labels(); ++label_index)
 	{
@@ -1796,7 +2421,7 @@ void MeshCuboidStructure::set_sample_point_label_confidence_using_cuboids()
 		{
 			MeshSamplePoint *sample_point = (*it);
 			assert(sample_point);
-			sample_point->label_index_confidence_[label_index] = 1.0;
+			sample_label_confidences_.set(sample_point->sample_point_index_, label_index, 1.0);
 		}
 	}
 }
@@ -1866,6 +2491,8 @@ LabelIndex MeshCuboidStructure::get_label_index(const std::string _label_name) c
 
 void MeshCuboidStructure::split_label_cuboids()
 {
+	TraceScope trace_scope("split_label_cuboids");
+
 	assert(mesh_);
 	assert(label_cuboids_.size() == num_labels());
 	Real object_diameter = mesh_->get_object_diameter();
@@ -1880,7 +2507,7 @@ void MeshCuboidStructure::split_label_cuboids()
 		for (std::vector<MeshCuboid *>::iterator it = cuboids.begin(); it != cuboids.end(); ++it)
 		{
 			MeshCuboid *cuboid = (*it);
-			std::vector<MeshCuboid *> sub_cuboids = cuboid->split_cuboid(object_diameter);
+			std::vector<MeshCuboid *> sub_cuboids = cuboid->split_cuboid(object_diameter, sample_label_confidences_, params_);
 			new_cuboids.insert(new_cuboids.end(), sub_cuboids.begin(), sub_cuboids.end());
 
 			// Note:
@@ -1958,6 +2585,8 @@ void MeshCuboidStructure::remove_symmetric_cuboids()
 
 void MeshCuboidStructure::compute_symmetry_groups()
 {
+	TraceScope trace_scope("compute_symmetry_groups");
+
 	for (std::vector< MeshCuboidReflectionSymmetryGroup* >::iterator it = reflection_symmetry_groups_.begin();
 		it != reflection_symmetry_groups_.end(); ++it)
 		delete (*it);
@@ -1980,7 +2609,8 @@ void MeshCuboidStructure::compute_symmetry_groups()
 		}
 		else if ((*it).symmetry_type_ == RotationSymmetryType)
 		{
-			MeshCuboidRotationSymmetryGroup* group = MeshCuboidRotationSymmetryGroup::constructor(*it, cuboids);
+			MeshCuboidRotationSymmetryGroup* group = MeshCuboidRotationSymmetryGroup::constructor(
+				*it, cuboids, params_.sparse_neighbor_distance_);
 			if (group) rotation_symmetry_groups_.push_back(group);
 		}
 	}
@@ -2079,7 +2709,7 @@ void MeshCuboidStructure::copy_sample_points_to_symmetric_position(
 				sample_points_2.col(sample_point_index)(i) = point_2[i];
 		}
 
-		const Real neighbor_distance = FLAGS_param_sparse_neighbor_distance * mesh_->get_object_diameter();
+		const Real neighbor_distance = params_.sparse_neighbor_distance_ * mesh_->get_object_diameter();
 
 		Eigen::Matrix3d rotation_mat;
 		Eigen::Vector3d translation_vec;
@@ -2117,7 +2747,8 @@ void MeshCuboidStructure::copy_sample_points_to_symmetric_position(
 			MeshSamplePoint *symmetric_sample_point = add_sample_point(symmetric_point_1, symmetric_normal_1);
 
 			// Copy label confidence values.
-			symmetric_sample_point->label_index_confidence_ = sample_point_1->label_index_confidence_;
+			sample_label_confidences_.copy_row(symmetric_sample_point->sample_point_index_,
+				sample_label_confidences_, sample_point_1->sample_point_index_);
 
 			_cuboid_2->add_sample_point(symmetric_sample_point);
 		}
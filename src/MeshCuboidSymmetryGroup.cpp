@@ -2,6 +2,7 @@
 #include "MeshCuboidParameters.h"
 #include "Utilities.h"
 
+#include <algorithm>
 #include <bitset>
 #include <Eigen/Eigenvalues> 
 
@@ -29,6 +30,90 @@ MeshCuboidSymmetryGroupInfo::MeshCuboidSymmetryGroupInfo(const MeshCuboidSymmetr
 	pair_label_indices_ = _other.pair_label_indices_;
 }
 
+MeshCuboidSamplePointGrids::MeshCuboidSamplePointGrids()
+	: neighbor_distance_(0.0)
+{
+
+}
+
+MeshCuboidSamplePointGrids::~MeshCuboidSamplePointGrids()
+{
+	clear();
+}
+
+void MeshCuboidSamplePointGrids::clear()
+{
+	for (std::vector<PointHashGrid *>::iterator it = grids_.begin(); it != grids_.end(); ++it)
+		delete (*it);
+
+	grids_.clear();
+	sample_points_.clear();
+}
+
+unsigned int MeshCuboidSamplePointGrids::update(
+	const std::vector<MeshCuboid *> &_cuboids, const Real _neighbor_distance)
+{
+	assert(_neighbor_distance > 0);
+
+	const unsigned int num_cuboids = _cuboids.size();
+	if (grids_.size() != num_cuboids || neighbor_distance_ != _neighbor_distance)
+	{
+		clear();
+		grids_.resize(num_cuboids, NULL);
+		sample_points_.resize(num_cuboids);
+		neighbor_distance_ = _neighbor_distance;
+	}
+
+	unsigned int num_rebuilt_grids = 0;
+
+	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
+	{
+		const MeshCuboid *cuboid = _cuboids[cuboid_index];
+		assert(cuboid);
+
+		unsigned int num_cuboid_sample_points = cuboid->num_sample_points();
+		Eigen::MatrixXd cuboid_sample_points(3, num_cuboid_sample_points);
+
+		for (unsigned int point_index = 0; point_index < num_cuboid_sample_points; ++point_index)
+		{
+			for (unsigned int i = 0; i < 3; ++i)
+				cuboid_sample_points.col(point_index)(i) =
+				cuboid->get_sample_point(point_index)->point_[i];
+		}
+
+		// NOTE:
+		// Keep the grid if the sample points are not changed.
+		if (cuboid_sample_points.cols() == sample_points_[cuboid_index].cols()
+			&& (num_cuboid_sample_points == 0 || grids_[cuboid_index])
+			&& cuboid_sample_points == sample_points_[cuboid_index])
+			continue;
+
+		delete grids_[cuboid_index];
+		grids_[cuboid_index] = NULL;
+		sample_points_[cuboid_index] = cuboid_sample_points;
+
+		if (num_cuboid_sample_points > 0)
+		{
+			grids_[cuboid_index] = new PointHashGrid(sample_points_[cuboid_index], neighbor_distance_);
+			++num_rebuilt_grids;
+		}
+	}
+
+	return num_rebuilt_grids;
+}
+
+const Eigen::MatrixXd &MeshCuboidSamplePointGrids::get_sample_points(const unsigned int _cuboid_index) const
+{
+	assert(_cuboid_index < sample_points_.size());
+	return sample_points_[_cuboid_index];
+}
+
+const PointHashGrid *MeshCuboidSamplePointGrids::get_grid(const unsigned int _cuboid_index) const
+{
+	assert(_cuboid_index < grids_.size());
+	return grids_[_cuboid_index];
+}
+
 MeshCuboidSymmetryGroup::MeshCuboidSymmetryGroup()
 	: num_symmetry_orders_(2)
 {
@@ -123,16 +208,14 @@ void MeshCuboidSymmetryGroup::get_pair_cuboid_indices(const std::vector<MeshCubo
 
 void MeshCuboidSymmetryGroup::get_symmetric_sample_point_pairs(
 	const std::vector<MeshCuboid *> &_cuboids,
-	const std::vector<ANNpointArray> &_cuboid_ann_points,
-	const std::vector<ANNkd_tree *> &_cuboid_ann_kd_tree,
+	const MeshCuboidSamplePointGrids &_cuboid_sample_point_grids,
 	const Real _squared_neighbor_distance,
-	std::list<WeightedPointPair> &_sample_point_pairs) const
+	std::vector<WeightedPointPair> &_sample_point_pairs) const
 {
 	const unsigned int num_cuboids = _cuboids.size();
-	assert(_cuboid_ann_points.size() == num_cuboids);
-	assert(_cuboid_ann_kd_tree.size() == num_cuboids);
+	assert(_cuboid_sample_point_grids.num_cuboids() == num_cuboids);
 
-	_sample_point_pairs.clear();
+	std::vector<SamplePointPairTask> tasks;
 
 
 	std::vector<unsigned int> single_cuboid_indices;
@@ -143,11 +226,10 @@ void MeshCuboidSymmetryGroup::get_symmetric_sample_point_pairs(
 	{
 		const unsigned int cuboid_index = (*it);
 
-		get_symmetric_sample_point_pairs(
-			_cuboids[cuboid_index],
-			_cuboid_ann_points[cuboid_index],
-			_cuboid_ann_kd_tree[cuboid_index],
-			_squared_neighbor_distance, _sample_point_pairs);
+		tasks.push_back(SamplePointPairTask(
+			&_cuboid_sample_point_grids.get_sample_points(cuboid_index),
+			&_cuboid_sample_point_grids.get_sample_points(cuboid_index),
+			_cuboid_sample_point_grids.get_grid(cuboid_index)));
 	}
 
 	// NOTE:
@@ -164,103 +246,123 @@ void MeshCuboidSymmetryGroup::get_symmetric_sample_point_pairs(
 			const unsigned int cuboid_index_2 = (*it).second;
 
 			// 1 -> 2.
-			get_symmetric_sample_point_pairs(
-				_cuboids[cuboid_index_1],
-				_cuboid_ann_points[cuboid_index_2],
-				_cuboid_ann_kd_tree[cuboid_index_2],
-				_squared_neighbor_distance, _sample_point_pairs);
+			tasks.push_back(SamplePointPairTask(
+				&_cuboid_sample_point_grids.get_sample_points(cuboid_index_1),
+				&_cuboid_sample_point_grids.get_sample_points(cuboid_index_2),
+				_cuboid_sample_point_grids.get_grid(cuboid_index_2)));
 
 			// 2 -> 1.
-			get_symmetric_sample_point_pairs(
-				_cuboids[cuboid_index_2],
-				_cuboid_ann_points[cuboid_index_1],
-				_cuboid_ann_kd_tree[cuboid_index_1],
-				_squared_neighbor_distance, _sample_point_pairs);
+			tasks.push_back(SamplePointPairTask(
+				&_cuboid_sample_point_grids.get_sample_points(cuboid_index_2),
+				&_cuboid_sample_point_grids.get_sample_points(cuboid_index_1),
+				_cuboid_sample_point_grids.get_grid(cuboid_index_1)));
 		}
 	}
+
+	get_symmetric_sample_point_pairs(tasks, _squared_neighbor_distance, _sample_point_pairs);
 }
 
 void MeshCuboidSymmetryGroup::get_symmetric_sample_point_pairs(
-	const MeshCuboid *_cuboid_1,
-	const ANNpointArray &_cuboid_ann_points_2,
-	ANNkd_tree *_cuboid_ann_kd_tree_2,
+	const Eigen::MatrixXd &_points_1,
+	const Eigen::MatrixXd &_points_2,
+	const PointHashGrid &_grid_2,
 	const Real _squared_neighbor_distance,
-	std::list<WeightedPointPair> &_sample_point_pairs) const
+	std::vector<WeightedPointPair> &_sample_point_pairs) const
 {
-	if (!_cuboid_1) return;
-	std::vector<MyMesh::Point> cuboid_1_sample_points;
-	_cuboid_1->get_sample_points(cuboid_1_sample_points);
+	assert(_grid_2.num_points() == _points_2.cols());
 
-	get_symmetric_sample_point_pairs(
-		cuboid_1_sample_points,
-		_cuboid_ann_points_2,
-		_cuboid_ann_kd_tree_2,
-		_squared_neighbor_distance,
-		_sample_point_pairs);
+	std::vector<SamplePointPairTask> tasks;
+	tasks.push_back(SamplePointPairTask(&_points_1, &_points_2, &_grid_2));
+	get_symmetric_sample_point_pairs(tasks, _squared_neighbor_distance, _sample_point_pairs);
 }
 
 void MeshCuboidSymmetryGroup::get_symmetric_sample_point_pairs(
-	const std::vector<MyMesh::Point> &_cuboid_1_sample_points,
-	const ANNpointArray &_cuboid_ann_points_2,
-	ANNkd_tree *_cuboid_ann_kd_tree_2,
+	const std::vector<SamplePointPairTask> &_tasks,
 	const Real _squared_neighbor_distance,
-	std::list<WeightedPointPair> &_sample_point_pairs) const
+	std::vector<WeightedPointPair> &_sample_point_pairs) const
 {
-	if (_cuboid_1_sample_points.size() == 0 || !_cuboid_ann_points_2 || !_cuboid_ann_kd_tree_2)
+	_sample_point_pairs.clear();
+	if (num_symmetry_orders_ < 2)
 		return;
 
-	const int num_points_1 = _cuboid_1_sample_points.size();
-	const int num_points_2 = _cuboid_ann_kd_tree_2->nPoints();
+	const unsigned int num_tasks = _tasks.size();
+	const unsigned int num_queries_per_point = num_symmetry_orders_ - 1;
+	const Real neighbor_distance = std::sqrt(_squared_neighbor_distance);
+	const Real rotation_angle = get_rotation_angle();
+
+	// Each query is a pair of a sample point and a symmetry order.
+	std::vector<unsigned int> task_query_offsets(num_tasks + 1, 0);
+	for (unsigned int task_index = 0; task_index < num_tasks; ++task_index)
+	{
+		const SamplePointPairTask &task = _tasks[task_index];
+		unsigned int num_task_queries = 0;
+		if (task.points_1_ && task.points_2_ && task.grid_2_)
+			num_task_queries = task.points_1_->cols() * num_queries_per_point;
+		task_query_offsets[task_index + 1] = task_query_offsets[task_index] + num_task_queries;
+	}
+
+	const int num_queries = task_query_offsets[num_tasks];
+	if (num_queries == 0)
+		return;
 
-	//
-	ANNpoint q = annAllocPt(3);
-	ANNidxArray nn_idx = new ANNidx[1];
-	ANNdistArray dd = new ANNdist[1];
-	//
+	// NOTE:
+	// Write results to a preallocated buffer and compact it afterwards,
+	// so that the order of pairs does not depend on the thread scheduling.
+	_sample_point_pairs.resize(num_queries);
+	std::vector<char> is_pair_found(num_queries, 0);
 
-	for (int point_index_1 = 0; point_index_1 < num_points_1; ++point_index_1)
+#pragma omp parallel for schedule(dynamic, 256)
+	for (int query_index = 0; query_index < num_queries; ++query_index)
 	{
-		MyMesh::Point point_1 = _cuboid_1_sample_points[point_index_1];
+		const unsigned int task_index = static_cast<unsigned int>(std::upper_bound(
+			task_query_offsets.begin(), task_query_offsets.end(), static_cast<unsigned int>(query_index))
+			- task_query_offsets.begin()) - 1;
+		assert(task_index < num_tasks);
+		const SamplePointPairTask &task = _tasks[task_index];
+
+		const unsigned int task_query_index = query_index - task_query_offsets[task_index];
+		const unsigned int point_index_1 = task_query_index / num_queries_per_point;
+		const unsigned int symmetry_order = task_query_index % num_queries_per_point + 1;
+
+		MyMesh::Point point_1;
+		for (unsigned int i = 0; i < 3; ++i)
+			point_1[i] = (*task.points_1_)(i, point_index_1);
+
+		MyMesh::Point symmetric_point_1 = get_symmetric_point(point_1, symmetry_order);
+		Eigen::Vector3d query;
+		for (unsigned int i = 0; i < 3; ++i)
+			query[i] = symmetric_point_1[i];
+
+		double point_distance = 0.0;
+		int point_index_2 = task.grid_2_->find_closest_point(query, neighbor_distance, &point_distance);
+		if (point_index_2 < 0)
+			continue;
 
-		for (int symmetry_order = 1; symmetry_order < num_symmetry_orders_; ++symmetry_order)
-		{
-			MyMesh::Point symmetric_point_1 = get_symmetric_point(point_1, symmetry_order);
+		assert(point_index_2 < task.points_2_->cols());
+		MyMesh::Point point_2;
+		for (unsigned int i = 0; i < 3; ++i)
+			point_2[i] = (*task.points_2_)(i, point_index_2);
 
-			for (unsigned int i = 0; i < 3; ++i)
-				q[i] = symmetric_point_1[i];
-
-			int num_searched_neighbors = _cuboid_ann_kd_tree_2->annkFRSearch(
-				q, _squared_neighbor_distance, 1, nn_idx, dd);
-			if (num_searched_neighbors > 0)
-			{
-				int point_index_2 = (int)nn_idx[0];
-				assert(point_index_2 < num_points_2);
-
-				MyMesh::Point point_2;
-				for (unsigned int i = 0; i < 3; ++i)
-					point_2[i] = _cuboid_ann_points_2[point_index_2][i];
-
-				//
-				// Debug.
-				Real test_distance = (symmetric_point_1 - point_2).norm();
-				CHECK_NUMERICAL_ERROR(__FUNCTION__, test_distance, std::sqrt(dd[0]));
-				double distance = (std::sqrt(_squared_neighbor_distance) - std::sqrt(dd[0]));
-				assert(distance >= 0);
-				//
-
-				Real weight = distance * distance;
-				Real angle = symmetry_order * get_rotation_angle();
-				WeightedPointPair point_pair(point_1, point_2, weight, angle);
-				_sample_point_pairs.push_back(point_pair);
-			}
-		}
+		double distance = (neighbor_distance - point_distance);
+		assert(distance >= 0);
+
+		Real weight = distance * distance;
+		Real angle = symmetry_order * rotation_angle;
+		_sample_point_pairs[query_index] = WeightedPointPair(point_1, point_2, weight, angle);
+		is_pair_found[query_index] = 1;
 	}
 
-	//
-	annDeallocPt(q);
-	delete[] nn_idx;
-	delete[] dd;
-	//
+	int num_pairs = 0;
+	for (int query_index = 0; query_index < num_queries; ++query_index)
+	{
+		if (!is_pair_found[query_index])
+			continue;
+
+		if (num_pairs != query_index)
+			_sample_point_pairs[num_pairs] = _sample_point_pairs[query_index];
+		++num_pairs;
+	}
+	_sample_point_pairs.resize(num_pairs);
 }
 
 MeshCuboidReflectionSymmetryGroup* MeshCuboidReflectionSymmetryGroup::constructor(
@@ -572,10 +674,12 @@ MyMesh::Normal MeshCuboidReflectionSymmetryGroup::get_symmetric_normal(const MyM
 
 MeshCuboidRotationSymmetryGroup* MeshCuboidRotationSymmetryGroup::constructor(
 	const MeshCuboidSymmetryGroupInfo &_info,
-	const std::vector<MeshCuboid *>& _cuboids)
+	const std::vector<MeshCuboid *>& _cuboids,
+	const Real _neighbor_distance)
 {
 	MeshCuboidRotationSymmetryGroup *group = new MeshCuboidRotationSymmetryGroup(_info);
-	bool ret = (group->compute_symmetry_axis(_cuboids) && group->compute_rotation_angle(_cuboids));
+	bool ret = (group->compute_symmetry_axis(_cuboids)
+		&& group->compute_rotation_angle(_cuboids, _neighbor_distance));
 	if (!ret)
 	{
 		delete group;
@@ -734,6 +838,12 @@ void MeshCuboidRotationSymmetryGroup::set_rotation_axis(const MyMesh::Normal &_n
 	n_.normalize();
 }
 
+void MeshCuboidRotationSymmetryGroup::set_num_symmetry_orders(const unsigned int _num_symmetry_orders)
+{
+	assert(_num_symmetry_orders >= 2);
+	num_symmetry_orders_ = _num_symmetry_orders;
+}
+
 void MeshCuboidRotationSymmetryGroup::get_rotation_axis_corners(
 	const MyMesh::Point &_point, const Real _size, std::array<MyMesh::Point, 2>& _corners) const
 {
@@ -765,44 +875,13 @@ void MeshCuboidRotationSymmetryGroup::compute_rotation_plane(
 }
 
 bool MeshCuboidRotationSymmetryGroup::compute_rotation_angle(
-	const std::vector<MeshCuboid *> &_cuboids)
+	const std::vector<MeshCuboid *> &_cuboids,
+	const Real _neighbor_distance)
 {
-	const Real squared_neighbor_distance = FLAGS_param_sparse_neighbor_distance
-		* FLAGS_param_sparse_neighbor_distance;
-	const unsigned int num_cuboids = _cuboids.size();
-
-	//
-	std::vector<ANNpointArray> cuboid_ann_points(num_cuboids);
-	std::vector<ANNkd_tree *> cuboid_ann_kd_tree(num_cuboids);
-
-	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
-	{
-		cuboid_ann_kd_tree[cuboid_index] = NULL;
-		cuboid_ann_points[cuboid_index] = NULL;
-
-		MeshCuboid *cuboid = _cuboids[cuboid_index];
-		unsigned int num_cuboid_sample_points = cuboid->num_sample_points();
-		if (num_cuboid_sample_points == 0)
-			continue;
+	const Real squared_neighbor_distance = _neighbor_distance * _neighbor_distance;
 
-		Eigen::MatrixXd cuboid_sample_points(3, num_cuboid_sample_points);
-
-		for (unsigned int point_index = 0; point_index < num_cuboid_sample_points; ++point_index)
-		{
-			for (unsigned int i = 0; i < 3; ++i)
-				cuboid_sample_points.col(point_index)(i) =
-				cuboid->get_sample_point(point_index)->point_[i];
-		}
-
-		cuboid_ann_kd_tree[cuboid_index] = ICP::create_kd_tree(cuboid_sample_points,
-			cuboid_ann_points[cuboid_index]);
-		assert(cuboid_ann_points[cuboid_index]);
-		assert(cuboid_ann_kd_tree[cuboid_index]);
-
-		assert(cuboid_ann_points.size() == num_cuboids);
-		assert(cuboid_ann_kd_tree.size() == num_cuboids);
-	}
-	//
+	MeshCuboidSamplePointGrids cuboid_sample_point_grids;
+	cuboid_sample_point_grids.update(_cuboids, _neighbor_distance);
 
 	std::vector<unsigned int> single_cuboid_indices;
 	get_single_cuboid_indices(_cuboids, single_cuboid_indices);
@@ -824,8 +903,8 @@ bool MeshCuboidRotationSymmetryGroup::compute_rotation_angle(
 
 		// Temporary set symmetry order.
 		num_symmetry_orders_ = num_symmetry_orders;
-		std::list<WeightedPointPair> sample_point_pairs;
-		get_symmetric_sample_point_pairs(_cuboids, cuboid_ann_points, cuboid_ann_kd_tree,
+		std::vector<WeightedPointPair> sample_point_pairs;
+		get_symmetric_sample_point_pairs(_cuboids, cuboid_sample_point_grids,
 			squared_neighbor_distance, sample_point_pairs);
 
 		Real num_point_pairs = sample_point_pairs.size();
@@ -842,16 +921,6 @@ bool MeshCuboidRotationSymmetryGroup::compute_rotation_angle(
 		}
 	}
 
-	//
-	for (unsigned int cuboid_index = 0; cuboid_index < num_cuboids; ++cuboid_index)
-	{
-		if (cuboid_ann_points[cuboid_index]) annDeallocPts(cuboid_ann_points[cuboid_index]);
-		if (cuboid_ann_kd_tree[cuboid_index]) delete cuboid_ann_kd_tree[cuboid_index];
-	}
-	cuboid_ann_points.clear();
-	cuboid_ann_kd_tree.clear();
-	//
-
 	num_symmetry_orders_ = best_num_symmetry_orders;
 	std::cout << "num_symmetry_orders = " << num_symmetry_orders_ << std::endl;
 
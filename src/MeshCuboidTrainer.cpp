@@ -8,7 +8,6 @@
 #include <sstream>
 #include <Eigen/Core>
 #include <Eigen/LU>
-#include <QFileInfo>
 
 
 Eigen::MatrixXd regularized_inverse(const Eigen::MatrixXd& _mat)
@@ -85,8 +84,7 @@ bool MeshCuboidTrainer::load_features(const std::string &_filename_prefix)
 		sstr << _filename_prefix << cuboid_index << std::string(".csv");
 		std::string attributes_filename = sstr.str();
 
-		QFileInfo attributes_file(attributes_filename.c_str());
-		if (!attributes_file.exists())
+		if (!std::ifstream(attributes_filename.c_str()))
 			break;
 
 		std::cout << "Loading '" << attributes_filename << "'..." << std::endl;
@@ -119,8 +117,7 @@ bool MeshCuboidTrainer::load_transformations(const std::string &_filename_prefix
 		std::stringstream  transformation_filename_sstr;
 		transformation_filename_sstr << _filename_prefix << cuboid_index << std::string(".csv");
 
-		QFileInfo transformation_file(transformation_filename_sstr.str().c_str());
-		if (!transformation_file.exists())
+		if (!std::ifstream(transformation_filename_sstr.str().c_str()))
 			break;
 
 		std::cout << "Loading '" << transformation_filename_sstr.str() << "'..." << std::endl;
@@ -654,8 +651,7 @@ void MeshCuboidTrainer::load_joint_normal_relations(
 				<< label_index_1 << std::string("_")
 				<< label_index_2 << std::string(".csv");
 
-			QFileInfo relation_file(relation_filename_sstr.str().c_str());
-			if (!relation_file.exists()) continue;
+			if (!std::ifstream(relation_filename_sstr.str().c_str())) continue;
 
 			_relations[label_index_1][label_index_2] = new MeshCuboidJointNormalRelations();
 			bool ret = _relations[label_index_1][label_index_2]->load_joint_normal_csv(
@@ -695,8 +691,7 @@ void MeshCuboidTrainer::load_cond_normal_relations(
 				<< label_index_1 << std::string("_")
 				<< label_index_2 << std::string(".csv");
 
-			QFileInfo relation_file(relation_filename_sstr.str().c_str());
-			if (!relation_file.exists()) continue;
+			if (!std::ifstream(relation_filename_sstr.str().c_str())) continue;
 
 			_relations[label_index_1][label_index_2] = new MeshCuboidCondNormalRelations();
 			bool ret = _relations[label_index_1][label_index_2]->load_cond_normal_csv(
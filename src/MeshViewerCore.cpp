@@ -1,6 +1,7 @@
 #include "MeshViewerCore.h"
 
 #include "MeshCuboidParameters.h"
+#include "TraceRecorder.h"
 
 #include <QColor>
 #include "glut_geometry.h"
@@ -601,6 +602,22 @@ void draw_cylinder(MyMesh::Point _p1, MyMesh::Point _p2, GLdouble _arrow_size)
 	glPolygonMode(GL_BACK, polygon_mode[1]);
 }
 
+void MeshViewerCore::draw_cuboid(const MeshCuboid *_cuboid)
+{
+	assert(_cuboid);
+	for (unsigned int face_index = 0; face_index < MeshCuboid::k_num_faces; ++face_index)
+	{
+		glBegin(GL_QUADS);
+		for (unsigned int i = 0; i < MeshCuboid::k_num_face_corners; ++i)
+		{
+			unsigned int corner_index = MeshCuboid::k_face_corner_indices[face_index][i];
+			MyMesh::Point corner = _cuboid->get_bbox_corner(corner_index);
+			glVertex3f(corner[0], corner[1], corner[2]);
+		}
+		glEnd();
+	}
+}
+
 void MeshViewerCore::draw_scene(const std::string& _draw_mode)
 {
 	MeshViewerCoreT<MyMesh>::draw_scene(_draw_mode);
@@ -795,8 +812,8 @@ void MeshViewerCore::draw_openmesh(const std::string& _drawmode)
 						Real radius = 0.0;
 						if (cuboid_structure_.query_label_index_ < cuboid_structure_.num_labels())
 						{
-							assert(sample_point->label_index_confidence_.size() == cuboid_structure_.num_labels());
-							radius = sample_point->label_index_confidence_[cuboid_structure_.query_label_index_];
+							radius = cuboid_structure_.sample_label_confidences_.get(
+								sample_point->sample_point_index_, cuboid_structure_.query_label_index_);
 						}
 
 						if (radius > 0)
@@ -925,14 +942,14 @@ void MeshViewerCore::draw_openmesh(const std::string& _drawmode)
 				glEnable(GL_BLEND);
 				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 				//draw_box(cuboid->get_bbox_corners());
-				cuboid->draw_cuboid();
+				draw_cuboid(cuboid);
 				glDisable(GL_BLEND);
 
 				glColor4f(0.0f, 0.0f, 0.0f, 1.0f);
 				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 				glLineWidth(8.0f);
 				//draw_box(cuboid->get_bbox_corners());
-				cuboid->draw_cuboid();
+				draw_cuboid(cuboid);
 				glLineWidth(1.0f);
 			}
 		}
@@ -1307,6 +1324,9 @@ void MeshViewerCore::draw_openmesh(const std::string& _drawmode)
 
 void MeshViewerCore::remove_occluded_points()
 {
+	TraceScope trace_scope("remove_occluded_points");
+	trace_scope.add_arg("points", cuboid_structure_.num_sample_points());
+
 	std::string curr_draw_mode = getDrawMode();
 	setDrawMode(FACE_INDEX_RENDERING);
 
@@ -1352,7 +1372,8 @@ void MeshViewerCore::remove_occluded_points()
 
 	// Test 2D view plane mask for occlusion.
 	//
-	if (FLAGS_use_view_plane_mask && num_sample_points > 0)
+	const MeshCuboidParameters &params = cuboid_structure_.get_parameters();
+	if (params.use_view_plane_mask_ && num_sample_points > 0)
 	{
 		std::vector<MyMesh::Point> sample_points(num_sample_points);
 		for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points;
@@ -1365,7 +1386,7 @@ void MeshViewerCore::remove_occluded_points()
 
 		std::list<SamplePointIndex> occluded_sample_point_indices;
 		MeshCuboid::compute_view_plane_mask_visibility(modelview_matrix(),
-			sample_points, occluded_sample_point_indices);
+			sample_points, params, occluded_sample_point_indices);
 		for (std::list<SamplePointIndex>::iterator it = occluded_sample_point_indices.begin();
 			it != occluded_sample_point_indices.end(); ++it)
 		{
@@ -1,11 +1,21 @@
 #include "MyMesh.h"
+#include "BinaryIO.h"
+#include "MeshCuboidParameters.h"
+#include "MeshCuboidPreprocessingCache.h"
 #include "simplerandom.h"
 //#include "ConvertFromOpenMesh.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <limits>
-#include <QColor>
+#include <sstream>
+
+
+#define MESH_CACHE_BINARY_MAGIC		0x4853454D	// "MESH"
+#define MESH_CACHE_BINARY_VERSION	2
 
 
 MyMesh::MyMesh()
@@ -109,17 +119,65 @@ void MyMesh::initialize(bool _verbose)
 	//delete[] referenced_vertex;
 
 	//make_face_normal_consistent();
-	
+
+	preprocess(false, false, false, _verbose);
+}
+
+void MyMesh::preprocess(const bool _update_face_normals, const bool _update_vertex_normals,
+	const bool _make_face_normal_consistent, bool _verbose)
+{
 	clear_colors();
 
-	// Compute bounding box.
-	MyMesh::Point bbox_min, bbox_max;
-	bbox_min = bbox_max = OpenMesh::vector_cast<MyMesh::Point>(point(vertices_begin()));
+	const int num_vertices = static_cast<int>(n_vertices());
+	const int num_faces = static_cast<int>(n_faces());
 
-	for (ConstVertexIter v_it = vertices_begin(); v_it != vertices_end(); ++v_it)
+	// NOTE:
+	// The face normals are required for the vertex normals, and they are not changed
+	// by the normalization below (uniform scaling and translation).
+	if (_update_face_normals)
 	{
-		bbox_min.minimize(OpenMesh::vector_cast<MyMesh::Point>(point(v_it)));
-		bbox_max.maximize(OpenMesh::vector_cast<MyMesh::Point>(point(v_it)));
+#pragma omp parallel for
+		for (int fid = 0; fid < num_faces; ++fid)
+		{
+			FaceHandle fh = face_handle(fid);
+			set_normal(fh, calc_face_normal(fh));
+		}
+	}
+
+	// NOTE:
+	// The vertex normals are also updated if any face normal is inverted.
+	bool update_vertex_normals = _update_vertex_normals;
+	if (_make_face_normal_consistent)
+	{
+		const unsigned int num_inverted_faces = orient_face_normals();
+		if (_verbose) std::cout << num_inverted_faces << " face normals are inverted." << std::endl;
+		if (num_inverted_faces > 0) update_vertex_normals = true;
+	}
+
+	// Compute bounding box (and vertex normals).
+	MyMesh::Point bbox_min(std::numeric_limits<Real>::max());
+	MyMesh::Point bbox_max(-std::numeric_limits<Real>::max());
+
+#pragma omp parallel
+	{
+		MyMesh::Point thread_bbox_min(bbox_min), thread_bbox_max(bbox_max);
+
+#pragma omp for
+		for (int vid = 0; vid < num_vertices; ++vid)
+		{
+			VertexHandle vh = vertex_handle(vid);
+			thread_bbox_min.minimize(point(vh));
+			thread_bbox_max.maximize(point(vh));
+
+			if (update_vertex_normals)
+				set_normal(vh, compute_vertex_normal(vh));
+		}
+
+#pragma omp critical
+		{
+			bbox_min.minimize(thread_bbox_min);
+			bbox_max.maximize(thread_bbox_max);
+		}
 	}
 
 	bbox_center_ = 0.5 * (bbox_min + bbox_max);
@@ -127,27 +185,36 @@ void MyMesh::initialize(bool _verbose)
 
 
 	// Compute object diameter.
-	object_diameter_ = 0.0;
+	Real max_squared_distance = 0.0;
 
-	for (ConstVertexIter v_it = vertices_begin(); v_it != vertices_end(); ++v_it)
+#pragma omp parallel
 	{
-		Real distance = (point(v_it) - bbox_center_).length();
-		object_diameter_ = std::max(object_diameter_, distance);
+		Real thread_max_squared_distance = 0.0;
+
+#pragma omp for
+		for (int vid = 0; vid < num_vertices; ++vid)
+		{
+			const Real squared_distance = (point(vertex_handle(vid)) - bbox_center_).sqrnorm();
+			thread_max_squared_distance = std::max(thread_max_squared_distance, squared_distance);
+		}
+
+#pragma omp critical
+		max_squared_distance = std::max(max_squared_distance, thread_max_squared_distance);
 	}
 
-	object_diameter_ = 2 * object_diameter_;
+	object_diameter_ = 2 * std::sqrt(max_squared_distance);
 
 
 	// NOTE:
 	// Change scale so that the object diameter becomes 1.
 	if (_verbose) std::cout << "Object diameter: " << get_object_diameter() << std::endl;
 	if (_verbose) std::cout << "Now scaled to become 1..." << std::endl;
-	scale(1.0 / get_object_diameter());
+	const Real scale = 1.0 / get_object_diameter();
 
 	// Move mesh so that the object stands on the z = 0 plane.
-	MyMesh::Point translation = -get_bbox_center();
-	translation[2] += 0.5 * get_bbox_size()[2];
-	translate(translation);
+	MyMesh::Point translation = -(get_bbox_center() * scale);
+	translation[2] += 0.5 * (get_bbox_size()[2] * scale);
+	scale_and_translate(scale, translation);
 }
 
 bool MyMesh::open_mesh(const char *_filename, bool _verbose)
@@ -158,20 +225,35 @@ bool MyMesh::open_mesh(const char *_filename, bool _verbose)
 	request_vertex_colors();
 	request_vertex_texcoords2D();
 
+	std::string cache_filename;
+	if (FLAGS_mesh_cache_dir != "")
+	{
+		// NOTE:
+		// The key is the hash of the file contents (and the cache version and the options).
+		MeshCuboidPreprocessingCache mesh_cache(FLAGS_mesh_cache_dir);
+		if (mesh_cache.add_file(_filename))
+		{
+			mesh_cache.add_value(static_cast<uint32_t>(MESH_CACHE_BINARY_VERSION));
+			mesh_cache.add_value(FLAGS_make_face_normal_consistent);
+			cache_filename = FLAGS_mesh_cache_dir + std::string("/") + mesh_cache.get_key() + std::string(".mesh");
+
+			if (load_mesh_cache(cache_filename, _verbose))
+				return true;
+		}
+	}
+
 	if (_verbose) std::cout << "Loading from file '" << _filename << "'\n";
 	bool ret = OpenMesh::IO::read_mesh(*this, _filename, options_);
 	if (!ret) return false;
 
 	// update face and vertex normals     
-	if (!options_.check(OpenMesh::IO::Options::FaceNormal))
-		update_face_normals();
-	else if (_verbose)
+	const bool update_face_normals = !options_.check(OpenMesh::IO::Options::FaceNormal);
+	if (!update_face_normals && _verbose)
 		std::cout << "File provides face normals\n";
 	assert(has_face_normals());
 
-	if (!options_.check(OpenMesh::IO::Options::VertexNormal))
-		update_vertex_normals();
-	else if (_verbose)
+	const bool update_vertex_normals = !options_.check(OpenMesh::IO::Options::VertexNormal);
+	if (!update_vertex_normals && _verbose)
 		std::cout << "File provides vertex normals\n";
 	assert(has_vertex_normals());
 
@@ -190,7 +272,196 @@ bool MyMesh::open_mesh(const char *_filename, bool _verbose)
 		&& _verbose)
 		std::cout << "File provides texture coordinates\n";
 
-	initialize(_verbose);
+	// NOTE:
+	// The normals are computed in the same passes with the normalization.
+	preprocess(update_face_normals, update_vertex_normals,
+		FLAGS_make_face_normal_consistent, _verbose);
+
+	if (cache_filename != "")
+		save_mesh_cache(cache_filename);
+
+	return true;
+}
+
+bool MyMesh::load_mesh_cache(const std::string &_filename, bool _verbose)
+{
+	std::ifstream file(_filename.c_str(), std::ios::binary);
+	if (!file)
+		return false;
+
+	if (!BinaryIO::read_header(file, MESH_CACHE_BINARY_MAGIC, MESH_CACHE_BINARY_VERSION))
+	{
+		std::cerr << "Warning: Invalid mesh cache file (" << _filename << ")." << std::endl;
+		return false;
+	}
+
+	if (_verbose) std::cout << "Loading from cache file '" << _filename << "'\n";
+
+	bool ret = true;
+	uint32_t options = 0;
+	std::vector<MyMesh::Point> points;
+	std::vector<int32_t> face_vertex_indices;
+	std::vector<MyMesh::Normal> vertex_normals, face_normals;
+	std::vector<MyMesh::TexCoord2D> texcoords;
+
+	ret = ret && BinaryIO::read(file, options);
+	ret = ret && BinaryIO::read(file, points);
+	ret = ret && BinaryIO::read(file, face_vertex_indices);
+	ret = ret && BinaryIO::read(file, vertex_normals);
+	ret = ret && BinaryIO::read(file, face_normals);
+	ret = ret && BinaryIO::read(file, texcoords);
+
+	MyMesh::Point bbox_center, translation;
+	MyMesh::Normal bbox_size;
+	Real object_diameter = 0.0, scale = 1.0;
+	ret = ret && BinaryIO::read(file, bbox_center);
+	ret = ret && BinaryIO::read(file, bbox_size);
+	ret = ret && BinaryIO::read(file, object_diameter);
+	ret = ret && BinaryIO::read(file, translation);
+	ret = ret && BinaryIO::read(file, scale);
+
+	const size_t num_vertices = points.size();
+	const size_t num_faces = face_vertex_indices.size() / 3;
+	ret = ret && (face_vertex_indices.size() == 3 * num_faces);
+	ret = ret && (vertex_normals.size() == num_vertices);
+	ret = ret && (face_normals.size() == num_faces);
+	ret = ret && (texcoords.empty() || texcoords.size() == num_vertices);
+	for (std::vector<int32_t>::const_iterator it = face_vertex_indices.begin();
+		ret && it != face_vertex_indices.end(); ++it)
+		ret = ret && ((*it) >= 0 && static_cast<size_t>(*it) < num_vertices);
+
+	if (!ret)
+	{
+		std::cerr << "Warning: Invalid mesh cache file (" << _filename << ")." << std::endl;
+		return false;
+	}
+
+	clear();
+	reserve(num_vertices, 3 * num_faces / 2, num_faces);
+
+	for (size_t vid = 0; vid < num_vertices; ++vid)
+		add_vertex(points[vid]);
+
+	for (size_t fid = 0; fid < num_faces; ++fid)
+	{
+		FaceHandle fh = add_face(
+			vertex_handle(face_vertex_indices[3 * fid + 0]),
+			vertex_handle(face_vertex_indices[3 * fid + 1]),
+			vertex_handle(face_vertex_indices[3 * fid + 2]));
+
+		// NOTE:
+		// The faces are the ones added when the file was read, and thus they should be valid.
+		if (!fh.is_valid())
+		{
+			std::cerr << "Warning: Invalid mesh cache file (" << _filename << ")." << std::endl;
+			clear();
+			return false;
+		}
+	}
+
+	for (size_t vid = 0; vid < num_vertices; ++vid)
+		set_normal(vertex_handle(vid), vertex_normals[vid]);
+	for (size_t fid = 0; fid < num_faces; ++fid)
+		set_normal(face_handle(fid), face_normals[fid]);
+	for (size_t vid = 0; vid < texcoords.size(); ++vid)
+		set_texcoord2D(vertex_handle(vid), texcoords[vid]);
+
+	options_ = OpenMesh::IO::Options(options);
+	if (!options_.check(OpenMesh::IO::Options::VertexColor))
+		release_vertex_colors();
+	if (!options_.check(OpenMesh::IO::Options::FaceColor))
+		release_face_colors();
+
+	clear_colors();
+
+	bbox_center_ = bbox_center;
+	bbox_size_ = bbox_size;
+	object_diameter_ = object_diameter;
+	translation_ = translation;
+	scale_ = scale;
+
+	if (_verbose) std::cout << "Object diameter: " << object_diameter_ / scale_ << std::endl;
+	return true;
+}
+
+bool MyMesh::save_mesh_cache(const std::string &_filename) const
+{
+	const int num_vertices = static_cast<int>(n_vertices());
+	const int num_faces = static_cast<int>(n_faces());
+
+	std::vector<MyMesh::Point> points(num_vertices);
+	std::vector<MyMesh::Normal> vertex_normals(num_vertices);
+	std::vector<int32_t> face_vertex_indices(3 * num_faces);
+	std::vector<MyMesh::Normal> face_normals(num_faces);
+	std::vector<MyMesh::TexCoord2D> texcoords;
+
+	for (int vid = 0; vid < num_vertices; ++vid)
+	{
+		VertexHandle vh = vertex_handle(vid);
+		points[vid] = point(vh);
+		vertex_normals[vid] = normal(vh);
+	}
+
+	for (int fid = 0; fid < num_faces; ++fid)
+	{
+		FaceHandle fh = face_handle(fid);
+		ConstFaceVertexIter fv_it = cfv_iter(fh);
+		for (unsigned int i = 0; fv_it && i < 3; ++fv_it, ++i)	// Trimesh
+			face_vertex_indices[3 * fid + i] = fv_it.handle().idx();
+		face_normals[fid] = normal(fh);
+	}
+
+	if (options_.check(OpenMesh::IO::Options::VertexTexCoord))
+	{
+		texcoords.resize(num_vertices);
+		for (int vid = 0; vid < num_vertices; ++vid)
+			texcoords[vid] = texcoord2D(vertex_handle(vid));
+	}
+
+	// NOTE:
+	// Write a temporary file first so that concurrent jobs never read a partial file.
+	const std::string temp_filename = MeshCuboidPreprocessingCache::get_temp_filename(_filename);
+
+	{
+		std::ofstream file(temp_filename.c_str(), std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "Warning: Cannot save the mesh cache file (" << temp_filename << ")." << std::endl;
+			return false;
+		}
+
+		BinaryIO::write_header(file, MESH_CACHE_BINARY_MAGIC, MESH_CACHE_BINARY_VERSION);
+		BinaryIO::write(file, static_cast<uint32_t>(options_));
+		BinaryIO::write(file, points);
+		BinaryIO::write(file, face_vertex_indices);
+		BinaryIO::write(file, vertex_normals);
+		BinaryIO::write(file, face_normals);
+		BinaryIO::write(file, texcoords);
+
+		BinaryIO::write(file, bbox_center_);
+		BinaryIO::write(file, bbox_size_);
+		BinaryIO::write(file, object_diameter_);
+		BinaryIO::write(file, translation_);
+		BinaryIO::write(file, scale_);
+
+		if (!file.good())
+		{
+			std::cerr << "Warning: Cannot save the mesh cache file (" << temp_filename << ")." << std::endl;
+			file.close();
+			std::remove(temp_filename.c_str());
+			return false;
+		}
+	}
+
+#ifdef _WIN32
+	std::remove(_filename.c_str());
+#endif
+	if (std::rename(temp_filename.c_str(), _filename.c_str()) != 0)
+	{
+		std::remove(temp_filename.c_str());
+		return false;
+	}
+
 	return true;
 }
 
@@ -309,33 +580,45 @@ void MyMesh::release_curvatures()
 
 void MyMesh::translate(const Normal _translate)
 {
-	for (MyMesh::ConstVertexIter v_it = vertices_begin(); v_it != vertices_end(); ++v_it)
-	{
-		MyMesh::Point &p = point(v_it.handle());
-		p = p + _translate;
-	}
-
-	translation_ += _translate;
-	bbox_center_ += _translate;
+	scale_and_translate(1.0, _translate);
 }
 
 void MyMesh::scale(const Real _scale)
+{
+	scale_and_translate(_scale, MyMesh::Normal(0.0));
+}
+
+void MyMesh::scale_and_translate(const Real _scale, const Normal _translate)
 {
 	assert(_scale > 0);
-	for (MyMesh::ConstVertexIter v_it = vertices_begin();
-		v_it != vertices_end(); ++v_it)
+	const int num_vertices = static_cast<int>(n_vertices());
+
+#pragma omp parallel for
+	for (int vid = 0; vid < num_vertices; ++vid)
 	{
-		MyMesh::Point &p = point(v_it.handle());
-		p = p * _scale;
+		MyMesh::Point &p = point(vertex_handle(vid));
+		p = p * _scale + _translate;
 	}
 
 	scale_ *= _scale;
-	translation_ *= _scale;
-	bbox_center_ *= _scale;
+	translation_ = translation_ * _scale + _translate;
+	bbox_center_ = bbox_center_ * _scale + _translate;
 	bbox_size_ *= _scale;
 	object_diameter_ *= _scale;
 }
 
+MyMesh::Normal MyMesh::compute_vertex_normal(const VertexHandle _vh) const
+{
+	// Same with 'update_vertex_normals()'.
+	MyMesh::Normal vertex_normal(0.0);
+	for (ConstVertexFaceIter vf_it = cvf_iter(_vh); vf_it; ++vf_it)
+		vertex_normal += normal(vf_it.handle());
+
+	const Real length = vertex_normal.length();
+	if (length != 0) vertex_normal *= (1.0 / length);
+	return vertex_normal;
+}
+
 void MyMesh::reset_transformation()
 {
 	if (translation_ != MyMesh::Point(0.0) || scale_ != 1.0)
@@ -842,7 +1125,7 @@ MyMesh::Color MyMesh::get_label_color(const Label _label)
 	// Reference:
 	// http://martin.ankerl.com/2009/12/09/how-to-create-random-colors-programmatically/
 
-	static SimpleRandomCong_t rng_cong;
+	SimpleRandomCong_t rng_cong;
 	simplerandom_cong_seed(&rng_cong, LABEL_COLORING_RANDOM_SEED);
 	float h = static_cast<float>(simplerandom_cong_next(&rng_cong))
 		/ std::numeric_limits<uint32_t>::max();
@@ -852,9 +1135,12 @@ MyMesh::Color MyMesh::get_label_color(const Label _label)
 		h += golden_ratio_conjugate;
 	h = fmod(h, 1.0f);
 
-	QColor color;
-	color.setHsvF(h, 0.9, 0.9);
-	MyMesh::Color label_color(color.red(), color.green(), color.blue());
+	Real r, g, b;
+	hsv_to_rgb_color(h, 0.9, 0.9, r, g, b);
+	MyMesh::Color label_color(
+		static_cast<unsigned char>(r * 255 + 0.5),
+		static_cast<unsigned char>(g * 255 + 0.5),
+		static_cast<unsigned char>(b * 255 + 0.5));
 
 	//static SimpleRandomCong_t rng_cong;
 	//simplerandom_cong_seed(&rng_cong, LABEL_COLORING_RANDOM_SEED * _label);
@@ -872,20 +1158,38 @@ MyMesh::Color MyMesh::get_label_color(const Label _label)
 	return label_color;
 }
 
+void MyMesh::hsv_to_rgb_color(const Real _h, const Real _s, const Real _v,
+	Real &_r, Real &_g, Real &_b)
+{
+	// Assume that all input and output values have range [0, 1].
+	Real h = 6.0 * (_h - std::floor(_h));
+	int sector = std::min(static_cast<int>(h), 5);
+	Real f = h - sector;
+
+	Real p = _v * (1.0 - _s);
+	Real q = _v * (1.0 - _s * f);
+	Real t = _v * (1.0 - _s * (1.0 - f));
+
+	switch (sector)
+	{
+	case 0: _r = _v; _g = t; _b = p; break;
+	case 1: _r = q; _g = _v; _b = p; break;
+	case 2: _r = p; _g = _v; _b = t; break;
+	case 3: _r = p; _g = q; _b = _v; break;
+	case 4: _r = t; _g = p; _b = _v; break;
+	default: _r = _v; _g = p; _b = q; break;
+	}
+}
+
 void MyMesh::gray_to_rgb_color(const Real _gray, Real &_r, Real &_g, Real &_b)
 {
 	// Assume that the input gray value and the output RGB value has range [0, 1].
 	Real value = std::min(std::max(_gray, 0.0), 1.0);
 	value = 1.0 - value;
 
-	QColor color;
 	// (hue = 0 -> red, hue = 240 -> blue);
 	int hue = static_cast<int>(value * 240);
-	color.setHsv(hue, 255, 255);
-
-	_r = static_cast<Real>(color.red()) / 255.0;
-	_g = static_cast<Real>(color.green()) / 255.0;
-	_b = static_cast<Real>(color.blue()) / 255.0;
+	hsv_to_rgb_color(hue / 360.0, 1.0, 1.0, _r, _g, _b);
 
 	/*
 	// Inverse gray value.
@@ -1135,205 +1439,176 @@ void MyMesh::extract_zero_value_feature_vertices(const RealArray &_values,
 	}
 }
 
-typedef enum {
-	SUBSET_A = 0,
-	SUBSET_B = 1,
-	VERIFIED = 2,
-	NOT_VISITED = 3,
-} FaceTraversal;
-
 void MyMesh::make_face_normal_consistent()
 {
 	request_face_normals();
 
-	int num_edges = n_edges();
-	int num_faces = n_faces();
+	const unsigned int num_inverted_faces = orient_face_normals();
 
-	bool *is_edge_inverted = new bool[num_edges];
-	memset(is_edge_inverted, false, num_edges * sizeof(bool));
+	if (num_inverted_faces > 0 && has_vertex_normals())
+	{
+		const int num_vertices = static_cast<int>(n_vertices());
 
+#pragma omp parallel for
+		for (int vid = 0; vid < num_vertices; ++vid)
+		{
+			VertexHandle vh = vertex_handle(vid);
+			set_normal(vh, compute_vertex_normal(vh));
+		}
+	}
 
-	// Step #1: Check inverted adjacent face normals.
-	for (EdgeIndex eid = 0; eid < num_edges; eid++)
-	{
-		EdgeHandle eh = edge_handle(eid);
+	std::cout << num_inverted_faces << " face normals are inverted." << std::endl;
+}
 
-		// Vertices on the adjacent edge.
-		VertexHandle vh[2];	
-		FaceHandle fh[2];
+unsigned int MyMesh::orient_face_normals()
+{
+	assert(has_face_normals());
 
-		// Face normals.
-		Normal n[2];	
+	const int num_vertices = static_cast<int>(n_vertices());
+	const int num_faces = static_cast<int>(n_faces());
+	const int num_face_edges = 3 * num_faces;	// Trimesh
 
-		// Vertices that are NOT on the adjacent edge, but on the opposite sides.
-		// Original Positions.
-		Point p[2];			
 
+	// NOTE:
+	// Mesh readers duplicate the vertices of faces that cannot be added
+	// with the orientation of their neighbors. Such faces are connected again
+	// by welding the vertices at the same position.
+	std::vector< std::pair<MyMesh::Point, VertexIndex> > sorted_vertices(num_vertices);
+	for (int vid = 0; vid < num_vertices; ++vid)
+		sorted_vertices[vid] = std::make_pair(point(vertex_handle(vid)), vid);
+	std::sort(sorted_vertices.begin(), sorted_vertices.end());
+
+	VertexIndexArray welded_vertex_indices(num_vertices);
+	for (int i = 0; i < num_vertices; ++i)
+	{
+		const VertexIndex vid = sorted_vertices[i].second;
+		if (i > 0 && sorted_vertices[i].first == sorted_vertices[i - 1].first)
+			welded_vertex_indices[vid] = welded_vertex_indices[sorted_vertices[i - 1].second];
+		else
+			welded_vertex_indices[vid] = vid;
+	}
 
-		// NOTE:
-		// When assuming that two normal vectors are the same,
-		// two faces are on the same plane.
-		// Let assume that this plane is projected 2D plane,
-		// and vh[0] is the origin, and (vh[1]-vh[0]) is y-axis direction.
 
-		// Position with local coordinates.
-		Point proj_p[2];	
-		bool ret;
+	// Face vertices, and whether each face normal follows the order of the face vertices.
+	VertexIndexArray face_vertex_indices(num_face_edges, -1);
+	std::vector<char> is_normal_along_face_vertices(num_faces, 1);
 
-		for (unsigned int i = 0; i < 2; i++)
-		{
-			vh[i] = from_vertex_handle(halfedge_handle(eh, i));
-			fh[i] = face_handle(halfedge_handle(eh, i));
-			if (fh[i].idx() >= 0)	n[i] = normal(fh[i]);
-		}
+#pragma omp parallel for
+	for (int fid = 0; fid < num_faces; ++fid)
+	{
+		FaceHandle fh = face_handle(fid);
+		ConstFaceVertexIter fv_it = cfv_iter(fh);
+		for (unsigned int i = 0; fv_it && i < 3; ++fv_it, ++i)	// Trimesh
+			face_vertex_indices[3 * fid + i] = welded_vertex_indices[fv_it.handle().idx()];
 
-		if (vh[0].idx() < 0 || vh[1].idx() < 0
-			|| fh[0].idx() < 0 || fh[1].idx() < 0)
-			continue;
+		is_normal_along_face_vertices[fid] = (dot(normal(fh), calc_face_normal(fh)) >= 0);
+	}
 
-		Normal dir = (point(vh[1]) - point(vh[0])).normalize();
 
-		for (unsigned int i = 0; i < 2; i++)
-		{
-			ret = false;
-			for (ConstFaceVertexIter fv_it = cfv_iter(fh[i]); fv_it; ++fv_it)
-			{
-				if (fv_it.handle() != vh[0] && fv_it.handle() != vh[1])
-				{
-					p[i] = point(fv_it.handle());
-					ret = true;
-					break;
-				}
-			}
-			assert(ret);
+	// Step #1: Find adjacent faces and check inverted adjacent face normals.
+	// Face edge (3 * fid + i) is from the i-th vertex to the next vertex of the face.
+	// Face edges are sorted by their (undirected) end vertices so that
+	// the face edges on the same mesh edge are consecutive.
+	std::vector< std::pair<std::pair<VertexIndex, VertexIndex>, int> > sorted_face_edges(num_face_edges);
 
-			Normal v = p[i] - point(vh[0]);
+#pragma omp parallel for
+	for (int feid = 0; feid < num_face_edges; ++feid)
+	{
+		const VertexIndex v1 = face_vertex_indices[feid];
+		const VertexIndex v2 = face_vertex_indices[3 * (feid / 3) + NEXT(feid % 3)];
+		sorted_face_edges[feid] = std::make_pair(
+			std::make_pair(std::min(v1, v2), std::max(v1, v2)), feid);
+	}
+	std::sort(sorted_face_edges.begin(), sorted_face_edges.end());
 
-			// Projection (parallel) -> y
-			Real y = dot(v, dir);
-			Real x = sqrt(v.sqrnorm() - y*y);
+	std::vector<int> mesh_edge_offsets;
+	for (int i = 0; i < num_face_edges; ++i)
+		if (i == 0 || sorted_face_edges[i].first != sorted_face_edges[i - 1].first)
+			mesh_edge_offsets.push_back(i);
+	mesh_edge_offsets.push_back(num_face_edges);
 
-			proj_p[i] = Point(x, y, 0);
-		}
+	// Flat face adjacency. Face edges on boundary or non-manifold mesh edges have no neighbor (-1).
+	FaceIndexArray face_edge_neighbors(num_face_edges, -1);
+	std::vector<char> is_face_edge_inverted(num_face_edges, 0);
+	const int num_mesh_edges = static_cast<int>(mesh_edge_offsets.size()) - 1;
+
+#pragma omp parallel for
+	for (int eid = 0; eid < num_mesh_edges; ++eid)
+	{
+		if (mesh_edge_offsets[eid + 1] - mesh_edge_offsets[eid] != 2)
+			continue;
 
-		Real dist = (p[1] - p[0]).norm();
-		Real cos_angle = dot(n[0], n[1]);
-		Real sin_angle = sqrt(1 - cos_angle*cos_angle);
-		Point folded_p1;
-
-
-		// Now, compute how p[1] is moved by two normal vectors.
-		// The face f[1] is flipped by the normal difference (flipping axis is y-axis).
-		folded_p1 = Point(
-			cos_angle*proj_p[1][0],		// cos
-			proj_p[1][1],
-			sin_angle*proj_p[1][0]		// sin
-			);
-
-		// Estimated distance using current normal vectors.
-		Real curr_normal_dist = (folded_p1 - proj_p[0]).norm();
-		Real curr_normal_diff = curr_normal_dist - dist;
-
-		// Consider the case that one of normal vector is inverted.
-		// (angle) -> (-angle), (cos) -> (-cos), (sin) -> (sin)
-		folded_p1 = Point(
-			-cos_angle*proj_p[1][0],	// -cos
-			proj_p[1][1],
-			sin_angle*proj_p[1][0]		// sin
-			);
-
-		// Estimated distance using flipped current normal vectors.
-		Real flip_normal_dist = (folded_p1 - proj_p[0]).norm();
-		Real flip_normal_diff = flip_normal_dist - dist;
-
-		if (curr_normal_diff > flip_normal_diff)
-			is_edge_inverted[eid] = true;
+		const int feid_1 = sorted_face_edges[mesh_edge_offsets[eid]].second;
+		const int feid_2 = sorted_face_edges[mesh_edge_offsets[eid] + 1].second;
+		const FaceIndex fid_1 = feid_1 / 3, fid_2 = feid_2 / 3;
+		const VertexIndex v1 = face_vertex_indices[feid_1];
+		if (fid_1 == fid_2 || v1 == face_vertex_indices[3 * fid_1 + NEXT(feid_1 % 3)])
+			continue;
+
+		// NOTE:
+		// Two faces have the same orientation if they traverse the edge in opposite directions.
+		const bool is_same_orientation = (v1 != face_vertex_indices[feid_2]);
+		const bool is_same_normal_side = (is_normal_along_face_vertices[fid_1]
+			== is_normal_along_face_vertices[fid_2]);
+
+		face_edge_neighbors[feid_1] = fid_2;
+		face_edge_neighbors[feid_2] = fid_1;
+		is_face_edge_inverted[feid_1] = is_face_edge_inverted[feid_2] =
+			(is_same_orientation != is_same_normal_side);
 	}
 
 
-	// Step #2: Gather non-inverted adjacent faces and invert face normals of minority.
-	std::vector<FaceTraversal> face_subsets(num_faces, NOT_VISITED);
+	// Step #2: Propagate orientations over each connected component (BFS),
+	// and invert face normals of minority.
+	std::vector<int> face_subsets(num_faces, -1);
+	FaceIndexArray queue;
+	queue.reserve(num_faces);
 	unsigned int num_inverted_faces = 0;
 
-	while (true)
+	for (FaceIndex seed_fid = 0; seed_fid < num_faces; ++seed_fid)
 	{
-		FaceIndex curr_fid = 0;
-		for (; curr_fid <= num_faces; curr_fid++)
-			if (face_subsets[curr_fid] == NOT_VISITED)
-				break;
-
-		if (curr_fid >= num_faces)
-			break;
+		if (face_subsets[seed_fid] >= 0)
+			continue;
 
+		const size_t component_begin = queue.size();
 		unsigned int num_subset_count[2] = { 0, 0 };
-		
-		FaceTraversal curr_subset_id = SUBSET_A;
-		face_subsets[curr_fid] = curr_subset_id;
-		num_subset_count[curr_subset_id]++;
 
+		face_subsets[seed_fid] = 0;
+		queue.push_back(seed_fid);
 
-		// Assume that some faces are not connected each other (multiple groups of connected faces)
-		// for one connected faces group.
-		bool all_neighbor_visited = false;
-		while (!all_neighbor_visited)
+		for (size_t head = component_begin; head < queue.size(); ++head)
 		{
-			FaceHandle fh = face_handle(curr_fid);
-			all_neighbor_visited = true;
+			const FaceIndex fid = queue[head];
+			++num_subset_count[face_subsets[fid]];
 
-			for (ConstFaceHalfedgeIter fh_it = cfh_iter(fh); fh_it; ++fh_it)
+			for (int i = 0; i < 3; ++i)
 			{
-				assert(fh == face_handle(fh_it.handle()));
-				HalfedgeHandle heh = opposite_halfedge_handle(fh_it.handle());
-
-				EdgeIndex eid = edge_handle(heh).idx();
-				FaceIndex n_fid = face_handle(heh).idx();
-
-				if (face_subsets[n_fid] == NOT_VISITED)
-				{
-					// Flip subset ID (1 -> 2, 2 -> 1).
-					if (is_edge_inverted[eid])
-					{
-						curr_subset_id = (curr_subset_id == SUBSET_A ? SUBSET_B : SUBSET_A);
-					}
-
-					assert(curr_subset_id == SUBSET_A || curr_subset_id == SUBSET_B);
-					face_subsets[n_fid] = curr_subset_id;
-					num_subset_count[curr_subset_id]++;
-					curr_fid = n_fid;
-
-					all_neighbor_visited = false;
-					break;
-				}
+				const FaceIndex n_fid = face_edge_neighbors[3 * fid + i];
+				if (n_fid < 0 || face_subsets[n_fid] >= 0)
+					continue;
+
+				// Flip subset ID (0 -> 1, 1 -> 0) across inverted edges.
+				face_subsets[n_fid] = face_subsets[fid] ^ is_face_edge_inverted[3 * fid + i];
+				queue.push_back(n_fid);
 			}
 		}
 
 		// Assume that majority of normal vectors are correct.
-		FaceTraversal minor_subset_id = (num_subset_count[0] > num_subset_count[1]
-			? SUBSET_B : SUBSET_A);
+		const int minor_subset_id = (num_subset_count[1] > num_subset_count[0] ? 0 : 1);
 
-
-		for (FaceIter f_it = faces_begin(); f_it != faces_end(); ++f_it)
+		for (size_t i = component_begin; i < queue.size(); ++i)
 		{
-			FaceHandle fh = f_it.handle();
-			FaceIndex fid = fh.idx();
-
-			if (face_subsets[fid] == minor_subset_id)
+			if (face_subsets[queue[i]] == minor_subset_id)
 			{
 				// Invert face normal.
+				FaceHandle fh = face_handle(queue[i]);
 				set_normal(fh, -normal(fh));
-				num_inverted_faces++;
-			}
-
-			if (face_subsets[fid] == SUBSET_A || face_subsets[fid] == SUBSET_B)
-			{
-				face_subsets[fid] = VERIFIED;
+				++num_inverted_faces;
 			}
 		}
 	}
 
-	std::cout << num_inverted_faces << " face normals are inverted." << std::endl;
-
-	delete [] is_edge_inverted;
+	return num_inverted_faces;
 }
 
 void MyMesh::print_vertex_information(unsigned int _vid) const
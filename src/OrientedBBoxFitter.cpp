@@ -0,0 +1,228 @@
+#include "OrientedBBoxFitter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <Eigen/Eigenvalues>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Stop when the volume decreases less than this proportion.
+static const double k_min_volume_decrease = 1.0e-6;
+static const unsigned int k_max_num_iterations = 10;
+
+
+void OrientedBBoxFitter::fit(const double *_points, const unsigned int _num_points,
+	Eigen::Matrix3d &_axes, Eigen::Vector3d &_center, Eigen::Vector3d &_size)
+{
+	assert(_points);
+	assert(_num_points > 0);
+
+	// Initialize (PCA).
+	Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+	for (unsigned int point_index = 0; point_index < _num_points; ++point_index)
+		mean += Eigen::Map<const Eigen::Vector3d>(_points + 3 * point_index);
+	mean /= static_cast<double>(_num_points);
+
+	Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+	for (unsigned int point_index = 0; point_index < _num_points; ++point_index)
+	{
+		const Eigen::Vector3d point = Eigen::Map<const Eigen::Vector3d>(_points + 3 * point_index) - mean;
+		cov.noalias() += point * point.transpose();
+	}
+
+	// NOTE:
+	// The eigenvalues are sorted in increasing order.
+	Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig(cov);
+	for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+		_axes.col(axis_index) = eig.eigenvectors().col(3 - axis_index - 1);
+
+	// Fix z-axis direction.
+	if (_axes.col(0).cross(_axes.col(1)).dot(_axes.col(2)) < 0)
+		_axes.col(2) = -_axes.col(2);
+
+
+	if (points_2d_.size() < _num_points)
+		points_2d_.resize(_num_points);
+	if (hull_.size() < 2 * _num_points)
+		hull_.resize(2 * _num_points);
+
+	// NOTE:
+	// The extent along an axis does not change when rotating about the axis, and thus
+	// each rotation never increases the volume. Repeat while the volume decreases.
+	double volume = std::numeric_limits<double>::max();
+	for (unsigned int iteration = 0; iteration < k_max_num_iterations; ++iteration)
+	{
+		double new_volume = 0.0;
+		for (unsigned int axis_index = 0; axis_index < 3; ++axis_index)
+			new_volume = rotate_about_axis(_points, _num_points, axis_index, _axes);
+
+		if (new_volume >= (1.0 - k_min_volume_decrease) * volume)
+			break;
+		volume = new_volume;
+	}
+
+
+	// Compute the center and size in the box coordinates.
+	Eigen::Vector3d bbox_min = Eigen::Vector3d::Constant(+std::numeric_limits<double>::max());
+	Eigen::Vector3d bbox_max = Eigen::Vector3d::Constant(-std::numeric_limits<double>::max());
+	const Eigen::Matrix3d local_coord_rotation_mat = _axes.transpose();
+
+	for (unsigned int point_index = 0; point_index < _num_points; ++point_index)
+	{
+		const Eigen::Vector3d local_point = local_coord_rotation_mat *
+			Eigen::Map<const Eigen::Vector3d>(_points + 3 * point_index);
+		bbox_min = bbox_min.cwiseMin(local_point);
+		bbox_max = bbox_max.cwiseMax(local_point);
+	}
+
+	_size = bbox_max - bbox_min;
+	_center = _axes * (0.5 * (bbox_min + bbox_max));
+}
+
+double OrientedBBoxFitter::rotate_about_axis(const double *_points, const unsigned int _num_points,
+	const unsigned int _axis_index, Eigen::Matrix3d &_axes)
+{
+	// NOTE:
+	// The rotation about '_axis_index' keeps the frame right-handed.
+	const unsigned int axis_index_1 = (_axis_index + 1) % 3;
+	const unsigned int axis_index_2 = (_axis_index + 2) % 3;
+	const Eigen::Vector3d axis = _axes.col(_axis_index);
+	const Eigen::Vector3d axis_1 = _axes.col(axis_index_1);
+	const Eigen::Vector3d axis_2 = _axes.col(axis_index_2);
+
+	double axis_min = +std::numeric_limits<double>::max();
+	double axis_max = -std::numeric_limits<double>::max();
+
+	for (unsigned int point_index = 0; point_index < _num_points; ++point_index)
+	{
+		const Eigen::Map<const Eigen::Vector3d> point(_points + 3 * point_index);
+		points_2d_[point_index].x_ = axis_1.dot(point);
+		points_2d_[point_index].y_ = axis_2.dot(point);
+
+		const double axis_coord = axis.dot(point);
+		axis_min = std::min(axis_min, axis_coord);
+		axis_max = std::max(axis_max, axis_coord);
+	}
+
+	double area = 0.0;
+	const double angle = compute_min_area_rectangle_angle(_num_points, area);
+	const double cos_angle = std::cos(angle), sin_angle = std::sin(angle);
+	_axes.col(axis_index_1) = (cos_angle * axis_1 + sin_angle * axis_2).normalized();
+	_axes.col(axis_index_2) = (-sin_angle * axis_1 + cos_angle * axis_2).normalized();
+
+	return (axis_max - axis_min) * area;
+}
+
+unsigned int OrientedBBoxFitter::compute_convex_hull(const unsigned int _num_points)
+{
+	// Andrew's monotone chain.
+	const unsigned int num_points = _num_points;
+	std::sort(points_2d_.begin(), points_2d_.begin() + num_points);
+
+	// Twice the signed area of the triangle (o, a, b).
+	struct Cross {
+		inline double operator()(const Point2D &_o, const Point2D &_a, const Point2D &_b) const {
+			return (_a.x_ - _o.x_) * (_b.y_ - _o.y_) - (_a.y_ - _o.y_) * (_b.x_ - _o.x_);
+		}
+	} cross;
+
+	if (num_points < 2)
+	{
+		if (num_points == 1) hull_[0] = points_2d_[0];
+		return num_points;
+	}
+
+	unsigned int num_hull_points = 0;
+
+	// Lower hull.
+	for (unsigned int i = 0; i < num_points; ++i)
+	{
+		while (num_hull_points >= 2 &&
+			cross(hull_[num_hull_points - 2], hull_[num_hull_points - 1], points_2d_[i]) <= 0)
+			--num_hull_points;
+		hull_[num_hull_points++] = points_2d_[i];
+	}
+
+	// Upper hull.
+	const unsigned int num_lower_hull_points = num_hull_points + 1;
+	for (int i = static_cast<int>(num_points) - 2; i >= 0; --i)
+	{
+		while (num_hull_points >= num_lower_hull_points &&
+			cross(hull_[num_hull_points - 2], hull_[num_hull_points - 1], points_2d_[i]) <= 0)
+			--num_hull_points;
+		hull_[num_hull_points++] = points_2d_[i];
+	}
+
+	// The last point is the same with the first point.
+	return num_hull_points - 1;
+}
+
+double OrientedBBoxFitter::compute_min_area_rectangle_angle(const unsigned int _num_points,
+	double &_area)
+{
+	assert(_num_points > 0);
+	assert(points_2d_.size() >= _num_points);
+	assert(hull_.size() >= 2 * _num_points);
+
+	const unsigned int num_hull_points = compute_convex_hull(_num_points);
+	_area = 0.0;
+	if (num_hull_points < 2)
+		return 0.0;
+
+	double best_angle = 0.0;
+	double min_area = std::numeric_limits<double>::max();
+
+	// NOTE:
+	// For each hull edge, the rectangle is aligned with the edge. The farthest points along
+	// the edge direction ('k'), the edge normal ('j'), and the opposite edge direction ('l')
+	// move forward monotonically as the edge moves around the hull (rotating calipers).
+	unsigned int j = 0, k = 0, l = 0;
+	for (unsigned int i = 0; i < num_hull_points; ++i)
+	{
+		const Point2D &p = hull_[i];
+		const Point2D &q = hull_[(i + 1) % num_hull_points];
+		const double edge_length = std::sqrt((q.x_ - p.x_) * (q.x_ - p.x_) + (q.y_ - p.y_) * (q.y_ - p.y_));
+		if (edge_length == 0) continue;
+
+		// Edge direction and inward normal.
+		const double ex = (q.x_ - p.x_) / edge_length, ey = (q.y_ - p.y_) / edge_length;
+		const double nx = -ey, ny = ex;
+
+#define NEXT(index) (((index) + 1) % num_hull_points)
+#define DOT(index, dx, dy) (hull_[index].x_ * (dx) + hull_[index].y_ * (dy))
+
+		if (i == 0) k = i;
+		while (DOT(NEXT(k), ex, ey) > DOT(k, ex, ey)) k = NEXT(k);
+
+		if (i == 0) j = k;
+		while (DOT(NEXT(j), nx, ny) > DOT(j, nx, ny)) j = NEXT(j);
+
+		if (i == 0) l = j;
+		while (DOT(NEXT(l), ex, ey) < DOT(l, ex, ey)) l = NEXT(l);
+
+		const double width = DOT(k, ex, ey) - DOT(l, ex, ey);
+		const double height = DOT(j, nx, ny) - DOT(i, nx, ny);
+
+#undef NEXT
+#undef DOT
+
+		const double area = width * height;
+		if (area < min_area)
+		{
+			min_area = area;
+			best_angle = std::atan2(ey, ex);
+		}
+	}
+
+	if (min_area < std::numeric_limits<double>::max())
+		_area = min_area;
+
+	// The rectangle is the same when rotated by 90 degrees.
+	const double right_angle = 0.5 * M_PI;
+	best_angle -= right_angle * std::floor(best_angle / right_angle + 0.5);
+	return best_angle;
+}
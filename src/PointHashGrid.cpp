@@ -0,0 +1,301 @@
+#include "PointHashGrid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+
+// Number of bits for each axis cell coordinate in a cell key.
+static const int k_num_cell_coord_bits = 21;
+static const int k_max_num_axis_cells = (1 << k_num_cell_coord_bits);
+
+
+template <typename Scalar>
+PointHashGridT<Scalar>::PointHashGridT(const Eigen::MatrixXd &_points, const double _cell_size)
+	: cell_size_(_cell_size)
+{
+	assert(_points.rows() == 3);
+	assert(_cell_size > 0);
+
+	const unsigned int num_points = static_cast<unsigned int>(_points.cols());
+	point_indices_.resize(num_points);
+	point_cell_indices_.resize(num_points);
+
+	if (num_points == 0)
+	{
+		min_.setZero();
+		num_axis_cells_.setOnes();
+		cell_offsets_.push_back(0);
+		return;
+	}
+
+	min_ = _points.rowwise().minCoeff();
+	Eigen::Vector3d max = _points.rowwise().maxCoeff();
+
+	for (int i = 0; i < 3; ++i)
+	{
+		double num_cells = std::floor((max[i] - min_[i]) / cell_size_) + 1;
+		// Enlarge the cell size if the grid is too fine for the cell keys.
+		if (num_cells >= k_max_num_axis_cells)
+			cell_size_ = (max[i] - min_[i]) / (k_max_num_axis_cells - 2);
+	}
+
+	for (int i = 0; i < 3; ++i)
+		num_axis_cells_[i] = static_cast<int>(std::floor((max[i] - min_[i]) / cell_size_)) + 1;
+
+	std::vector< std::pair<uint64_t, unsigned int> > key_point_pairs(num_points);
+	for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+	{
+		Eigen::Vector3i coord;
+		bool ret = get_cell_coord(_points.col(point_index), coord);
+		assert(ret);
+		key_point_pairs[point_index] = std::make_pair(get_cell_key(coord), point_index);
+	}
+
+	// NOTE:
+	// Point indices in each cell are kept in ascending order.
+	std::sort(key_point_pairs.begin(), key_point_pairs.end());
+
+	sorted_points_.resize(3, num_points);
+	for (unsigned int offset = 0; offset < num_points; ++offset)
+	{
+		const uint64_t key = key_point_pairs[offset].first;
+		const unsigned int point_index = key_point_pairs[offset].second;
+
+		if (cell_keys_.empty() || cell_keys_.back() != key)
+		{
+			cell_keys_.push_back(key);
+			cell_offsets_.push_back(offset);
+		}
+
+		point_indices_[offset] = point_index;
+		point_cell_indices_[point_index] = static_cast<int>(cell_keys_.size()) - 1;
+		sorted_points_.col(offset) = _points.col(point_index).template cast<Scalar>();
+	}
+	cell_offsets_.push_back(num_points);
+}
+
+template <typename Scalar>
+PointHashGridT<Scalar>::~PointHashGridT()
+{
+}
+
+template <typename Scalar>
+bool PointHashGridT<Scalar>::get_cell_coord(const Eigen::Vector3d &_point, Eigen::Vector3i &_coord) const
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		double coord = std::floor((_point[i] - min_[i]) / cell_size_);
+		if (coord < 0 || coord >= num_axis_cells_[i])
+			return false;
+		_coord[i] = static_cast<int>(coord);
+	}
+	return true;
+}
+
+template <typename Scalar>
+uint64_t PointHashGridT<Scalar>::get_cell_key(const Eigen::Vector3i &_coord) const
+{
+	return (static_cast<uint64_t>(_coord[0]) << (2 * k_num_cell_coord_bits))
+		| (static_cast<uint64_t>(_coord[1]) << k_num_cell_coord_bits)
+		| static_cast<uint64_t>(_coord[2]);
+}
+
+template <typename Scalar>
+int PointHashGridT<Scalar>::find_cell(const uint64_t _key) const
+{
+	std::vector<uint64_t>::const_iterator it = std::lower_bound(
+		cell_keys_.begin(), cell_keys_.end(), _key);
+	if (it == cell_keys_.end() || (*it) != _key)
+		return -1;
+	return static_cast<int>(it - cell_keys_.begin());
+}
+
+template <typename Scalar>
+int PointHashGridT<Scalar>::get_cell_index(const Eigen::Vector3d &_point) const
+{
+	Eigen::Vector3i coord;
+	if (!get_cell_coord(_point, coord))
+		return -1;
+	return find_cell(get_cell_key(coord));
+}
+
+template <typename Scalar>
+int PointHashGridT<Scalar>::get_point_cell_index(const unsigned int _point_index) const
+{
+	assert(_point_index < point_cell_indices_.size());
+	return point_cell_indices_[_point_index];
+}
+
+template <typename Scalar>
+void PointHashGridT<Scalar>::get_neighbor_cells(const unsigned int _cell_index, const int _cell_radius,
+	std::vector<unsigned int> &_neighbor_cell_indices) const
+{
+	assert(_cell_index < num_cells());
+	assert(_cell_radius >= 0);
+	_neighbor_cell_indices.clear();
+
+	const uint64_t coord_mask = (static_cast<uint64_t>(1) << k_num_cell_coord_bits) - 1;
+	const uint64_t key = cell_keys_[_cell_index];
+	Eigen::Vector3i coord(
+		static_cast<int>((key >> (2 * k_num_cell_coord_bits)) & coord_mask),
+		static_cast<int>((key >> k_num_cell_coord_bits) & coord_mask),
+		static_cast<int>(key & coord_mask));
+
+	// NOTE:
+	// Cells of the same x and y coordinates are contiguous in the sorted keys,
+	// and thus each row along the z axis is found with one binary search.
+	const int min_z = std::max(coord[2] - _cell_radius, 0);
+	const int max_z = std::min(coord[2] + _cell_radius, num_axis_cells_[2] - 1);
+
+	for (int dx = -_cell_radius; dx <= _cell_radius; ++dx)
+	{
+		for (int dy = -_cell_radius; dy <= _cell_radius; ++dy)
+		{
+			const int n_x = coord[0] + dx, n_y = coord[1] + dy;
+			if (n_x < 0 || n_x >= num_axis_cells_[0] || n_y < 0 || n_y >= num_axis_cells_[1])
+				continue;
+
+			const uint64_t max_key = get_cell_key(Eigen::Vector3i(n_x, n_y, max_z));
+			for (std::vector<uint64_t>::const_iterator it = std::lower_bound(cell_keys_.begin(),
+				cell_keys_.end(), get_cell_key(Eigen::Vector3i(n_x, n_y, min_z)));
+				it != cell_keys_.end() && (*it) <= max_key; ++it)
+				_neighbor_cell_indices.push_back(static_cast<unsigned int>(it - cell_keys_.begin()));
+		}
+	}
+}
+
+template <typename Scalar>
+template <typename Func>
+void PointHashGridT<Scalar>::for_each_candidate(const Eigen::Vector3d &_query, Func &_func) const
+{
+	if (num_cells() == 0)
+		return;
+
+	const Vector3 query = _query.template cast<Scalar>();
+
+	Eigen::Vector3i coord;
+	for (int i = 0; i < 3; ++i)
+	{
+		double axis_coord = std::floor((_query[i] - min_[i]) / cell_size_);
+
+		// The query is far from all points.
+		if (axis_coord < -1 || axis_coord > num_axis_cells_[i])
+			return;
+		coord[i] = static_cast<int>(axis_coord);
+	}
+
+	for (int dx = -1; dx <= 1; ++dx)
+	{
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			for (int dz = -1; dz <= 1; ++dz)
+			{
+				Eigen::Vector3i n_coord = coord + Eigen::Vector3i(dx, dy, dz);
+				if ((n_coord.array() < 0).any()
+					|| (n_coord.array() >= num_axis_cells_.array()).any())
+					continue;
+
+				int n_cell_index = find_cell(get_cell_key(n_coord));
+				if (n_cell_index < 0)
+					continue;
+
+				for (unsigned int offset = cell_offsets_[n_cell_index];
+					offset < cell_offsets_[n_cell_index + 1]; ++offset)
+				{
+					double squared_distance = (sorted_points_.col(offset) - query).squaredNorm();
+					if (!_func(point_indices_[offset], squared_distance))
+						return;
+				}
+			}
+		}
+	}
+}
+
+struct PointHashGridHasNeighbor
+{
+	PointHashGridHasNeighbor(double _squared_radius)
+		: squared_radius_(_squared_radius), found_(false) {}
+
+	bool operator()(unsigned int /*_point_index*/, double _squared_distance) {
+		found_ = (_squared_distance <= squared_radius_);
+		return !found_;
+	}
+
+	double squared_radius_;
+	bool found_;
+};
+
+struct PointHashGridClosestPoint
+{
+	PointHashGridClosestPoint(double _squared_radius)
+		: min_squared_distance_(_squared_radius), closest_point_index_(-1) {}
+
+	bool operator()(unsigned int _point_index, double _squared_distance) {
+		// Ties are broken by the smaller point index.
+		if (_squared_distance < min_squared_distance_
+			|| (_squared_distance == min_squared_distance_
+			&& (closest_point_index_ < 0 || static_cast<int>(_point_index) < closest_point_index_)))
+		{
+			min_squared_distance_ = _squared_distance;
+			closest_point_index_ = static_cast<int>(_point_index);
+		}
+		return true;
+	}
+
+	double min_squared_distance_;
+	int closest_point_index_;
+};
+
+struct PointHashGridNeighbors
+{
+	PointHashGridNeighbors(double _squared_radius, std::vector<unsigned int> &_point_indices)
+		: squared_radius_(_squared_radius), point_indices_(_point_indices) {}
+
+	bool operator()(unsigned int _point_index, double _squared_distance) {
+		if (_squared_distance <= squared_radius_)
+			point_indices_.push_back(_point_index);
+		return true;
+	}
+
+	double squared_radius_;
+	std::vector<unsigned int> &point_indices_;
+};
+
+template <typename Scalar>
+bool PointHashGridT<Scalar>::has_neighbor(const Eigen::Vector3d &_query, const double _radius) const
+{
+	assert(_radius <= cell_size_);
+	PointHashGridHasNeighbor func(_radius * _radius);
+	for_each_candidate(_query, func);
+	return func.found_;
+}
+
+template <typename Scalar>
+int PointHashGridT<Scalar>::find_closest_point(const Eigen::Vector3d &_query, const double _radius,
+	double *_distance) const
+{
+	assert(_radius <= cell_size_);
+	PointHashGridClosestPoint func(_radius * _radius);
+	for_each_candidate(_query, func);
+
+	if (_distance && func.closest_point_index_ >= 0)
+		(*_distance) = std::sqrt(func.min_squared_distance_);
+	return func.closest_point_index_;
+}
+
+template <typename Scalar>
+void PointHashGridT<Scalar>::get_neighbors(const Eigen::Vector3d &_query, const double _radius,
+	std::vector<unsigned int> &_neighbor_point_indices) const
+{
+	assert(_radius <= cell_size_);
+	_neighbor_point_indices.clear();
+	PointHashGridNeighbors func(_radius * _radius, _neighbor_point_indices);
+	for_each_candidate(_query, func);
+	std::sort(_neighbor_point_indices.begin(), _neighbor_point_indices.end());
+}
+
+
+template class PointHashGridT<float>;
+template class PointHashGridT<double>;
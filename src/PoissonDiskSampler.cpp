@@ -0,0 +1,297 @@
+#include "PoissonDiskSampler.h"
+#include "PointHashGrid.h"
+#include "simplerandom.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+
+
+// Random numbers taken by each dense point (face and two barycentric coordinates).
+#define POISSON_DISK_NUM_POINT_RANDOM_NUMBERS	3
+// Number of dense points generated by each parallel task.
+#define POISSON_DISK_CHUNK_SIZE					4096
+// Number of candidate points for each sparse point in the sample elimination.
+#define POISSON_DISK_NUM_CANDIDATES_PER_POINT	5
+// Weight function parameters in [Yuksel 2015].
+#define POISSON_DISK_WEIGHT_ALPHA				8
+#define POISSON_DISK_WEIGHT_BETA				0.65
+#define POISSON_DISK_WEIGHT_GAMMA				1.5
+
+
+namespace PoissonDiskSampler {
+
+// Random values in [0, 1].
+static inline Real random_real(SimpleRandomCong_t &_rng)
+{
+	return static_cast<Real>(simplerandom_cong_next(&_rng))
+		/ std::numeric_limits<uint32_t>::max();
+}
+
+// NOTE:
+// Same with calling 'simplerandom_cong_next()' '_n' times, but in O(log(_n)) time.
+// 'simplerandom_cong_next()' is x <- 69069 * x + 12345 (mod 2^32), and the affine map is
+// composed with itself for each bit of '_n'.
+static void discard_random_numbers(SimpleRandomCong_t &_rng, uintmax_t _n)
+{
+	uint32_t mult = UINT32_C(69069), add = 12345u;
+	uint32_t cong = _rng.cong;
+
+	for (; _n > 0; _n >>= 1)
+	{
+		if (_n & 1)
+			cong = mult * cong + add;
+		add = (mult + 1u) * add;
+		mult = mult * mult;
+	}
+
+	_rng.cong = cong;
+}
+
+// Maximum radius of '_num_points' Poisson-disk points on a surface (hexagonal packing).
+static inline Real get_max_radius(const Real _surface_area, const unsigned int _num_points)
+{
+	return std::sqrt(_surface_area / (2 * std::sqrt(3.0) * _num_points));
+}
+
+// NOTE:
+// Distances less than '_min_distance' are clamped so that
+// points in dense regions are not excessively weighted.
+static inline Real compute_weight(const Real _distance,
+	const Real _min_distance, const Real _max_distance)
+{
+	const Real distance = std::min(std::max(_distance, _min_distance), _max_distance);
+	return std::pow(1 - distance / _max_distance, POISSON_DISK_WEIGHT_ALPHA);
+}
+
+Real sample_dense_points(const MyMesh &_mesh, const unsigned int _num_points,
+	const unsigned int _seed, std::vector<SamplePoint> &_sample_points)
+{
+	_sample_points.clear();
+
+	const int num_faces = static_cast<int>(_mesh.n_faces());
+	if (num_faces == 0) return 0;
+
+	std::vector<Real> cumulative_areas(num_faces);
+
+#pragma omp parallel for
+	for (int fid = 0; fid < num_faces; ++fid)
+	{
+		MyMesh::Point p[3];
+		MyMesh::ConstFaceVertexIter fv_it = _mesh.cfv_iter(_mesh.face_handle(fid));
+		for (unsigned int i = 0; fv_it && i < 3; ++fv_it, ++i)	// Trimesh
+			p[i] = _mesh.point(fv_it.handle());
+		cumulative_areas[fid] = 0.5 * cross(p[1] - p[0], p[2] - p[0]).length();
+	}
+
+	for (int fid = 1; fid < num_faces; ++fid)
+		cumulative_areas[fid] += cumulative_areas[fid - 1];
+
+	const Real sum_areas = cumulative_areas.back();
+	if (sum_areas <= 0) return 0;
+
+	_sample_points.resize(_num_points);
+	const int num_chunks = static_cast<int>(
+		(_num_points + POISSON_DISK_CHUNK_SIZE - 1) / POISSON_DISK_CHUNK_SIZE);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int chunk_index = 0; chunk_index < num_chunks; ++chunk_index)
+	{
+		const unsigned int begin = chunk_index * POISSON_DISK_CHUNK_SIZE;
+		const unsigned int end = std::min(begin + POISSON_DISK_CHUNK_SIZE, _num_points);
+
+		// NOTE:
+		// Skip the random numbers of the previous points so that
+		// the points are the same with the ones generated sequentially.
+		SimpleRandomCong_t rng;
+		simplerandom_cong_seed(&rng, _seed);
+		discard_random_numbers(rng,
+			static_cast<uintmax_t>(begin) * POISSON_DISK_NUM_POINT_RANDOM_NUMBERS);
+
+		for (unsigned int point_index = begin; point_index < end; ++point_index)
+		{
+			// NOTE:
+			// 'upper_bound' never selects zero-area faces except for the last face.
+			const Real area = random_real(rng) * sum_areas;
+			FaceIndex fid = static_cast<FaceIndex>(std::upper_bound(
+				cumulative_areas.begin(), cumulative_areas.end(), area) - cumulative_areas.begin());
+			fid = std::min(fid, num_faces - 1);
+
+			// Uniform barycentric coordinates.
+			const Real r1 = std::sqrt(random_real(rng));
+			const Real r2 = random_real(rng);
+
+			MyMesh::FaceHandle fh = _mesh.face_handle(fid);
+			SamplePoint &sample_point = _sample_points[point_index];
+			sample_point.corr_fid_ = fid;
+			sample_point.bary_coord_ = MyMesh::Point(1 - r1, r1 * (1 - r2), r1 * r2);
+			sample_point.point_ = MyMesh::Point(0.0);
+
+			MyMesh::ConstFaceVertexIter fv_it = _mesh.cfv_iter(fh);
+			for (unsigned int i = 0; fv_it && i < 3; ++fv_it, ++i)	// Trimesh
+				sample_point.point_ += sample_point.bary_coord_[i] * _mesh.point(fv_it.handle());
+
+			sample_point.normal_ = _mesh.normal(fh);
+		}
+	}
+
+	return sum_areas;
+}
+
+void eliminate_sample_points(const std::vector<SamplePoint> &_sample_points,
+	const unsigned int _num_candidate_points, const unsigned int _num_sparse_points,
+	const Real _surface_area, std::vector<unsigned int> &_sparse_to_dense_indices)
+{
+	assert(_num_candidate_points <= _sample_points.size());
+	assert(_num_sparse_points <= _num_candidate_points);
+
+	_sparse_to_dense_indices.clear();
+	if (_num_sparse_points == 0) return;
+
+	const int num_candidates = static_cast<int>(_num_candidate_points);
+	if (_num_sparse_points == _num_candidate_points || _surface_area <= 0)
+	{
+		for (unsigned int point_index = 0; point_index < _num_sparse_points; ++point_index)
+			_sparse_to_dense_indices.push_back(point_index);
+		return;
+	}
+
+	const Real max_radius = get_max_radius(_surface_area, _num_sparse_points);
+	const Real min_radius = max_radius * POISSON_DISK_WEIGHT_BETA * (1 - std::pow(
+		static_cast<Real>(_num_sparse_points) / _num_candidate_points, POISSON_DISK_WEIGHT_GAMMA));
+	const Real max_distance = 2 * max_radius;
+	const Real min_distance = 2 * min_radius;
+
+	Eigen::MatrixXd points(3, num_candidates);
+	for (int point_index = 0; point_index < num_candidates; ++point_index)
+		for (unsigned int i = 0; i < 3; ++i)
+			points(i, point_index) = _sample_points[point_index].point_[i];
+
+	PointHashGrid point_grid(points, max_distance);
+
+
+	// Neighbors and initial weights.
+	std::vector< std::vector<unsigned int> > point_neighbors(num_candidates);
+	std::vector<Real> point_weights(num_candidates, 0.0);
+
+#pragma omp parallel for schedule(dynamic, 256)
+	for (int point_index = 0; point_index < num_candidates; ++point_index)
+	{
+		std::vector<unsigned int> &neighbors = point_neighbors[point_index];
+		point_grid.get_neighbors(points.col(point_index), max_distance, neighbors);
+		neighbors.erase(std::remove(neighbors.begin(), neighbors.end(),
+			static_cast<unsigned int>(point_index)), neighbors.end());
+
+		for (std::vector<unsigned int>::const_iterator it = neighbors.begin(); it != neighbors.end(); ++it)
+		{
+			const Real distance = (points.col(point_index) - points.col(*it)).norm();
+			point_weights[point_index] += compute_weight(distance, min_distance, max_distance);
+		}
+	}
+
+
+	// Remove the point of the largest weight, and update the weights of its neighbors.
+	// NOTE:
+	// The queue may have outdated weights of points, which are skipped.
+	std::priority_queue< std::pair<Real, unsigned int> > point_queue;
+	for (int point_index = 0; point_index < num_candidates; ++point_index)
+		point_queue.push(std::make_pair(point_weights[point_index], point_index));
+
+	std::vector<bool> is_point_removed(num_candidates, false);
+	unsigned int num_points = _num_candidate_points;
+
+	while (num_points > _num_sparse_points)
+	{
+		assert(!point_queue.empty());
+		const std::pair<Real, unsigned int> top = point_queue.top();
+		point_queue.pop();
+
+		const unsigned int point_index = top.second;
+		if (is_point_removed[point_index] || top.first != point_weights[point_index])
+			continue;
+
+		is_point_removed[point_index] = true;
+		--num_points;
+
+		const std::vector<unsigned int> &neighbors = point_neighbors[point_index];
+		for (std::vector<unsigned int>::const_iterator it = neighbors.begin(); it != neighbors.end(); ++it)
+		{
+			if (is_point_removed[*it]) continue;
+			const Real distance = (points.col(point_index) - points.col(*it)).norm();
+			point_weights[*it] -= compute_weight(distance, min_distance, max_distance);
+			point_queue.push(std::make_pair(point_weights[*it], *it));
+		}
+	}
+
+	_sparse_to_dense_indices.reserve(_num_sparse_points);
+	for (int point_index = 0; point_index < num_candidates; ++point_index)
+		if (!is_point_removed[point_index])
+			_sparse_to_dense_indices.push_back(point_index);
+	assert(_sparse_to_dense_indices.size() == _num_sparse_points);
+}
+
+void sample_points(const MyMesh &_mesh,
+	const unsigned int _num_sparse_points, const unsigned int _num_dense_points,
+	const unsigned int _seed, SampleSet &_sample_set)
+{
+	assert(_num_sparse_points <= _num_dense_points);
+
+	const Real surface_area = sample_dense_points(_mesh, _num_dense_points, _seed,
+		_sample_set.dense_sample_points_);
+
+	const std::vector<SamplePoint> &dense_sample_points = _sample_set.dense_sample_points_;
+	const int num_dense_points = static_cast<int>(dense_sample_points.size());
+	const unsigned int num_sparse_points = std::min(_num_sparse_points,
+		static_cast<unsigned int>(num_dense_points));
+
+	// NOTE:
+	// Dense points are random, and thus the first points are also random candidates.
+	const unsigned int num_candidate_points = std::min(static_cast<unsigned int>(num_dense_points),
+		POISSON_DISK_NUM_CANDIDATES_PER_POINT * num_sparse_points);
+
+	eliminate_sample_points(dense_sample_points, num_candidate_points, num_sparse_points,
+		surface_area, _sample_set.sparse_to_dense_indices_);
+
+
+	// Closest sparse point of each dense point.
+	const std::vector<unsigned int> &sparse_to_dense_indices = _sample_set.sparse_to_dense_indices_;
+	_sample_set.dense_to_sparse_indices_.clear();
+	_sample_set.dense_to_sparse_indices_.resize(num_dense_points, 0);
+	if (num_sparse_points == 0) return;
+
+	Eigen::MatrixXd sparse_points(3, num_sparse_points);
+	for (unsigned int sparse_index = 0; sparse_index < num_sparse_points; ++sparse_index)
+		for (unsigned int i = 0; i < 3; ++i)
+			sparse_points(i, sparse_index) = dense_sample_points[sparse_to_dense_indices[sparse_index]].point_[i];
+
+	const Real search_radius = (surface_area > 0) ?
+		2 * get_max_radius(surface_area, num_sparse_points) : 1.0;
+	PointHashGrid sparse_point_grid(sparse_points, search_radius);
+
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int point_index = 0; point_index < num_dense_points; ++point_index)
+	{
+		Eigen::Vector3d point;
+		for (unsigned int i = 0; i < 3; ++i)
+			point[i] = dense_sample_points[point_index].point_[i];
+
+		int sparse_index = sparse_point_grid.find_closest_point(point, search_radius);
+
+		// NOTE:
+		// Sparse points cover almost all dense points within the search radius.
+		// Search all sparse points otherwise.
+		if (sparse_index < 0)
+		{
+			Eigen::VectorXd::Index min_index;
+			(sparse_points.colwise() - point).colwise().squaredNorm().minCoeff(&min_index);
+			sparse_index = static_cast<int>(min_index);
+		}
+
+		_sample_set.dense_to_sparse_indices_[point_index] = static_cast<unsigned int>(sparse_index);
+	}
+}
+
+}
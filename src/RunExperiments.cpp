@@ -2,16 +2,22 @@
 #include "MeshCuboidEvaluator.h"
 #include "MeshCuboidFusion.h"
 #include "MeshCuboidParameters.h"
+#include "MeshCuboidPredictionCheckpoint.h"
 #include "MeshCuboidPredictor.h"
+#include "MeshCuboidPreprocessingCache.h"
 #include "MeshCuboidRelation.h"
 #include "MeshCuboidTrainer.h"
 #include "MeshCuboidSolver.h"
 #include "simplerandom.h"
+#include "StructureCompletion.h"
 #include "SymmetryDetection.h"
+#include "TraceRecorder.h"
 //#include "QGLOcculsionTestWidget.h"
 
+#include <cstdio>
 #include <sstream>
 #include <Eigen/Core>
+#include <OpenMesh/Tools/Utils/Timer.hh>
 #include <gflags/gflags.h>
 #include <QDir>
 #include <QFileInfo>
@@ -28,6 +34,10 @@ void MeshViewerCore::parse_arguments()
 	std::cout << "mesh_label_path = " << FLAGS_data_root_path + FLAGS_mesh_label_path << std::endl;
 	std::cout << "output_dir = " << FLAGS_output_dir << std::endl;
 
+	// NOTE:
+	// The viewer can be created before the flags are parsed.
+	cuboid_structure_.set_parameters(MeshCuboidParameters());
+
 	if (FLAGS_run_ground_truth_cuboids)
 	{
 		std::cout << "mesh_filename = " << FLAGS_mesh_filename << std::endl;
@@ -45,6 +55,12 @@ void MeshViewerCore::parse_arguments()
 		predict();
 		exit(EXIT_FAILURE);
 	}
+	else if (FLAGS_run_batch_prediction)
+	{
+		std::cout << "batch_job_manifest_filename = " << FLAGS_batch_job_manifest_filename << std::endl;
+		run_batch_prediction();
+		exit(EXIT_FAILURE);
+	}
 	else if (FLAGS_run_part_assembly)
 	{
 		std::cout << "mesh_filename = " << FLAGS_mesh_filename << std::endl;
@@ -122,7 +138,7 @@ bool MeshViewerCore::load_object_info(
 		std::cerr << "Error: The mesh label file does not exist (" << mesh_label_filepath << ")." << std::endl;
 		return false;
 	}
-	if (!sample_file.exists())
+	if (!FLAGS_sample_points_from_mesh && !sample_file.exists())
 	{
 		std::cerr << "Error: The sample file does not exist (" << sample_filepath << ")." << std::endl;
 		return false;
@@ -132,7 +148,8 @@ bool MeshViewerCore::load_object_info(
 		std::cerr << "Error: The sample label file does not exist (" << sample_label_filepath << ")." << std::endl;
 		return false;
 	}
-	if ((_option == LoadDenseSamplePoints || _option == LoadDenseTestData) && !dense_sample_file.exists())
+	if (!FLAGS_sample_points_from_mesh
+		&& (_option == LoadDenseSamplePoints || _option == LoadDenseTestData) && !dense_sample_file.exists())
 	{
 		std::cerr << "Error: The dense sample file does not exist (" << dense_sample_filepath << ")." << std::endl;
 		return false;
@@ -161,8 +178,17 @@ bool MeshViewerCore::load_object_info(
 		ret = _mesh.load_face_label_simple(mesh_label_filepath.c_str(), false);
 		assert(ret);
 
-		if (_verbose) std::cout << " - Load sample points." << std::endl;
-		ret = _cuboid_structure.load_sample_points(sample_filepath.c_str(), false);
+		if (FLAGS_sample_points_from_mesh)
+		{
+			if (_verbose) std::cout << " - Sample points." << std::endl;
+			ret = _cuboid_structure.sample_points_on_mesh(FLAGS_num_sample_points,
+				FLAGS_num_dense_sample_points, FLAGS_sample_points_seed, false);
+		}
+		else
+		{
+			if (_verbose) std::cout << " - Load sample points." << std::endl;
+			ret = _cuboid_structure.load_sample_points(sample_filepath.c_str(), false);
+		}
 		assert(ret);
 
 		_cuboid_structure.apply_mesh_face_labels_to_sample_points();
@@ -177,8 +203,19 @@ bool MeshViewerCore::load_object_info(
 		// Load dense sample points as base sample points.
 		// Do not use load_dense_sample_points() function,
 		// which requires to load sparse sample point first.
-		if (_verbose) std::cout << " - Load dense sample points." << std::endl;
-		ret = _cuboid_structure.load_sample_points(dense_sample_filepath.c_str(), false);
+		if (FLAGS_sample_points_from_mesh)
+		{
+			// NOTE:
+			// All dense sample points remain when the numbers of points are the same.
+			if (_verbose) std::cout << " - Sample dense points." << std::endl;
+			ret = _cuboid_structure.sample_points_on_mesh(FLAGS_num_dense_sample_points,
+				FLAGS_num_dense_sample_points, FLAGS_sample_points_seed, false);
+		}
+		else
+		{
+			if (_verbose) std::cout << " - Load dense sample points." << std::endl;
+			ret = _cuboid_structure.load_sample_points(dense_sample_filepath.c_str(), false);
+		}
 		assert(ret);
 
 		_cuboid_structure.apply_mesh_face_labels_to_sample_points();
@@ -193,8 +230,19 @@ bool MeshViewerCore::load_object_info(
 		// Load dense sample points as base sample points.
 		// Do not use load_dense_sample_points() function,
 		// which requires to load sparse sample point first.
-		if (_verbose) std::cout << " - Load dense sample points." << std::endl;
-		ret = _cuboid_structure.load_sample_points(dense_sample_filepath.c_str(), false);
+		if (FLAGS_sample_points_from_mesh)
+		{
+			// NOTE:
+			// All dense sample points remain when the numbers of points are the same.
+			if (_verbose) std::cout << " - Sample dense points." << std::endl;
+			ret = _cuboid_structure.sample_points_on_mesh(FLAGS_num_dense_sample_points,
+				FLAGS_num_dense_sample_points, FLAGS_sample_points_seed, false);
+		}
+		else
+		{
+			if (_verbose) std::cout << " - Load dense sample points." << std::endl;
+			ret = _cuboid_structure.load_sample_points(dense_sample_filepath.c_str(), false);
+		}
 		assert(ret);
 
 		_cuboid_structure.apply_mesh_face_labels_to_sample_points();
@@ -208,8 +256,17 @@ bool MeshViewerCore::load_object_info(
 	}
 	else if (_option == LoadTestData || _option == LoadDenseTestData)
 	{
-		if (_verbose) std::cout << " - Load sample points." << std::endl;
-		ret = _cuboid_structure.load_sample_points(sample_filepath.c_str(), false);
+		if (FLAGS_sample_points_from_mesh)
+		{
+			if (_verbose) std::cout << " - Sample points." << std::endl;
+			ret = _cuboid_structure.sample_points_on_mesh(FLAGS_num_sample_points,
+				FLAGS_num_dense_sample_points, FLAGS_sample_points_seed, false);
+		}
+		else
+		{
+			if (_verbose) std::cout << " - Load sample points." << std::endl;
+			ret = _cuboid_structure.load_sample_points(sample_filepath.c_str(), false);
+		}
 		assert(ret);
 		assert(_cuboid_structure.num_sample_points() > 0);
 
@@ -219,8 +276,17 @@ bool MeshViewerCore::load_object_info(
 
 		if (_option == LoadDenseTestData)
 		{
-			if (_verbose) std::cout << " - Load dense sample points." << std::endl;
-			ret = _cuboid_structure.load_dense_sample_points(dense_sample_filepath.c_str(), false);
+			if (FLAGS_sample_points_from_mesh)
+			{
+				if (_verbose) std::cout << " - Sample dense points." << std::endl;
+				ret = _cuboid_structure.sample_dense_points_on_mesh(FLAGS_num_sample_points,
+					FLAGS_num_dense_sample_points, FLAGS_sample_points_seed, false);
+			}
+			else
+			{
+				if (_verbose) std::cout << " - Load dense sample points." << std::endl;
+				ret = _cuboid_structure.load_dense_sample_points(dense_sample_filepath.c_str(), false);
+			}
 			assert(ret);
 		}
 	}
@@ -493,10 +559,11 @@ void MeshViewerCore::compute_ground_truth_cuboids()
 		output_filename_sstr << FLAGS_training_dir << std::string("/") << mesh_name << std::string("_log.txt");
 
 		// Iterate only once.
-		const bool use_symmetry = !(FLAGS_disable_symmetry_terms);
-		MeshCuboidPredictor predictor(num_labels);
+		const MeshCuboidParameters &params = cuboid_structure_.get_parameters();
+		const bool use_symmetry = !(params.disable_symmetry_terms_);
+		MeshCuboidPredictor predictor(num_labels, params);
 		optimize_attributes(cuboid_structure_, NULL, predictor,
-			FLAGS_param_opt_single_energy_term_weight, FLAGS_param_opt_symmetry_energy_term_weight,
+			params.opt_single_energy_term_weight_, params.opt_symmetry_energy_term_weight_,
 			1, output_filename_sstr.str(), this,
 			use_symmetry);
 
@@ -609,10 +676,11 @@ void MeshViewerCore::train()
 				output_filename_sstr << FLAGS_training_dir << std::string("/") << mesh_name << std::string("_log.txt");
 
 				// Iterate only once.
-				const bool use_symmetry = !(FLAGS_disable_symmetry_terms);
-				MeshCuboidPredictor predictor(num_labels);
+				const MeshCuboidParameters &params = cuboid_structure_.get_parameters();
+				const bool use_symmetry = !(params.disable_symmetry_terms_);
+				MeshCuboidPredictor predictor(num_labels, params);
 				optimize_attributes(cuboid_structure_, NULL, predictor,
-					FLAGS_param_opt_single_energy_term_weight, FLAGS_param_opt_symmetry_energy_term_weight,
+					params.opt_single_energy_term_weight_, params.opt_symmetry_energy_term_weight_,
 					1, output_filename_sstr.str(), this,
 					use_symmetry);
 
@@ -833,6 +901,12 @@ void MeshViewerCore::batch_predict()
 	input_dir.setFilter(QDir::Files | QDir::Hidden | QDir::NoSymLinks);
 	input_dir.setSorting(QDir::Name);
 
+	// NOTE:
+	// Label information and training data are loaded only once for all meshes.
+	MeshCuboidTrainer trainer;
+	if (!load_prediction_info(trainer))
+		return;
+
 	QFileInfoList dir_list = input_dir.entryInfoList();
 	for (int file_index = 0; file_index < dir_list.size(); file_index++)
 	{
@@ -843,14 +917,101 @@ void MeshViewerCore::batch_predict()
 		{
 			FLAGS_mesh_filename = std::string(file_info.fileName().toLocal8Bit());
 			std::cout << "mesh_filename = " << FLAGS_mesh_filename << std::endl;
-			predict();
+			predict(trainer);
 		}
 	}
 
 	std::cout << " -- Batch Completed. -- " << std::endl;
 }
 
-void MeshViewerCore::predict()
+void MeshViewerCore::run_batch_prediction()
+{
+	// NOTE:
+	// Each line of the job manifest file is
+	// '<mesh_filename> [<occlusion_pose_filename>] [<random_view_seed>]'.
+	// Use '-' as the occlusion pose filename for a random view direction.
+	// Empty lines and lines starting with '#' are ignored.
+	std::ifstream manifest_file(FLAGS_batch_job_manifest_filename.c_str());
+	if (!manifest_file)
+	{
+		std::cerr << "Error: The job manifest file does not exist ("
+			<< FLAGS_batch_job_manifest_filename << ")." << std::endl;
+		return;
+	}
+
+	assert(FLAGS_batch_num_workers > 0);
+	assert(FLAGS_batch_worker_index >= 0);
+	assert(FLAGS_batch_worker_index < FLAGS_batch_num_workers);
+
+	// NOTE:
+	// Label information and training data are loaded only once for all jobs.
+	MeshCuboidTrainer trainer;
+	if (!load_prediction_info(trainer))
+		return;
+
+	const std::string default_occlusion_pose_filename = FLAGS_occlusion_pose_filename;
+	const int default_random_view_seed = FLAGS_random_view_seed;
+
+	int job_index = 0;
+	unsigned int num_completed_jobs = 0;
+	std::string buffer;
+
+	while (std::getline(manifest_file, buffer))
+	{
+		std::stringstream sstr(buffer);
+		std::string mesh_filename;
+		if (!(sstr >> mesh_filename) || mesh_filename[0] == '#')
+			continue;
+
+		// NOTE:
+		// Jobs are distributed to worker processes in a round-robin manner.
+		const int current_job_index = job_index++;
+		if (current_job_index % FLAGS_batch_num_workers != FLAGS_batch_worker_index)
+			continue;
+
+		std::string occlusion_pose_filename;
+		int random_view_seed;
+		if (!(sstr >> occlusion_pose_filename))
+			occlusion_pose_filename = default_occlusion_pose_filename;
+		else if (occlusion_pose_filename == "-")
+			occlusion_pose_filename = "";
+		if (!(sstr >> random_view_seed))
+			random_view_seed = default_random_view_seed;
+
+		FLAGS_mesh_filename = mesh_filename;
+		FLAGS_occlusion_pose_filename = occlusion_pose_filename;
+		FLAGS_random_view_seed = random_view_seed;
+
+		QFileInfo mesh_file(mesh_filename.c_str());
+		std::string mesh_name = std::string(mesh_file.baseName().toLocal8Bit());
+		std::string mesh_output_path = FLAGS_output_dir + std::string("/") + mesh_name;
+		QDir output_dir;
+		output_dir.mkpath(mesh_output_path.c_str());
+
+		std::cout << "Job [" << mesh_filename << "] Started." << std::endl;
+		OpenMesh::Utils::Timer timer;
+		timer.start();
+
+		// Write the log of each job in its output directory.
+		std::ofstream log_file((mesh_output_path + std::string("/") + mesh_name + std::string("_log.txt")).c_str());
+		std::streambuf *cout_buffer = std::cout.rdbuf(log_file.rdbuf());
+		std::cout << "mesh_filename = " << FLAGS_mesh_filename << std::endl;
+		predict(trainer);
+		std::cout.rdbuf(cout_buffer);
+		log_file.close();
+
+		timer.stop();
+		std::cout << "Job [" << mesh_filename << "] Finished (" << timer.as_string() << ")." << std::endl;
+		++num_completed_jobs;
+	}
+
+	FLAGS_occlusion_pose_filename = default_occlusion_pose_filename;
+	FLAGS_random_view_seed = default_random_view_seed;
+
+	std::cout << " -- Batch Completed (" << num_completed_jobs << " jobs). -- " << std::endl;
+}
+
+bool MeshViewerCore::load_prediction_info(MeshCuboidTrainer &_trainer)
 {
 	// Load basic information.
 	bool ret = true;
@@ -866,10 +1027,8 @@ void MeshViewerCore::predict()
 
 	if (!ret)
 	{
-		do {
-			std::cout << "Error: Cannot open label information files.";
-			std::cout << '\n' << "Press the Enter key to continue.";
-		} while (std::cin.get() != '\n');
+		std::cout << "Error: Cannot open label information files." << std::endl;
+		return false;
 	}
 
 	// To be removed.
@@ -878,20 +1037,162 @@ void MeshViewerCore::predict()
 	//	cuboid_structure_.add_symmetric_group_labels();
 	//}
 
-	ret = true;
-	MeshCuboidTrainer trainer;
-	ret = ret & trainer.load_object_list(FLAGS_training_dir + std::string("/") + FLAGS_object_list_filename);
-	ret = ret & trainer.load_features(FLAGS_training_dir + std::string("/") + FLAGS_feature_filename_prefix);
-	ret = ret & trainer.load_transformations(FLAGS_training_dir + std::string("/") + FLAGS_transformation_filename_prefix);
+	ret = ret & _trainer.load_object_list(FLAGS_training_dir + std::string("/") + FLAGS_object_list_filename);
+	ret = ret & _trainer.load_features(FLAGS_training_dir + std::string("/") + FLAGS_feature_filename_prefix);
+	ret = ret & _trainer.load_transformations(FLAGS_training_dir + std::string("/") + FLAGS_transformation_filename_prefix);
 
 	if (!ret)
+	{
+		std::cout << "Error: Cannot open training files." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void MeshViewerCore::predict()
+{
+	MeshCuboidTrainer trainer;
+	if (!load_prediction_info(trainer))
 	{
 		do {
-			std::cout << "Error: Cannot open training files.";
 			std::cout << '\n' << "Press the Enter key to continue.";
 		} while (std::cin.get() != '\n');
 	}
 
+	predict(trainer);
+}
+
+bool MeshViewerCore::is_snapshot_enabled(const SnapshotStage _stage) const
+{
+	return ((FLAGS_snapshot_stage_mask & _stage) != 0);
+}
+
+class MeshViewerCore::PredictionObserver : public StructureCompletionObserver
+{
+public:
+	PredictionObserver(MeshViewerCore &_viewer,
+		const std::string &_mesh_filepath,
+		const std::string &_mesh_output_path,
+		const std::string &_mesh_intermediate_path,
+		const std::string &_filename_prefix,
+		const double *_snapshot_modelview_matrix,
+		const double *_occlusion_modelview_matrix,
+		const std::string &_checkpoint_filename,
+		const std::string &_checkpoint_input_key)
+		: viewer_(_viewer)
+		, mesh_filepath_(_mesh_filepath)
+		, mesh_output_path_(_mesh_output_path)
+		, mesh_intermediate_path_(_mesh_intermediate_path)
+		, filename_prefix_(_filename_prefix)
+		, snapshot_modelview_matrix_(_snapshot_modelview_matrix)
+		, occlusion_modelview_matrix_(_occlusion_modelview_matrix)
+		, checkpoint_filename_(_checkpoint_filename)
+		, checkpoint_input_key_(_checkpoint_input_key)
+		, snapshot_intermediate_(_viewer.is_snapshot_enabled(SnapshotIntermediate))
+	{}
+
+	virtual std::string get_log_filename(const std::string &_candidate_name)
+	{
+		return mesh_intermediate_path_ + filename_prefix_
+			+ std::string("c_") + _candidate_name + std::string("_log.txt");
+	}
+
+	virtual MeshCuboidSolverObserver *get_solver_observer()
+	{
+		return snapshot_intermediate_ ? &viewer_ : NULL;
+	}
+
+	virtual void candidate_started(const std::string &_candidate_name,
+		const unsigned int _start_stage)
+	{
+		if (_start_stage == MeshCuboidPredictionCheckpoint::RecognizeStage)
+		{
+			std::ofstream log_file(get_log_filename(_candidate_name));
+			log_file.clear(); log_file.close();
+
+			if (snapshot_intermediate_)
+				snapshot_candidate(mesh_intermediate_path_, _candidate_name, 0);
+		}
+		viewer_.draw_cuboid_axes_ = true;
+	}
+
+	virtual void stage_finished(const std::string &_candidate_name,
+		const unsigned int _stage)
+	{
+		if (!snapshot_intermediate_) return;
+
+		// NOTE:
+		// The snapshot after the optimization is saved in the 'Temp' directory.
+		const std::string path = (_stage == MeshCuboidPredictionCheckpoint::OptimizeStage) ?
+			FLAGS_output_dir + std::string("/Temp") : mesh_intermediate_path_;
+		snapshot_candidate(path, _candidate_name, _stage + 1);
+	}
+
+	virtual bool is_checkpoint_enabled() const { return FLAGS_checkpoint_prediction; }
+
+	virtual void save_checkpoint(const MeshCuboidPredictionCheckpoint &_state)
+	{
+		_state.save(checkpoint_filename_, checkpoint_input_key_);
+	}
+
+	virtual void candidate_finished(const std::string &_candidate_name,
+		const unsigned int _final_candidate_index,
+		MeshCuboidStructure &_cuboid_structure)
+	{
+		// NOTE:
+		// The reconstruction uses the cuboid structure of the viewer.
+		assert(&_cuboid_structure == &viewer_.cuboid_structure_);
+
+		std::stringstream snapshot_filename_sstr;
+		snapshot_filename_sstr << mesh_output_path_ << filename_prefix_ << _final_candidate_index;
+
+		viewer_.draw_point_correspondences_ = false;
+		if (!FLAGS_no_evaluation) {
+			viewer_.reconstruct(
+				mesh_filepath_.c_str(),
+				snapshot_modelview_matrix_,
+				occlusion_modelview_matrix_,
+				snapshot_filename_sstr.str().c_str());
+			viewer_.draw_point_correspondences_ = true;
+		}
+		else
+		{
+			viewer_.reconstruct_scan(
+				mesh_filepath_.c_str(),
+				snapshot_modelview_matrix_,
+				occlusion_modelview_matrix_,
+				snapshot_filename_sstr.str().c_str());
+		}
+	}
+
+private:
+	void snapshot_candidate(const std::string &_path, const std::string &_candidate_name,
+		const unsigned int _snapshot_index)
+	{
+		viewer_.updateGL();
+		std::stringstream snapshot_filename_sstr;
+		snapshot_filename_sstr << _path << filename_prefix_
+			<< std::string("c_") << _candidate_name << std::string("_")
+			<< std::string("s_") << _snapshot_index;
+		viewer_.snapshot(snapshot_filename_sstr.str().c_str());
+	}
+
+	MeshViewerCore &viewer_;
+	const std::string mesh_filepath_;
+	const std::string mesh_output_path_;
+	const std::string mesh_intermediate_path_;
+	const std::string filename_prefix_;
+	const double *snapshot_modelview_matrix_;
+	const double *occlusion_modelview_matrix_;
+	const std::string checkpoint_filename_;
+	const std::string checkpoint_input_key_;
+	const bool snapshot_intermediate_;
+};
+
+void MeshViewerCore::predict(const MeshCuboidTrainer &_trainer)
+{
+	bool ret = true;
 
 	// Check file paths.
 	setDrawMode(CUSTOM_VIEW);
@@ -913,7 +1214,6 @@ void MeshViewerCore::predict()
 
 	std::string filename_prefix = std::string("/") + mesh_name + std::string("_");
 	std::stringstream snapshot_filename_sstr;
-	std::stringstream log_filename_sstr;
 
 	QDir output_dir;
 	std::string mesh_output_path = FLAGS_output_dir + std::string("/") + mesh_name;
@@ -924,21 +1224,24 @@ void MeshViewerCore::predict()
 
 
 	// Initialize basic information.
-	unsigned int num_labels = cuboid_structure_.num_labels();
 	cuboid_structure_.clear_cuboids();
 	cuboid_structure_.clear_sample_points();
 
+	// NOTE:
+	// Parameters of this job. The view plane mask range is set below.
+	MeshCuboidParameters params;
+
 	std::list<std::string> ignored_object_list;
 	ignored_object_list.push_back(mesh_name);
 
 	std::vector< std::vector<MeshCuboidJointNormalRelations *> > joint_normal_relations;
 	//MeshCuboidTrainer::load_joint_normal_relations(num_labels, "joint_normal_", joint_normal_relations);
-	trainer.get_joint_normal_relations(joint_normal_relations, &ignored_object_list);
-	MeshCuboidJointNormalRelationPredictor joint_normal_predictor(joint_normal_relations);
+	_trainer.get_joint_normal_relations(joint_normal_relations, &ignored_object_list);
+	MeshCuboidJointNormalRelationPredictor joint_normal_predictor(joint_normal_relations, params);
 
 	//std::vector< std::vector<MeshCuboidCondNormalRelations *> > cond_normal_relations;
 	//MeshCuboidTrainer::load_cond_normal_relations(num_labels, "conditional_normal_", cond_normal_relations);
-	//trainer.get_cond_normal_relations(cond_normal_relations, &ignored_object_list);
+	//_trainer.get_cond_normal_relations(cond_normal_relations, &ignored_object_list);
 	//MeshCuboidCondNormalRelationPredictor cond_normal_predictor(cond_normal_relations);
 
 
@@ -966,47 +1269,44 @@ void MeshViewerCore::predict()
 	set_modelview_matrix(occlusion_modelview_matrix, false);
 
 	// View plane mask.
-	if (FLAGS_use_view_plane_mask)
+	if (params.use_view_plane_mask_)
 	{
 		std::string view_plane_mask_filename = mesh_output_path + std::string("/view_mask.txt");
 		QFileInfo view_plane_mask_file_info(view_plane_mask_filename.c_str());
 
 		if (!view_plane_mask_file_info.exists())
 		{
-			compute_view_plane_mask_range(occlusion_modelview_matrix);
+			compute_view_plane_mask_range(occlusion_modelview_matrix, params);
 
 			// Save range.
-			std::ofstream view_plane_mask_file(view_plane_mask_filename.c_str());
-			assert(view_plane_mask_file.is_open());
-			view_plane_mask_file << FLAGS_param_view_plane_mask_min_x << std::endl;
-			view_plane_mask_file << FLAGS_param_view_plane_mask_min_y << std::endl;
-			view_plane_mask_file << FLAGS_param_view_plane_mask_max_x << std::endl;
-			view_plane_mask_file << FLAGS_param_view_plane_mask_max_y << std::endl;
-			view_plane_mask_file.close();
+			ret = params.save_view_plane_mask(view_plane_mask_filename);
+			assert(ret);
 		}
 
-		std::ifstream view_plane_mask_file(view_plane_mask_filename.c_str());
-		assert(view_plane_mask_file.is_open());
-		std::string buffer;
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_min_x = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_min_y = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_max_x = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_max_y = std::atof(buffer.c_str());
-		view_plane_mask_file.close();
+		ret = params.load_view_plane_mask(view_plane_mask_filename);
+		assert(ret);
 	}
 
+	cuboid_structure_.set_parameters(params);
+
 	remove_occluded_points();
 	
-	updateGL();
-	snapshot_filename_sstr.clear(); snapshot_filename_sstr.str("");
-	snapshot_filename_sstr << mesh_output_path << filename_prefix << std::string("view");
-	snapshot(snapshot_filename_sstr.str().c_str());
+	if (is_snapshot_enabled(SnapshotView))
+	{
+		updateGL();
+		snapshot_filename_sstr.clear(); snapshot_filename_sstr.str("");
+		snapshot_filename_sstr << mesh_output_path << filename_prefix << std::string("view");
+		snapshot(snapshot_filename_sstr.str().c_str());
+	}
 
 	set_modelview_matrix(snapshot_modelview_matrix);
-	updateGL();
 	snapshot_filename_sstr.clear(); snapshot_filename_sstr.str("");
 	snapshot_filename_sstr << mesh_output_path << filename_prefix << std::string("input");
-	snapshot(snapshot_filename_sstr.str().c_str());
+	if (is_snapshot_enabled(SnapshotInput))
+	{
+		updateGL();
+		snapshot(snapshot_filename_sstr.str().c_str());
+	}
 
 	cuboid_structure_.save_sample_points_to_ply(snapshot_filename_sstr.str().c_str());
 	cuboid_structure_.save_sample_points((snapshot_filename_sstr.str() + std::string(".pts")).c_str());
@@ -1025,206 +1325,148 @@ void MeshViewerCore::predict()
 	}
 
 
-	std::cout << " - Remove occluded points." << std::endl;
-	set_modelview_matrix(occlusion_modelview_matrix, false);
-	remove_occluded_points();
-	set_modelview_matrix(snapshot_modelview_matrix);
-
-
-	std::cout << " - Cluster points and construct initial cuboids." << std::endl;
-	draw_cuboid_axes_ = false;
-
-	cuboid_structure_.compute_label_cuboids();
-
-	// Split cuboids if sample points are far away each other.
-	cuboid_structure_.split_label_cuboids();
+	// NOTE:
+	// Stages are recorded from here, after all input files are loaded.
+	std::string trace_filename = mesh_output_path + std::string("/trace.json");
+	if (FLAGS_trace_pipeline)
+	{
+		TraceRecorder::start();
+		TraceRecorder::set_counter("sample_points", cuboid_structure_.num_sample_points());
+	}
 
-	// Remove cuboids in symmetric labels.
-	cuboid_structure_.remove_symmetric_cuboids();
 
-	if (cuboid_structure_.get_all_cuboids().empty())
-		return;
-
-	update_cuboid_surface_points(cuboid_structure_, occlusion_modelview_matrix);
+	// NOTE:
+	// The key includes all inputs of the preprocessing below. The occlusion test renders
+	// the mesh, and thus the viewport size is also included.
+	MeshCuboidPreprocessingCache preprocessing_cache(FLAGS_preprocessing_cache_dir);
+	if (FLAGS_preprocessing_cache_dir != "" || FLAGS_checkpoint_prediction)
+	{
+		const std::string label_info_path = FLAGS_data_root_path + FLAGS_label_info_path + std::string("/");
+		ret = preprocessing_cache.add_file(mesh_filepath);
+		if (FLAGS_sample_points_from_mesh)
+		{
+			preprocessing_cache.add_value(FLAGS_num_sample_points);
+			preprocessing_cache.add_value(FLAGS_num_dense_sample_points);
+			preprocessing_cache.add_value(FLAGS_sample_points_seed);
+		}
+		else
+		{
+			ret = ret && preprocessing_cache.add_file(FLAGS_data_root_path + FLAGS_sample_path +
+				std::string("/") + mesh_name + std::string(".pts"));
+		}
+		ret = ret && preprocessing_cache.add_file(FLAGS_data_root_path + FLAGS_sample_label_path +
+			std::string("/") + mesh_name + std::string(".arff"))
+			&& preprocessing_cache.add_file(label_info_path + FLAGS_label_info_filename)
+			&& preprocessing_cache.add_file(label_info_path + FLAGS_label_symmetry_info_filename)
+			&& preprocessing_cache.add_file(label_info_path + FLAGS_symmetry_group_info_filename);
+		assert(ret);
 
+		preprocessing_cache.add_data(occlusion_modelview_matrix, 16 * sizeof(double));
+		preprocessing_cache.add_value(width());
+		preprocessing_cache.add_value(height());
+		preprocessing_cache.add_parameters(params);
+	}
 
-	// Sub-routine.
-	bool first_iteration = true;
-	unsigned int num_final_cuboid_structure_candidates = 0;
+	// NOTE:
+	// With 'checkpoint_prediction', the candidate exploration is saved after each stage,
+	// and a preempted prediction resumes from the last saved stage.
+	// The checkpoint is used only when it was saved with the same inputs and parameters.
+	const std::string checkpoint_filename = mesh_intermediate_path + std::string("/checkpoint.bin");
+	MeshCuboidPreprocessingCache checkpoint_key(preprocessing_cache);
+	checkpoint_key.add_all_parameters(params);
+	checkpoint_key.add_value(FLAGS_max_num_prediction_sample_points);
+	const std::string checkpoint_input_key = checkpoint_key.get_key();
 
-	std::list< std::pair<std::string, MeshCuboidStructure> > cuboid_structure_candidates;
-	cuboid_structure_candidates.push_back(std::make_pair(std::string("0"), cuboid_structure_));
-	std::set<LabelIndex> ignored_label_indices;
+	MeshCuboidPredictionCheckpoint checkpoint(&mesh_, params);
+	const bool is_resumed = FLAGS_checkpoint_prediction
+		&& checkpoint.load(checkpoint_filename, checkpoint_input_key);
 
-	while (!cuboid_structure_candidates.empty())
+	if (is_resumed)
 	{
-		// FIXME:
-		// The cuboid structure should not deep copy all sample points.
-		// Use smart pointers for sample points.
-		std::string cuboid_structure_name = cuboid_structure_candidates.front().first;
-		cuboid_structure_ = cuboid_structure_candidates.front().second;
-		cuboid_structure_candidates.pop_front();
-
-		unsigned int snapshot_index = 0;
-		log_filename_sstr.clear(); log_filename_sstr.str("");
-		log_filename_sstr << mesh_intermediate_path << filename_prefix
-			<< std::string("c_") << cuboid_structure_name << std::string("_log.txt");
-		std::ofstream log_file(log_filename_sstr.str());
-		log_file.clear(); log_file.close();
-
-
-		updateGL();
-		snapshot_filename_sstr.clear(); snapshot_filename_sstr.str("");
-		snapshot_filename_sstr << mesh_intermediate_path << filename_prefix
-			<< std::string("c_") << cuboid_structure_name << std::string("_")
-			<< std::string("s_") << snapshot_index;
-		snapshot(snapshot_filename_sstr.str().c_str());
-		++snapshot_index;
-		draw_cuboid_axes_ = true;
-		
-
-		std::cout << "\n1. Recognize labels and axes configurations." << std::endl;
-		// NOTE:
-		// Use symmetric label information only at the first time of the iteration.
-		recognize_labels_and_axes_configurations(cuboid_structure_,
-			joint_normal_predictor, log_filename_sstr.str(), first_iteration,
-			true);
-		first_iteration = false;
+		std::cout << " - Resume from the checkpoint (" << checkpoint.candidates_.size()
+			<< " candidate(s))." << std::endl;
+	}
+	else
+	{
+		bool is_cached = false;
+		if (FLAGS_preprocessing_cache_dir != "")
+		{
+			output_dir.mkpath(FLAGS_preprocessing_cache_dir.c_str());
+			is_cached = preprocessing_cache.load(cuboid_structure_);
+		}
 
-		//
-		cuboid_structure_.compute_symmetry_groups();
-		//
+		if (is_cached)
+		{
+			std::cout << " - Load the preprocessed cuboids (" << preprocessing_cache.get_key() << ")." << std::endl;
+			draw_cuboid_axes_ = false;
+		}
+		else
+		{
+			std::cout << " - Remove occluded points." << std::endl;
+			set_modelview_matrix(occlusion_modelview_matrix, false);
+			remove_occluded_points();
+			set_modelview_matrix(snapshot_modelview_matrix);
 
-		updateGL();
-		snapshot_filename_sstr.clear(); snapshot_filename_sstr.str("");
-		snapshot_filename_sstr << mesh_intermediate_path << filename_prefix
-			<< std::string("c_") << cuboid_structure_name << std::string("_")
-			<< std::string("s_") << snapshot_index;
-		snapshot(snapshot_filename_sstr.str().c_str());
-		++snapshot_index;
 
+			std::cout << " - Cluster points and construct initial cuboids." << std::endl;
+			draw_cuboid_axes_ = false;
 
-		std::cout << "\n2. Segment sample points." << std::endl;
-		segment_sample_points(cuboid_structure_);
+			cuboid_structure_.compute_label_cuboids();
 
-		updateGL();
-		snapshot_filename_sstr.clear(); snapshot_filename_sstr.str("");
-		snapshot_filename_sstr << mesh_intermediate_path << filename_prefix
-			<< std::string("c_") << cuboid_structure_name << std::string("_")
-			<< std::string("s_") << snapshot_index;
-		snapshot(snapshot_filename_sstr.str().c_str());
-		++snapshot_index;
+			// Split cuboids if sample points are far away each other.
+			cuboid_structure_.split_label_cuboids();
 
+			// Remove cuboids in symmetric labels.
+			cuboid_structure_.remove_symmetric_cuboids();
+		}
 
-		bool is_cuboid_added = false;
-		// When part relation terms are disabled, part pose optimization and additional candidate
-		// generation are NOT performed. We do part labeling since it does affect to the cuboid
-		// distance error measure.
-		if (!FLAGS_disable_part_relation_terms)
+		if (cuboid_structure_.get_all_cuboids().empty())
 		{
+			if (FLAGS_trace_pipeline) TraceRecorder::stop(trace_filename);
+			return;
+		}
 
-			std::cout << "\n3. Optimize cuboid attributes." << std::endl;
-
-			optimize_attributes(cuboid_structure_, occlusion_modelview_matrix, joint_normal_predictor,
-				FLAGS_param_opt_single_energy_term_weight, FLAGS_param_opt_symmetry_energy_term_weight,
-				FLAGS_param_opt_max_iterations, log_filename_sstr.str(), this, false);
-
-			const bool use_symmetry = !(FLAGS_disable_symmetry_terms);
-			if (use_symmetry)
-			{
-				cuboid_structure_.compute_symmetry_groups();
-
-				optimize_attributes(cuboid_structure_, occlusion_modelview_matrix, joint_normal_predictor,
-					FLAGS_param_opt_single_energy_term_weight, FLAGS_param_opt_symmetry_energy_term_weight,
-					FLAGS_param_opt_max_iterations, log_filename_sstr.str(), this, true);
-			}
-
-			updateGL();
-			snapshot_filename_sstr.clear(); snapshot_filename_sstr.str("");
-			snapshot_filename_sstr << FLAGS_output_dir + std::string("/Temp") << filename_prefix
-				<< std::string("c_") << cuboid_structure_name << std::string("_")
-				<< std::string("s_") << snapshot_index;
-			snapshot(snapshot_filename_sstr.str().c_str());
-			++snapshot_index;
-
+		if (!is_cached)
+		{
+			update_cuboid_surface_points(cuboid_structure_, occlusion_modelview_matrix);
 
-			std::cout << "\n4. Add missing cuboids." << std::endl;
-			assert(cuboid_structure_.num_labels() == num_labels);
-			std::list<LabelIndex> given_label_indices;
-			for (LabelIndex label_index = 0; label_index < num_labels; ++label_index)
-				if (!cuboid_structure_.label_cuboids_[label_index].empty())
-					given_label_indices.push_back(label_index);
+			if (FLAGS_preprocessing_cache_dir != "")
+				preprocessing_cache.save(cuboid_structure_);
+		}
 
-			std::list< std::list<LabelIndex> > missing_label_index_groups;
-			trainer.get_missing_label_index_groups(given_label_indices, missing_label_index_groups,
-				&ignored_label_indices);
+		if (FLAGS_max_num_prediction_sample_points > 0 && cuboid_structure_.num_sample_points()
+			> static_cast<unsigned int>(FLAGS_max_num_prediction_sample_points))
+		{
+			// NOTE:
+			// The full-resolution points are kept in the checkpoint, and are restored before the reconstruction.
+			std::cout << " - Downsample points." << std::endl;
+			checkpoint.full_resolution_structure_ = cuboid_structure_;
+			Real voxel_size = cuboid_structure_.downsample_sample_points(
+				FLAGS_max_num_prediction_sample_points, checkpoint.representative_indices_);
+			std::cout << "   " << checkpoint.full_resolution_structure_.num_sample_points() << " -> "
+				<< cuboid_structure_.num_sample_points() << " points (voxel size = " << voxel_size << ")." << std::endl;
+		}
 
+		checkpoint.candidates_.push_back(std::make_pair(std::string("0"), cuboid_structure_));
+	}
 
-			is_cuboid_added = (!missing_label_index_groups.empty());
 
-			if (!missing_label_index_groups.empty())
-			{
-				unsigned int missing_label_index_group_index = 0;
+	// NOTE:
+	// Intermediate results are not rendered if the intermediate snapshots are disabled.
+	PredictionObserver observer(*this, mesh_filepath, mesh_output_path, mesh_intermediate_path,
+		filename_prefix, snapshot_modelview_matrix, occlusion_modelview_matrix,
+		checkpoint_filename, checkpoint_input_key);
 
-				for (std::list< std::list<LabelIndex> >::iterator it = missing_label_index_groups.begin();
-					it != missing_label_index_groups.end(); ++it)
-				{
-					std::list<LabelIndex> &missing_label_indices = (*it);
-					MeshCuboidStructure new_cuboid_structure = cuboid_structure_;
-
-					// FIXME:
-					// Any missing cuboid may not be added.
-					// Then, you should escape the loop.
-					ret = add_missing_cuboids(new_cuboid_structure, occlusion_modelview_matrix,
-						missing_label_indices, joint_normal_predictor, ignored_label_indices);
-					//ret = add_missing_cuboids(new_cuboid_structure, occlusion_modelview_matrix,
-					//	missing_label_indices, joint_normal_relations, ignored_label_indices);
-
-					if (!ret)
-					{
-						is_cuboid_added = false;
-					}
-					else
-					{
-						std::stringstream new_cuboid_structure_name;
-						new_cuboid_structure_name << cuboid_structure_name << missing_label_index_group_index;
-						cuboid_structure_candidates.push_front(
-							std::make_pair(new_cuboid_structure_name.str(), new_cuboid_structure));
-						++missing_label_index_group_index;
-					}
-				}
-			}
-		}
+	StructureCompletion::explore_candidates(checkpoint, cuboid_structure_, _trainer,
+		joint_normal_predictor, occlusion_modelview_matrix, params, &observer);
 
-		// If there was a case when no cuboid is added, reconstruct using the current cuboid structure.
-		if (!is_cuboid_added)
-		{
-			// Escape loop.
-			snapshot_filename_sstr.clear(); snapshot_filename_sstr.str("");
-			snapshot_filename_sstr << mesh_output_path << filename_prefix << num_final_cuboid_structure_candidates;
-
-			draw_point_correspondences_ = false;
-			if (!FLAGS_no_evaluation) {
-				reconstruct(
-					mesh_filepath.c_str(),
-					snapshot_modelview_matrix,
-					occlusion_modelview_matrix,
-					snapshot_filename_sstr.str().c_str());
-				draw_point_correspondences_ = true;
-			}
-			else
-			{
-				reconstruct_scan(
-					mesh_filepath.c_str(),
-					snapshot_modelview_matrix,
-					occlusion_modelview_matrix,
-					snapshot_filename_sstr.str().c_str());
-			}
+	// NOTE:
+	// The checkpoint is removed when all candidates are finished.
+	if (FLAGS_checkpoint_prediction)
+		std::remove(checkpoint_filename.c_str());
 
-			ignored_label_indices.clear();
-			++num_final_cuboid_structure_candidates;
-		}
-	}
+	if (FLAGS_trace_pipeline)
+		TraceRecorder::stop(trace_filename);
 
 
 	//annDeallocPts(occlusion_test_ann_points);
@@ -1288,7 +1530,7 @@ void MeshViewerCore::run_symmetry_detection()
 
 	std::list<SymmetryDetection::ReflectionPlane> reflection_planes;
 	SymmetryDetection::detect_reflectional_symmetry(sample_points,
-		FLAGS_param_sparse_neighbor_distance, 0.7, reflection_planes);
+		cuboid_structure_.get_parameters().sparse_neighbor_distance_, 0.7, reflection_planes);
 
 	//
 	for (std::vector< MeshCuboidReflectionSymmetryGroup* >::iterator it
@@ -1341,25 +1583,19 @@ void MeshViewerCore::run_symmetry_detection_msh2pln()
 	}
 
 	// View plane mask.
-	if (FLAGS_use_view_plane_mask)
+	MeshCuboidParameters params;
+	if (params.use_view_plane_mask_)
 	{
 		std::string mesh_output_path = FLAGS_output_dir + std::string("/") + mesh_name;
 		std::string view_plane_mask_filename = mesh_output_path + std::string("/view_mask.txt");
-		std::ifstream view_plane_mask_file(view_plane_mask_filename.c_str());
 
-		if (!view_plane_mask_file.is_open())
+		if (!params.load_view_plane_mask(view_plane_mask_filename))
 		{
 			std::cerr << "Error: The view plane mask file is not opened (" << view_plane_mask_filename << ")." << std::endl;
 			return;
 		}
-
-		std::string buffer;
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_min_x = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_min_y = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_max_x = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_max_y = std::atof(buffer.c_str());
-		view_plane_mask_file.close();
 	}
+	cuboid_structure_.set_parameters(params);
 
 
 	std::string filename_prefix = std::string("/") + mesh_name + std::string("_");
@@ -1408,20 +1644,16 @@ void MeshViewerCore::run_symmetry_detection_msh2pln()
 
 	//
 	unsigned int num_sample_points = cuboid_structure_.num_sample_points();
-	std::vector<MyMesh::Point> sample_points(num_sample_points);
 	Eigen::MatrixXd sample_points_mat(3, num_sample_points);
 
 	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points; ++sample_point_index)
 	{
 		MeshSamplePoint *sample_point = cuboid_structure_.sample_points_[sample_point_index];
 		assert(sample_point);
-		sample_points[sample_point_index] = sample_point->point_;
 		for (unsigned int i = 0; i < 3; ++i)
 			sample_points_mat.col(sample_point_index)[i] = sample_point->point_[i];
 	}
 
-	ANNpointArray sample_ann_points;
-	ANNkd_tree *sample_ann_kd_tree = ICP::create_kd_tree(sample_points_mat, sample_ann_points);
 	//
 
 
@@ -1438,8 +1670,10 @@ void MeshViewerCore::run_symmetry_detection_msh2pln()
 	std::stringstream strstr;
 	std::string token;
 	
-	const Real squared_neighbor_distance = FLAGS_param_sparse_neighbor_distance *
-		FLAGS_param_sparse_neighbor_distance * mesh_.get_object_diameter();
+	const Real sparse_neighbor_distance = cuboid_structure_.get_parameters().sparse_neighbor_distance_;
+	const Real squared_neighbor_distance = sparse_neighbor_distance *
+		sparse_neighbor_distance * mesh_.get_object_diameter();
+	PointHashGrid sample_point_grid(sample_points_mat, std::sqrt(squared_neighbor_distance));
 
 	unsigned int max_num_symmetric_point_pairs = 0;
 	assert(cuboid_structure_.reflection_symmetry_groups_.empty());
@@ -1482,9 +1716,9 @@ void MeshViewerCore::run_symmetry_detection_msh2pln()
 			normal, dot(normal, center));
 		
 
-		std::list<MeshCuboidSymmetryGroup::WeightedPointPair> sample_point_pairs;
+		std::vector<MeshCuboidSymmetryGroup::WeightedPointPair> sample_point_pairs;
 		new_symmetry_group->get_symmetric_sample_point_pairs(
-			sample_points, sample_ann_points, sample_ann_kd_tree,
+			sample_points_mat, sample_points_mat, sample_point_grid,
 			squared_neighbor_distance, sample_point_pairs);
 
 		if (sample_point_pairs.size() > max_num_symmetric_point_pairs)
@@ -1503,8 +1737,6 @@ void MeshViewerCore::run_symmetry_detection_msh2pln()
 	}
 
 	file.close();
-	annDeallocPts(sample_ann_points);
-	delete sample_ann_kd_tree;
 
 	
 	output_filename_sstr.clear(); output_filename_sstr.str("");
@@ -1591,25 +1823,19 @@ void MeshViewerCore::run_baseline_stats()
 	}
 
 	// View plane mask.
-	if (FLAGS_use_view_plane_mask)
+	MeshCuboidParameters params;
+	if (params.use_view_plane_mask_)
 	{
 		std::string mesh_output_path = FLAGS_output_dir + std::string("/") + mesh_name;
 		std::string view_plane_mask_filename = mesh_output_path + std::string("/view_mask.txt");
-		std::ifstream view_plane_mask_file(view_plane_mask_filename.c_str());
 
-		if (!view_plane_mask_file.is_open())
+		if (!params.load_view_plane_mask(view_plane_mask_filename))
 		{
 			std::cerr << "Error: The view plane mask file is not opened (" << view_plane_mask_filename << ")." << std::endl;
 			return;
 		}
-
-		std::string buffer;
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_min_x = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_min_y = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_max_x = std::atof(buffer.c_str());
-		std::getline(view_plane_mask_file, buffer); FLAGS_param_view_plane_mask_max_y = std::atof(buffer.c_str());
-		view_plane_mask_file.close();
 	}
+	cuboid_structure_.set_parameters(params);
 
 
 	std::string filename_prefix = std::string("/") + mesh_name + std::string("_");
@@ -1957,7 +2183,8 @@ void MeshViewerCore::test_figure_1()
 	std::vector< std::vector<MeshCuboidJointNormalRelations *> > joint_normal_relations;
 	//MeshCuboidTrainer::load_joint_normal_relations(num_labels, "joint_normal_", joint_normal_relations);
 	trainer.get_joint_normal_relations(joint_normal_relations, &ignored_object_list);
-	MeshCuboidJointNormalRelationPredictor joint_normal_predictor(joint_normal_relations);
+	MeshCuboidJointNormalRelationPredictor joint_normal_predictor(joint_normal_relations,
+		cuboid_structure_.get_parameters());
 
 
 	assert(cuboid_structure_.label_cuboids_.size() == num_labels);
@@ -2148,7 +2375,8 @@ void MeshViewerCore::test_figure_1()
 	updateGL();
 }
 
-void MeshViewerCore::compute_view_plane_mask_range(const Real _modelview_matrix[16])
+void MeshViewerCore::compute_view_plane_mask_range(const Real _modelview_matrix[16],
+	MeshCuboidParameters &_params)
 {
 	unsigned int num_sample_points = cuboid_structure_.num_sample_points();
 	assert(num_sample_points > 0);
@@ -2162,10 +2390,10 @@ void MeshViewerCore::compute_view_plane_mask_range(const Real _modelview_matrix[
 		sample_points[sample_point_index] = sample_point->point_;
 	}
 
-	FLAGS_param_view_plane_mask_min_x = 0;
-	FLAGS_param_view_plane_mask_min_y = 0;
-	FLAGS_param_view_plane_mask_max_x = 0;
-	FLAGS_param_view_plane_mask_max_y = 0;
+	_params.view_plane_mask_min_x_ = 0;
+	_params.view_plane_mask_min_y_ = 0;
+	_params.view_plane_mask_max_x_ = 0;
+	_params.view_plane_mask_max_y_ = 0;
 
 
 	Eigen::Matrix3d rotation_mat;
@@ -2257,11 +2485,11 @@ void MeshViewerCore::compute_view_plane_mask_range(const Real _modelview_matrix[
 		}
 
 		Real removed_point_proportion = static_cast<Real>(num_removed_points) / num_points;
-		if (std::abs(removed_point_proportion - FLAGS_param_view_plane_mask_proportion) < 0.01)
+		if (std::abs(removed_point_proportion - _params.view_plane_mask_proportion_) < 0.01)
 		{
 			break;
 		}
-		else if (removed_point_proportion < FLAGS_param_view_plane_mask_proportion)
+		else if (removed_point_proportion < _params.view_plane_mask_proportion_)
 		{
 			// Increase the mask size.
 			scale_factor += std::pow(0.5, iter + 1);
@@ -2277,10 +2505,10 @@ void MeshViewerCore::compute_view_plane_mask_range(const Real _modelview_matrix[
 	Eigen::Vector2d view_plane_mask_range_min = view_plane_mask_range_center - view_plane_mask_range_size;
 	Eigen::Vector2d view_plane_mask_range_max = view_plane_mask_range_center + view_plane_mask_range_size;
 
-	FLAGS_param_view_plane_mask_min_x = view_plane_mask_range_min[0];
-	FLAGS_param_view_plane_mask_min_y = view_plane_mask_range_min[1];
-	FLAGS_param_view_plane_mask_max_x = view_plane_mask_range_max[0];
-	FLAGS_param_view_plane_mask_max_y = view_plane_mask_range_max[1];
+	_params.view_plane_mask_min_x_ = view_plane_mask_range_min[0];
+	_params.view_plane_mask_min_y_ = view_plane_mask_range_min[1];
+	_params.view_plane_mask_max_x_ = view_plane_mask_range_max[0];
+	_params.view_plane_mask_max_y_ = view_plane_mask_range_max[1];
 }
 
 /*
@@ -2335,7 +2563,8 @@ void MeshViewerCore::run_occlusion_test()
 
 	std::array<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>, 4> occlusion_test_result;
 	occlusion_test_widget_->get_occlusion_test_result(
-		static_cast<float>(FLAGS_param_occlusion_test_neighbor_distance), occlusion_test_result);
+		static_cast<float>(cuboid_structure_.get_parameters().occlusion_test_neighbor_distance_),
+		occlusion_test_result);
 
 	occlusion_test_points_.clear();
 	occlusion_test_points_.reserve(occlusion_test_result[0].rows() * occlusion_test_result[0].cols());
@@ -54,7 +54,8 @@ void MeshViewerCore::test_initialize()
 	}
 
 	delete test_joint_normal_predictor_;
-	test_joint_normal_predictor_ = new MeshCuboidJointNormalRelationPredictor(test_joint_normal_relations_);
+	test_joint_normal_predictor_ = new MeshCuboidJointNormalRelationPredictor(test_joint_normal_relations_,
+		cuboid_structure_.get_parameters());
 
 	all_cuboids_.clear();
 	for (std::vector< std::vector<MeshCuboid *> >::iterator it = cuboid_structure_.label_cuboids_.begin();
@@ -143,9 +144,10 @@ void MeshViewerCore::test_scale(const Real _scale_x, const Real _scale_y)
 
 void MeshViewerCore::test_optimize()
 {
+	const MeshCuboidParameters &params = cuboid_structure_.get_parameters();
 	optimize_attributes(cuboid_structure_, test_occlusion_modelview_matrix_, *test_joint_normal_predictor_,
-		FLAGS_param_opt_single_energy_term_weight, FLAGS_param_opt_symmetry_energy_term_weight,
-		FLAGS_param_opt_max_iterations, "log.txt", this, false);
+		params.opt_single_energy_term_weight_, params.opt_symmetry_energy_term_weight_,
+		params.opt_max_iterations_, "log.txt", this, false);
 }
 
 
@@ -0,0 +1,243 @@
+#include "SnapshotWriter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+
+const unsigned char *SnapshotImage::row(const unsigned int _y) const
+{
+	assert(_y < height_);
+	const unsigned int row_index = is_bottom_up_ ? (height_ - 1 - _y) : _y;
+	return &data_[row_index * width_ * num_channels_];
+}
+
+SnapshotWriter::SnapshotWriter(const unsigned int _max_queue_size)
+	: max_queue_size_(std::max(_max_queue_size, 1u))
+	, is_running_job_(false)
+	, is_stopped_(false)
+	, num_written_(0)
+{
+	thread_ = std::thread(&SnapshotWriter::run, this);
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		is_stopped_ = true;
+	}
+	job_pushed_.notify_all();
+	thread_.join();
+}
+
+void SnapshotWriter::push(const std::string &_filename, SnapshotImage &_image, Encoder _encoder)
+{
+	assert(_encoder);
+	assert(_image.num_channels_ >= 3);
+	assert(_image.data_.size() == _image.width_ * _image.height_ * _image.num_channels_);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (queue_.size() >= max_queue_size_)
+		job_popped_.wait(lock);
+
+	queue_.push_back(Job());
+	Job &job = queue_.back();
+	job.filename_ = _filename;
+	job.image_ = std::move(_image);
+	job.encoder_ = _encoder;
+	_image.data_.clear();
+
+	lock.unlock();
+	job_pushed_.notify_one();
+}
+
+void SnapshotWriter::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (!queue_.empty() || is_running_job_)
+		job_done_.wait(lock);
+}
+
+unsigned int SnapshotWriter::num_written() const
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	return num_written_;
+}
+
+void SnapshotWriter::run()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (queue_.empty() && !is_stopped_)
+				job_pushed_.wait(lock);
+
+			// NOTE:
+			// Remaining jobs are written even after stopped.
+			if (queue_.empty())
+				break;
+
+			job = std::move(queue_.front());
+			queue_.pop_front();
+			is_running_job_ = true;
+		}
+		job_popped_.notify_one();
+
+		bool ret = (*job.encoder_)(job.filename_, job.image_);
+		if (!ret)
+			std::cerr << "Error: Cannot write the snapshot (" << job.filename_ << ")." << std::endl;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			is_running_job_ = false;
+			if (ret) ++num_written_;
+		}
+		job_done_.notify_all();
+	}
+}
+
+bool SnapshotWriter::write_ppm(const std::string &_filename, const SnapshotImage &_image)
+{
+	std::ofstream file(_filename.c_str(), std::ios::out | std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	file << "P6\n" << _image.width_ << " " << _image.height_ << "\n255\n";
+
+	std::vector<unsigned char> buffer(3 * _image.width_);
+	for (unsigned int y = 0; y < _image.height_; ++y)
+	{
+		const unsigned char *row = _image.row(y);
+		for (unsigned int x = 0; x < _image.width_; ++x)
+			memcpy(&buffer[3 * x], &row[_image.num_channels_ * x], 3);
+		file.write(reinterpret_cast<const char *>(&buffer[0]), buffer.size());
+	}
+
+	return file.good();
+}
+
+bool SnapshotWriter::write_qoi(const std::string &_filename, const SnapshotImage &_image)
+{
+	std::ofstream file(_filename.c_str(), std::ios::out | std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	// NOTE:
+	// Worst case: 4 bytes for each pixel (QOI_OP_RGB).
+	std::vector<unsigned char> buffer;
+	buffer.reserve(14 + 4 * _image.width_ * _image.height_ + 8);
+
+	// Header.
+	const char magic[4] = { 'q', 'o', 'i', 'f' };
+	buffer.insert(buffer.end(), magic, magic + 4);
+	for (int i = 3; i >= 0; --i) buffer.push_back((_image.width_ >> (8 * i)) & 0xff);
+	for (int i = 3; i >= 0; --i) buffer.push_back((_image.height_ >> (8 * i)) & 0xff);
+	buffer.push_back(3);	// Channels.
+	buffer.push_back(0);	// sRGB.
+
+	// NOTE:
+	// The index stores RGBA values as in the decoder. Since unused entries have
+	// zero alpha, they never match an input pixel.
+	unsigned char index[64][4];
+	memset(index, 0, sizeof(index));
+	unsigned char prev[3] = { 0, 0, 0 };
+	unsigned int run = 0;
+
+	for (unsigned int y = 0; y < _image.height_; ++y)
+	{
+		const unsigned char *row = _image.row(y);
+		for (unsigned int x = 0; x < _image.width_; ++x)
+		{
+			const unsigned char *pixel = &row[_image.num_channels_ * x];
+
+			if (pixel[0] == prev[0] && pixel[1] == prev[1] && pixel[2] == prev[2])
+			{
+				++run;
+				if (run == 62)
+				{
+					buffer.push_back(0xc0 | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0)
+			{
+				buffer.push_back(0xc0 | (run - 1));
+				run = 0;
+			}
+
+			// NOTE:
+			// Alpha is always 255.
+			const unsigned int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + 255 * 11) % 64;
+
+			if (index[hash][0] == pixel[0] && index[hash][1] == pixel[1] && index[hash][2] == pixel[2]
+				&& index[hash][3] == 255)
+			{
+				buffer.push_back(hash);
+			}
+			else
+			{
+				memcpy(index[hash], pixel, 3);
+				index[hash][3] = 255;
+
+				const signed char dr = static_cast<signed char>(pixel[0] - prev[0]);
+				const signed char dg = static_cast<signed char>(pixel[1] - prev[1]);
+				const signed char db = static_cast<signed char>(pixel[2] - prev[2]);
+				const signed char dr_dg = dr - dg;
+				const signed char db_dg = db - dg;
+
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				{
+					buffer.push_back(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+				}
+				else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+				{
+					buffer.push_back(0x80 | (dg + 32));
+					buffer.push_back(((dr_dg + 8) << 4) | (db_dg + 8));
+				}
+				else
+				{
+					buffer.push_back(0xfe);
+					buffer.insert(buffer.end(), pixel, pixel + 3);
+				}
+			}
+
+			memcpy(prev, pixel, 3);
+		}
+	}
+
+	if (run > 0)
+		buffer.push_back(0xc0 | (run - 1));
+
+	// End marker.
+	const unsigned char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	buffer.insert(buffer.end(), padding, padding + 8);
+
+	file.write(reinterpret_cast<const char *>(&buffer[0]), buffer.size());
+	return file.good();
+}
+
+bool SnapshotWriter::get_encoder(const std::string &_format, Encoder &_encoder, std::string &_extension)
+{
+	if (_format == "ppm")
+	{
+		_encoder = &SnapshotWriter::write_ppm;
+		_extension = ".ppm";
+		return true;
+	}
+	else if (_format == "qoi")
+	{
+		_encoder = &SnapshotWriter::write_qoi;
+		_extension = ".qoi";
+		return true;
+	}
+
+	return false;
+}
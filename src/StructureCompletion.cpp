@@ -0,0 +1,423 @@
+#include "StructureCompletion.h"
+
+#include "MeshCuboidParameters.h"
+#include "MeshCuboidPredictionCheckpoint.h"
+#include "MeshCuboidPredictor.h"
+#include "MeshCuboidSolver.h"
+#include "TraceRecorder.h"
+
+#include <cassert>
+#include <iostream>
+#include <list>
+#include <set>
+#include <sstream>
+
+
+StructureCompletion::StructureCompletion()
+	: is_model_loaded_(false)
+	, label_info_(&label_info_mesh_)
+{
+
+}
+
+StructureCompletion::~StructureCompletion()
+{
+	clear();
+}
+
+void StructureCompletion::clear()
+{
+	for (LabelIndex label_index_1 = 0; label_index_1 < joint_normal_relations_.size(); ++label_index_1)
+		for (LabelIndex label_index_2 = 0; label_index_2 < joint_normal_relations_[label_index_1].size(); ++label_index_2)
+			delete joint_normal_relations_[label_index_1][label_index_2];
+	joint_normal_relations_.clear();
+
+	label_info_.clear();
+	trainer_.clear();
+	is_model_loaded_ = false;
+}
+
+bool StructureCompletion::load_model(bool _verbose)
+{
+	return load_model(FLAGS_data_root_path + FLAGS_label_info_path, FLAGS_training_dir, _verbose);
+}
+
+bool StructureCompletion::load_model(const std::string &_label_info_path,
+	const std::string &_training_dir, bool _verbose)
+{
+	clear();
+
+	bool ret = true;
+	ret = ret & label_info_.load_labels((_label_info_path +
+		FLAGS_label_info_filename).c_str(), _verbose);
+	ret = ret & label_info_.load_label_symmetries((_label_info_path +
+		FLAGS_label_symmetry_info_filename).c_str(), _verbose);
+	ret = ret & label_info_.load_symmetry_groups((_label_info_path +
+		FLAGS_symmetry_group_info_filename).c_str(), _verbose);
+
+	if (!ret)
+	{
+		std::cerr << "Error: Cannot open label information files." << std::endl;
+		return false;
+	}
+
+	ret = ret & trainer_.load_object_list(_training_dir + std::string("/") + FLAGS_object_list_filename);
+	ret = ret & trainer_.load_features(_training_dir + std::string("/") + FLAGS_feature_filename_prefix);
+	ret = ret & trainer_.load_transformations(_training_dir + std::string("/") + FLAGS_transformation_filename_prefix);
+
+	if (!ret)
+	{
+		std::cerr << "Error: Cannot open training files." << std::endl;
+		return false;
+	}
+
+	// NOTE:
+	// Relations do not depend on the input, and are computed only once.
+	trainer_.get_joint_normal_relations(joint_normal_relations_);
+
+	is_model_loaded_ = true;
+	return true;
+}
+
+static void get_result(MeshCuboidStructure &_cuboid_structure,
+	StructureCompletion::Result &_result);
+
+// Reconstruct each final cuboid structure using symmetry, and record it as a result.
+class ResultCollector : public StructureCompletionObserver
+{
+public:
+	ResultCollector(std::vector<StructureCompletion::Result> &_results)
+		: results_(_results) {}
+
+	virtual void candidate_finished(const std::string &_candidate_name,
+		const unsigned int _final_candidate_index,
+		MeshCuboidStructure &_cuboid_structure)
+	{
+		// Reconstruction using symmetry.
+		_cuboid_structure.copy_sample_points_to_symmetric_position();
+
+		// NOTE:
+		// The label of reconstructed points are recorded as confidence values.
+		_cuboid_structure.set_sample_point_label_confidence_using_cuboids();
+
+		results_.push_back(StructureCompletion::Result());
+		get_result(_cuboid_structure, results_.back());
+	}
+
+private:
+	std::vector<StructureCompletion::Result> &results_;
+};
+
+bool StructureCompletion::complete(const Eigen::MatrixXd &_points,
+	const Eigen::MatrixXd &_normals,
+	const Eigen::MatrixXd &_point_label_confidences,
+	const Real _modelview_matrix[16],
+	const MeshCuboidParameters &_params,
+	std::vector<Result> &_results) const
+{
+	assert(is_model_loaded_);
+	_results.clear();
+
+	const unsigned int num_points = _points.cols();
+	const unsigned int num_labels = label_info_.num_labels();
+	assert(_points.rows() == 3);
+	assert(_normals.rows() == 3);
+	assert(_normals.cols() == num_points);
+	assert(_point_label_confidences.rows() == num_points);
+	assert(_point_label_confidences.cols() == num_labels);
+
+	if (num_points == 0)
+		return false;
+
+	TraceScope trace_scope("complete");
+	trace_scope.add_arg("points", num_points);
+
+	// NOTE:
+	// The mesh has only vertices, and it is used to normalize the input points
+	// in the same way with the input meshes.
+	MyMesh mesh;
+	for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+	{
+		mesh.add_vertex(MyMesh::Point(_points(0, point_index),
+			_points(1, point_index), _points(2, point_index)));
+	}
+	mesh.initialize(false);
+
+	MeshCuboidStructure cuboid_structure(&mesh);
+	cuboid_structure = label_info_;
+	cuboid_structure.mesh_ = &mesh;
+	cuboid_structure.set_parameters(_params);
+
+	for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+	{
+		cuboid_structure.add_sample_point(
+			MyMesh::Point(_points(0, point_index), _points(1, point_index), _points(2, point_index)),
+			MyMesh::Normal(_normals(0, point_index), _normals(1, point_index), _normals(2, point_index)));
+	}
+
+	assert(cuboid_structure.num_labels() == num_labels);
+	cuboid_structure.sample_label_confidences_.set_matrix(_point_label_confidences);
+
+	cuboid_structure.apply_mesh_transformation();
+
+
+	MeshCuboidJointNormalRelationPredictor joint_normal_predictor(joint_normal_relations_, _params);
+
+	cuboid_structure.compute_label_cuboids();
+
+	// Split cuboids if sample points are far away each other.
+	cuboid_structure.split_label_cuboids();
+
+	// Remove cuboids in symmetric labels.
+	cuboid_structure.remove_symmetric_cuboids();
+
+	if (cuboid_structure.get_all_cuboids().empty())
+		return false;
+
+	update_cuboid_surface_points(cuboid_structure, _modelview_matrix);
+
+
+	MeshCuboidPredictionCheckpoint state(&mesh, _params);
+	state.candidates_.push_back(std::make_pair(std::string("0"), cuboid_structure));
+
+	ResultCollector result_collector(_results);
+	explore_candidates(state, cuboid_structure, trainer_, joint_normal_predictor,
+		_modelview_matrix, _params, &result_collector);
+
+	return true;
+}
+
+void StructureCompletion::explore_candidates(MeshCuboidPredictionCheckpoint &_state,
+	MeshCuboidStructure &_cuboid_structure,
+	const MeshCuboidTrainer &_trainer,
+	const MeshCuboidJointNormalRelationPredictor &_predictor,
+	const Real _modelview_matrix[16],
+	const MeshCuboidParameters &_params,
+	StructureCompletionObserver *_observer)
+{
+	StructureCompletionObserver default_observer;
+	StructureCompletionObserver *observer = _observer ? _observer : &default_observer;
+	MeshCuboidSolverObserver *solver_observer = observer->get_solver_observer();
+
+	// NOTE:
+	// The current candidate stays at the front of the list until it is finished.
+	std::list< std::pair<std::string, MeshCuboidStructure> > &cuboid_structure_candidates = _state.candidates_;
+	std::set<LabelIndex> &ignored_label_indices = _state.ignored_label_indices_;
+
+	// Save the current candidate, which resumes from '_next_stage', and the other candidates.
+	auto save_checkpoint = [&](const unsigned int _next_stage)
+	{
+		if (!observer->is_checkpoint_enabled()) return;
+		if (_next_stage != MeshCuboidPredictionCheckpoint::RecognizeStage)
+			cuboid_structure_candidates.front().second = _cuboid_structure;
+		_state.next_stage_ = _next_stage;
+		observer->save_checkpoint(_state);
+	};
+
+	while (!cuboid_structure_candidates.empty())
+	{
+		// FIXME:
+		// The cuboid structure should not deep copy all sample points.
+		// Use smart pointers for sample points.
+		const std::string cuboid_structure_name = cuboid_structure_candidates.front().first;
+		_cuboid_structure = cuboid_structure_candidates.front().second;
+		const unsigned int num_labels = _cuboid_structure.num_labels();
+
+		const unsigned int start_stage = _state.next_stage_;
+		_state.next_stage_ = MeshCuboidPredictionCheckpoint::RecognizeStage;
+
+		TraceScope trace_scope("candidate");
+		trace_scope.add_arg("points", _cuboid_structure.num_sample_points());
+		trace_scope.add_arg("cuboids", _cuboid_structure.get_all_cuboids().size());
+		TraceRecorder::set_counter("sample_points", _cuboid_structure.num_sample_points());
+		TraceRecorder::set_counter("cuboids", _cuboid_structure.get_all_cuboids().size());
+
+		const std::string log_filename = observer->get_log_filename(cuboid_structure_name);
+		observer->candidate_started(cuboid_structure_name, start_stage);
+
+
+		if (start_stage <= MeshCuboidPredictionCheckpoint::RecognizeStage)
+		{
+			std::cout << "\n1. Recognize labels and axes configurations." << std::endl;
+			// NOTE:
+			// Use symmetric label information only at the first time of the iteration.
+			recognize_labels_and_axes_configurations(_cuboid_structure,
+				_predictor, log_filename, _state.first_iteration_, true);
+			_state.first_iteration_ = false;
+
+			//
+			_cuboid_structure.compute_symmetry_groups();
+			//
+
+			observer->stage_finished(cuboid_structure_name, MeshCuboidPredictionCheckpoint::RecognizeStage);
+			save_checkpoint(MeshCuboidPredictionCheckpoint::SegmentStage);
+		}
+
+
+		if (start_stage <= MeshCuboidPredictionCheckpoint::SegmentStage)
+		{
+			std::cout << "\n2. Segment sample points." << std::endl;
+			segment_sample_points(_cuboid_structure);
+
+			observer->stage_finished(cuboid_structure_name, MeshCuboidPredictionCheckpoint::SegmentStage);
+			save_checkpoint(MeshCuboidPredictionCheckpoint::OptimizeStage);
+		}
+
+
+		bool is_cuboid_added = false;
+		// When part relation terms are disabled, part pose optimization and additional candidate
+		// generation are NOT performed. We do part labeling since it does affect to the cuboid
+		// distance error measure.
+		if (!_params.disable_part_relation_terms_)
+		{
+			if (start_stage <= MeshCuboidPredictionCheckpoint::OptimizeStage)
+			{
+				std::cout << "\n3. Optimize cuboid attributes." << std::endl;
+
+				optimize_attributes(_cuboid_structure, _modelview_matrix, _predictor,
+					_params.opt_single_energy_term_weight_, _params.opt_symmetry_energy_term_weight_,
+					_params.opt_max_iterations_, log_filename, solver_observer, false);
+
+				const bool use_symmetry = !(_params.disable_symmetry_terms_);
+				if (use_symmetry)
+				{
+					_cuboid_structure.compute_symmetry_groups();
+
+					optimize_attributes(_cuboid_structure, _modelview_matrix, _predictor,
+						_params.opt_single_energy_term_weight_, _params.opt_symmetry_energy_term_weight_,
+						_params.opt_max_iterations_, log_filename, solver_observer, true);
+				}
+
+				observer->stage_finished(cuboid_structure_name, MeshCuboidPredictionCheckpoint::OptimizeStage);
+				save_checkpoint(MeshCuboidPredictionCheckpoint::AddMissingCuboidsStage);
+			}
+
+
+			if (start_stage <= MeshCuboidPredictionCheckpoint::AddMissingCuboidsStage)
+			{
+				std::cout << "\n4. Add missing cuboids." << std::endl;
+				std::list<LabelIndex> given_label_indices;
+				for (LabelIndex label_index = 0; label_index < num_labels; ++label_index)
+					if (!_cuboid_structure.label_cuboids_[label_index].empty())
+						given_label_indices.push_back(label_index);
+
+				std::list< std::list<LabelIndex> > missing_label_index_groups;
+				_trainer.get_missing_label_index_groups(given_label_indices, missing_label_index_groups,
+					&ignored_label_indices);
+
+
+				is_cuboid_added = (!missing_label_index_groups.empty());
+
+				unsigned int missing_label_index_group_index = 0;
+
+				for (std::list< std::list<LabelIndex> >::iterator it = missing_label_index_groups.begin();
+					it != missing_label_index_groups.end(); ++it)
+				{
+					std::list<LabelIndex> &missing_label_indices = (*it);
+					MeshCuboidStructure new_cuboid_structure = _cuboid_structure;
+
+					// FIXME:
+					// Any missing cuboid may not be added.
+					// Then, you should escape the loop.
+					bool ret = add_missing_cuboids(new_cuboid_structure, _modelview_matrix,
+						missing_label_indices, _predictor, ignored_label_indices);
+
+					if (!ret)
+					{
+						is_cuboid_added = false;
+					}
+					else
+					{
+						// NOTE:
+						// New candidates are processed right after the current candidate,
+						// the last one first.
+						std::stringstream new_cuboid_structure_name;
+						new_cuboid_structure_name << cuboid_structure_name << missing_label_index_group_index;
+						cuboid_structure_candidates.insert(++cuboid_structure_candidates.begin(),
+							std::make_pair(new_cuboid_structure_name.str(), new_cuboid_structure));
+						++missing_label_index_group_index;
+					}
+				}
+			}
+		}
+
+		// If there was a case when no cuboid is added, reconstruct using the current cuboid structure.
+		if (!is_cuboid_added)
+		{
+			if (start_stage < MeshCuboidPredictionCheckpoint::ReconstructStage)
+				save_checkpoint(MeshCuboidPredictionCheckpoint::ReconstructStage);
+
+			// Propagate the labels and cuboids of the downsampled points to all input points.
+			if (!_state.representative_indices_.empty())
+			{
+				_cuboid_structure.upsample_sample_points(_state.full_resolution_structure_,
+					_state.representative_indices_);
+			}
+
+			observer->candidate_finished(cuboid_structure_name, _state.num_final_candidates_,
+				_cuboid_structure);
+
+			ignored_label_indices.clear();
+			++_state.num_final_candidates_;
+		}
+
+		cuboid_structure_candidates.pop_front();
+		save_checkpoint(MeshCuboidPredictionCheckpoint::RecognizeStage);
+	}
+}
+
+static void get_result(MeshCuboidStructure &_cuboid_structure,
+	StructureCompletion::Result &_result)
+{
+	// NOTE:
+	// Undo the normalization of the input points.
+	// (normalized point) = scale * (input point) + translation.
+	const Real scale = _cuboid_structure.scale_;
+	const MyMesh::Normal translation = _cuboid_structure.translation_;
+	assert(scale > 0);
+
+	std::vector<MeshCuboid *> all_cuboids = _cuboid_structure.get_all_cuboids();
+	_result.cuboids_.clear();
+	_result.cuboids_.reserve(all_cuboids.size());
+
+	for (std::vector<MeshCuboid *>::const_iterator it = all_cuboids.begin();
+		it != all_cuboids.end(); ++it)
+	{
+		const MeshCuboid *cuboid = (*it);
+		assert(cuboid);
+
+		StructureCompletion::Cuboid output_cuboid;
+		output_cuboid.label_ = _cuboid_structure.get_label(cuboid->get_label_index());
+		output_cuboid.bbox_center_ = (cuboid->get_bbox_center() - translation) / scale;
+		output_cuboid.bbox_axes_ = cuboid->get_bbox_axes();
+		output_cuboid.bbox_size_ = cuboid->get_bbox_size() / scale;
+		_result.cuboids_.push_back(output_cuboid);
+	}
+
+	std::vector<LabelIndex> sample_point_label_indices;
+	_cuboid_structure.get_sample_point_label_indices_from_confidences(sample_point_label_indices);
+
+	const unsigned int num_sample_points = _cuboid_structure.num_sample_points();
+	assert(sample_point_label_indices.size() == num_sample_points);
+	_result.points_.resize(3, num_sample_points);
+	_result.normals_.resize(3, num_sample_points);
+	_result.point_labels_.resize(num_sample_points);
+
+	for (SamplePointIndex sample_point_index = 0; sample_point_index < num_sample_points;
+		++sample_point_index)
+	{
+		const MeshSamplePoint *sample_point = _cuboid_structure.sample_points_[sample_point_index];
+		assert(sample_point);
+
+		MyMesh::Point point = (sample_point->point_ - translation) / scale;
+		for (int i = 0; i < 3; ++i)
+		{
+			_result.points_(i, sample_point_index) = point[i];
+			_result.normals_(i, sample_point_index) = sample_point->normal_[i];
+		}
+
+		LabelIndex label_index = sample_point_label_indices[sample_point_index];
+		_result.point_labels_[sample_point_index] = (label_index < _cuboid_structure.num_labels()) ?
+			_cuboid_structure.get_label(label_index) : -1;
+	}
+}
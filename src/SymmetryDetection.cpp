@@ -1,6 +1,11 @@
 #include "SymmetryDetection.h"
+#include "PointHashGrid.h"
 #include "simplerandom.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
 Eigen::VectorXd get_symmetric_point(
 	const Eigen::VectorXd& _normal,
 	const Eigen::VectorXd& _center,
@@ -29,19 +34,131 @@ Eigen::MatrixXd get_symmetric_point(
 	return symmetric_point;
 }
 
+struct ReflectionHypothesis
+{
+	ReflectionHypothesis() : is_accepted_(false) {}
+	bool is_accepted_;
+	SymmetryDetection::ReflectionPlane plane_;
+};
+
+inline Eigen::Vector3d get_reflected_point(
+	const Eigen::Vector3d& _normal,
+	const Eigen::Vector3d& _center,
+	const Eigen::Vector3d& _point)
+{
+	// Assume that '_normal' is normalized.
+	return _point - (2 * _normal.dot(_point - _center)) * _normal;
+}
+
+void evaluate_reflection_hypothesis(
+	const unsigned int _hypothesis_index,
+	const unsigned int _seed,
+	const Eigen::MatrixXd &_sparse_points,
+	const PointHashGrid &_sparse_grid,
+	const double &_inlier_dist, const double &_inlier_ratio,
+	ReflectionHypothesis &_hypothesis)
+{
+	const unsigned int num_sparse_points = _sparse_points.cols();
+	_hypothesis.is_accepted_ = false;
+
+	// Random number stream of this hypothesis.
+	SimpleRandomCong_t rng_cong;
+	uint32_t seeds[2] = { _seed, _hypothesis_index };
+	simplerandom_cong_seed_array(&rng_cong, seeds, 2, true);
+
+	unsigned int sparse_index_1 = simplerandom_cong_next(&rng_cong) % num_sparse_points;
+	unsigned int sparse_index_2 = simplerandom_cong_next(&rng_cong) % num_sparse_points;
+
+	Eigen::Vector3d sparse_point_1 = _sparse_points.col(sparse_index_1);
+	Eigen::Vector3d sparse_point_2 = _sparse_points.col(sparse_index_2);
+	if ((sparse_point_2 - sparse_point_1).norm() == 0)
+		return;
+
+	SymmetryDetection::ReflectionPlane &reflection_plane = _hypothesis.plane_;
+	reflection_plane.normal_ = sparse_point_2 - sparse_point_1;
+	reflection_plane.normal_.normalize();
+	reflection_plane.point_ = 0.5 * (sparse_point_1 + sparse_point_2);
+
+
+	// Pre-score the hypothesis using a small random subset.
+	const unsigned int num_prescore_points = SYMMETRY_DETECTION_NUM_PRESCORE_POINTS;
+	if (num_prescore_points < num_sparse_points)
+	{
+		unsigned int num_prescore_inliers = 0;
+		for (unsigned int i = 0; i < num_prescore_points; ++i)
+		{
+			unsigned int sparse_index = simplerandom_cong_next(&rng_cong) % num_sparse_points;
+			Eigen::Vector3d symmetric_point = get_reflected_point(
+				reflection_plane.normal_, reflection_plane.point_, _sparse_points.col(sparse_index));
+			if (_sparse_grid.has_neighbor(symmetric_point, _inlier_dist))
+				++num_prescore_inliers;
+		}
+
+		// Reject the hypothesis if the subset inlier ratio is lower than
+		// the given ratio by more than two standard deviations.
+		double stddev = std::sqrt(_inlier_ratio * (1 - _inlier_ratio) / num_prescore_points);
+		if (static_cast<double>(num_prescore_inliers) / num_prescore_points
+			< _inlier_ratio - 2 * stddev)
+			return;
+	}
+
+
+	// Full sweep.
+	reflection_plane.inlier_indices_.clear();
+	for (unsigned int i = 0; i < num_sparse_points; ++i)
+	{
+		Eigen::Vector3d symmetric_point = get_reflected_point(
+			reflection_plane.normal_, reflection_plane.point_, _sparse_points.col(i));
+		if (_sparse_grid.has_neighbor(symmetric_point, _inlier_dist))
+			reflection_plane.inlier_indices_.push_back(i);
+	}
+
+	unsigned int num_sparse_inliers = reflection_plane.inlier_indices_.size();
+	_hypothesis.is_accepted_ =
+		(static_cast<double>(num_sparse_inliers) / num_sparse_points >= _inlier_ratio);
+}
+
+// Return the index of the merged plane in '_reflection_planes'.
+unsigned int merge_reflection_plane(
+	const SymmetryDetection::ReflectionPlane &_reflection_plane,
+	const double &_inlier_dist,
+	std::vector<SymmetryDetection::ReflectionPlane> &_reflection_planes)
+{
+	const double min_cos_angle = std::cos(SYMMETRY_DETECTION_MERGE_ANGLE / 180.0 * M_PI);
+
+	for (unsigned int plane_index = 0; plane_index < _reflection_planes.size(); ++plane_index)
+	{
+		SymmetryDetection::ReflectionPlane &reflection_plane = _reflection_planes[plane_index];
+		if (std::abs(reflection_plane.normal_.dot(_reflection_plane.normal_)) < min_cos_angle)
+			continue;
+		if (std::abs(reflection_plane.normal_.dot(_reflection_plane.point_ - reflection_plane.point_)) > _inlier_dist)
+			continue;
+
+		// Near-duplicate plane. Keep the one with more inliers.
+		if (_reflection_plane.inlier_indices_.size() > reflection_plane.inlier_indices_.size())
+			reflection_plane = _reflection_plane;
+		return plane_index;
+	}
+
+	_reflection_planes.push_back(_reflection_plane);
+	return _reflection_planes.size() - 1;
+}
+
 void SymmetryDetection::detect_reflectional_symmetry(
 	const Eigen::MatrixXd &_points,
 	const double &_inlier_dist, const double &_inlier_ratio,
-	std::list<ReflectionPlane> &_reflection_planes)
+	std::list<ReflectionPlane> &_reflection_planes,
+	const unsigned int _seed)
 {
-	detect_reflectional_symmetry(_points, _points, _inlier_dist, _inlier_ratio, _reflection_planes);
+	detect_reflectional_symmetry(_points, _points, _inlier_dist, _inlier_ratio, _reflection_planes, _seed);
 }
 
 void SymmetryDetection::detect_reflectional_symmetry(
 	const Eigen::MatrixXd &_sparse_points,
 	const Eigen::MatrixXd &_dense_points,
 	const double &_inlier_dist, const double &_inlier_ratio,
-	std::list<ReflectionPlane> &_reflection_planes)
+	std::list<ReflectionPlane> &_reflection_planes,
+	const unsigned int _seed)
 {
 	const unsigned int dimension = 3;
 	assert(_sparse_points.rows() == dimension);
@@ -51,57 +168,95 @@ void SymmetryDetection::detect_reflectional_symmetry(
 
 	_reflection_planes.clear();
 	const unsigned int num_sparse_points = _sparse_points.cols();
-	const unsigned int num_dense_points = _dense_points.cols();
+	if (num_sparse_points == 0)
+		return;
 
-	ANNpointArray sparse_ann_points;
-	ANNkd_tree* sparse_kd_tree = ICP::create_kd_tree(_sparse_points, sparse_ann_points);
+	PointHashGrid sparse_grid(_sparse_points, _inlier_dist);
 
-	const unsigned int num_iteration = 1000;
+	std::vector<ReflectionPlane> reflection_planes;
 
-	static SimpleRandomCong_t rng_cong;
-	// seed = num_iteration.
-	simplerandom_cong_seed(&rng_cong, num_iteration);
+	// Number of accepted hypotheses merged to each plane.
+	std::vector<unsigned int> num_plane_hypotheses;
 
-	for (unsigned int iteration = 0; iteration < num_iteration; ++iteration)
-	{
-		double sparse_index_1 = simplerandom_cong_next(&rng_cong) % num_sparse_points;
-		double sparse_index_2 = simplerandom_cong_next(&rng_cong) % num_sparse_points;
+	unsigned int num_iterations = SYMMETRY_DETECTION_MAX_NUM_ITERATIONS;
+	unsigned int num_evaluated_hypotheses = 0;
+	unsigned int num_accepted_hypotheses = 0;
+	unsigned int last_new_plane_hypothesis = 0;
 
-		Eigen::VectorXd sparse_point_1 = _sparse_points.col(sparse_index_1);
-		Eigen::VectorXd sparse_point_2 = _sparse_points.col(sparse_index_2);
+	while (num_evaluated_hypotheses < num_iterations)
+	{
+		const int num_batch_hypotheses = static_cast<int>(std::min(
+			static_cast<unsigned int>(SYMMETRY_DETECTION_BATCH_SIZE),
+			num_iterations - num_evaluated_hypotheses));
+		std::vector<ReflectionHypothesis> hypotheses(num_batch_hypotheses);
 
-		ReflectionPlane reflection_plane;
+#pragma omp parallel for schedule(dynamic)
+		for (int i = 0; i < num_batch_hypotheses; ++i)
+		{
+			evaluate_reflection_hypothesis(num_evaluated_hypotheses + i, _seed,
+				_sparse_points, sparse_grid, _inlier_dist, _inlier_ratio, hypotheses[i]);
+		}
 
-		reflection_plane.normal_ = sparse_point_2 - sparse_point_1;
-		reflection_plane.normal_.normalize();
-		reflection_plane.point_ = 0.5 * (sparse_point_1 + sparse_point_2);
+		// Merge accepted hypotheses in the hypothesis order.
+		for (int i = 0; i < num_batch_hypotheses; ++i)
+		{
+			if (!hypotheses[i].is_accepted_)
+				continue;
 
-		Eigen::MatrixXd symmetric_sparse_points = get_symmetric_point(
-			reflection_plane.normal_, reflection_plane.point_, _sparse_points);
+			++num_accepted_hypotheses;
+			unsigned int plane_index = merge_reflection_plane(hypotheses[i].plane_, _inlier_dist, reflection_planes);
+			if (plane_index == num_plane_hypotheses.size())
+			{
+				num_plane_hypotheses.push_back(0);
+				last_new_plane_hypothesis = num_evaluated_hypotheses + i + 1;
+			}
+			++num_plane_hypotheses[plane_index];
+		}
 
-		Eigen::VectorXd sparse_distances;
-		ICP::get_closest_points(sparse_kd_tree, symmetric_sparse_points, sparse_distances);
-		unsigned int num_sparse_inliers = (sparse_distances.array() <= _inlier_dist).count();
+		num_evaluated_hypotheses += num_batch_hypotheses;
 
-		if (static_cast<double>(num_sparse_inliers) / num_sparse_points >= _inlier_ratio)
+		// NOTE:
+		// The number of iterations is adapted to the hit ratio of the weakest plane found so far,
+		// not to the ratio of all accepted hypotheses. Otherwise, a dominant plane stops the search
+		// before weaker planes are found. The search also continues for a while after
+		// the last new plane since planes weaker than the weakest one may remain.
+		if (!num_plane_hypotheses.empty())
 		{
-			reflection_plane.inlier_indices_.clear();
-			for (unsigned int i = 0; i < num_sparse_points; ++i)
-				if (sparse_distances[i] < _inlier_dist)
-					reflection_plane.inlier_indices_.push_back(i);
-			
-			_reflection_planes.push_back(reflection_plane);
+			const unsigned int min_num_plane_hypotheses = *std::min_element(
+				num_plane_hypotheses.begin(), num_plane_hypotheses.end());
+			double weakest_ratio = static_cast<double>(min_num_plane_hypotheses) / num_evaluated_hypotheses;
+			double num_required_iterations = SYMMETRY_DETECTION_MIN_NUM_ITERATIONS;
+			if (weakest_ratio < 1.0)
+			{
+				num_required_iterations = std::ceil(std::log(1.0 - SYMMETRY_DETECTION_CONFIDENCE)
+					/ std::log(1.0 - weakest_ratio));
+			}
 
-			std::cout << "Reflection plane detected [" << _reflection_planes.size() << "]:" << std::endl;
-			std::cout << " - # of inliers = (" << num_sparse_inliers << " / " << num_sparse_points << ")" << std::endl;
-			std::cout << " - Normal = (" << reflection_plane.normal_.transpose() << ")" << std::endl;
-			std::cout << " - Point = (" << reflection_plane.point_.transpose() << ")" << std::endl;
-			std::cout << std::endl;
+			num_required_iterations = std::max(num_required_iterations,
+				static_cast<double>(last_new_plane_hypothesis + SYMMETRY_DETECTION_MIN_NUM_ITERATIONS_AFTER_NEW_PLANE));
+			num_required_iterations = std::max(num_required_iterations,
+				static_cast<double>(SYMMETRY_DETECTION_MIN_NUM_ITERATIONS));
+			num_required_iterations = std::min(num_required_iterations,
+				static_cast<double>(SYMMETRY_DETECTION_MAX_NUM_ITERATIONS));
+			num_iterations = static_cast<unsigned int>(num_required_iterations);
 		}
 	}
 
-	annDeallocPts(sparse_ann_points);
-	delete sparse_kd_tree;
+	std::cout << "# of hypotheses = (" << num_accepted_hypotheses << " / "
+		<< num_evaluated_hypotheses << ")" << std::endl;
+
+	for (std::vector<ReflectionPlane>::const_iterator it = reflection_planes.begin();
+		it != reflection_planes.end(); ++it)
+	{
+		const ReflectionPlane &reflection_plane = (*it);
+		_reflection_planes.push_back(reflection_plane);
+
+		std::cout << "Reflection plane detected [" << _reflection_planes.size() << "]:" << std::endl;
+		std::cout << " - # of inliers = (" << reflection_plane.inlier_indices_.size() << " / " << num_sparse_points << ")" << std::endl;
+		std::cout << " - Normal = (" << reflection_plane.normal_.transpose() << ")" << std::endl;
+		std::cout << " - Point = (" << reflection_plane.point_.transpose() << ")" << std::endl;
+		std::cout << std::endl;
+	}
 }
 
 /*
@@ -0,0 +1,1001 @@
+#include "SyntheticDataset.h"
+
+#include "MeshCuboidRelation.h"
+#include "MeshCuboidStructure.h"
+#include "MeshCuboidTrainer.h"
+#include "simplerandom.h"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace SyntheticDataset {
+
+// Random values in [_min, _max].
+static Real random_real(SimpleRandomCong_t &_rng, const Real _min = 0.0, const Real _max = 1.0)
+{
+	Real value = static_cast<Real>(simplerandom_cong_next(&_rng))
+		/ std::numeric_limits<uint32_t>::max();
+	return _min + (_max - _min) * value;
+}
+
+static void add_box(Part &_part, const MyMesh::Point &_center, const MyMesh::Normal &_size,
+	const Real _angle = 0.0)
+{
+	Box box;
+	box.center_ = _center;
+	box.size_ = _size;
+	box.angle_ = _angle;
+	_part.boxes_.push_back(box);
+}
+
+static Part &add_part(Object &_object, const Category &_category, const std::string &_label_name)
+{
+	std::vector<std::string>::const_iterator it = std::find(
+		_category.label_names_.begin(), _category.label_names_.end(), _label_name);
+	assert(it != _category.label_names_.end());
+
+	Part part;
+	part.label_index_ = static_cast<LabelIndex>(it - _category.label_names_.begin());
+	_object.parts_.push_back(part);
+	return _object.parts_.back();
+}
+
+static void get_box_corners(const Box &_box, std::array<MyMesh::Point, 8> &_corners)
+{
+	const Real cos_angle = std::cos(_box.angle_);
+	const Real sin_angle = std::sin(_box.angle_);
+
+	// NOTE:
+	// The i-th bit of the corner index indicates the sign of the i-th axis.
+	for (unsigned int corner_index = 0; corner_index < 8; ++corner_index)
+	{
+		MyMesh::Normal local;
+		for (unsigned int i = 0; i < 3; ++i)
+			local[i] = ((corner_index >> i) & 1) ? 0.5 * _box.size_[i] : -0.5 * _box.size_[i];
+
+		_corners[corner_index] = _box.center_ + MyMesh::Normal(
+			cos_angle * local[0] - sin_angle * local[1],
+			sin_angle * local[0] + cos_angle * local[1],
+			local[2]);
+	}
+}
+
+// Normalize the object as in 'MyMesh::initialize()':
+// The object diameter becomes 1, and the object stands on the z = 0 plane.
+static void normalize_object(Object &_object)
+{
+	MyMesh::Point bbox_min(std::numeric_limits<Real>::max());
+	MyMesh::Point bbox_max(-std::numeric_limits<Real>::max());
+	std::vector<MyMesh::Point> points;
+
+	for (std::vector<Part>::const_iterator it = _object.parts_.begin(); it != _object.parts_.end(); ++it)
+	{
+		for (std::vector<Box>::const_iterator jt = (*it).boxes_.begin(); jt != (*it).boxes_.end(); ++jt)
+		{
+			std::array<MyMesh::Point, 8> corners;
+			get_box_corners(*jt, corners);
+			for (unsigned int corner_index = 0; corner_index < 8; ++corner_index)
+			{
+				bbox_min.minimize(corners[corner_index]);
+				bbox_max.maximize(corners[corner_index]);
+				points.push_back(corners[corner_index]);
+			}
+		}
+	}
+
+	const MyMesh::Point bbox_center = 0.5 * (bbox_min + bbox_max);
+	Real object_diameter = 0.0;
+	for (std::vector<MyMesh::Point>::const_iterator it = points.begin(); it != points.end(); ++it)
+		object_diameter = std::max(object_diameter, ((*it) - bbox_center).length());
+	object_diameter = 2 * object_diameter;
+	assert(object_diameter > 0);
+
+	const Real scale = 1.0 / object_diameter;
+	MyMesh::Normal translation = -bbox_center * scale;
+	translation[2] += 0.5 * (bbox_max[2] - bbox_min[2]) * scale;
+
+	for (std::vector<Part>::iterator it = _object.parts_.begin(); it != _object.parts_.end(); ++it)
+	{
+		for (std::vector<Box>::iterator jt = (*it).boxes_.begin(); jt != (*it).boxes_.end(); ++jt)
+		{
+			(*jt).center_ = (*jt).center_ * scale + translation;
+			(*jt).size_ *= scale;
+		}
+	}
+}
+
+static MeshCuboidSymmetryGroupInfo reflection_group(const unsigned int _axis_index,
+	const std::vector<LabelIndex> &_single_label_indices,
+	const std::vector< std::pair<LabelIndex, LabelIndex> > &_pair_label_indices)
+{
+	MeshCuboidSymmetryGroupInfo info(ReflectionSymmetryType, _axis_index);
+	info.single_label_indices_ = _single_label_indices;
+	info.pair_label_indices_ = _pair_label_indices;
+	return info;
+}
+
+std::vector<std::string> get_category_names()
+{
+	std::vector<std::string> category_names;
+	category_names.push_back("chair");
+	category_names.push_back("table");
+	category_names.push_back("swivel_chair");
+	return category_names;
+}
+
+bool get_category(const std::string &_category_name, Category &_category)
+{
+	_category = Category();
+	_category.name_ = _category_name;
+
+	typedef std::pair<LabelIndex, LabelIndex> LabelIndexPair;
+
+	if (_category_name == "chair")
+	{
+		const char *label_names[] = { "seat", "back",
+			"leg_front_left", "leg_front_right", "leg_back_left", "leg_back_right",
+			"arm_left", "arm_right" };
+		_category.label_names_.assign(label_names, label_names + 8);
+
+		_category.label_symmetries_.push_back(std::vector<LabelIndex>(1, 0));
+		_category.label_symmetries_.push_back(std::vector<LabelIndex>(1, 1));
+		_category.label_symmetries_.push_back({ 2, 3, 4, 5 });
+		_category.label_symmetries_.push_back({ 6, 7 });
+
+		_category.symmetry_groups_.push_back(reflection_group(0, { 0, 1 },
+			{ LabelIndexPair(2, 3), LabelIndexPair(4, 5), LabelIndexPair(6, 7) }));
+	}
+	else if (_category_name == "table")
+	{
+		const char *label_names[] = { "top",
+			"leg_front_left", "leg_front_right", "leg_back_left", "leg_back_right",
+			"shelf" };
+		_category.label_names_.assign(label_names, label_names + 6);
+
+		_category.label_symmetries_.push_back(std::vector<LabelIndex>(1, 0));
+		_category.label_symmetries_.push_back({ 1, 2, 3, 4 });
+		_category.label_symmetries_.push_back(std::vector<LabelIndex>(1, 5));
+
+		_category.symmetry_groups_.push_back(reflection_group(0, { 0, 5 },
+			{ LabelIndexPair(1, 2), LabelIndexPair(3, 4) }));
+		_category.symmetry_groups_.push_back(reflection_group(1, { 0, 5 },
+			{ LabelIndexPair(1, 3), LabelIndexPair(2, 4) }));
+	}
+	else if (_category_name == "swivel_chair")
+	{
+		const char *label_names[] = { "seat", "back", "column", "base" };
+		_category.label_names_.assign(label_names, label_names + 4);
+
+		for (LabelIndex label_index = 0; label_index < 4; ++label_index)
+			_category.label_symmetries_.push_back(std::vector<LabelIndex>(1, label_index));
+
+		_category.symmetry_groups_.push_back(reflection_group(0, { 0, 1, 2 },
+			std::vector<LabelIndexPair>()));
+
+		// NOTE:
+		// Rotation groups cannot have pairs.
+		MeshCuboidSymmetryGroupInfo rotation_info(RotationSymmetryType, 2);
+		rotation_info.single_label_indices_.push_back(3);
+		_category.symmetry_groups_.push_back(rotation_info);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void generate_object(const Category &_category, const std::string &_object_name,
+	const unsigned int _seed, Object &_object)
+{
+	SimpleRandomCong_t rng;
+	simplerandom_cong_seed(&rng, _seed);
+
+	_object = Object();
+	_object.name_ = _object_name;
+
+	if (_category.name_ == "chair")
+	{
+		const Real width = random_real(rng, 0.8, 1.2);
+		const Real depth = random_real(rng, 0.8, 1.2);
+		const Real seat_height = random_real(rng, 0.8, 1.1);
+		const Real seat_thickness = random_real(rng, 0.06, 0.12);
+		const Real leg_thickness = random_real(rng, 0.06, 0.12);
+		const Real back_height = random_real(rng, 0.8, 1.4);
+		const Real back_thickness = random_real(rng, 0.06, 0.12);
+		const bool has_arms = (random_real(rng) < 0.4);
+		const Real arm_height = random_real(rng, 0.2, 0.35);
+		const Real arm_thickness = random_real(rng, 0.06, 0.1);
+
+		const Real seat_top = seat_height + seat_thickness;
+
+		add_box(add_part(_object, _category, "seat"),
+			MyMesh::Point(0, 0, seat_height + 0.5 * seat_thickness),
+			MyMesh::Normal(width, depth, seat_thickness));
+		add_box(add_part(_object, _category, "back"),
+			MyMesh::Point(0, 0.5 * (depth - back_thickness), seat_top + 0.5 * back_height),
+			MyMesh::Normal(width, back_thickness, back_height));
+
+		const char *leg_names[] = { "leg_front_left", "leg_front_right", "leg_back_left", "leg_back_right" };
+		for (unsigned int leg_index = 0; leg_index < 4; ++leg_index)
+		{
+			const Real x = ((leg_index % 2) ? 0.5 : -0.5) * (width - leg_thickness);
+			const Real y = ((leg_index / 2) ? 0.5 : -0.5) * (depth - leg_thickness);
+			add_box(add_part(_object, _category, leg_names[leg_index]),
+				MyMesh::Point(x, y, 0.5 * seat_height),
+				MyMesh::Normal(leg_thickness, leg_thickness, seat_height));
+		}
+
+		if (has_arms)
+		{
+			const char *arm_names[] = { "arm_left", "arm_right" };
+			for (unsigned int arm_index = 0; arm_index < 2; ++arm_index)
+			{
+				const Real x = (arm_index ? 0.5 : -0.5) * (width - arm_thickness);
+				const Real arm_depth = depth - back_thickness;
+				add_box(add_part(_object, _category, arm_names[arm_index]),
+					MyMesh::Point(x, -0.5 * back_thickness, seat_top + arm_height),
+					MyMesh::Normal(arm_thickness, arm_depth, arm_thickness));
+			}
+		}
+	}
+	else if (_category.name_ == "table")
+	{
+		const Real width = random_real(rng, 1.0, 2.0);
+		const Real depth = random_real(rng, 0.6, 1.2);
+		const Real height = random_real(rng, 0.7, 1.0);
+		const Real top_thickness = random_real(rng, 0.04, 0.1);
+		const Real leg_thickness = random_real(rng, 0.06, 0.12);
+		const Real leg_inset = random_real(rng, 0.0, 0.1);
+		const bool has_shelf = (random_real(rng) < 0.5);
+		const Real shelf_height = random_real(rng, 0.15, 0.35);
+		const Real shelf_thickness = random_real(rng, 0.03, 0.06);
+
+		add_box(add_part(_object, _category, "top"),
+			MyMesh::Point(0, 0, height - 0.5 * top_thickness),
+			MyMesh::Normal(width, depth, top_thickness));
+
+		const Real leg_height = height - top_thickness;
+		const Real leg_x = 0.5 * (width - leg_thickness) - leg_inset;
+		const Real leg_y = 0.5 * (depth - leg_thickness) - leg_inset;
+
+		const char *leg_names[] = { "leg_front_left", "leg_front_right", "leg_back_left", "leg_back_right" };
+		for (unsigned int leg_index = 0; leg_index < 4; ++leg_index)
+		{
+			const Real x = (leg_index % 2) ? leg_x : -leg_x;
+			const Real y = (leg_index / 2) ? leg_y : -leg_y;
+			add_box(add_part(_object, _category, leg_names[leg_index]),
+				MyMesh::Point(x, y, 0.5 * leg_height),
+				MyMesh::Normal(leg_thickness, leg_thickness, leg_height));
+		}
+
+		if (has_shelf)
+		{
+			add_box(add_part(_object, _category, "shelf"),
+				MyMesh::Point(0, 0, shelf_height),
+				MyMesh::Normal(2 * leg_x - leg_thickness, 2 * leg_y - leg_thickness, shelf_thickness));
+		}
+	}
+	else if (_category.name_ == "swivel_chair")
+	{
+		const Real seat_size = random_real(rng, 0.9, 1.2);
+		const Real seat_thickness = random_real(rng, 0.08, 0.15);
+		const Real back_height = random_real(rng, 0.7, 1.2);
+		const Real back_thickness = random_real(rng, 0.06, 0.12);
+		const Real column_height = random_real(rng, 0.5, 0.8);
+		const Real column_thickness = random_real(rng, 0.08, 0.14);
+		const Real arm_length = random_real(rng, 0.4, 0.6);
+		const Real arm_thickness = random_real(rng, 0.06, 0.1);
+		const unsigned int num_arms = 5;
+
+		const Real column_bottom = arm_thickness;
+		const Real seat_bottom = column_bottom + column_height;
+
+		add_box(add_part(_object, _category, "seat"),
+			MyMesh::Point(0, 0, seat_bottom + 0.5 * seat_thickness),
+			MyMesh::Normal(seat_size, seat_size, seat_thickness));
+		add_box(add_part(_object, _category, "back"),
+			MyMesh::Point(0, 0.5 * (seat_size - back_thickness),
+			seat_bottom + seat_thickness + 0.5 * back_height),
+			MyMesh::Normal(seat_size, back_thickness, back_height));
+		add_box(add_part(_object, _category, "column"),
+			MyMesh::Point(0, 0, column_bottom + 0.5 * column_height),
+			MyMesh::Normal(column_thickness, column_thickness, column_height));
+
+		// Star-shaped base with rotational symmetry.
+		Part &base = add_part(_object, _category, "base");
+		for (unsigned int arm_index = 0; arm_index < num_arms; ++arm_index)
+		{
+			const Real angle = 0.5 * M_PI + 2 * M_PI * arm_index / num_arms;
+			add_box(base,
+				MyMesh::Point(0.5 * arm_length * std::cos(angle), 0.5 * arm_length * std::sin(angle),
+				0.5 * arm_thickness),
+				MyMesh::Normal(arm_length, arm_thickness, arm_thickness), angle);
+		}
+	}
+	else
+	{
+		assert(false);
+	}
+
+	normalize_object(_object);
+}
+
+void get_mesh(const Object &_object,
+	std::vector<MyMesh::Point> &_vertices,
+	std::vector< std::array<VertexIndex, 3> > &_faces,
+	std::vector<Label> &_face_labels)
+{
+	_vertices.clear();
+	_faces.clear();
+	_face_labels.clear();
+
+	// NOTE:
+	// Counterclockwise from the outside (corner indices as in 'get_box_corners()').
+	const VertexIndex box_faces[12][3] = {
+		{ 0, 4, 6 }, { 0, 6, 2 },	// -x
+		{ 1, 3, 7 }, { 1, 7, 5 },	// +x
+		{ 0, 1, 5 }, { 0, 5, 4 },	// -y
+		{ 2, 6, 7 }, { 2, 7, 3 },	// +y
+		{ 0, 2, 3 }, { 0, 3, 1 },	// -z
+		{ 4, 5, 7 }, { 4, 7, 6 }	// +z
+	};
+
+	for (std::vector<Part>::const_iterator it = _object.parts_.begin(); it != _object.parts_.end(); ++it)
+	{
+		for (std::vector<Box>::const_iterator jt = (*it).boxes_.begin(); jt != (*it).boxes_.end(); ++jt)
+		{
+			const VertexIndex first_vertex_index = static_cast<VertexIndex>(_vertices.size());
+
+			std::array<MyMesh::Point, 8> corners;
+			get_box_corners(*jt, corners);
+			_vertices.insert(_vertices.end(), corners.begin(), corners.end());
+
+			for (unsigned int face_index = 0; face_index < 12; ++face_index)
+			{
+				std::array<VertexIndex, 3> face;
+				for (unsigned int i = 0; i < 3; ++i)
+					face[i] = first_vertex_index + box_faces[face_index][i];
+				_faces.push_back(face);
+				_face_labels.push_back(static_cast<Label>((*it).label_index_));
+			}
+		}
+	}
+}
+
+void sample_points(const std::vector<MyMesh::Point> &_vertices,
+	const std::vector< std::array<VertexIndex, 3> > &_faces,
+	const unsigned int _num_points, const unsigned int _seed,
+	std::vector<SamplePoint> &_sample_points)
+{
+	_sample_points.clear();
+	if (_faces.empty()) return;
+
+	const unsigned int num_faces = _faces.size();
+	std::vector<Real> cumulative_areas(num_faces);
+	std::vector<MyMesh::Normal> normals(num_faces);
+	Real sum_areas = 0;
+
+	for (unsigned int face_index = 0; face_index < num_faces; ++face_index)
+	{
+		const std::array<VertexIndex, 3> &face = _faces[face_index];
+		MyMesh::Normal cross_prod = cross(_vertices[face[1]] - _vertices[face[0]],
+			_vertices[face[2]] - _vertices[face[0]]);
+		const Real length = cross_prod.length();
+
+		sum_areas += 0.5 * length;
+		cumulative_areas[face_index] = sum_areas;
+		normals[face_index] = (length > 0) ? (cross_prod / length) : MyMesh::Normal(0.0);
+	}
+
+	SimpleRandomCong_t rng;
+	simplerandom_cong_seed(&rng, _seed);
+
+	_sample_points.reserve(_num_points);
+	for (unsigned int point_index = 0; point_index < _num_points; ++point_index)
+	{
+		const Real area = random_real(rng, 0.0, sum_areas);
+		FaceIndex face_index = static_cast<FaceIndex>(std::lower_bound(
+			cumulative_areas.begin(), cumulative_areas.end(), area) - cumulative_areas.begin());
+		face_index = std::min(face_index, static_cast<FaceIndex>(num_faces - 1));
+
+		// Uniform barycentric coordinates.
+		const Real r1 = std::sqrt(random_real(rng));
+		const Real r2 = random_real(rng);
+
+		SamplePoint sample_point;
+		sample_point.corr_fid_ = face_index;
+		sample_point.bary_coord_ = MyMesh::Point(1 - r1, r1 * (1 - r2), r1 * r2);
+		sample_point.point_ = MyMesh::Point(0.0);
+		for (unsigned int i = 0; i < 3; ++i)
+			sample_point.point_ += sample_point.bary_coord_[i] * _vertices[_faces[face_index][i]];
+		sample_point.normal_ = normals[face_index];
+		_sample_points.push_back(sample_point);
+	}
+}
+
+void get_label_confidences(const std::vector<SamplePoint> &_sample_points,
+	const std::vector<Label> &_face_labels, const unsigned int _num_labels,
+	const Real _label_noise, const unsigned int _seed,
+	Eigen::MatrixXd &_label_confidences)
+{
+	assert(_num_labels > 0);
+	const unsigned int num_points = _sample_points.size();
+	_label_confidences.resize(num_points, _num_labels);
+
+	SimpleRandomCong_t rng;
+	simplerandom_cong_seed(&rng, _seed);
+
+	for (unsigned int point_index = 0; point_index < num_points; ++point_index)
+	{
+		const FaceIndex face_index = _sample_points[point_index].corr_fid_;
+		assert(face_index < static_cast<FaceIndex>(_face_labels.size()));
+		LabelIndex predicted_label_index = static_cast<LabelIndex>(_face_labels[face_index]);
+
+		if (_num_labels > 1 && random_real(rng) < _label_noise)
+		{
+			// Any other label.
+			const LabelIndex offset = 1 + std::min(static_cast<LabelIndex>(
+				random_real(rng) * (_num_labels - 1)), _num_labels - 2);
+			predicted_label_index = (predicted_label_index + offset) % _num_labels;
+		}
+
+		// NOTE:
+		// All confidence values are positive since their logs are used.
+		const Real confidence = (_num_labels > 1) ? random_real(rng, 0.5, 0.9) : 1.0;
+		const Real other_confidence = (_num_labels > 1) ? (1.0 - confidence) / (_num_labels - 1) : 0.0;
+
+		_label_confidences.row(point_index).setConstant(other_confidence);
+		_label_confidences(point_index, predicted_label_index) = confidence;
+	}
+}
+
+void get_ground_truth_cuboids(const Object &_object,
+	std::vector<MeshCuboid *> &_cuboids)
+{
+	_cuboids.clear();
+
+	std::array<MyMesh::Normal, 3> bbox_axes;
+	bbox_axes[0] = MyMesh::Normal(1.0, 0.0, 0.0);
+	bbox_axes[1] = MyMesh::Normal(0.0, 1.0, 0.0);
+	bbox_axes[2] = MyMesh::Normal(0.0, 0.0, 1.0);
+
+	for (std::vector<Part>::const_iterator it = _object.parts_.begin(); it != _object.parts_.end(); ++it)
+	{
+		MyMesh::Point bbox_min(std::numeric_limits<Real>::max());
+		MyMesh::Point bbox_max(-std::numeric_limits<Real>::max());
+
+		for (std::vector<Box>::const_iterator jt = (*it).boxes_.begin(); jt != (*it).boxes_.end(); ++jt)
+		{
+			std::array<MyMesh::Point, 8> corners;
+			get_box_corners(*jt, corners);
+			for (unsigned int corner_index = 0; corner_index < 8; ++corner_index)
+			{
+				bbox_min.minimize(corners[corner_index]);
+				bbox_max.maximize(corners[corner_index]);
+			}
+		}
+
+		MeshCuboid *cuboid = new MeshCuboid((*it).label_index_);
+		cuboid->set_bbox_center(0.5 * (bbox_min + bbox_max));
+		cuboid->set_bbox_axes(bbox_axes, false);
+		cuboid->set_bbox_size(bbox_max - bbox_min);
+		_cuboids.push_back(cuboid);
+	}
+}
+
+
+void get_modelview_matrix(const Real _azimuth_degrees, const Real _elevation_degrees,
+	Real _modelview_matrix[16])
+{
+	const Real azimuth = _azimuth_degrees / 180.0 * M_PI;
+	const Real elevation = _elevation_degrees / 180.0 * M_PI;
+	const Real distance = 2.5;
+	const Eigen::Vector3d center(0.0, 0.0, 0.5 * std::sqrt(1.0 / 3.0));
+
+	// NOTE:
+	// The z-axis (up) in the object coordinates becomes the y-axis in the view coordinates.
+	Eigen::Matrix3d rotation =
+		Eigen::AngleAxisd(elevation - 0.5 * M_PI, Eigen::Vector3d::UnitX()).toRotationMatrix()
+		* Eigen::AngleAxisd(azimuth, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+
+	Eigen::Matrix4d modelview = Eigen::Matrix4d::Identity();
+	modelview.topLeftCorner<3, 3>() = rotation;
+	modelview.topRightCorner<3, 1>() = -rotation * center + Eigen::Vector3d(0.0, 0.0, -distance);
+
+	for (unsigned int col = 0; col < 4; ++col)
+		for (unsigned int row = 0; row < 4; ++row)
+			_modelview_matrix[4 * col + row] = modelview(row, col);
+}
+
+void get_visible_sample_points(const std::vector<SamplePoint> &_sample_points,
+	const Real _modelview_matrix[16],
+	std::vector<SamplePoint> &_visible_sample_points)
+{
+	_visible_sample_points.clear();
+
+	Eigen::Matrix4d modelview;
+	for (unsigned int col = 0; col < 4; ++col)
+		for (unsigned int row = 0; row < 4; ++row)
+			modelview(row, col) = _modelview_matrix[4 * col + row];
+
+	// Camera position in the object coordinates.
+	const Eigen::Vector3d camera_position = -modelview.topLeftCorner<3, 3>().transpose()
+		* modelview.topRightCorner<3, 1>();
+
+	for (std::vector<SamplePoint>::const_iterator it = _sample_points.begin(); it != _sample_points.end(); ++it)
+	{
+		Eigen::Vector3d point, normal;
+		for (unsigned int i = 0; i < 3; ++i)
+		{
+			point(i) = (*it).point_[i];
+			normal(i) = (*it).normal_[i];
+		}
+
+		if ((camera_position - point).dot(normal) > 0)
+			_visible_sample_points.push_back(*it);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// File output
+
+static bool make_directory(const std::string &_path)
+{
+	// Create parent directories first.
+	for (size_t pos = _path.find_first_of("/\\", 1); pos != std::string::npos;
+		pos = _path.find_first_of("/\\", pos + 1))
+	{
+		const std::string parent_path = _path.substr(0, pos);
+#ifdef _WIN32
+		_mkdir(parent_path.c_str());
+#else
+		mkdir(parent_path.c_str(), 0755);
+#endif
+	}
+
+#ifdef _WIN32
+	int ret = _mkdir(_path.c_str());
+#else
+	int ret = mkdir(_path.c_str(), 0755);
+#endif
+	if (ret != 0 && errno != EEXIST)
+	{
+		std::cerr << "Error: Cannot create the directory (" << _path << ")." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static std::string get_absolute_path(const std::string &_path)
+{
+	if (!_path.empty() && (_path[0] == '/' || _path[0] == '\\'
+		|| (_path.size() > 1 && _path[1] == ':')))
+		return _path;
+
+	char buffer[4096];
+#ifdef _WIN32
+	if (!_getcwd(buffer, sizeof(buffer))) return _path;
+#else
+	if (!getcwd(buffer, sizeof(buffer))) return _path;
+#endif
+	return std::string(buffer) + std::string("/") + _path;
+}
+
+static bool write_label_info(const Category &_category, const std::string &_path,
+	const Options &_options)
+{
+	std::ofstream label_file((_path + _options.label_info_filename_).c_str());
+	std::ofstream label_symmetry_file((_path + _options.label_symmetry_info_filename_).c_str());
+	std::ofstream symmetry_group_file((_path + _options.symmetry_group_info_filename_).c_str());
+	if (!label_file || !label_symmetry_file || !symmetry_group_file)
+	{
+		std::cerr << "Error: Cannot save label information files (" << _path << ")." << std::endl;
+		return false;
+	}
+
+	for (std::vector<std::string>::const_iterator it = _category.label_names_.begin();
+		it != _category.label_names_.end(); ++it)
+		label_file << (*it) << " pnts 1" << std::endl;
+
+	for (std::vector< std::vector<LabelIndex> >::const_iterator it = _category.label_symmetries_.begin();
+		it != _category.label_symmetries_.end(); ++it)
+	{
+		for (std::vector<LabelIndex>::const_iterator jt = (*it).begin(); jt != (*it).end(); ++jt)
+		{
+			if (jt != (*it).begin()) label_symmetry_file << " ";
+			label_symmetry_file << _category.label_names_[*jt];
+		}
+		label_symmetry_file << std::endl;
+	}
+
+	for (std::vector<MeshCuboidSymmetryGroupInfo>::const_iterator it = _category.symmetry_groups_.begin();
+		it != _category.symmetry_groups_.end(); ++it)
+	{
+		symmetry_group_file << "symmetry_group "
+			<< (((*it).symmetry_type_ == ReflectionSymmetryType) ? "reflection" : "rotation")
+			<< " " << (*it).aligned_global_axis_index_ << std::endl;
+
+		symmetry_group_file << "single_label_indices";
+		for (std::vector<LabelIndex>::const_iterator jt = (*it).single_label_indices_.begin();
+			jt != (*it).single_label_indices_.end(); ++jt)
+			symmetry_group_file << " " << (*jt);
+		symmetry_group_file << std::endl;
+
+		symmetry_group_file << "pair_label_indices";
+		for (std::vector< std::pair<LabelIndex, LabelIndex> >::const_iterator jt = (*it).pair_label_indices_.begin();
+			jt != (*it).pair_label_indices_.end(); ++jt)
+			symmetry_group_file << " " << (*jt).first << " " << (*jt).second;
+		symmetry_group_file << std::endl;
+	}
+
+	return true;
+}
+
+static bool write_mesh(const std::string &_filename,
+	const std::vector<MyMesh::Point> &_vertices,
+	const std::vector< std::array<VertexIndex, 3> > &_faces)
+{
+	std::ofstream file(_filename.c_str());
+	if (!file) return false;
+
+	file << std::setprecision(10);
+	file << "OFF" << std::endl;
+	file << _vertices.size() << " " << _faces.size() << " 0" << std::endl;
+	for (std::vector<MyMesh::Point>::const_iterator it = _vertices.begin(); it != _vertices.end(); ++it)
+		file << (*it)[0] << " " << (*it)[1] << " " << (*it)[2] << std::endl;
+	for (std::vector< std::array<VertexIndex, 3> >::const_iterator it = _faces.begin(); it != _faces.end(); ++it)
+		file << "3 " << (*it)[0] << " " << (*it)[1] << " " << (*it)[2] << std::endl;
+
+	return file.good();
+}
+
+// Same format with 'MyMesh::load_face_label_simple()'.
+static bool write_face_labels(const std::string &_filename, const std::vector<Label> &_face_labels)
+{
+	std::ofstream file(_filename.c_str());
+	if (!file) return false;
+
+	for (std::vector<Label>::const_iterator it = _face_labels.begin(); it != _face_labels.end(); ++it)
+		file << (*it) << std::endl;
+
+	return file.good();
+}
+
+// Same format with 'MeshCuboidStructure::save_sample_points()'.
+static bool write_sample_points(const std::string &_filename,
+	const std::vector<SamplePoint> &_sample_points)
+{
+	std::ofstream file(_filename.c_str());
+	if (!file) return false;
+
+	file << std::setprecision(10);
+	for (std::vector<SamplePoint>::const_iterator it = _sample_points.begin(); it != _sample_points.end(); ++it)
+	{
+		file << (*it).corr_fid_ << " "
+			<< (*it).bary_coord_[0] << " " << (*it).bary_coord_[1] << " " << (*it).bary_coord_[2] << " "
+			<< (*it).point_[0] << " " << (*it).point_[1] << " " << (*it).point_[2] << " " << std::endl;
+	}
+
+	return file.good();
+}
+
+// Same format with 'MeshCuboidStructure::save_sample_point_labels()'.
+static bool write_sample_point_labels(const std::string &_filename,
+	const Eigen::MatrixXd &_label_confidences)
+{
+	std::ofstream file(_filename.c_str());
+	if (!file) return false;
+
+	file << "@RELATION pnts - featpnts" << std::endl;
+	for (int label_index = 0; label_index < _label_confidences.cols(); ++label_index)
+		file << "@ATTRIBUTE prediction - " << label_index << " NUMERIC" << std::endl;
+	file << "@DATA" << std::endl;
+
+	for (int point_index = 0; point_index < _label_confidences.rows(); ++point_index)
+	{
+		for (int label_index = 0; label_index < _label_confidences.cols(); ++label_index)
+		{
+			file << _label_confidences(point_index, label_index);
+			if (label_index + 1 < _label_confidences.cols())
+				file << ",";
+		}
+		file << std::endl;
+	}
+
+	return file.good();
+}
+
+static bool write_pose(const std::string &_filename)
+{
+	std::ofstream file(_filename.c_str());
+	if (!file) return false;
+
+	Real modelview_matrix[16];
+	get_modelview_matrix(SYNTHETIC_DATASET_AZIMUTH_DEGREES, SYNTHETIC_DATASET_ELEVATION_DEGREES, modelview_matrix);
+
+	file << std::setprecision(10);
+	for (unsigned int i = 0; i < 16; ++i)
+		file << modelview_matrix[i] << std::endl;
+
+	return file.good();
+}
+
+static bool write_training_files(const Category &_category,
+	const std::vector<Object> &_objects,
+	const std::string &_label_info_path,
+	const std::string &_training_path,
+	const Options &_options,
+	bool _verbose)
+{
+	MyMesh mesh;
+	MeshCuboidStructure cuboid_structure(&mesh);
+	if (!cuboid_structure.load_labels((_label_info_path + _options.label_info_filename_).c_str(), false))
+		return false;
+
+	const unsigned int num_labels = cuboid_structure.num_labels();
+	assert(num_labels == _category.label_names_.size());
+
+	std::vector< std::list<MeshCuboidFeatures *> > feature_list(num_labels);
+	std::vector< std::list<MeshCuboidTransformation *> > transformation_list(num_labels);
+
+	std::ofstream object_list_file((_training_path + _options.object_list_filename_).c_str());
+	if (!object_list_file)
+	{
+		std::cerr << "Error: Cannot save the object list file (" << _training_path << ")." << std::endl;
+		return false;
+	}
+
+	// NOTE:
+	// The same with 'MeshViewerCore::train()', but ground truth cuboids are
+	// given from the parts.
+	for (std::vector<Object>::const_iterator it = _objects.begin(); it != _objects.end(); ++it)
+	{
+		const Object &object = (*it);
+		object_list_file << object.name_ << std::endl;
+
+		cuboid_structure.clear_cuboids();
+		std::vector<MeshCuboid *> cuboids;
+		get_ground_truth_cuboids(object, cuboids);
+		for (std::vector<MeshCuboid *>::iterator jt = cuboids.begin(); jt != cuboids.end(); ++jt)
+			cuboid_structure.label_cuboids_[(*jt)->get_label_index()].push_back(*jt);
+
+		cuboid_structure.save_cuboids(_training_path + object.name_ + std::string(".arff"), false);
+
+		for (LabelIndex label_index = 0; label_index < num_labels; ++label_index)
+		{
+			MeshCuboidTransformation *transformation = new MeshCuboidTransformation(object.name_);
+			MeshCuboidFeatures *features = new MeshCuboidFeatures(object.name_);
+
+			assert(cuboid_structure.label_cuboids_[label_index].size() <= 1);
+			if (!cuboid_structure.label_cuboids_[label_index].empty())
+			{
+				MeshCuboid *cuboid = cuboid_structure.label_cuboids_[label_index].front();
+				transformation->compute_transformation(cuboid);
+				features->compute_features(cuboid);
+			}
+
+			transformation_list[label_index].push_back(transformation);
+			feature_list[label_index].push_back(features);
+		}
+	}
+
+	object_list_file.close();
+	cuboid_structure.clear_cuboids();
+
+	for (LabelIndex label_index = 0; label_index < num_labels; ++label_index)
+	{
+		std::stringstream transformation_filename_sstr;
+		transformation_filename_sstr << _training_path << _options.transformation_filename_prefix_
+			<< label_index << std::string(".csv");
+		MeshCuboidTransformation::save_transformation_collection(transformation_filename_sstr.str().c_str(),
+			transformation_list[label_index]);
+
+		std::stringstream feature_filename_sstr;
+		feature_filename_sstr << _training_path << _options.feature_filename_prefix_
+			<< label_index << std::string(".csv");
+		MeshCuboidFeatures::save_feature_collection(feature_filename_sstr.str().c_str(),
+			feature_list[label_index]);
+
+		for (std::list<MeshCuboidTransformation *>::iterator jt = transformation_list[label_index].begin();
+			jt != transformation_list[label_index].end(); ++jt)
+			delete (*jt);
+		for (std::list<MeshCuboidFeatures *>::iterator jt = feature_list[label_index].begin();
+			jt != feature_list[label_index].end(); ++jt)
+			delete (*jt);
+	}
+
+
+	// Pairwise relations (previously trained outside with the same features).
+	MeshCuboidTrainer trainer;
+	bool ret = true;
+	ret = ret & trainer.load_object_list(_training_path + _options.object_list_filename_);
+	ret = ret & trainer.load_features(_training_path + _options.feature_filename_prefix_);
+	ret = ret & trainer.load_transformations(_training_path + _options.transformation_filename_prefix_);
+	if (!ret) return false;
+
+	std::vector< std::vector<MeshCuboidJointNormalRelations *> > joint_normal_relations;
+	trainer.get_joint_normal_relations(joint_normal_relations);
+
+	for (LabelIndex label_index_1 = 0; label_index_1 < joint_normal_relations.size(); ++label_index_1)
+	{
+		for (LabelIndex label_index_2 = 0; label_index_2 < joint_normal_relations[label_index_1].size(); ++label_index_2)
+		{
+			MeshCuboidJointNormalRelations *relation_12 = joint_normal_relations[label_index_1][label_index_2];
+			if (!relation_12) continue;
+
+			if (label_index_1 != label_index_2)
+			{
+				std::stringstream relation_filename_sstr;
+				relation_filename_sstr << _training_path << _options.joint_normal_relation_filename_prefix_
+					<< label_index_1 << "_" << label_index_2 << ".csv";
+				relation_12->save_joint_normal_csv(relation_filename_sstr.str().c_str());
+			}
+
+			delete relation_12;
+		}
+	}
+
+	if (_verbose)
+		std::cout << "Saved training files (" << _training_path << ")." << std::endl;
+	return true;
+}
+
+Options::Options()
+	: output_path_("synthetic")
+	, category_names_(get_category_names())
+	, num_objects_(20)
+	, num_sample_points_(1000)
+	, num_dense_sample_points_(10000)
+	, label_noise_(0.1)
+	, seed_(SYNTHETIC_DATASET_RANDOM_SEED)
+	, training_dir_("training")
+	, label_info_filename_("regions.txt")
+	, label_symmetry_info_filename_("regions_symmetry.txt")
+	, symmetry_group_info_filename_("symmetry_groups.txt")
+	, pose_filename_("pose.txt")
+	, object_list_filename_("object_list.txt")
+	, feature_filename_prefix_("feature_")
+	, transformation_filename_prefix_("transformation_")
+	, joint_normal_relation_filename_prefix_("joint_normal_")
+	, batch_job_manifest_filename_("jobs.txt")
+{
+}
+
+bool generate_dataset(const Options &_options, bool _verbose)
+{
+	const std::string root_path = get_absolute_path(_options.output_path_) + std::string("/");
+
+	for (std::vector<std::string>::const_iterator c_it = _options.category_names_.begin();
+		c_it != _options.category_names_.end(); ++c_it)
+	{
+		Category category;
+		if (!get_category(*c_it, category))
+		{
+			std::cerr << "Error: Unknown category (" << (*c_it) << ")." << std::endl;
+			return false;
+		}
+
+		const unsigned int num_labels = category.label_names_.size();
+
+		// NOTE:
+		// The same directory layout with the shape2pose data (see README).
+		std::stringstream sample_path_sstr, dense_sample_path_sstr;
+		sample_path_sstr << "data/2_analysis/" << category.name_ << "/points/even"
+			<< _options.num_sample_points_ << "/";
+		dense_sample_path_sstr << "data/2_analysis/" << category.name_ << "/points/random"
+			<< _options.num_dense_sample_points_ << "/";
+
+		const std::string label_info_path = "data/0_body/" + category.name_ + "/";
+		const std::string mesh_path = "data/1_input/" + category.name_ + "/off/";
+		const std::string mesh_label_path = "data/1_input/" + category.name_ + "/gt/";
+		const std::string sample_path = sample_path_sstr.str();
+		const std::string dense_sample_path = dense_sample_path_sstr.str();
+		const std::string sample_label_path = "data/4_experiments/exp1_" + category.name_ + "/1_prediction/";
+		const std::string experiment_path = root_path + "experiments/" + category.name_ + "/";
+		const std::string training_path = experiment_path + _options.training_dir_ + "/";
+
+		const std::string directories[] = { label_info_path, mesh_path, mesh_label_path,
+			sample_path, dense_sample_path, sample_label_path };
+		for (unsigned int i = 0; i < 6; ++i)
+			if (!make_directory(root_path + directories[i])) return false;
+		if (!make_directory(training_path)) return false;
+
+		if (!write_label_info(category, root_path + label_info_path, _options))
+			return false;
+
+		std::vector<Object> objects(_options.num_objects_);
+		std::ofstream job_manifest_file((experiment_path + _options.batch_job_manifest_filename_).c_str());
+
+		for (unsigned int object_index = 0; object_index < _options.num_objects_; ++object_index)
+		{
+			std::stringstream object_name_sstr;
+			object_name_sstr << category.name_ << "_" << std::setw(4) << std::setfill('0') << object_index;
+			const std::string object_name = object_name_sstr.str();
+
+			// NOTE:
+			// Each object has its own seed, and thus an object does not depend on the number of objects.
+			const unsigned int object_seed = _options.seed_ + 7919 * object_index;
+
+			Object &object = objects[object_index];
+			generate_object(category, object_name, object_seed, object);
+
+			std::vector<MyMesh::Point> vertices;
+			std::vector< std::array<VertexIndex, 3> > faces;
+			std::vector<Label> face_labels;
+			get_mesh(object, vertices, faces, face_labels);
+
+			std::vector<SamplePoint> sparse_sample_points, dense_sample_points;
+			sample_points(vertices, faces, _options.num_sample_points_, object_seed + 1, sparse_sample_points);
+			sample_points(vertices, faces, _options.num_dense_sample_points_, object_seed + 2, dense_sample_points);
+
+			Eigen::MatrixXd label_confidences;
+			get_label_confidences(sparse_sample_points, face_labels, num_labels,
+				_options.label_noise_, object_seed + 3, label_confidences);
+
+			bool ret = true;
+			ret = ret && write_mesh(root_path + mesh_path + object_name + ".off", vertices, faces);
+			ret = ret && write_face_labels(root_path + mesh_label_path + object_name + ".seg", face_labels);
+			ret = ret && write_sample_points(root_path + sample_path + object_name + ".pts", sparse_sample_points);
+			ret = ret && write_sample_points(root_path + dense_sample_path + object_name + ".pts", dense_sample_points);
+			ret = ret && write_sample_point_labels(root_path + sample_label_path + object_name + ".arff", label_confidences);
+			if (!ret)
+			{
+				std::cerr << "Error: Cannot save the files of " << object_name << "." << std::endl;
+				return false;
+			}
+
+			job_manifest_file << object_name << ".off" << std::endl;
+		}
+
+		job_manifest_file.close();
+
+		if (!write_training_files(category, objects, root_path + label_info_path, training_path,
+			_options, _verbose))
+			return false;
+
+		if (!write_pose(experiment_path + _options.pose_filename_))
+			return false;
+
+		std::ofstream arguments_file((experiment_path + "arguments.txt").c_str());
+		arguments_file << "--data_root_path=" << root_path << std::endl;
+		arguments_file << "--label_info_path=" << label_info_path << std::endl;
+		arguments_file << "--mesh_path=" << mesh_path << std::endl;
+		arguments_file << "--sample_path=" << sample_path << std::endl;
+		arguments_file << "--dense_sample_path=" << dense_sample_path << std::endl;
+		arguments_file << "--mesh_label_path=" << mesh_label_path << std::endl;
+		arguments_file << "--sample_label_path=" << sample_label_path << std::endl;
+		arguments_file.close();
+
+		if (_verbose)
+		{
+			std::cout << "Generated " << _options.num_objects_ << " " << category.name_
+				<< " objects (" << experiment_path << ")." << std::endl;
+		}
+	}
+
+	return true;
+}
+
+}
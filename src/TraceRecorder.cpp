@@ -0,0 +1,186 @@
+#include "TraceRecorder.h"
+
+#include <cassert>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+
+std::atomic<bool> TraceRecorder::is_recording_(false);
+std::chrono::steady_clock::time_point TraceRecorder::start_time_;
+std::mutex TraceRecorder::mutex_;
+std::vector<TraceRecorder::Event> TraceRecorder::events_;
+std::map<std::string, double> TraceRecorder::counters_;
+
+
+// Escape a string for JSON.
+static std::string escape_json(const std::string &_str)
+{
+	std::string output;
+	output.reserve(_str.size());
+	for (std::string::const_iterator it = _str.begin(); it != _str.end(); ++it)
+	{
+		if ((*it) == '"' || (*it) == '\\') output.push_back('\\');
+		if (static_cast<unsigned char>(*it) < 0x20) continue;
+		output.push_back(*it);
+	}
+	return output;
+}
+
+void TraceRecorder::start()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	events_.clear();
+	counters_.clear();
+	start_time_ = std::chrono::steady_clock::now();
+	is_recording_.store(true);
+}
+
+bool TraceRecorder::stop(const std::string &_filename)
+{
+	std::vector<Event> events;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		is_recording_.store(false);
+		events.swap(events_);
+		counters_.clear();
+	}
+
+	std::ofstream file(_filename.c_str());
+	if (!file.is_open())
+	{
+		std::cerr << "Error: Cannot save the trace file (" << _filename << ")." << std::endl;
+		return false;
+	}
+
+	file << std::setprecision(12);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	for (std::vector<Event>::const_iterator it = events.begin(); it != events.end(); ++it)
+	{
+		if (it != events.begin()) file << ",";
+		file << "\n{\"name\":\"" << escape_json(it->name_) << "\""
+			<< ",\"ph\":\"" << it->phase_ << "\""
+			<< ",\"pid\":0,\"tid\":" << it->thread_id_
+			<< ",\"ts\":" << it->timestamp_;
+		if (it->phase_ == 'X')
+			file << ",\"dur\":" << it->duration_;
+
+		file << ",\"args\":{";
+		for (std::vector< std::pair<std::string, double> >::const_iterator jt = it->args_.begin();
+			jt != it->args_.end(); ++jt)
+		{
+			if (jt != it->args_.begin()) file << ",";
+			file << "\"" << escape_json(jt->first) << "\":" << jt->second;
+		}
+		file << "}}";
+	}
+
+	file << "\n]}\n";
+	file.close();
+	return true;
+}
+
+void TraceRecorder::stop()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	is_recording_.store(false);
+	events_.clear();
+	counters_.clear();
+}
+
+void TraceRecorder::get_stage_summaries(std::map<std::string, StageSummary> &_summaries)
+{
+	_summaries.clear();
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (std::vector<Event>::const_iterator it = events_.begin(); it != events_.end(); ++it)
+	{
+		if (it->phase_ != 'X') continue;
+
+		std::map<std::string, StageSummary>::iterator jt = _summaries.find(it->name_);
+		if (jt == _summaries.end())
+		{
+			StageSummary summary;
+			summary.count_ = 0;
+			summary.total_duration_ = 0;
+			jt = _summaries.insert(std::make_pair(it->name_, summary)).first;
+		}
+
+		++(jt->second.count_);
+		jt->second.total_duration_ += it->duration_;
+	}
+}
+
+long long TraceRecorder::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start_time_).count();
+}
+
+unsigned int TraceRecorder::thread_id()
+{
+	static std::atomic<unsigned int> num_threads(0);
+	static thread_local unsigned int id = num_threads++;
+	return id;
+}
+
+void TraceRecorder::record_counter(const char *_name, const double _value, bool _accumulate)
+{
+	assert(_name);
+
+	Event event;
+	event.phase_ = 'C';
+	event.name_ = _name;
+	event.thread_id_ = thread_id();
+	event.timestamp_ = now();
+	event.duration_ = 0;
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (!is_recording()) return;
+
+	double &value = counters_[event.name_];
+	value = _accumulate ? (value + _value) : _value;
+	event.args_.push_back(std::make_pair(std::string("value"), value));
+	events_.push_back(event);
+}
+
+void TraceRecorder::record(Event &_event)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (!is_recording()) return;
+
+	events_.push_back(Event());
+	std::swap(events_.back(), _event);
+}
+
+TraceScope::TraceScope(const char *_name)
+	: name_(_name)
+	, is_recording_(TraceRecorder::is_recording())
+	, start_timestamp_(0)
+{
+	assert(_name);
+	if (is_recording_)
+		start_timestamp_ = TraceRecorder::now();
+}
+
+TraceScope::~TraceScope()
+{
+	if (!is_recording_)
+		return;
+
+	TraceRecorder::Event event;
+	event.phase_ = 'X';
+	event.name_ = name_;
+	event.thread_id_ = TraceRecorder::thread_id();
+	event.timestamp_ = start_timestamp_;
+	event.duration_ = TraceRecorder::now() - start_timestamp_;
+	event.args_.swap(args_);
+	TraceRecorder::record(event);
+}
+
+void TraceScope::add_arg(const char *_name, const double _value)
+{
+	if (is_recording_)
+		args_.push_back(std::make_pair(std::string(_name), _value));
+}